@@ -0,0 +1,181 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+
+#include <am_mcu_apollo.h>
+
+#include "alg_correlator.h"
+
+int32_t alg_correlator_init(alg_correlator_t *correlator, const float32_t *reference, float32_t *buffer, uint32_t length)
+{
+    if ((length == 0) || (length > ALG_CORRELATOR_MAX_LENGTH))
+    {
+        return -1;
+    }
+
+    correlator->buffer = buffer;
+    correlator->length = length;
+    correlator->tap_count = 0;
+
+    // Output k of the convolution is sum(reference[j] * signal[k - j]).
+    // Summing k over [offset, offset + length - 1] leaves, for each j, the
+    // sum of signal[i] for i in [offset - j, offset + length - 1 - j]
+    // clipped to the buffer.  signal[i] has age length - 1 - i.
+    int32_t offset = length >> 1;
+    for (int32_t j = 0; j < (int32_t)length; j++)
+    {
+        if (reference[j] == 0.0f)
+        {
+            continue;
+        }
+
+        int32_t lo = offset - j;
+        int32_t hi = offset + (int32_t)length - 1 - j;
+        if (lo < 0)
+        {
+            lo = 0;
+        }
+        if (hi > (int32_t)length - 1)
+        {
+            hi = length - 1;
+        }
+
+        alg_correlator_tap_t *tap = &correlator->taps[correlator->tap_count++];
+        tap->weight = reference[j];
+        tap->age_newest = length - 1 - hi;
+        tap->age_oldest = length - 1 - lo;
+    }
+
+    alg_correlator_reset(correlator);
+
+    return 0;
+}
+
+void alg_correlator_reset(alg_correlator_t *correlator)
+{
+    arm_fill_f32(0.0f, correlator->buffer, correlator->length);
+    correlator->head = 0;
+    correlator->output = 0.0f;
+    correlator->resum_count = 0;
+    correlator->resum_tap = 0;
+
+    for (uint32_t i = 0; i < correlator->tap_count; i++)
+    {
+        correlator->taps[i].sum = 0.0f;
+    }
+}
+
+static void alg_correlator_resum(alg_correlator_t *correlator, alg_correlator_tap_t *tap)
+{
+    uint32_t length = correlator->length;
+    uint32_t index = correlator->head + length - 1 - tap->age_oldest;
+    float32_t sum = 0.0f;
+
+    index = (index >= length) ? index - length : index;
+    for (uint32_t age = tap->age_oldest + 1; age > tap->age_newest; age--)
+    {
+        sum += correlator->buffer[index];
+        index = (index + 1 == length) ? 0 : index + 1;
+    }
+
+    tap->sum = sum;
+}
+
+float32_t alg_correlator_push(alg_correlator_t *correlator, float32_t sample)
+{
+    uint32_t length = correlator->length;
+    float32_t *buffer = correlator->buffer;
+
+    // buffer[head] holds the oldest sample.  It reaches age length with
+    // this push and is only needed to retire it from the window sums.
+    float32_t retired = buffer[correlator->head];
+    buffer[correlator->head] = sample;
+    correlator->head = (correlator->head + 1 == length) ? 0 : correlator->head + 1;
+
+    float32_t output = 0.0f;
+    for (uint32_t i = 0; i < correlator->tap_count; i++)
+    {
+        alg_correlator_tap_t *tap = &correlator->taps[i];
+
+        // The sample now at age_newest enters the window and the one now
+        // at age_oldest + 1 leaves it.
+        uint32_t entering = correlator->head + length - 1 - tap->age_newest;
+        entering = (entering >= length) ? entering - length : entering;
+
+        float32_t leaving = retired;
+        if (tap->age_oldest + 1 < length)
+        {
+            uint32_t index = correlator->head + length - 2 - tap->age_oldest;
+            index = (index >= length) ? index - length : index;
+            leaving = buffer[index];
+        }
+
+        tap->sum += buffer[entering] - leaving;
+        output += tap->weight * tap->sum;
+    }
+
+    // Taking the next window sum afresh bounds the rounding error each one
+    // can accumulate to tap_count * ALG_CORRELATOR_RESUM_INTERVAL updates
+    // while keeping the cost per sample constant.
+    if (correlator->tap_count && (++correlator->resum_count == ALG_CORRELATOR_RESUM_INTERVAL))
+    {
+        correlator->resum_count = 0;
+        alg_correlator_resum(correlator, &correlator->taps[correlator->resum_tap]);
+        correlator->resum_tap = (correlator->resum_tap + 1 == correlator->tap_count) ? 0 : correlator->resum_tap + 1;
+    }
+
+    correlator->output = output;
+
+    return correlator->output;
+}
+
+float32_t alg_correlator_reference(const alg_correlator_t *correlator, const float32_t *reference, float32_t *signal, float32_t *convolved)
+{
+    uint32_t length = correlator->length;
+    float32_t output = 0.0f;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        uint32_t index = correlator->head + i;
+        signal[i] = correlator->buffer[(index >= length) ? index - length : index];
+    }
+
+    arm_conv_f32((float32_t *)reference, length, signal, length, convolved);
+
+    uint32_t offset = length >> 1;
+    for (uint32_t i = offset; i < length + offset; i++)
+    {
+        output += convolved[i];
+    }
+
+    return output;
+}
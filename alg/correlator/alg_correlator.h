@@ -0,0 +1,110 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _ALG_CORRELATOR_H_
+#define _ALG_CORRELATOR_H_
+
+#include <stdint.h>
+
+#include <arm_math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest reference signal supported.
+#define ALG_CORRELATOR_MAX_LENGTH   (64)
+
+// One window sum is recomputed from the buffer every this many samples.
+#define ALG_CORRELATOR_RESUM_INTERVAL   (16)
+
+/*
+ * Each non-zero reference coefficient contributes its weight times the sum
+ * of a fixed window of the input.  The window is given by the age of its
+ * newest and oldest samples, 0 being the most recent sample.
+ */
+typedef struct alg_correlator_tap_s
+{
+    float32_t weight;
+    uint16_t age_newest;
+    uint16_t age_oldest;
+    float32_t sum;
+} alg_correlator_tap_t;
+
+typedef struct alg_correlator_s
+{
+    float32_t *buffer;
+    uint32_t length;
+    uint32_t head;
+    uint32_t tap_count;
+    uint32_t resum_count;
+    uint32_t resum_tap;
+    alg_correlator_tap_t taps[ALG_CORRELATOR_MAX_LENGTH];
+    float32_t output;
+} alg_correlator_t;
+
+/*
+ * Streaming form of
+ *
+ *   arm_conv_f32(reference, length, signal, length, convolved);
+ *   output = sum(convolved[length / 2 .. length / 2 + length - 1]);
+ *
+ * where signal holds the last length samples, oldest first.  The sum of
+ * the central outputs of the convolution reduces to a weighted sum of
+ * window sums of the input, one per non-zero reference coefficient, and
+ * each window sum is updated in constant time as samples arrive.  The cost
+ * per sample is therefore proportional to the number of non-zero
+ * coefficients rather than to length squared.
+ *
+ * buffer must hold length samples.  The window sums are kept in single
+ * precision and pick up the rounding of every update, so they are
+ * recomputed from the buffer in turn, one every
+ * ALG_CORRELATOR_RESUM_INTERVAL samples, to keep them from drifting over
+ * long runs.  The output agrees with the arm_conv_f32() form to within
+ * single precision rounding, which alg_correlator_reference() can be used
+ * to check on recorded traces.
+ */
+extern int32_t alg_correlator_init(alg_correlator_t *correlator, const float32_t *reference, float32_t *buffer, uint32_t length);
+extern void alg_correlator_reset(alg_correlator_t *correlator);
+extern float32_t alg_correlator_push(alg_correlator_t *correlator, float32_t sample);
+
+/*
+ * Computes the same output through arm_conv_f32().  signal receives the
+ * buffered samples oldest first and must hold length samples.  convolved
+ * must hold 2 * length - 1 samples.
+ */
+extern float32_t alg_correlator_reference(const alg_correlator_t *correlator, const float32_t *reference, float32_t *signal, float32_t *convolved);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,314 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+
+#include "alg_matched_filter.h"
+
+// The fixed length initialisations only link the tables of the lengths
+// used.  arm_rfft_fast_init_f32() links every table up to 4096 points.
+static arm_status alg_matched_filter_fft_init(arm_rfft_fast_instance_f32 *fft, uint32_t fft_length)
+{
+    switch (fft_length)
+    {
+    case 64:
+        return arm_rfft_fast_init_64_f32(fft);
+    case 128:
+        return arm_rfft_fast_init_128_f32(fft);
+    case 256:
+        return arm_rfft_fast_init_256_f32(fft);
+    case 512:
+        return arm_rfft_fast_init_512_f32(fft);
+    case 1024:
+        return arm_rfft_fast_init_1024_f32(fft);
+    default:
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+}
+
+int32_t alg_matched_filter_init(alg_matched_filter_t *bank, float32_t min_variance)
+{
+    if (alg_matched_filter_fft_init(&bank->fft, ALG_MATCHED_FILTER_FFT_MIN) != ARM_MATH_SUCCESS)
+    {
+        return -1;
+    }
+
+    bank->fft_length = ALG_MATCHED_FILTER_FFT_MIN;
+    bank->template_max = 1;
+    bank->min_variance = min_variance;
+    bank->template_count = 0;
+    alg_matched_filter_reset(bank);
+
+    return 0;
+}
+
+void alg_matched_filter_reset(alg_matched_filter_t *bank)
+{
+    // The first block starts with a full overlap of zeros, so that the
+    // first new sample has stream index 0.
+    arm_fill_f32(0.0f, bank->signal, ALG_MATCHED_FILTER_FFT_LENGTH);
+    bank->hop = bank->fft_length - bank->template_max + 1;
+    bank->overlap = bank->template_max - 1;
+    bank->fill = bank->overlap;
+    bank->position = -bank->overlap;
+
+    for (uint32_t i = 0; i < bank->template_count; i++)
+    {
+        bank->templates[i].active = false;
+    }
+}
+
+// Transforms a zero padded template, overwriting it.  Everything but the
+// packed DC and Nyquist terms, which are real, is conjugated.
+static void alg_matched_filter_spectrum(arm_rfft_fast_instance_f32 *fft, uint32_t fft_length, float32_t *reference, float32_t *spectrum)
+{
+    arm_rfft_fast_f32(fft, reference, spectrum, 0);
+    arm_cmplx_conj_f32(&spectrum[2], &spectrum[2], fft_length / 2 - 1);
+}
+
+// Grows the block so that at least half of it is new samples for the
+// longest template.  The templates already added are transformed back and
+// carried over, and the stream restarts.
+static int32_t alg_matched_filter_resize(alg_matched_filter_t *bank, uint32_t length)
+{
+    arm_rfft_fast_instance_f32 fft;
+    uint32_t fft_length = bank->fft_length;
+
+    if (length > bank->template_max)
+    {
+        bank->template_max = length;
+    }
+    while (fft_length < 2 * bank->template_max)
+    {
+        fft_length *= 2;
+    }
+
+    if (fft_length != bank->fft_length)
+    {
+        if (alg_matched_filter_fft_init(&fft, fft_length) != ARM_MATH_SUCCESS)
+        {
+            return -1;
+        }
+
+        for (uint32_t i = 0; i < bank->template_count; i++)
+        {
+            alg_matched_filter_template_t *t = &bank->templates[i];
+
+            arm_cmplx_conj_f32(&t->spectrum[2], &t->spectrum[2], bank->fft_length / 2 - 1);
+            arm_rfft_fast_f32(&bank->fft, t->spectrum, bank->scratch, 1);
+            arm_fill_f32(0.0f, &bank->scratch[bank->fft_length], fft_length - bank->fft_length);
+            alg_matched_filter_spectrum(&fft, fft_length, bank->scratch, t->spectrum);
+        }
+
+        bank->fft = fft;
+        bank->fft_length = fft_length;
+    }
+
+    alg_matched_filter_reset(bank);
+
+    return 0;
+}
+
+int32_t alg_matched_filter_add(alg_matched_filter_t *bank, uint32_t id, const float32_t *reference, uint32_t length, float32_t threshold)
+{
+    float32_t mean;
+    float32_t norm;
+
+    if ((bank->template_count == ALG_MATCHED_FILTER_BANK_SIZE) ||
+        (length < 2) || (length > ALG_MATCHED_FILTER_TEMPLATE_MAX))
+    {
+        return -1;
+    }
+
+    arm_mean_f32((float32_t *)reference, length, &mean);
+    arm_offset_f32((float32_t *)reference, -mean, bank->correlation, length);
+    arm_dot_prod_f32(bank->correlation, bank->correlation, length, &norm);
+    if ((norm == 0.0f) || (alg_matched_filter_resize(bank, length) != 0))
+    {
+        return -1;
+    }
+
+    alg_matched_filter_template_t *t = &bank->templates[bank->template_count];
+
+    arm_sqrt_f32(norm, &norm);
+    arm_fill_f32(0.0f, bank->scratch, bank->fft_length);
+    arm_scale_f32(bank->correlation, 1.0f / norm, bank->scratch, length);
+    alg_matched_filter_spectrum(&bank->fft, bank->fft_length, bank->scratch, t->spectrum);
+
+    t->id = id;
+    t->length = length;
+    t->threshold = threshold;
+    t->active = false;
+
+    bank->template_count++;
+
+    return 0;
+}
+
+static void alg_matched_filter_correlate(alg_matched_filter_t *bank, alg_matched_filter_template_t *t)
+{
+    // spectrum holds the signal spectrum.  Packed DC and Nyquist terms
+    // first, then the complex bins.
+    bank->scratch[0] = bank->spectrum[0] * t->spectrum[0];
+    bank->scratch[1] = bank->spectrum[1] * t->spectrum[1];
+    arm_cmplx_mult_cmplx_f32(&bank->spectrum[2], &t->spectrum[2], &bank->scratch[2], bank->fft_length / 2 - 1);
+
+    // correlation[n] = sum(signal[n + k] * template[k]), valid without
+    // wrap around for n up to fft_length - length.
+    arm_rfft_fast_f32(&bank->fft, bank->scratch, bank->correlation, 1);
+}
+
+static uint32_t alg_matched_filter_score(
+    alg_matched_filter_t *bank,
+    alg_matched_filter_template_t *t,
+    alg_matched_filter_detection_t *detections,
+    uint32_t max_detections,
+    uint32_t detected)
+{
+    float32_t *centred = bank->scratch;
+    uint32_t length = t->length;
+    float32_t mean;
+    float32_t sum = 0.0f;
+    float32_t sum_squares = 0.0f;
+
+    // The scratch buffer is free once the correlation has been taken.
+    // The window sums are taken about the block mean, which removes the
+    // gravity offset of the acceleration magnitude before the variance
+    // subtracts two large terms.  The correlation does not depend on the
+    // offset as the templates are zero mean.
+    arm_mean_f32(bank->signal, bank->fft_length, &mean);
+    arm_offset_f32(bank->signal, -mean, centred, bank->fft_length);
+
+    for (uint32_t n = 0; n < bank->hop; n++)
+    {
+        // Taking the window sums afresh every ALG_MATCHED_FILTER_RESUM_INTERVAL
+        // windows bounds the rounding error the running updates accumulate.
+        if (n % ALG_MATCHED_FILTER_RESUM_INTERVAL == 0)
+        {
+            arm_mean_f32(&centred[n], length, &sum);
+            sum *= length;
+            arm_dot_prod_f32(&centred[n], &centred[n], length, &sum_squares);
+        }
+
+        // The template is zero mean and unit norm, so the correlation only
+        // needs dividing by the norm of the zero mean window.
+        float32_t variance = sum_squares - sum * sum / length;
+        float32_t score = 0.0f;
+        if (variance > bank->min_variance * length)
+        {
+            float32_t root;
+            arm_sqrt_f32(variance, &root);
+            score = bank->correlation[n] / root;
+        }
+
+        // A candidate is reported once no higher score has been seen for a
+        // template length after it, which also suppresses the side lobes
+        // of periodic templates.
+        uint32_t position = bank->position + n + length - 1;
+        if (t->active && (position - t->peak_position >= length))
+        {
+            t->active = false;
+            if (detected < max_detections)
+            {
+                detections[detected].id = t->id;
+                detections[detected].position = t->peak_position;
+                detections[detected].score = t->peak_score;
+            }
+            detected++;
+        }
+
+        if ((score >= t->threshold) && (!t->active || (score > t->peak_score)))
+        {
+            t->active = true;
+            t->peak_score = score;
+            t->peak_position = position;
+        }
+
+        // Slide the window.  The last one may end at the end of the block.
+        if (n + length < bank->fft_length)
+        {
+            sum += centred[n + length] - centred[n];
+            sum_squares += centred[n + length] * centred[n + length] - centred[n] * centred[n];
+        }
+    }
+
+    return detected;
+}
+
+uint32_t alg_matched_filter_push(
+    alg_matched_filter_t *bank,
+    const float32_t *samples,
+    uint32_t count,
+    alg_matched_filter_detection_t *detections,
+    uint32_t max_detections)
+{
+    uint32_t detected = 0;
+
+    while (count)
+    {
+        uint32_t space = bank->fft_length - bank->fill;
+        uint32_t n = count < space ? count : space;
+
+        arm_copy_f32((float32_t *)samples, &bank->signal[bank->fill], n);
+        bank->fill += n;
+        samples += n;
+        count -= n;
+
+        if (bank->fill < bank->fft_length)
+        {
+            break;
+        }
+
+        if (bank->template_count)
+        {
+            // The forward transform overwrites its input.
+            arm_copy_f32(bank->signal, bank->scratch, bank->fft_length);
+            arm_rfft_fast_f32(&bank->fft, bank->scratch, bank->spectrum, 0);
+
+            for (uint32_t i = 0; i < bank->template_count; i++)
+            {
+                alg_matched_filter_template_t *t = &bank->templates[i];
+                alg_matched_filter_correlate(bank, t);
+                detected = alg_matched_filter_score(bank, t, detections, max_detections, detected);
+            }
+        }
+
+        // Keep the tail as the overlap for the next block.
+        memmove(bank->signal, &bank->signal[bank->hop], bank->overlap * sizeof(float32_t));
+        bank->fill = bank->overlap;
+        bank->position += bank->hop;
+    }
+
+    return detected;
+}
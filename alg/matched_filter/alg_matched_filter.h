@@ -0,0 +1,151 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _ALG_MATCHED_FILTER_H_
+#define _ALG_MATCHED_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <arm_math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Shortest and longest FFT used for the overlap-save blocks.
+#define ALG_MATCHED_FILTER_FFT_MIN          (64)
+#define ALG_MATCHED_FILTER_FFT_LENGTH       (1024)
+
+// Longest template supported.
+#define ALG_MATCHED_FILTER_TEMPLATE_MAX     (ALG_MATCHED_FILTER_FFT_LENGTH / 2)
+
+// Windows scored between two exact window sums.
+#define ALG_MATCHED_FILTER_RESUM_INTERVAL   (32)
+
+// Number of templates in a bank.
+#define ALG_MATCHED_FILTER_BANK_SIZE        (4)
+
+/*
+ * A template is stored as the conjugate of its spectrum at the block length
+ * of the bank, in the arm_rfft_fast_f32() packed layout, so that
+ * multiplying it with the
+ * spectrum of the signal gives the spectrum of the cross-correlation.
+ * It is made zero mean and unit norm when added.
+ */
+typedef struct alg_matched_filter_template_s
+{
+    uint32_t id;
+    uint32_t length;
+    float32_t threshold;
+    float32_t spectrum[ALG_MATCHED_FILTER_FFT_LENGTH];
+
+    // Best candidate not yet reported.
+    bool active;
+    float32_t peak_score;
+    uint32_t peak_position;
+} alg_matched_filter_template_t;
+
+typedef struct alg_matched_filter_detection_s
+{
+    uint32_t id;
+    uint32_t position;
+    float32_t score;
+} alg_matched_filter_detection_t;
+
+/*
+ * The block length is the shortest power of two that is at least twice
+ * the longest template added, so that each block produces hop =
+ * fft_length - template_max + 1 new outputs per template.  A detection is
+ * reported when the block holding the end of its window is full, and a
+ * template length later when it is confirmed, so it can lag the event by
+ * up to hop + template_max samples: 1.3s for a 64 sample template at
+ * 100Hz, 10s for the longest.
+ */
+typedef struct alg_matched_filter_s
+{
+    arm_rfft_fast_instance_f32 fft;
+    uint32_t fft_length;
+    uint32_t template_max;
+    uint32_t hop;
+    uint32_t overlap;
+
+    // The last overlap samples of the previous block followed by up to hop
+    // new ones.  position is the stream index of signal[0].
+    float32_t signal[ALG_MATCHED_FILTER_FFT_LENGTH];
+    uint32_t fill;
+    uint32_t position;
+
+    float32_t spectrum[ALG_MATCHED_FILTER_FFT_LENGTH];
+    float32_t scratch[ALG_MATCHED_FILTER_FFT_LENGTH];
+    float32_t correlation[ALG_MATCHED_FILTER_FFT_LENGTH];
+
+    // Windows whose variance is below this are not scored, so that sensor
+    // noise at rest cannot correlate with a template.
+    float32_t min_variance;
+
+    uint32_t template_count;
+    alg_matched_filter_template_t templates[ALG_MATCHED_FILTER_BANK_SIZE];
+} alg_matched_filter_t;
+
+int32_t alg_matched_filter_init(alg_matched_filter_t *bank, float32_t min_variance);
+
+/*
+ * Adds a template of 2 to ALG_MATCHED_FILTER_TEMPLATE_MAX samples.  The
+ * score of a window is its Pearson correlation with the template, so
+ * threshold lies in (0, 1].  A template longer than those already added
+ * may grow the block, which restarts the stream.  Returns -1 if the bank is
+ * full or the template is invalid.
+ */
+int32_t alg_matched_filter_add(alg_matched_filter_t *bank, uint32_t id, const float32_t *reference, uint32_t length, float32_t threshold);
+
+void alg_matched_filter_reset(alg_matched_filter_t *bank);
+
+/*
+ * Appends count samples.  Every hop samples the block is correlated
+ * against every template with one forward FFT and one inverse FFT per
+ * template.  A detection is reported at a local maximum of the score above
+ * threshold, a template length after it, with position the stream index of
+ * the last sample of the matching window.  Returns the number of
+ * detections, which may exceed max_detections.
+ */
+uint32_t alg_matched_filter_push(
+    alg_matched_filter_t *bank,
+    const float32_t *samples,
+    uint32_t count,
+    alg_matched_filter_detection_t *detections,
+    uint32_t max_detections);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -34,33 +34,30 @@
 
 #include "alg_shotdetect.h"
 
+int32_t alg_shotdetect_init(alg_shotdetect_context_t *context)
+{
+    context->energy_transferred = 0.0f;
+
+    // sampled_signal becomes the correlator's circular buffer.
+    return alg_correlator_init(
+        &context->correlator,
+        context->reference_signal,
+        context->sampled_signal,
+        context->signal_length);
+}
+
 void alg_shotdetect_sample(alg_shotdetect_context_t *context, float32_t new_sample)
 {
-    int i;
-    for (i = 0; i < context->signal_length - 1; i++)
-    {
-        context->sampled_signal[i] = context->sampled_signal[i + 1];
-    }
-    context->sampled_signal[i] = new_sample;
+    // Equivalent to shifting new_sample into the signal, convolving it with
+    // the reference and summing the central signal_length outputs, but in
+    // constant time per sample.  See alg_correlator.h.
+    context->energy_transferred = alg_correlator_push(&context->correlator, new_sample);
 }
 
 bool alg_shotdetect_step(alg_shotdetect_context_t *context)
 {
     bool ret = false;
 
-    arm_conv_f32(
-        context->reference_signal, context->signal_length,
-        context->sampled_signal, context->signal_length,
-        context->convolved_signal
-    );
-
-    context->energy_transferred = 0.0f;
-    uint32_t offset = context->signal_length >> 1;
-    for (int i = offset; i < context->signal_length + offset; i++)
-    {
-        context->energy_transferred += context->convolved_signal[i];
-    }
-
     switch (context->state)
     {
     case ALG_SHOTDETECT_IDLE:
@@ -90,4 +87,54 @@ bool alg_shotdetect_step(alg_shotdetect_context_t *context)
     }
 
     return ret;
-}
\ No newline at end of file
+}
+
+uint32_t alg_shotdetect_block(
+    alg_shotdetect_context_t *context,
+    const q15_t *accel,
+    const float32_t *scale,
+    uint32_t count,
+    float32_t *scratch,
+    uint32_t *shots,
+    uint32_t max_shots)
+{
+    uint32_t detected = 0;
+
+    if (count > ALG_SHOTDETECT_BLOCK_MAX)
+    {
+        count = ALG_SHOTDETECT_BLOCK_MAX;
+    }
+
+    // Square every component in place, then fold each x, y, z triple into
+    // the first count entries.  Entry i is only written after entries
+    // 3i to 3i + 2 have been read.
+    arm_q15_to_float((q15_t *)accel, scratch, 3 * count);
+    arm_mult_f32(scratch, scratch, scratch, 3 * count);
+
+    float32_t *magnitude = scratch;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        magnitude[i] = scratch[3 * i] + scratch[3 * i + 1] + scratch[3 * i + 2];
+    }
+
+    arm_mult_f32(magnitude, (float32_t *)scale, magnitude, count);
+    arm_mult_f32(magnitude, (float32_t *)scale, magnitude, count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float32_t force;
+
+        arm_sqrt_f32(magnitude[i], &force);
+        alg_shotdetect_sample(context, force);
+        if (alg_shotdetect_step(context))
+        {
+            if (detected < max_shots)
+            {
+                shots[detected] = i;
+            }
+            detected++;
+        }
+    }
+
+    return detected;
+}
@@ -42,6 +42,8 @@
 
 #include <arm_math.h>
 
+#include "alg_correlator.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -61,14 +63,40 @@ typedef struct alg_shotdetect_context_s
     uint32_t sampling_period_ms;
     float32_t *reference_signal;
     float32_t *sampled_signal;
-    float32_t *convolved_signal;
     uint32_t signal_length;
     float32_t energy_transferred;
+    alg_correlator_t correlator;
 } alg_shotdetect_context_t;
 
+// Largest block accepted by alg_shotdetect_block().
+#define ALG_SHOTDETECT_BLOCK_MAX    (32)
+
+int32_t alg_shotdetect_init(alg_shotdetect_context_t *cfg);
 void alg_shotdetect_sample(alg_shotdetect_context_t *cfg, float32_t new_sample);
 bool alg_shotdetect_step(alg_shotdetect_context_t *cfg);
 
+/*
+ * Block form of alg_shotdetect_sample() and alg_shotdetect_step().
+ *
+ * accel holds count raw x, y, z samples interleaved.  scale holds, per
+ * sample, the factor that converts a raw value divided by 32768 into the
+ * signal unit, so a block may straddle a range change.  The acceleration
+ * magnitudes are computed over the whole block before the detector is
+ * advanced sample by sample.
+ *
+ * scratch must hold 3 * count values.  The sample offsets within the block
+ * at which shots completed are written to shots, up to max_shots of them.
+ * Returns the number of shots detected, which may exceed max_shots.
+ */
+uint32_t alg_shotdetect_block(
+    alg_shotdetect_context_t *cfg,
+    const q15_t *accel,
+    const float32_t *scale,
+    uint32_t count,
+    float32_t *scratch,
+    uint32_t *shots,
+    uint32_t max_shots);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,197 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <math.h>
+
+#include <am_mcu_apollo.h>
+
+#include "alg_shotdetect_q15.h"
+
+int32_t alg_shotdetect_q15_init(
+    alg_shotdetect_q15_context_t *context,
+    const float32_t *reference,
+    q15_t *weights,
+    q15_t *sampled_signal,
+    uint32_t signal_length,
+    float32_t trigger_threshold,
+    float32_t idle_threshold,
+    float32_t lsb)
+{
+    float32_t w[ALG_CORRELATOR_MAX_LENGTH];
+    float32_t peak = 0.0f;
+
+    if ((signal_length == 0) || (signal_length > ALG_CORRELATOR_MAX_LENGTH))
+    {
+        return -1;
+    }
+
+    // Reference coefficient j weighs signal[i] for i in
+    // [offset - j, offset + length - 1 - j] clipped to the buffer.  See
+    // alg_correlator_init() for the derivation.
+    int32_t length = signal_length;
+    int32_t offset = length >> 1;
+    arm_fill_f32(0.0f, w, length);
+    for (int32_t j = 0; j < length; j++)
+    {
+        int32_t lo = offset - j > 0 ? offset - j : 0;
+        int32_t hi = offset + length - 1 - j < length - 1 ? offset + length - 1 - j : length - 1;
+        for (int32_t i = lo; i <= hi; i++)
+        {
+            w[i] += reference[j];
+        }
+    }
+
+    for (int32_t i = 0; i < length; i++)
+    {
+        if (fabsf(w[i]) > peak)
+        {
+            peak = fabsf(w[i]);
+        }
+    }
+
+    if (peak == 0.0f)
+    {
+        return -1;
+    }
+
+    // The weights are scaled to use the full q15 range.  The thresholds are
+    // scaled the same way so that the dot product never needs rescaling:
+    // energy = dot * peak / 32768 * lsb.
+    for (int32_t i = 0; i < length; i++)
+    {
+        w[i] /= peak;
+    }
+    arm_float_to_q15(w, weights, length);
+
+    context->weights = weights;
+    context->sampled_signal = sampled_signal;
+    context->signal_length = signal_length;
+    context->head = 0;
+    context->state = ALG_SHOTDETECT_IDLE;
+    context->energy_transferred = 0;
+    context->trigger_threshold = (q63_t)(trigger_threshold / (lsb * peak) * 32768.0f);
+    context->idle_threshold = (q63_t)(idle_threshold / (lsb * peak) * 32768.0f);
+
+    arm_fill_q15(0, sampled_signal, 2 * signal_length);
+
+    return 0;
+}
+
+q15_t alg_shotdetect_q15_magnitude(const q15_t *xyz, uint32_t shift)
+{
+    q31_t root;
+
+    // The sum of squares needs 32 unsigned bits.  Halving it makes it a
+    // valid q31 and then sqrt(sum / 2 / 2^31) * 2^31 = sqrt(sum) * 2^15.
+    uint32_t sum = (uint32_t)((int32_t)xyz[0] * xyz[0])
+                 + (uint32_t)((int32_t)xyz[1] * xyz[1])
+                 + (uint32_t)((int32_t)xyz[2] * xyz[2]);
+    arm_sqrt_q31((q31_t)(sum >> 1), &root);
+
+    uint32_t magnitude = ((uint32_t)root >> 15) >> shift;
+
+    // Only reachable with a shift that does not match the range.
+    return (q15_t)(magnitude > INT16_MAX ? INT16_MAX : magnitude);
+}
+
+void alg_shotdetect_q15_sample(alg_shotdetect_q15_context_t *context, q15_t new_sample)
+{
+    uint32_t length = context->signal_length;
+
+    context->sampled_signal[context->head] = new_sample;
+    context->sampled_signal[context->head + length] = new_sample;
+    context->head = (context->head + 1 == length) ? 0 : context->head + 1;
+
+    // sampled_signal[head] onwards now holds the last length samples,
+    // oldest first.
+    arm_dot_prod_q15(&context->sampled_signal[context->head], context->weights, length, &context->energy_transferred);
+}
+
+bool alg_shotdetect_q15_step(alg_shotdetect_q15_context_t *context)
+{
+    bool ret = false;
+
+    switch (context->state)
+    {
+    case ALG_SHOTDETECT_IDLE:
+        if (context->energy_transferred > context->trigger_threshold)
+        {
+            context->state = ALG_SHOTDETECT_IN_PROGRESS;
+        }
+        break;
+
+    case ALG_SHOTDETECT_IN_PROGRESS:
+        if (context->energy_transferred < context->trigger_threshold)
+        {
+            context->state = ALG_SHOTDETECT_COMPLETED;
+        }
+        break;
+
+    case ALG_SHOTDETECT_COMPLETED:
+        if (context->energy_transferred < context->idle_threshold)
+        {
+            context->state = ALG_SHOTDETECT_IDLE;
+            ret = true;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return ret;
+}
+
+uint32_t alg_shotdetect_q15_block(
+    alg_shotdetect_q15_context_t *context,
+    const q15_t *accel,
+    const uint8_t *shift,
+    uint32_t count,
+    uint32_t *shots,
+    uint32_t max_shots)
+{
+    uint32_t detected = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        alg_shotdetect_q15_sample(context, alg_shotdetect_q15_magnitude(&accel[3 * i], shift[i]));
+        if (alg_shotdetect_q15_step(context))
+        {
+            if (detected < max_shots)
+            {
+                shots[detected] = i;
+            }
+            detected++;
+        }
+    }
+
+    return detected;
+}
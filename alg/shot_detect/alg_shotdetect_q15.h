@@ -0,0 +1,118 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _ALG_SHOTDETECT_Q15_H_
+#define _ALG_SHOTDETECT_Q15_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <arm_math.h>
+
+#include "alg_shotdetect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed point variant of the shot detector.
+ *
+ * The energy transferred is a linear function of the buffered signal:
+ * summing the central outputs of the convolution with the reference gives
+ * every buffered sample a fixed weight.  The weights are derived from the
+ * float reference once at init and the energy is then a single
+ * arm_dot_prod_q15() over the signal, which maps onto the Cortex-M4 dual
+ * 16 bit MAC.  The signal is kept in a mirrored circular buffer, each
+ * sample written twice signal_length apart, so that the last signal_length
+ * samples are always contiguous.
+ *
+ * The signal is the acceleration magnitude in raw BMI270 LSBs normalised
+ * to a 32G scale, which holds the magnitude of a full scale 16G reading on
+ * all three axes.  Thresholds are given in the same unit as the float
+ * detector and converted with lsb, the size of one 32G LSB in that unit.
+ */
+// Each accelerometer range step doubles the LSB, starting from 2G.
+#define ALG_SHOTDETECT_Q15_SHIFT(range) (4 - (range))
+
+typedef struct alg_shotdetect_q15_context_s
+{
+    alg_shotdetect_state_t state;
+    q63_t trigger_threshold;
+    q63_t idle_threshold;
+    q15_t *weights;
+    q15_t *sampled_signal;
+    uint32_t signal_length;
+    uint32_t head;
+    q63_t energy_transferred;
+} alg_shotdetect_q15_context_t;
+
+/*
+ * weights must hold signal_length values and sampled_signal twice that.
+ * Returns -1 if the reference is empty or too long.
+ */
+int32_t alg_shotdetect_q15_init(
+    alg_shotdetect_q15_context_t *cfg,
+    const float32_t *reference,
+    q15_t *weights,
+    q15_t *sampled_signal,
+    uint32_t signal_length,
+    float32_t trigger_threshold,
+    float32_t idle_threshold,
+    float32_t lsb);
+
+/*
+ * Magnitude of a raw x, y, z sample.  shift normalises the sample to the
+ * 32G scale, i.e. ALG_SHOTDETECT_Q15_SHIFT(BMI2_ACC_RANGE_*).
+ */
+q15_t alg_shotdetect_q15_magnitude(const q15_t *xyz, uint32_t shift);
+
+void alg_shotdetect_q15_sample(alg_shotdetect_q15_context_t *cfg, q15_t new_sample);
+bool alg_shotdetect_q15_step(alg_shotdetect_q15_context_t *cfg);
+
+/*
+ * Block form.  accel holds count raw x, y, z samples interleaved and shift
+ * the per sample normalisation.  Reports shot offsets as
+ * alg_shotdetect_block() does.
+ */
+uint32_t alg_shotdetect_q15_block(
+    alg_shotdetect_q15_context_t *cfg,
+    const q15_t *accel,
+    const uint8_t *shift,
+    uint32_t count,
+    uint32_t *shots,
+    uint32_t max_shots);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+
+#include "alg_spectrum.h"
+
+#if ALG_SPECTRUM_FFT_LENGTH != 256
+#error "alg_spectrum_init() initialises a 256 point transform"
+#endif
+
+int32_t alg_spectrum_init(
+    alg_spectrum_t *spectrum,
+    float32_t rate_hz,
+    const float32_t *band_edges,
+    uint32_t band_count,
+    uint32_t averages)
+{
+    if ((band_count > ALG_SPECTRUM_BANDS_MAX) || (averages == 0) || (rate_hz <= 0.0f))
+    {
+        return -1;
+    }
+
+    for (uint32_t b = 0; b < band_count; b++)
+    {
+        if (band_edges[b + 1] <= band_edges[b])
+        {
+            return -1;
+        }
+    }
+
+    // The fixed length initialisation only links the tables of this
+    // length.  arm_rfft_fast_init_f32() links every table up to 4096 points.
+    if (arm_rfft_fast_init_256_f32(&spectrum->fft) != ARM_MATH_SUCCESS)
+    {
+        return -1;
+    }
+
+    // Periodic Hann window, so that windows overlapping by half sum to a
+    // constant.
+    for (uint32_t n = 0; n < ALG_SPECTRUM_FFT_LENGTH; n++)
+    {
+        spectrum->window[n] = 0.5f - 0.5f * arm_cos_f32(2.0f * PI * n / ALG_SPECTRUM_FFT_LENGTH);
+    }
+    arm_dot_prod_f32(spectrum->window, spectrum->window, ALG_SPECTRUM_FFT_LENGTH, &spectrum->window_power);
+
+    spectrum->band_edges = band_edges;
+    spectrum->band_count = band_count;
+    spectrum->averages = averages;
+    spectrum->rate_hz = rate_hz;
+    alg_spectrum_reset(spectrum);
+
+    return 0;
+}
+
+void alg_spectrum_reset(alg_spectrum_t *spectrum)
+{
+    spectrum->fill = 0;
+    spectrum->windows = 0;
+    arm_fill_f32(0.0f, &spectrum->power[0][0], ALG_SPECTRUM_AXES * ALG_SPECTRUM_BINS);
+}
+
+void alg_spectrum_set_rate(alg_spectrum_t *spectrum, float32_t rate_hz)
+{
+    spectrum->rate_hz = rate_hz;
+    alg_spectrum_reset(spectrum);
+}
+
+static void alg_spectrum_window(alg_spectrum_t *spectrum, uint32_t axis)
+{
+    float32_t *power = spectrum->scratch;
+    float32_t mean;
+
+    // Remove the mean so that gravity does not leak into the low bins.
+    // The forward transform overwrites its input.
+    arm_mean_f32(spectrum->signal[axis], ALG_SPECTRUM_FFT_LENGTH, &mean);
+    arm_offset_f32(spectrum->signal[axis], -mean, spectrum->scratch, ALG_SPECTRUM_FFT_LENGTH);
+    arm_mult_f32(spectrum->scratch, spectrum->window, spectrum->scratch, ALG_SPECTRUM_FFT_LENGTH);
+    arm_rfft_fast_f32(&spectrum->fft, spectrum->scratch, spectrum->spectrum, 0);
+
+    // Packed DC and Nyquist terms first, then the complex bins.
+    power[0] = spectrum->spectrum[0] * spectrum->spectrum[0];
+    power[ALG_SPECTRUM_BINS - 1] = spectrum->spectrum[1] * spectrum->spectrum[1];
+    arm_cmplx_mag_squared_f32(&spectrum->spectrum[2], &power[1], ALG_SPECTRUM_BINS - 2);
+
+    arm_add_f32(spectrum->power[axis], power, spectrum->power[axis], ALG_SPECTRUM_BINS);
+}
+
+uint32_t alg_spectrum_push(
+    alg_spectrum_t *spectrum,
+    const float32_t *x,
+    const float32_t *y,
+    const float32_t *z,
+    uint32_t count)
+{
+    const float32_t *samples[ALG_SPECTRUM_AXES] = { x, y, z };
+    uint32_t windows = 0;
+
+    while (count)
+    {
+        uint32_t space = alg_spectrum_space(spectrum);
+        uint32_t n = count < space ? count : space;
+
+        for (uint32_t axis = 0; axis < ALG_SPECTRUM_AXES; axis++)
+        {
+            arm_copy_f32((float32_t *)samples[axis], &spectrum->signal[axis][spectrum->fill], n);
+            samples[axis] += n;
+        }
+        spectrum->fill += n;
+        count -= n;
+
+        if (spectrum->fill < ALG_SPECTRUM_FFT_LENGTH)
+        {
+            break;
+        }
+
+        for (uint32_t axis = 0; axis < ALG_SPECTRUM_AXES; axis++)
+        {
+            alg_spectrum_window(spectrum, axis);
+
+            // The second half starts the next window.
+            memmove(spectrum->signal[axis], &spectrum->signal[axis][ALG_SPECTRUM_HOP],
+                (ALG_SPECTRUM_FFT_LENGTH - ALG_SPECTRUM_HOP) * sizeof(float32_t));
+        }
+        spectrum->fill = ALG_SPECTRUM_FFT_LENGTH - ALG_SPECTRUM_HOP;
+        spectrum->windows++;
+        windows++;
+    }
+
+    return windows;
+}
+
+bool alg_spectrum_summary(alg_spectrum_t *spectrum, alg_spectrum_summary_t *summary)
+{
+    if (spectrum->windows < spectrum->averages)
+    {
+        return false;
+    }
+
+    // Power of bin k, in the squared unit of the samples, is
+    // 2 |X[k]|^2 / (N sum(w^2)) averaged over the windows, so that the bins
+    // of the one sided spectrum add up to the variance of the signal.  The
+    // DC and Nyquist bins are not doubled.  The PSD is this divided by the
+    // bin width.
+    float32_t bin_hz = spectrum->rate_hz / ALG_SPECTRUM_FFT_LENGTH;
+    float32_t scale = 2.0f / (spectrum->windows * ALG_SPECTRUM_FFT_LENGTH * spectrum->window_power);
+
+    summary->windows = spectrum->windows;
+    summary->rate_hz = spectrum->rate_hz;
+    summary->band_count = spectrum->band_count;
+
+    for (uint32_t axis = 0; axis < ALG_SPECTRUM_AXES; axis++)
+    {
+        float32_t *power = spectrum->power[axis];
+        float32_t total = 0.0f;
+        float32_t peak = 0.0f;
+        uint32_t peak_bin = 0;
+        uint32_t k = 1;
+
+        arm_scale_f32(power, scale, power, ALG_SPECTRUM_BINS);
+        power[ALG_SPECTRUM_BINS - 1] *= 0.5f;
+
+        // The DC bin only holds what is left of the window means.
+        for (uint32_t i = 1; i < ALG_SPECTRUM_BINS; i++)
+        {
+            total += power[i];
+            if (power[i] > peak)
+            {
+                peak = power[i];
+                peak_bin = i;
+            }
+        }
+        arm_sqrt_f32(total, &summary->rms[axis]);
+        summary->peak_hz[axis] = peak_bin * bin_hz;
+
+        for (uint32_t b = 0; b < spectrum->band_count; b++)
+        {
+            float32_t band = 0.0f;
+
+            while ((k < ALG_SPECTRUM_BINS) && (k * bin_hz < spectrum->band_edges[b]))
+            {
+                k++;
+            }
+            while ((k < ALG_SPECTRUM_BINS) && (k * bin_hz < spectrum->band_edges[b + 1]))
+            {
+                band += power[k++];
+            }
+            arm_sqrt_f32(band, &summary->band_rms[axis][b]);
+        }
+    }
+
+    spectrum->windows = 0;
+    arm_fill_f32(0.0f, &spectrum->power[0][0], ALG_SPECTRUM_AXES * ALG_SPECTRUM_BINS);
+
+    return true;
+}
@@ -0,0 +1,143 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _ALG_SPECTRUM_H_
+#define _ALG_SPECTRUM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <arm_math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ALG_SPECTRUM_AXES           (3)
+
+// Length of each Hann window.  Windows overlap by half, so one is
+// transformed every ALG_SPECTRUM_HOP samples.  alg_spectrum_init() uses
+// the 256 point transform initialisation.
+#define ALG_SPECTRUM_FFT_LENGTH     (256)
+#define ALG_SPECTRUM_HOP            (ALG_SPECTRUM_FFT_LENGTH / 2)
+#define ALG_SPECTRUM_BINS           (ALG_SPECTRUM_FFT_LENGTH / 2 + 1)
+
+// Largest number of bands in a summary.
+#define ALG_SPECTRUM_BANDS_MAX      (8)
+
+/*
+ * Summary of the averaged spectrum.  Band and total values are RMS
+ * accelerations in the unit of the samples, with the mean of each window
+ * removed.  Band b covers [band_edges[b], band_edges[b + 1]) Hz and is 0
+ * above the Nyquist frequency.
+ */
+typedef struct alg_spectrum_summary_s
+{
+    uint32_t windows;
+    float32_t rate_hz;
+    float32_t rms[ALG_SPECTRUM_AXES];
+    float32_t peak_hz[ALG_SPECTRUM_AXES];
+    uint32_t band_count;
+    float32_t band_rms[ALG_SPECTRUM_AXES][ALG_SPECTRUM_BANDS_MAX];
+} alg_spectrum_summary_t;
+
+typedef struct alg_spectrum_s
+{
+    arm_rfft_fast_instance_f32 fft;
+
+    float32_t window[ALG_SPECTRUM_FFT_LENGTH];
+    float32_t window_power;     // sum of the squared window coefficients
+
+    // The last fill samples of each axis, oldest first.
+    float32_t signal[ALG_SPECTRUM_AXES][ALG_SPECTRUM_FFT_LENGTH];
+    uint32_t fill;
+
+    float32_t scratch[ALG_SPECTRUM_FFT_LENGTH];
+    float32_t spectrum[ALG_SPECTRUM_FFT_LENGTH];
+
+    // Sum of the periodograms, |X[k]|^2, of the windows since the last
+    // summary.
+    float32_t power[ALG_SPECTRUM_AXES][ALG_SPECTRUM_BINS];
+    uint32_t windows;
+    uint32_t averages;
+
+    float32_t rate_hz;
+    const float32_t *band_edges;
+    uint32_t band_count;
+} alg_spectrum_t;
+
+/*
+ * Welch power spectral density of three axes.  band_edges holds
+ * band_count + 1 increasing frequencies in Hz and must stay valid.  A
+ * summary is ready every averages windows.  Returns -1 if the parameters
+ * are invalid.
+ */
+int32_t alg_spectrum_init(
+    alg_spectrum_t *spectrum,
+    float32_t rate_hz,
+    const float32_t *band_edges,
+    uint32_t band_count,
+    uint32_t averages);
+
+// Discards the buffered samples and the running average.
+void alg_spectrum_reset(alg_spectrum_t *spectrum);
+
+// Changes the sample rate.  The spectrum is reset, since windows at two
+// rates cannot be averaged.
+void alg_spectrum_set_rate(alg_spectrum_t *spectrum, float32_t rate_hz);
+
+// Number of samples still needed to complete the next window.
+static inline uint32_t alg_spectrum_space(const alg_spectrum_t *spectrum)
+{
+    return ALG_SPECTRUM_FFT_LENGTH - spectrum->fill;
+}
+
+/*
+ * Appends count samples of each axis.  Every window that is completed is
+ * transformed with arm_rfft_fast_f32() and added to the running average.
+ * Returns the number of windows completed.
+ */
+uint32_t alg_spectrum_push(
+    alg_spectrum_t *spectrum,
+    const float32_t *x,
+    const float32_t *y,
+    const float32_t *z,
+    uint32_t count);
+
+// Returns false until averages windows have been added.  Otherwise fills
+// summary and starts a new average.
+bool alg_spectrum_summary(alg_spectrum_t *spectrum, alg_spectrum_summary_t *summary);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -36,11 +36,17 @@
 enum
 {
     APP_MSG_LED_STATUS,
-    APP_MSG_SAMPLING_START,
-    APP_MSG_SAMPLING_STOP,
+    APP_MSG_MOTION_EVENT,
     APP_MSG_SAMPLING_TRIGGER,
+    APP_MSG_SAMPLING_WATERMARK,
+    APP_MSG_MAG_DRDY,
     APP_MSG_CALIBRATE_START,
     APP_MSG_CALIBRATE_STOP,
+    APP_MSG_SENSORS_BENCHMARK,
+    APP_MSG_FIFO_BENCHMARK,
+    APP_MSG_CAPTURE_CONFIGURE,
+    APP_MSG_AHRS_SHOW,
+    APP_MSG_MAG_CAL_UPDATED,
 };
 
 typedef struct application_msg_s
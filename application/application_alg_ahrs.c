@@ -0,0 +1,95 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <arm_math.h>
+
+#include "imu.h"
+#include "mag.h"
+#include "ahrs.h"
+#include "resampler.h"
+#include "profile.h"
+
+#include "application.h"
+#include "application_task.h"
+
+static profile_t profile_ahrs = { .name = "ahrs" };
+static bool application_ahrs_over_budget;
+
+void application_alg_ahrs_setup(ahrs_t *ahrs)
+{
+    ahrs_init(ahrs, AHRS_BETA);
+    profile_register(&profile_ahrs);
+}
+
+void application_alg_ahrs_update(const resampler_frame_t *frames, uint32_t count, ahrs_t *ahrs)
+{
+    float32_t mag[3];
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // The magnetometer axes are re-mapped onto the IMU axes.
+        //   along the IMU Petal Board width: -imu_x, +mag_y
+        //   along the IMU Petal board height: -imu_y, +mag_x
+        //   top: +imu_z, -mag_z
+        mag[0] = -frames[i].mag[1];
+        mag[1] = -frames[i].mag[0];
+        mag[2] = -frames[i].mag[2];
+
+        profile_start(&profile_ahrs);
+        ahrs_update(ahrs, frames[i].gyr, frames[i].acc, mag, frames[i].timestamp);
+        profile_stop(&profile_ahrs);
+    }
+
+    if (!application_ahrs_over_budget && (profile_ahrs.max > AHRS_CYCLE_BUDGET))
+    {
+        application_ahrs_over_budget = true;
+        am_util_stdio_printf("AHRS update took %u cycles, budget %u\n", profile_ahrs.max, AHRS_CYCLE_BUDGET);
+    }
+}
+
+void application_alg_ahrs_show(const ahrs_t *ahrs)
+{
+    ahrs_euler_t euler;
+
+    ahrs_euler(ahrs, &euler);
+    am_util_stdio_printf("q: %.4f %.4f %.4f %.4f roll: %.1f pitch: %.1f yaw: %.1f\n",
+        (double)ahrs->q0, (double)ahrs->q1, (double)ahrs->q2, (double)ahrs->q3,
+        (double)(euler.roll * 180.0f / PI),
+        (double)(euler.pitch * 180.0f / PI),
+        (double)(euler.yaw * 180.0f / PI));
+}
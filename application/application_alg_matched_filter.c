@@ -0,0 +1,93 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <am_mcu_apollo.h>
+#include <am_bsp.h>
+#include <am_util.h>
+
+#include <arm_math.h>
+
+#include "imu.h"
+
+#include "alg_matched_filter.h"
+
+#include "application.h"
+#include "application_task.h"
+
+// Frames are converted in chunks so that the buffer stays small.
+#define MATCHED_FILTER_CHUNK    (32)
+
+uint32_t application_alg_matched_filter_block(
+    const imu_context_t *frames,
+    uint32_t count,
+    alg_matched_filter_t *bank,
+    alg_matched_filter_detection_t *detections,
+    uint32_t max_detections)
+{
+    static float32_t force[MATCHED_FILTER_CHUNK];
+    uint32_t detected = 0;
+
+    if (bank->template_count == 0)
+    {
+        return 0;
+    }
+
+    // The templates describe the acceleration magnitude in m/s^2, the same
+    // signal as the shot detector sees.
+    while (count)
+    {
+        uint32_t n = count < MATCHED_FILTER_CHUNK ? count : MATCHED_FILTER_CHUNK;
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            float32_t ax = imu_lsb_to_mps2(&frames[i], frames[i].ax);
+            float32_t ay = imu_lsb_to_mps2(&frames[i], frames[i].ay);
+            float32_t az = imu_lsb_to_mps2(&frames[i], frames[i].az);
+            arm_sqrt_f32(ax * ax + ay * ay + az * az, &force[i]);
+        }
+
+        detected += alg_matched_filter_push(
+            bank,
+            force,
+            n,
+            detected < max_detections ? &detections[detected] : NULL,
+            detected < max_detections ? max_detections - detected : 0);
+
+        frames += n;
+        count -= n;
+    }
+
+    return detected;
+}
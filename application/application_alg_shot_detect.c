@@ -43,10 +43,59 @@
 #include "imu.h"
 
 #include "alg_shotdetect.h"
+#include "alg_shotdetect_q15.h"
 
 #include "application.h"
 #include "application_task.h"
 
+// The reference and the thresholds were tuned at 100Hz, the rate set by
+// SENSORS_SHOTDETECT_RATE_HZ.
+#define ALG_SHOTDETECT_SIGNAL_LENGTH        (32)
+#define ALG_SHOTDETECT_TRIGGER_THRESHOLD    (1500)
+#define ALG_SHOTDETECT_IDLE_THRESHOLD       (1000)
+
+// One LSB of the fixed point magnitude in m/s^2, the unit of the thresholds.
+#define ALG_SHOTDETECT_Q15_LSB              (32.0f * 9.80665f / 32768.0f)
+
+static float32_t shotdetect_signal_reference[ALG_SHOTDETECT_SIGNAL_LENGTH] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 1.0f,
+    1.0f, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+
+// The detector configuration is kept here so that the host replay runs the
+// same detector as the application.  Each variant has a single instance.
+void application_alg_shotdetect_setup(alg_shotdetect_context_t *alg_shotdetect_context)
+{
+    static float32_t shotdetect_signal_sampled[ALG_SHOTDETECT_SIGNAL_LENGTH];
+
+    alg_shotdetect_context->state = ALG_SHOTDETECT_IDLE;
+    alg_shotdetect_context->trigger_threshold = ALG_SHOTDETECT_TRIGGER_THRESHOLD;
+    alg_shotdetect_context->idle_threshold = ALG_SHOTDETECT_IDLE_THRESHOLD;
+    alg_shotdetect_context->sampled_signal = shotdetect_signal_sampled;
+    alg_shotdetect_context->reference_signal = shotdetect_signal_reference;
+    alg_shotdetect_context->signal_length = ALG_SHOTDETECT_SIGNAL_LENGTH;
+    alg_shotdetect_context->sampling_period_ms = 20;
+    alg_shotdetect_init(alg_shotdetect_context);
+}
+
+void application_alg_shotdetect_q15_setup(alg_shotdetect_q15_context_t *alg_shotdetect_context)
+{
+    static q15_t shotdetect_signal_sampled[2 * ALG_SHOTDETECT_SIGNAL_LENGTH];
+    static q15_t shotdetect_signal_weights[ALG_SHOTDETECT_SIGNAL_LENGTH];
+
+    alg_shotdetect_q15_init(
+        alg_shotdetect_context,
+        shotdetect_signal_reference,
+        shotdetect_signal_weights,
+        shotdetect_signal_sampled,
+        ALG_SHOTDETECT_SIGNAL_LENGTH,
+        ALG_SHOTDETECT_TRIGGER_THRESHOLD,
+        ALG_SHOTDETECT_IDLE_THRESHOLD,
+        ALG_SHOTDETECT_Q15_LSB);
+}
+
 bool application_alg_shotdetect_step(imu_context_t *imu_context, alg_shotdetect_context_t *alg_shotdetect_context)
 {
     // Strictly speaking, we don't really need to compute the actual force.
@@ -56,9 +105,9 @@ bool application_alg_shotdetect_step(imu_context_t *imu_context, alg_shotdetect_
     // adjusted accordingly to properly reflect the change in the numerical
     // value.
     float32_t force = 0.0f;
-    float32_t ax = imu_lsb_to_mps2(imu_context->ax);
-    float32_t ay = imu_lsb_to_mps2(imu_context->ay);
-    float32_t az = imu_lsb_to_mps2(imu_context->az);
+    float32_t ax = imu_lsb_to_mps2(imu_context, imu_context->ax);
+    float32_t ay = imu_lsb_to_mps2(imu_context, imu_context->ay);
+    float32_t az = imu_lsb_to_mps2(imu_context, imu_context->az);
     arm_sqrt_f32(
         (float32_t)( ax * ax + ay * ay + az * az),
         &force
@@ -66,4 +115,71 @@ bool application_alg_shotdetect_step(imu_context_t *imu_context, alg_shotdetect_
 
     alg_shotdetect_sample(alg_shotdetect_context, force);
     return alg_shotdetect_step(alg_shotdetect_context);
-}
\ No newline at end of file
+}
+
+uint32_t application_alg_shotdetect_block(
+    const imu_context_t *frames,
+    uint32_t count,
+    alg_shotdetect_context_t *alg_shotdetect_context,
+    uint32_t *shots,
+    uint32_t max_shots)
+{
+    static q15_t accel[3 * ALG_SHOTDETECT_BLOCK_MAX];
+    static float32_t scale[ALG_SHOTDETECT_BLOCK_MAX];
+    static float32_t scratch[3 * ALG_SHOTDETECT_BLOCK_MAX];
+
+    if (count > ALG_SHOTDETECT_BLOCK_MAX)
+    {
+        count = ALG_SHOTDETECT_BLOCK_MAX;
+    }
+
+    // The raw readings are treated as q15 so that the conversion to float
+    // divides by 32768.  The per frame scale restores m/s^2 at whatever
+    // range each frame was measured at.
+    for (uint32_t i = 0; i < count; i++)
+    {
+        accel[3 * i + 0] = frames[i].ax;
+        accel[3 * i + 1] = frames[i].ay;
+        accel[3 * i + 2] = frames[i].az;
+        scale[i] = imu_lsb_to_mps2(&frames[i], 1) * 32768.0f;
+    }
+
+    return alg_shotdetect_block(alg_shotdetect_context, accel, scale, count, scratch, shots, max_shots);
+}
+
+bool application_alg_shotdetect_q15_step(imu_context_t *imu_context, alg_shotdetect_q15_context_t *alg_shotdetect_context)
+{
+    q15_t accel[3] = { imu_context->ax, imu_context->ay, imu_context->az };
+
+    alg_shotdetect_q15_sample(alg_shotdetect_context,
+        alg_shotdetect_q15_magnitude(accel, ALG_SHOTDETECT_Q15_SHIFT(imu_context->acc_range)));
+    return alg_shotdetect_q15_step(alg_shotdetect_context);
+}
+
+uint32_t application_alg_shotdetect_q15_block(
+    const imu_context_t *frames,
+    uint32_t count,
+    alg_shotdetect_q15_context_t *alg_shotdetect_context,
+    uint32_t *shots,
+    uint32_t max_shots)
+{
+    static q15_t accel[3 * ALG_SHOTDETECT_BLOCK_MAX];
+    static uint8_t shift[ALG_SHOTDETECT_BLOCK_MAX];
+
+    if (count > ALG_SHOTDETECT_BLOCK_MAX)
+    {
+        count = ALG_SHOTDETECT_BLOCK_MAX;
+    }
+
+    // Raw readings are used as they are.  The shift brings every frame to
+    // the same scale whatever range it was measured at.
+    for (uint32_t i = 0; i < count; i++)
+    {
+        accel[3 * i + 0] = frames[i].ax;
+        accel[3 * i + 1] = frames[i].ay;
+        accel[3 * i + 2] = frames[i].az;
+        shift[i] = ALG_SHOTDETECT_Q15_SHIFT(frames[i].acc_range);
+    }
+
+    return alg_shotdetect_q15_block(alg_shotdetect_context, accel, shift, count, shots, max_shots);
+}
@@ -0,0 +1,179 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <am_mcu_apollo.h>
+#include <am_bsp.h>
+#include <am_util.h>
+
+#include <arm_math.h>
+
+#include "sensors_config.h"
+
+#include "imu.h"
+#include "profile.h"
+
+#include "alg_spectrum.h"
+
+#include "application.h"
+#include "application_task.h"
+
+// Frames are converted in chunks so that the buffers stay small.
+#define SPECTRUM_CHUNK      (32)
+
+// Band edges in Hz.  Bands above the Nyquist frequency of the current rate
+// read 0.
+static const float32_t spectrum_band_edges[] = {
+    2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 100.0f, 200.0f, 400.0f, 800.0f
+};
+
+static profile_t profile_spectrum = { .name = "spectrum" };
+static uint64_t spectrum_last_timestamp;
+static uint32_t spectrum_period_us;
+
+void application_alg_spectrum_setup(alg_spectrum_t *spectrum)
+{
+    // The rate is taken from the frame timestamps once they arrive.
+    alg_spectrum_init(
+        spectrum,
+        SENSORS_RESAMPLE_RATE_HZ,
+        spectrum_band_edges,
+        sizeof(spectrum_band_edges) / sizeof(spectrum_band_edges[0]) - 1,
+        SENSORS_VIBRATION_AVERAGES);
+    spectrum_last_timestamp = 0;
+    spectrum_period_us = 0;
+    profile_register(&profile_spectrum);
+}
+
+// Follows the sample period of the frames.  The sampling profile can change
+// the rate at any time, and the spectrum restarts when it does.  Frames that
+// follow dropped samples are not used to measure the period.
+static bool application_alg_spectrum_track_rate(const imu_context_t *frame, alg_spectrum_t *spectrum)
+{
+    bool changed = false;
+
+    if ((spectrum_last_timestamp != 0) && (frame->dropped == 0) && (frame->timestamp > spectrum_last_timestamp))
+    {
+        uint32_t period_us = (uint32_t)(frame->timestamp - spectrum_last_timestamp);
+        uint32_t tolerance_us = spectrum_period_us / 8;
+
+        if ((period_us + tolerance_us < spectrum_period_us) || (period_us > spectrum_period_us + tolerance_us))
+        {
+            spectrum_period_us = period_us;
+            alg_spectrum_set_rate(spectrum, 1000000.0f / period_us);
+            changed = true;
+        }
+    }
+    spectrum_last_timestamp = frame->timestamp;
+
+    return changed;
+}
+
+bool application_alg_spectrum_block(
+    const imu_context_t *frames,
+    uint32_t count,
+    alg_spectrum_t *spectrum,
+    alg_spectrum_summary_t *summary)
+{
+    static float32_t x[SPECTRUM_CHUNK];
+    static float32_t y[SPECTRUM_CHUNK];
+    static float32_t z[SPECTRUM_CHUNK];
+    bool ready = false;
+
+    while (count)
+    {
+        // A chunk never goes past the end of a window, so that the probe
+        // times one window per stop.
+        uint32_t space = alg_spectrum_space(spectrum);
+        uint32_t n = count < SPECTRUM_CHUNK ? count : SPECTRUM_CHUNK;
+        bool restarted = false;
+        n = n < space ? n : space;
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (application_alg_spectrum_track_rate(&frames[i], spectrum))
+            {
+                // The spectrum restarts with this frame.  The frames
+                // before it were sampled at the old rate.
+                frames += i;
+                count -= i;
+                restarted = true;
+                break;
+            }
+            x[i] = imu_lsb_to_mps2(&frames[i], frames[i].ax);
+            y[i] = imu_lsb_to_mps2(&frames[i], frames[i].ay);
+            z[i] = imu_lsb_to_mps2(&frames[i], frames[i].az);
+        }
+        if (restarted)
+        {
+            continue;
+        }
+
+        profile_start(&profile_spectrum);
+        if (alg_spectrum_push(spectrum, x, y, z, n))
+        {
+            profile_stop(&profile_spectrum);
+            ready |= alg_spectrum_summary(spectrum, summary);
+        }
+
+        frames += n;
+        count -= n;
+    }
+
+    return ready;
+}
+
+void application_alg_spectrum_show(const alg_spectrum_summary_t *summary)
+{
+    uint32_t avg = profile_spectrum.count ? (uint32_t)(profile_spectrum.total / profile_spectrum.count) : 0;
+
+    am_util_stdio_printf("Vibration %uHz x%u (%u cycles/window) rms: %.3f %.3f %.3f peak: %.1f %.1f %.1fHz\n",
+        (uint32_t)summary->rate_hz, summary->windows, avg,
+        (double)summary->rms[0], (double)summary->rms[1], (double)summary->rms[2],
+        (double)summary->peak_hz[0], (double)summary->peak_hz[1], (double)summary->peak_hz[2]);
+
+    // One RMS per band over all axes.
+    am_util_stdio_printf("  bands:");
+    for (uint32_t b = 0; b < summary->band_count; b++)
+    {
+        float32_t band;
+        arm_sqrt_f32(
+            summary->band_rms[0][b] * summary->band_rms[0][b] +
+            summary->band_rms[1][b] * summary->band_rms[1][b] +
+            summary->band_rms[2][b] * summary->band_rms[2][b],
+            &band);
+        am_util_stdio_printf(" %.3f", (double)band);
+    }
+    am_util_stdio_printf("\n");
+}
@@ -0,0 +1,219 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "lfs.h"
+
+#include "application_capture.h"
+#include "application_task.h"
+
+/*
+ * The application task appends every frame to a circular history.  A
+ * trigger marks a frame and, once the post-trigger frames have arrived,
+ * the window is copied out to the snapshot and the writer task is woken to
+ * store it.  Acquisition never waits on flash: if the writer is still busy
+ * with the previous capture the new one is dropped.
+ */
+typedef struct capture_state_s
+{
+    capture_frame_t history[CAPTURE_HISTORY_FRAMES];
+    uint32_t head;
+    uint32_t filled;
+
+    uint32_t pre;
+    uint32_t post;
+
+    // Capture in progress.
+    bool armed;
+    uint32_t remaining;
+    uint32_t event;
+    uint64_t timestamp;
+
+    // Handed over to the writer while busy is set.
+    capture_header_t header;
+    capture_frame_t snapshot[CAPTURE_HISTORY_FRAMES];
+    volatile bool busy;
+
+    uint32_t sequence;
+    uint32_t dropped;
+} capture_state_t;
+
+static capture_state_t capture;
+
+static TaskHandle_t capture_task_handle;
+
+static void capture_complete(uint32_t skip)
+{
+    uint32_t length = capture.pre + capture.post;
+
+    capture.armed = false;
+
+    if (capture.busy)
+    {
+        capture.dropped++;
+        return;
+    }
+
+    // The window ends skip frames before the newest one.
+    uint32_t start = (capture.head + 2 * CAPTURE_HISTORY_FRAMES - skip - length) % CAPTURE_HISTORY_FRAMES;
+    uint32_t first = CAPTURE_HISTORY_FRAMES - start;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(&capture.snapshot[0], &capture.history[start], first * sizeof(capture_frame_t));
+    memcpy(&capture.snapshot[first], &capture.history[0], (length - first) * sizeof(capture_frame_t));
+
+    capture.header.magic = CAPTURE_MAGIC;
+    capture.header.sequence = capture.sequence++;
+    capture.header.timestamp = capture.timestamp;
+    capture.header.event = capture.event;
+    capture.header.pre = capture.pre;
+    capture.header.post = capture.post;
+    capture.header.frame_size = sizeof(capture_frame_t);
+
+    capture.busy = true;
+    xTaskNotifyGive(capture_task_handle);
+}
+
+bool application_capture_configure(uint32_t pre, uint32_t post)
+{
+    if ((post == 0) || (pre + post > CAPTURE_HISTORY_FRAMES) || capture.armed)
+    {
+        return false;
+    }
+
+    capture.pre = pre;
+    capture.post = post;
+
+    return true;
+}
+
+void application_capture_push(const imu_context_t *frames, uint32_t count, const mag_context_t *mag_context)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        capture_frame_t *frame = &capture.history[capture.head];
+
+        frame->sensortime = frames[i].sensortime;
+        frame->ax = frames[i].ax;
+        frame->ay = frames[i].ay;
+        frame->az = frames[i].az;
+        frame->gx = frames[i].gx;
+        frame->gy = frames[i].gy;
+        frame->gz = frames[i].gz;
+        frame->acc_range = frames[i].acc_range;
+        frame->gyr_range = frames[i].gyr_range;
+        frame->reserved = 0;
+        frame->mx = mag_context->mx;
+        frame->my = mag_context->my;
+        frame->mz = mag_context->mz;
+
+        capture.head = (capture.head + 1) % CAPTURE_HISTORY_FRAMES;
+        if (capture.filled < CAPTURE_HISTORY_FRAMES)
+        {
+            capture.filled++;
+        }
+
+        if (capture.armed && (--capture.remaining == 0))
+        {
+            capture_complete(0);
+        }
+    }
+}
+
+void application_capture_trigger(uint32_t event, uint64_t timestamp, uint32_t age)
+{
+    // The trigger frame is age frames before the newest one.  The window
+    // holds pre frames before it, then post frames starting with it.
+    // Events inside a capture in progress are part of it, and without
+    // enough history the pre-trigger window would be short.
+    if (capture.armed || (capture.filled < capture.pre + age + 1))
+    {
+        return;
+    }
+
+    capture.event = event;
+    capture.timestamp = timestamp;
+
+    if (age + 1 >= capture.post)
+    {
+        capture_complete(age + 1 - capture.post);
+    }
+    else
+    {
+        capture.armed = true;
+        capture.remaining = capture.post - age - 1;
+    }
+}
+
+static void capture_task(void *parameter)
+{
+    application_lfs_init();
+    capture.sequence = application_lfs_capture_sequence();
+    application_lfs_deinit();
+
+    capture.busy = false;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        application_lfs_init();
+        int32_t err = application_lfs_write_capture(&capture.header, capture.snapshot);
+        application_lfs_deinit();
+
+        am_util_stdio_printf("Capture %u stored: %d (%u dropped)\n",
+            capture.header.sequence, err, capture.dropped);
+
+        capture.busy = false;
+    }
+}
+
+void application_capture_task_create(uint32_t priority)
+{
+    capture.pre = CAPTURE_PRE_FRAMES;
+    capture.post = CAPTURE_POST_FRAMES;
+
+    // Captures are dropped until the writer knows the next sequence number.
+    capture.busy = true;
+
+    xTaskCreate(capture_task, "capture", 512, 0, priority, &capture_task_handle);
+}
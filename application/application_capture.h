@@ -0,0 +1,92 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _APPLICATION_CAPTURE_H_
+#define _APPLICATION_CAPTURE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "imu.h"
+#include "mag.h"
+
+// Frames of history kept, which bounds the pre-trigger plus post-trigger
+// window.
+#define CAPTURE_HISTORY_FRAMES      (256)
+#define CAPTURE_PRE_FRAMES          (64)
+#define CAPTURE_POST_FRAMES         (128)
+
+// Captures are stored in CAPTURE_DIR and the oldest is overwritten once
+// there are CAPTURE_FILES_MAX of them.
+#define CAPTURE_DIR                 "captures"
+#define CAPTURE_FILES_MAX           (4)
+#define CAPTURE_MAGIC               (0x31504143)    // "CAP1"
+
+// What triggered a capture.
+#define CAPTURE_EVENT_SHOT          (1)
+
+/*
+ * One raw IMU frame with the magnetometer sample current when it was
+ * taken.  The IMU readings are left in LSBs at the range they were
+ * measured at.
+ */
+typedef struct capture_frame_s
+{
+    uint32_t sensortime;
+    int16_t ax, ay, az;
+    int16_t gx, gy, gz;
+    uint8_t acc_range;
+    uint8_t gyr_range;
+    uint16_t reserved;
+    float_t mx, my, mz;
+} capture_frame_t;
+
+/*
+ * A capture file is this header followed by pre + post frames, oldest
+ * first.  Frame pre is the one that triggered the capture.
+ */
+typedef struct capture_header_s
+{
+    uint32_t magic;
+    uint32_t sequence;
+    uint64_t timestamp;     // trigger frame, microseconds on the MCU timebase
+    uint32_t event;
+    uint16_t pre;
+    uint16_t post;
+    uint32_t frame_size;
+} capture_header_t;
+
+extern void application_capture_task_create(uint32_t priority);
+extern bool application_capture_configure(uint32_t pre, uint32_t post);
+extern void application_capture_push(const imu_context_t *frames, uint32_t count, const mag_context_t *mag_context);
+extern void application_capture_trigger(uint32_t event, uint64_t timestamp, uint32_t age);
+
+#endif
@@ -34,21 +34,59 @@
 
 #include "am_bsp.h"
 
+#include <FreeRTOS.h>
+#include <semphr.h>
+
 #include "lfs.h"
 #include "lfs_hal.h"
 
 #include "mag.h"
 
+#include "alg_matched_filter.h"
+
+#include "application_capture.h"
+
 #include "application_task.h"
 
+// The calibration is stored as this header followed by a mag_cal_t.
+// Files without it hold the first, min/max only, layout.
+#define CAL_MAGIC       (0x4c41434d)    // "MCAL"
+#define CAL_VERSION     (2)
+
+typedef struct application_lfs_cal_s
+{
+    uint32_t magic;
+    uint32_t version;
+} application_lfs_cal_t;
+
+// Matched filter templates are stored one per file in TEMPLATE_DIR as a
+// header followed by length float32_t samples.
+#define TEMPLATE_DIR    "templates"
+#define TEMPLATE_MAGIC  (0x3154464d)    // "MFT1"
+
+typedef struct application_lfs_template_s
+{
+    uint32_t magic;
+    uint32_t id;
+    uint32_t length;
+    float32_t threshold;
+} application_lfs_template_t;
+
 #define CACHE_SIZE      16
 #define LOOKAHEAD_SIZE  16
 
-// LoRaWAN and BLE each use 2 pages
-#define LFS_NUM_PAGES   (4)
+// LoRaWAN and BLE each use 2 pages.  The linker scripts end the image
+// below LFS_START_PAGE, keep them in step.
+#define LFS_NUM_PAGES   (16)
 #define LFS_START_PAGE  ((AM_HAL_FLASH_INSTANCE_PAGES - 1) - 2 - 2 - LFS_NUM_PAGES)
 
+// Earlier releases used the top 4 of these pages.  Its calibration is
+// carried over when the larger file system is first formatted.
+#define LFS_LEGACY_NUM_PAGES    (4)
+#define LFS_LEGACY_START_PAGE   ((AM_HAL_FLASH_INSTANCE_PAGES - 1) - 2 - 2 - LFS_LEGACY_NUM_PAGES)
+
 static lfs_t lfs;
+static SemaphoreHandle_t lfs_mutex;
 static uint8_t lfs_read_buffer[CACHE_SIZE];
 static uint8_t lfs_prog_buffer[CACHE_SIZE];
 static uint8_t lfs_lookahead_buffer[LOOKAHEAD_SIZE];
@@ -71,34 +109,255 @@ const struct lfs_config cfg = {
     .lookahead_buffer = lfs_lookahead_buffer,
 };
 
+static const struct lfs_config cfg_legacy = {
+    .context = (void *)LFS_LEGACY_START_PAGE,
+    .read = littlefs_hal_read,
+    .prog = littlefs_hal_prog,
+    .erase = littlefs_hal_erase,
+    .sync = littlefs_hal_sync,
+    .read_size = 4,
+    .prog_size = 4,
+    .block_size = AM_HAL_FLASH_PAGE_SIZE,
+    .block_count = LFS_LEGACY_NUM_PAGES,
+    .cache_size = CACHE_SIZE,
+    .lookahead_size = LOOKAHEAD_SIZE,
+    .block_cycles = 500,
+    .read_buffer = lfs_read_buffer,
+    .prog_buffer = lfs_prog_buffer,
+    .lookahead_buffer = lfs_lookahead_buffer,
+};
+
+void application_lfs_setup(void)
+{
+    lfs_mutex = xSemaphoreCreateMutex();
+}
+
+// Formats the file system.  The calibration file of the legacy file system
+// is copied as is, before the format can overwrite it, and is converted
+// when it is loaded.  Anything else stored there is lost.
+static void application_lfs_format(void)
+{
+    static uint8_t cal_data[sizeof(application_lfs_cal_t) + sizeof(mag_cal_t)];
+    lfs_ssize_t size = 0;
+    lfs_file_t file;
+
+    if (lfs_mount(&lfs, &cfg_legacy) == 0)
+    {
+        if (lfs_file_open(&lfs, &file, "cal_data", LFS_O_RDONLY) == 0)
+        {
+            size = lfs_file_read(&lfs, &file, cal_data, sizeof(cal_data));
+            lfs_file_close(&lfs, &file);
+        }
+        lfs_unmount(&lfs);
+    }
+
+    lfs_format(&lfs, &cfg);
+    lfs_mount(&lfs, &cfg);
+
+    if (size > 0)
+    {
+        lfs_file_open(&lfs, &file, "cal_data", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+        lfs_file_write(&lfs, &file, cal_data, size);
+        lfs_file_close(&lfs, &file);
+        am_util_stdio_printf("Calibration carried over to the new file system.\r\n");
+    }
+}
+
+// The file system is mounted by one task at a time, from init to deinit.
 void application_lfs_init(void)
 {
+    xSemaphoreTake(lfs_mutex, portMAX_DELAY);
+
     int err = lfs_mount(&lfs, &cfg);
     if (err) {
-        lfs_format(&lfs, &cfg);
-        lfs_mount(&lfs, &cfg);
+        application_lfs_format();
     }
 }
 
 void application_lfs_deinit(void)
 {
     lfs_unmount(&lfs);
+
+    xSemaphoreGive(lfs_mutex);
 }
 
 void application_lfs_load_cal(mag_cal_t *cal_data)
 {
+    application_lfs_cal_t header;
     lfs_file_t file;
 
-    lfs_file_open(&lfs, &file, "cal_data", LFS_O_RDWR | LFS_O_CREAT);
-    lfs_file_read(&lfs, &file, cal_data, sizeof(mag_cal_t));
+    if (lfs_file_open(&lfs, &file, "cal_data", LFS_O_RDONLY) < 0)
+    {
+        return;
+    }
+
+    lfs_soff_t size = lfs_file_size(&lfs, &file);
+    if ((size == (lfs_soff_t)(sizeof(header) + sizeof(mag_cal_t))) &&
+        (lfs_file_read(&lfs, &file, &header, sizeof(header)) == sizeof(header)) &&
+        (header.magic == CAL_MAGIC) &&
+        (header.version == CAL_VERSION))
+    {
+        lfs_file_read(&lfs, &file, cal_data, sizeof(mag_cal_t));
+    }
+    else if (size == (lfs_soff_t)MAG_CAL_V1_SIZE)
+    {
+        // The first layout was the bare min/max fields.
+        lfs_file_rewind(&lfs, &file);
+        if (lfs_file_read(&lfs, &file, cal_data, MAG_CAL_V1_SIZE) == MAG_CAL_V1_SIZE)
+        {
+            mag_cal_from_range(cal_data);
+        }
+    }
+
     lfs_file_close(&lfs, &file);
 }
 
 void application_lfs_write_cal(mag_cal_t *cal_data)
 {
+    application_lfs_cal_t header = {
+        .magic = CAL_MAGIC,
+        .version = CAL_VERSION,
+    };
     lfs_file_t file;
 
-    lfs_file_open(&lfs, &file, "cal_data", LFS_O_RDWR | LFS_O_CREAT);
+    lfs_file_open(&lfs, &file, "cal_data", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    lfs_file_write(&lfs, &file, &header, sizeof(header));
     lfs_file_write(&lfs, &file, cal_data, sizeof(mag_cal_t));
     lfs_file_close(&lfs, &file);
-}
\ No newline at end of file
+}
+
+int32_t application_lfs_load_templates(alg_matched_filter_t *bank)
+{
+    // Kept off the task stack.
+    static float32_t reference[ALG_MATCHED_FILTER_TEMPLATE_MAX];
+    static struct lfs_info info;
+    static char path[LFS_NAME_MAX + sizeof(TEMPLATE_DIR) + 1];
+    application_lfs_template_t header;
+    lfs_dir_t dir;
+    lfs_file_t file;
+    int32_t loaded = 0;
+
+    if (lfs_dir_open(&lfs, &dir, TEMPLATE_DIR) < 0)
+    {
+        return 0;
+    }
+
+    while (lfs_dir_read(&lfs, &dir, &info) > 0)
+    {
+        if (info.type != LFS_TYPE_REG)
+        {
+            continue;
+        }
+
+        am_util_stdio_sprintf(path, TEMPLATE_DIR "/%s", info.name);
+        if (lfs_file_open(&lfs, &file, path, LFS_O_RDONLY) < 0)
+        {
+            continue;
+        }
+
+        if ((lfs_file_read(&lfs, &file, &header, sizeof(header)) == sizeof(header)) &&
+            (header.magic == TEMPLATE_MAGIC) &&
+            (header.length <= ALG_MATCHED_FILTER_TEMPLATE_MAX) &&
+            (lfs_file_read(&lfs, &file, reference, header.length * sizeof(float32_t)) == (lfs_ssize_t)(header.length * sizeof(float32_t))) &&
+            (alg_matched_filter_add(bank, header.id, reference, header.length, header.threshold) == 0))
+        {
+            loaded++;
+        }
+
+        lfs_file_close(&lfs, &file);
+    }
+
+    lfs_dir_close(&lfs, &dir);
+
+    return loaded;
+}
+
+int32_t application_lfs_write_template(uint32_t id, const float32_t *reference, uint32_t length, float32_t threshold)
+{
+    application_lfs_template_t header = {
+        .magic = TEMPLATE_MAGIC,
+        .id = id,
+        .length = length,
+        .threshold = threshold,
+    };
+    char path[sizeof(TEMPLATE_DIR) + 12];
+    lfs_file_t file;
+    int err;
+
+    lfs_mkdir(&lfs, TEMPLATE_DIR);
+
+    am_util_stdio_sprintf(path, TEMPLATE_DIR "/%u", id);
+    err = lfs_file_open(&lfs, &file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    if (err < 0)
+    {
+        return err;
+    }
+
+    lfs_file_write(&lfs, &file, &header, sizeof(header));
+    lfs_file_write(&lfs, &file, reference, length * sizeof(float32_t));
+
+    return lfs_file_close(&lfs, &file);
+}
+
+uint32_t application_lfs_capture_sequence(void)
+{
+    static struct lfs_info info;
+    static char path[LFS_NAME_MAX + sizeof(CAPTURE_DIR) + 1];
+    capture_header_t header;
+    lfs_dir_t dir;
+    lfs_file_t file;
+    uint32_t sequence = 0;
+
+    if (lfs_dir_open(&lfs, &dir, CAPTURE_DIR) < 0)
+    {
+        return 0;
+    }
+
+    while (lfs_dir_read(&lfs, &dir, &info) > 0)
+    {
+        if (info.type != LFS_TYPE_REG)
+        {
+            continue;
+        }
+
+        am_util_stdio_sprintf(path, CAPTURE_DIR "/%s", info.name);
+        if (lfs_file_open(&lfs, &file, path, LFS_O_RDONLY) < 0)
+        {
+            continue;
+        }
+
+        if ((lfs_file_read(&lfs, &file, &header, sizeof(header)) == sizeof(header)) &&
+            (header.magic == CAPTURE_MAGIC) &&
+            (header.sequence >= sequence))
+        {
+            sequence = header.sequence + 1;
+        }
+
+        lfs_file_close(&lfs, &file);
+    }
+
+    lfs_dir_close(&lfs, &dir);
+
+    return sequence;
+}
+
+int32_t application_lfs_write_capture(const capture_header_t *header, const capture_frame_t *frames)
+{
+    char path[sizeof(CAPTURE_DIR) + 12];
+    lfs_file_t file;
+    int err;
+
+    lfs_mkdir(&lfs, CAPTURE_DIR);
+
+    am_util_stdio_sprintf(path, CAPTURE_DIR "/%u", header->sequence % CAPTURE_FILES_MAX);
+    err = lfs_file_open(&lfs, &file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    if (err < 0)
+    {
+        return err;
+    }
+
+    lfs_file_write(&lfs, &file, header, sizeof(capture_header_t));
+    lfs_file_write(&lfs, &file, frames, (header->pre + header->post) * sizeof(capture_frame_t));
+
+    return lfs_file_close(&lfs, &file);
+}
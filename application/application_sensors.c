@@ -39,29 +39,122 @@
 
 #include "am_bsp.h"
 
+#include "sensors_config.h"
+#include "profile.h"
+
 #include "imu.h"
 #include "mag.h"
+#include "mag_fit.h"
+#include "sampling_profile.h"
+#include "sensor_time.h"
 
 #include "application.h"
 #include "application_task.h"
+#include "application_trace.h"
 
 /*
  * We use a hardware timer to minimize OS timer latency.  This is
  * useful for algorithms that are sensitive to clock jitter.
- * 
- * Configure for 100Hz sampling rate
- * Clock Source: HFRC 12kHz
- * Clock Period: 1 / 12e3 = 83us
+ *
+ * The timer runs from the fastest HFRC division whose count for the
+ * sampling period fits the 16 bit segment, so that the profile periods
+ * are whole numbers of ticks:
+ *   625us (burst): 12MHz, 7500 ticks
+ *   10ms (normal): 3MHz, 30000 ticks
+ *   40ms (idle): 187.5kHz, 7500 ticks
  */
-#define SAMPLING_CLK                AM_HAL_CTIMER_HFRC_12KHZ
 #define SAMPLING_TIMER_NUM          2
 #define SAMPLING_TIMER_SEG          AM_HAL_CTIMER_TIMERA
 #define SAMPLING_TIMER_INT          AM_HAL_CTIMER_INT_TIMERA2C0
-#define SAMPLING_CLOCK_PERIOD_US    (83)
+#define SAMPLING_TIMER_MAX_TICKS    (0xFFFF)
+#define SAMPLING_CLOCK_SOURCE_HZ    (48000000)
 
 static struct bmi2_dev bmi270_handle;
 static struct bmm350_dev bmm350_handle;
 
+typedef struct sensors_profile_s
+{
+    imu_rate_t imu;
+    enum bmm350_data_rates mag_odr;
+    enum bmm350_performance_parameters mag_avg;
+    uint32_t mag_period_us;
+    uint32_t sampling_period_us;    // timer acquisition
+    uint16_t watermark_frames;      // FIFO acquisition
+} sensors_profile_t;
+
+/*
+ * The idle profile keeps the accelerometer in its low power mode at 50Hz,
+ * the lowest rate at which the feature engine still runs the motion
+ * detectors, and reads it at 25Hz.  The normal profile matches the
+ * configuration applied by imu_setup() and mag_setup().  Its sampling
+ * period is the one passed to application_setup_sensors().  The burst
+ * profile runs both sensors at their fastest rates to capture high-g
+ * transients.
+ */
+static sensors_profile_t sensors_profiles[SAMPLING_PROFILE_COUNT] = {
+    [SAMPLING_PROFILE_IDLE] = {
+        .imu = { BMI2_ACC_ODR_50HZ, BMI2_ACC_NORMAL_AVG4, BMI2_GYR_NORMAL_MODE, BMI2_POWER_OPT_MODE },
+        .mag_odr = BMM350_DATA_RATE_25HZ,
+        .mag_avg = BMM350_AVERAGING_2,
+        .mag_period_us = 40000,
+        .sampling_period_us = 40000,
+        .watermark_frames = 25,
+    },
+    [SAMPLING_PROFILE_NORMAL] = {
+        .imu = { BMI2_ACC_ODR_400HZ, BMI2_ACC_NORMAL_AVG4, BMI2_GYR_NORMAL_MODE, BMI2_PERF_OPT_MODE },
+        .mag_odr = BMM350_DATA_RATE_100HZ,
+        .mag_avg = BMM350_AVERAGING_4,
+        .mag_period_us = MAG_ODR_PERIOD_US,
+        .sampling_period_us = 10000,
+        .watermark_frames = SENSORS_FIFO_WATERMARK_FRAMES,
+    },
+    [SAMPLING_PROFILE_BURST] = {
+        .imu = { BMI2_ACC_ODR_1600HZ, BMI2_ACC_NORMAL_AVG4, BMI2_GYR_NORMAL_MODE, BMI2_PERF_OPT_MODE },
+        .mag_odr = BMM350_DATA_RATE_400HZ,
+        .mag_avg = BMM350_NO_AVERAGING,
+        .mag_period_us = 2500,
+        .sampling_period_us = 625,
+        .watermark_frames = 16,
+    },
+};
+
+static sampling_profile_t sampling_profile;
+
+#if SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_TIMER
+typedef struct sampling_clock_s
+{
+    uint32_t clock;
+    uint32_t divider;
+} sampling_clock_t;
+
+static const sampling_clock_t sampling_clocks[] = {
+    { AM_HAL_CTIMER_HFRC_12MHZ, 4 },
+    { AM_HAL_CTIMER_HFRC_3MHZ, 16 },
+    { AM_HAL_CTIMER_HFRC_187_5KHZ, 256 },
+    { AM_HAL_CTIMER_HFRC_47KHZ, 1024 },
+    { AM_HAL_CTIMER_HFRC_12KHZ, 4096 },
+};
+
+// Sampling period the timer actually runs at.
+static uint32_t sampling_period_us;
+#endif
+
+#if SENSORS_MAG_ACQUISITION_MODE == SENSORS_MAG_ACQUISITION_POLLED
+// With timer acquisition the magnetometer is read on every n-th tick so
+// that it is not polled faster than its ODR.
+static uint32_t mag_poll_ticks = 1;
+static uint32_t mag_poll_count;
+#endif
+
+#if SENSORS_MAG_AUTOCAL
+static mag_fit_t mag_fit;
+#endif
+
+static profile_t profile_sensors_read = { .name = "sensors_read" };
+static profile_t profile_imu_burst = { .name = "imu_burst" };
+static profile_t profile_imu_bosch = { .name = "imu_bosch" };
+
+#if SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_TIMER
 static void sensor_sample_trigger(void)
 {
     // To avoid potential bus contention, we perform the sensor data read in the
@@ -69,53 +162,98 @@ static void sensor_sample_trigger(void)
     application_msg_t message = { .message = APP_MSG_SAMPLING_TRIGGER, .size = 0, .payload = NULL };
     application_send_message(&message);
 }
+#endif
 
-static void sensor_int1_handler()
+#if SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_FIFO
+static void sensor_fifo_watermark_handler(void)
+{
+    // The FIFO is drained in the application task as the read needs the
+    // SPI bus.  A single message covers every frame buffered since the
+    // last watermark.
+    application_msg_t message = { .message = APP_MSG_SAMPLING_WATERMARK, .size = 0, .payload = NULL };
+    application_send_message(&message);
+}
+#endif
+
+#if SENSORS_MAG_ACQUISITION_MODE == SENSORS_MAG_ACQUISITION_DRDY
+static void sensor_mag_drdy_handler(void)
 {
-    uint32_t state;
-    application_msg_t message = { 0 };
+    application_msg_t message = { .message = APP_MSG_MAG_DRDY, .size = 0, .payload = NULL };
+    application_send_message(&message);
+}
+#endif
 
-    // The IMU is configured to generate an interrupt when there is no motion.
-    // We stop sampling when there is no motion and resume when motion is detected.
-    // 
+static void sensor_int1_handler()
+{
+    // The IMU raises INT1 on no motion, any motion and significant motion.
+    // The source is read back in the application task as it requires a
+    // bus transfer.
+    //
     // See imu.c for configuration details.
-    am_hal_gpio_state_read(AM_BSP_GPIO_IMU_INT1, AM_HAL_GPIO_INPUT_READ, &state);
-    if (state)
+    application_msg_t message = { .message = APP_MSG_MOTION_EVENT, .size = 0, .payload = NULL };
+    application_send_message(&message);
+}
+
+#if SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_TIMER
+static void application_sensors_sampling_clock_period(uint32_t period_us)
+{
+    const uint32_t clocks = sizeof(sampling_clocks) / sizeof(sampling_clocks[0]);
+    const sampling_clock_t *sampling_clock = &sampling_clocks[0];
+    uint64_t tick_scale = 0;
+    uint32_t sampling_period_tick = 0;
+
+    // Round up so that the timer never fires faster than requested.  At
+    // the burst rate a truncated period is shorter than the IMU ODR period
+    // and the same sample would be read twice.
+    for (uint32_t i = 0; i < clocks; i++)
     {
-        message.message = APP_MSG_SAMPLING_START;
+        sampling_clock = &sampling_clocks[i];
+        tick_scale = (uint64_t)sampling_clock->divider * 1000000;
+        sampling_period_tick =
+            (uint32_t)(((uint64_t)period_us * SAMPLING_CLOCK_SOURCE_HZ + tick_scale - 1) / tick_scale);
+        if (sampling_period_tick <= SAMPLING_TIMER_MAX_TICKS)
+        {
+            break;
+        }
     }
-    else
+    if (sampling_period_tick > SAMPLING_TIMER_MAX_TICKS)
     {
-        message.message = APP_MSG_SAMPLING_STOP;
+        sampling_period_tick = SAMPLING_TIMER_MAX_TICKS;
     }
-    application_send_message(&message);
-}
 
+    // The sensor timebases are started at the period the timer runs at so
+    // that skipped samples are counted against the real tick.
+    sampling_period_us = (uint32_t)(((uint64_t)sampling_period_tick * tick_scale) / SAMPLING_CLOCK_SOURCE_HZ);
 
-static void application_setup_sensors_sampling_clock(uint32_t sampling_period_ms)
-{
     am_hal_ctimer_config_single(
         SAMPLING_TIMER_NUM,
         SAMPLING_TIMER_SEG,
         AM_HAL_CTIMER_FN_PWM_REPEAT |
         AM_HAL_CTIMER_INT_ENABLE |
-        SAMPLING_CLK
+        sampling_clock->clock
     );
 
-    uint32_t sampling_period_tick = sampling_period_ms * 1000 / SAMPLING_CLOCK_PERIOD_US;
-
     am_hal_ctimer_period_set(
         SAMPLING_TIMER_NUM,
         SAMPLING_TIMER_SEG,
         sampling_period_tick, 1);
+}
+
+static void application_setup_sensors_sampling_clock(uint32_t period_us)
+{
+    application_sensors_sampling_clock_period(period_us);
 
     am_hal_ctimer_int_register(SAMPLING_TIMER_INT, sensor_sample_trigger);
     am_hal_ctimer_int_enable(SAMPLING_TIMER_INT);
     NVIC_EnableIRQ(CTIMER_IRQn);
 }
+#endif
 
 void application_setup_sensors(uint32_t sampling_period_ms)
 {
+    sensors_profiles[SAMPLING_PROFILE_NORMAL].sampling_period_us = sampling_period_ms * 1000;
+    sampling_profile_init(&sampling_profile, SAMPLING_PROFILE_NORMAL, SENSORS_PROFILE_BURST_HOLD_MS * 1000);
+
     imu_status_t imu_status = imu_setup(&bmi270_handle);
     mag_status_t mag_status = mag_setup(&bmm350_handle);
     if (imu_status || mag_status)
@@ -125,33 +263,350 @@ void application_setup_sensors(uint32_t sampling_period_ms)
     }
 
     imu_int1_register(&bmi270_handle, sensor_int1_handler);
-    application_setup_sensors_sampling_clock(sampling_period_ms);
+
+#if SENSORS_MAG_AUTOCAL
+    mag_fit_init(&mag_fit);
+#endif
+
+    profile_setup();
+    profile_register(&profile_sensors_read);
+    profile_register(&profile_imu_burst);
+    profile_register(&profile_imu_bosch);
+
+#if SENSORS_MAG_ACQUISITION_MODE == SENSORS_MAG_ACQUISITION_DRDY
+    if (mag_drdy_setup(&bmm350_handle))
+    {
+        am_util_stdio_printf("\r\nMagnetometer interrupt initialization failed.\r\n");
+        vTaskSuspend(xTaskGetCurrentTaskHandle());
+    }
+    mag_drdy_register(&bmm350_handle, sensor_mag_drdy_handler);
+#endif
+
+#if SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_FIFO
+    if (imu_fifo_setup(&bmi270_handle, SENSORS_FIFO_WATERMARK_FRAMES))
+    {
+        am_util_stdio_printf("\r\nIMU FIFO initialization failed.\r\n");
+        vTaskSuspend(xTaskGetCurrentTaskHandle());
+    }
+    imu_int2_register(&bmi270_handle, sensor_fifo_watermark_handler);
+#else
+    application_setup_sensors_sampling_clock(sensors_profiles[SAMPLING_PROFILE_NORMAL].sampling_period_us);
+#endif
 }
 
-void application_sensors_read(imu_context_t *imu_context, mag_context_t *mag_context, mag_cal_t *mag_cal)
+static void application_sensors_mag_start(const sensors_profile_t *profile)
+{
+#if SENSORS_MAG_ACQUISITION_MODE == SENSORS_MAG_ACQUISITION_DRDY
+    mag_timebase_start(&bmm350_handle, profile->mag_period_us);
+    mag_drdy_enable(&bmm350_handle);
+#elif SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_FIFO
+    mag_timebase_start(&bmm350_handle, profile->watermark_frames * imu_odr_period_us(profile->imu.odr));
+#else
+    mag_poll_ticks = (profile->mag_period_us + sampling_period_us - 1) / sampling_period_us;
+    if (mag_poll_ticks == 0)
+    {
+        mag_poll_ticks = 1;
+    }
+    mag_poll_count = 0;
+    mag_timebase_start(&bmm350_handle, mag_poll_ticks * sampling_period_us);
+#endif
+}
+
+static void application_sensors_profile_apply(void)
+{
+    const sensors_profile_t *profile = &sensors_profiles[sampling_profile.current];
+
+#if SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_FIFO
+    // The IMU keeps filling the FIFO through the change.  imu_set_rate()
+    // marks the rate boundary so the frames already buffered, such as the
+    // onset of the transient that asked for a burst, are read out at the
+    // next watermark and stamped at the period they were sampled at.
+#if SENSORS_MAG_ACQUISITION_MODE == SENSORS_MAG_ACQUISITION_DRDY
+    mag_drdy_disable(&bmm350_handle);
+#endif
+
+    imu_set_rate(&bmi270_handle, &profile->imu);
+    mag_set_rate(&bmm350_handle, profile->mag_odr, profile->mag_avg);
+    imu_fifo_set_watermark(&bmi270_handle, profile->watermark_frames);
+
+    application_sensors_mag_start(profile);
+#else
+    // Sampling is paused while the rates change so that no sample is
+    // stamped against the wrong period.
+    application_sensors_stop();
+
+    imu_set_rate(&bmi270_handle, &profile->imu);
+    mag_set_rate(&bmm350_handle, profile->mag_odr, profile->mag_avg);
+    application_sensors_sampling_clock_period(profile->sampling_period_us);
+
+    application_sensors_start();
+#endif
+
+    am_util_stdio_printf("Sampling profile: %s\r\n", sampling_profile_name(sampling_profile.current));
+}
+
+void application_sensors_motion_event(void)
+{
+    uint8_t status;
+    uint32_t events = 0;
+
+    if (imu_int1_status(&bmi270_handle, &status) != IMU_STATUS_OK)
+    {
+        return;
+    }
+
+    if (status & IMU_INT1_NO_MOTION)
+    {
+        events |= SAMPLING_EVENT_NO_MOTION;
+    }
+    if (status & IMU_INT1_ANY_MOTION)
+    {
+        events |= SAMPLING_EVENT_ANY_MOTION;
+    }
+    if (status & IMU_INT1_SIG_MOTION)
+    {
+        events |= SAMPLING_EVENT_SIG_MOTION;
+    }
+
+    if (sampling_profile_event(&sampling_profile, events, sensor_time_mcu_us()))
+    {
+        application_sensors_profile_apply();
+    }
+}
+
+void application_sensors_request_burst(uint32_t requester, bool active)
+{
+    if (sampling_profile_request(&sampling_profile, requester, active, sensor_time_mcu_us()))
+    {
+        application_sensors_profile_apply();
+    }
+}
+
+void application_sensors_hold_normal(bool hold)
+{
+    sampling_profile_id_t floor = hold ? SAMPLING_PROFILE_NORMAL : SAMPLING_PROFILE_IDLE;
+
+    if (sampling_profile_set_floor(&sampling_profile, floor, sensor_time_mcu_us()))
+    {
+        application_sensors_profile_apply();
+    }
+}
+
+static void application_sensors_update_profile(void)
+{
+    if (sampling_profile_update(&sampling_profile, sensor_time_mcu_us()))
+    {
+        application_sensors_profile_apply();
+    }
+}
+
+static void application_sensors_apply_cal(mag_context_t *mag_context, mag_cal_t *mag_cal)
 {
-    imu_sample(&bmi270_handle, imu_context);
-    mag_sample(&bmm350_handle, mag_context);
     if (mag_cal)
     {
+#if SENSORS_MAG_AUTOCAL
+        // The fit sees the raw sample.  A new solution takes effect from
+        // this sample on and the application is told so that it can be
+        // saved.
+        if (mag_fit_step(&mag_fit, mag_context) &&
+            (mag_fit.samples % SENSORS_MAG_AUTOCAL_SOLVE_SAMPLES == 0) &&
+            mag_fit_solve(&mag_fit, mag_cal))
+        {
+            application_msg_t message = { .message = APP_MSG_MAG_CAL_UPDATED, .size = 0, .payload = NULL };
+
+            mag_cal->initialised = 1;
+            application_send_message(&message);
+        }
+#endif
+
         if (mag_cal->initialised)
         {
-            mag_context->mx -= mag_cal->ox;
-            mag_context->my -= mag_cal->oy;
-            mag_context->mz -= mag_cal->oz;
-            mag_context->mx *= mag_cal->sx;
-            mag_context->my *= mag_cal->sy;
-            mag_context->mz *= mag_cal->sz;
+#if SENSORS_TRACE
+            application_trace_cal(mag_cal);
+#endif
+            mag_cal_apply(mag_cal, mag_context);
         }
     }
 }
 
+bool application_sensors_read(imu_context_t *imu_context, mag_context_t *mag_context, mag_cal_t *mag_cal)
+{
+    bool mag_read = false;
+
+#if SENSORS_MAG_ACQUISITION_MODE == SENSORS_MAG_ACQUISITION_DRDY
+    // The magnetometer is read on its own data ready interrupt.
+    profile_start(&profile_sensors_read);
+    imu_sample(&bmi270_handle, imu_context);
+    profile_stop(&profile_sensors_read);
+#if SENSORS_TRACE
+    application_trace_imu(imu_context, 1);
+#endif
+#else
+    // The IMU and the magnetometer sit on separate IOM modules so both
+    // transfers are started before waiting on either.  The read then takes
+    // as long as the slower of the two rather than their sum.
+    bool mag_due = (++mag_poll_count >= mag_poll_ticks);
+    mag_status_t mag_status = MAG_STATUS_ERROR;
+
+    profile_start(&profile_sensors_read);
+    imu_status_t imu_status = imu_sample_start(&bmi270_handle);
+    if (mag_due)
+    {
+        mag_poll_count = 0;
+        mag_status = mag_sample_start(&bmm350_handle);
+    }
+
+    if (imu_status == IMU_STATUS_OK)
+    {
+        imu_sample_finish(&bmi270_handle, imu_context);
+    }
+    if (mag_status == MAG_STATUS_OK)
+    {
+        mag_status = mag_sample_finish(&bmm350_handle, mag_context);
+    }
+    profile_stop(&profile_sensors_read);
+
+#if SENSORS_TRACE
+    application_trace_imu(imu_context, 1);
+    if (mag_status == MAG_STATUS_OK)
+    {
+        application_trace_mag(mag_context);
+    }
+#endif
+    // A failed read leaves the previous, already corrected, sample in the
+    // context.  It must not be fitted or corrected a second time.
+    if (mag_status == MAG_STATUS_OK)
+    {
+        application_sensors_apply_cal(mag_context, mag_cal);
+        mag_read = true;
+    }
+#endif
+
+#if SENSORS_ACC_AUTORANGE
+    imu_autorange(&bmi270_handle, imu_context, 1);
+#endif
+
+    application_sensors_update_profile();
+
+    return mag_read;
+}
+
+uint32_t application_sensors_read_fifo(imu_context_t *imu_frames, uint32_t max_frames, mag_context_t *mag_context, mag_cal_t *mag_cal, bool *mag_read)
+{
+    *mag_read = false;
+
+#if SENSORS_MAG_ACQUISITION_MODE == SENSORS_MAG_ACQUISITION_DRDY
+    profile_start(&profile_sensors_read);
+    uint32_t count = imu_fifo_read(&bmi270_handle, imu_frames, max_frames);
+    profile_stop(&profile_sensors_read);
+#if SENSORS_TRACE
+    application_trace_imu(imu_frames, count);
+#endif
+#else
+    // The magnetometer runs at 100Hz so one sample per drain is sufficient.
+    // Its transfer runs on IOM1 while the FIFO is drained on IOM0.
+    profile_start(&profile_sensors_read);
+    mag_status_t mag_status = mag_sample_start(&bmm350_handle);
+
+    uint32_t count = imu_fifo_read(&bmi270_handle, imu_frames, max_frames);
+
+    if (mag_status == MAG_STATUS_OK)
+    {
+        mag_status = mag_sample_finish(&bmm350_handle, mag_context);
+    }
+    profile_stop(&profile_sensors_read);
+#if SENSORS_TRACE
+    application_trace_imu(imu_frames, count);
+    if (mag_status == MAG_STATUS_OK)
+    {
+        application_trace_mag(mag_context);
+    }
+#endif
+    if (mag_status == MAG_STATUS_OK)
+    {
+        application_sensors_apply_cal(mag_context, mag_cal);
+        *mag_read = true;
+    }
+#endif
+
+#if SENSORS_ACC_AUTORANGE
+    imu_autorange(&bmi270_handle, imu_frames, count);
+#endif
+
+    application_sensors_update_profile();
+
+    return count;
+}
+
+bool application_sensors_read_mag(mag_context_t *mag_context, mag_cal_t *mag_cal)
+{
+    if (mag_sample(&bmm350_handle, mag_context) != MAG_STATUS_OK)
+    {
+        return false;
+    }
+#if SENSORS_TRACE
+    application_trace_mag(mag_context);
+#endif
+    application_sensors_apply_cal(mag_context, mag_cal);
+
+    return true;
+}
+
+/*
+ * Compares the single burst IMU read against the generic Bosch read path.
+ * Sampling is paused so that both paths see the same bus conditions.  The
+ * results are reported by the "app profile" command.
+ */
+void application_sensors_benchmark(uint32_t samples)
+{
+    imu_context_t imu_context;
+
+    application_sensors_stop();
+
+    profile_reset(&profile_imu_burst);
+    profile_reset(&profile_imu_bosch);
+
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        profile_start(&profile_imu_burst);
+        imu_sample(&bmi270_handle, &imu_context);
+        profile_stop(&profile_imu_burst);
+
+        profile_start(&profile_imu_bosch);
+        imu_sample_reference(&bmi270_handle, &imu_context);
+        profile_stop(&profile_imu_bosch);
+    }
+
+    application_sensors_start();
+}
+
 void application_sensors_start()
 {
+    const sensors_profile_t *profile = &sensors_profiles[sampling_profile.current];
+
+    application_sensors_mag_start(profile);
+
+#if SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_FIFO
+    // Discard frames buffered while sampling was paused so that the first
+    // batch after a restart is contiguous.
+    imu_fifo_flush(&bmi270_handle);
+    imu_int2_enable(&bmi270_handle);
+#else
+    // The sensor clocks may have wrapped while sampling was paused.
+    imu_timebase_start(&bmi270_handle, sampling_period_us);
     am_hal_ctimer_start(SAMPLING_TIMER_NUM, SAMPLING_TIMER_SEG);
+#endif
 }
 
 void application_sensors_stop()
 {
+#if SENSORS_MAG_ACQUISITION_MODE == SENSORS_MAG_ACQUISITION_DRDY
+    mag_drdy_disable(&bmm350_handle);
+#endif
+
+#if SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_FIFO
+    imu_int2_disable(&bmi270_handle);
+#else
     am_hal_ctimer_stop(SAMPLING_TIMER_NUM, SAMPLING_TIMER_SEG);
+#endif
 }
\ No newline at end of file
@@ -50,7 +50,10 @@
 #include "ble.h"
 #endif
 
+#include "sensors_config.h"
+
 #include "imu.h"
+#include "imu_fifo_bench.h"
 #include "mag.h"
 
 #include "button.h"
@@ -62,6 +65,9 @@
 #define LED_BLINK_NORMAL    500
 #define LED_BLINK_QUICK      100
 
+// Algorithms that may request the burst sampling profile.
+#define SAMPLING_REQUEST_SHOTDETECT (1 << 0)
+
 typedef enum {
     APP_STATE_NORMAL,
     APP_STATE_CALIBRATION
@@ -77,22 +83,65 @@ static QueueHandle_t application_queue_handle;
 static TimerHandle_t application_timer_handle;
 
 static imu_context_t imu_context;
+static imu_context_t imu_frames[IMU_FIFO_MAX_FRAMES];
 static mag_context_t mag_context;
 static mag_cal_t mag_cal;
+static bool mag_cal_saved;
+static TickType_t mag_cal_saved_ticks;
 
-#define ALG_SHOTDETECT_SIGNAL_LENGTH    (32)
+#define ALG_SHOTDETECT_BATCH_SHOTS      (4)
+#ifdef ALG_SHOTDETECT_Q15
+static alg_shotdetect_q15_context_t alg_shotdetect_context;
+#else
 static alg_shotdetect_context_t alg_shotdetect_context;
-static float32_t shotdetect_signal_sampled[ALG_SHOTDETECT_SIGNAL_LENGTH];
-static float32_t shotdetect_signal_convolved[ALG_SHOTDETECT_SIGNAL_LENGTH*2];
-static float32_t shotdetect_signal_reference[ALG_SHOTDETECT_SIGNAL_LENGTH] = {
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 1.0f,
-    1.0f, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0
-};
+#endif
 
 static uint32_t application_shot_count;
 
+// Event classes are recognised by a bank of templates loaded from littlefs.
+// Windows with less variance than this, in (m/s^2)^2, are not scored.
+#define ALG_MATCHED_FILTER_MIN_VARIANCE (0.01f)
+#define ALG_MATCHED_FILTER_DETECTIONS   (4)
+static alg_matched_filter_t alg_matched_filter_bank;
+
+#if SENSORS_VIBRATION
+static alg_spectrum_t alg_spectrum;
+static alg_spectrum_summary_t alg_spectrum_result;
+#endif
+
+// Time aligned frames for the fusion algorithms.
+#define RESAMPLER_BATCH_FRAMES          (16)
+static resampler_t resampler;
+static resampler_frame_t resampled_frames[RESAMPLER_BATCH_FRAMES];
+static ahrs_t ahrs;
+
+// Streams at the rates the event algorithms were tuned for.
+static decimator_t decimator;
+
+
+// Runs the fusion algorithms on every aligned frame that is ready.
+static void application_resample_run(void)
+{
+    uint32_t count;
+
+    do
+    {
+        count = resampler_pull(&resampler, resampled_frames, RESAMPLER_BATCH_FRAMES);
+        application_alg_ahrs_update(resampled_frames, count, &ahrs);
+    } while (count == RESAMPLER_BATCH_FRAMES);
+}
+
+// Number of frames read after the one sampled at the timestamp.
+static uint32_t application_frame_age(const imu_context_t *frames, uint32_t count, uint64_t timestamp)
+{
+    uint64_t newest = frames[count - 1].timestamp;
+
+    if ((decimator.period_us == 0) || (timestamp >= newest))
+    {
+        return 0;
+    }
+    return (uint32_t)((newest - timestamp + decimator.period_us / 2) / decimator.period_us);
+}
 
 static void application_led_timer_callback(TimerHandle_t timer)
 {
@@ -122,6 +171,20 @@ static void application_toggle_always_on()
     am_util_stdio_printf("Sampling Always On: %d\r\n", sampling_always_on);
 }
 
+static void application_mag_cal_print(void)
+{
+    am_util_stdio_printf("Calibration State: %d (%s)\r\n", mag_cal.initialised,
+        mag_cal.source == MAG_CAL_SOURCE_ELLIPSOID ? "ellipsoid" : "min/max");
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        am_util_stdio_printf("  %7.4f %7.4f %7.4f  %7.2f\r\n",
+            (double)mag_cal.transform[i][0],
+            (double)mag_cal.transform[i][1],
+            (double)mag_cal.transform[i][2],
+            (double)mag_cal.transform[i][3]);
+    }
+}
+
 static void application_setup_task()
 {
     am_hal_gpio_pinconfig(AM_BSP_GPIO_LED0, g_AM_HAL_GPIO_OUTPUT);
@@ -153,20 +216,10 @@ static void application_setup_task()
 
     if (mag_cal.initialised == 0)
     {
-        mag_cal.ox = 0.0f;
-        mag_cal.oy = 0.0f;
-        mag_cal.oz = 0.0f;
-
-        mag_cal.sx = 1.0f;
-        mag_cal.sy = 1.0f;
-        mag_cal.sz = 1.0f;
+        mag_cal_reset(&mag_cal);
     }
 
-    am_util_stdio_printf("Calibration State: %d\r\n", mag_cal.initialised);
-    am_util_stdio_printf("Hard Iron Offsets: %4.2f, %4.2f, %4.2f\r\n",
-        (double)mag_cal.ox,
-        (double)mag_cal.oy,
-        (double)mag_cal.oz);
+    application_mag_cal_print();
 
     application_state = APP_STATE_NORMAL;
     sampling_always_on = 0;
@@ -181,18 +234,86 @@ static void application_setup_task()
     xTimerStart(application_timer_handle, portMAX_DELAY);
 }
 
-static void application_alg_shotdetect_setup(void)
+static void application_alg_matched_filter_setup(void)
+{
+    alg_matched_filter_init(&alg_matched_filter_bank, ALG_MATCHED_FILTER_MIN_VARIANCE);
+
+    application_lfs_init();
+    int32_t loaded = application_lfs_load_templates(&alg_matched_filter_bank);
+    application_lfs_deinit();
+
+    // The block follows the longest template.  Detections lag the event by
+    // up to a hop and a template length, at SENSORS_MATCHED_FILTER_RATE_HZ.
+    am_util_stdio_printf("Matched filter templates: %d, detections up to %u samples late\n", loaded,
+        alg_matched_filter_bank.hop + alg_matched_filter_bank.template_max);
+}
+
+static void application_alg_matched_filter_run(const imu_context_t *frames, uint32_t count)
+{
+    alg_matched_filter_detection_t detections[ALG_MATCHED_FILTER_DETECTIONS];
+
+    uint32_t detected = application_alg_matched_filter_block(
+        frames, count, &alg_matched_filter_bank, detections, ALG_MATCHED_FILTER_DETECTIONS);
+    for (uint32_t i = 0; (i < detected) && (i < ALG_MATCHED_FILTER_DETECTIONS); i++)
+    {
+        am_util_stdio_printf("Event %u detected at sample %u (score %u%%)\n",
+            detections[i].id, detections[i].position, (uint32_t)(detections[i].score * 100.0f));
+    }
+}
+
+static void application_alg_spectrum_run(const imu_context_t *frames, uint32_t count)
 {
-    alg_shotdetect_context.state = ALG_SHOTDETECT_IDLE;
-    alg_shotdetect_context.trigger_threshold = 1500;
-    alg_shotdetect_context.idle_threshold = 1000;
-    alg_shotdetect_context.sampled_signal = shotdetect_signal_sampled;
-    alg_shotdetect_context.convolved_signal = shotdetect_signal_convolved;
-    alg_shotdetect_context.reference_signal = shotdetect_signal_reference;
-    alg_shotdetect_context.signal_length = ALG_SHOTDETECT_SIGNAL_LENGTH;
-    alg_shotdetect_context.sampling_period_ms = 20;
-    arm_fill_f32(0.0f, alg_shotdetect_context.sampled_signal, alg_shotdetect_context.signal_length);
-    arm_fill_f32(0.0f, alg_shotdetect_context.convolved_signal, alg_shotdetect_context.signal_length);
+#if SENSORS_VIBRATION
+    if (application_alg_spectrum_block(frames, count, &alg_spectrum, &alg_spectrum_result))
+    {
+        application_alg_spectrum_show(&alg_spectrum_result);
+    }
+#endif
+}
+
+// Runs the event algorithms on the frames of the last read.  Frames are
+// processed as one block in the order they were sampled, at the rate each
+// algorithm asks for, whatever the sampling profile.
+static void application_alg_run(const imu_context_t *input, uint32_t count)
+{
+    decimator_push(&decimator, input, count);
+
+    const imu_context_t *frames;
+    uint32_t frames_count = decimator_output(&decimator, SENSORS_SHOTDETECT_RATE_HZ, &frames);
+
+    uint32_t shots[ALG_SHOTDETECT_BATCH_SHOTS];
+#ifdef ALG_SHOTDETECT_Q15
+    uint32_t detected = application_alg_shotdetect_q15_block(
+        frames, frames_count, &alg_shotdetect_context, shots, ALG_SHOTDETECT_BATCH_SHOTS);
+#else
+    uint32_t detected = application_alg_shotdetect_block(
+        frames, frames_count, &alg_shotdetect_context, shots, ALG_SHOTDETECT_BATCH_SHOTS);
+#endif
+    for (uint32_t i = 0; i < detected; i++)
+    {
+        application_shot_count++;
+        if (i < ALG_SHOTDETECT_BATCH_SHOTS)
+        {
+            am_util_stdio_printf("Shot Detected: %d (frame %u of %u)\n",
+                application_shot_count, shots[i], frames_count);
+            application_capture_trigger(CAPTURE_EVENT_SHOT, frames[shots[i]].timestamp,
+                application_frame_age(input, count, frames[shots[i]].timestamp));
+        }
+    }
+
+    frames_count = decimator_output(&decimator, SENSORS_MATCHED_FILTER_RATE_HZ, &frames);
+    application_alg_matched_filter_run(frames, frames_count);
+
+    frames_count = decimator_output(&decimator, SENSORS_VIBRATION_RATE_HZ, &frames);
+    application_alg_spectrum_run(frames, frames_count);
+
+    // Sample at the burst rate while the signal is above the idle level so
+    // that the whole shot is captured.
+    if (count)
+    {
+        application_sensors_request_burst(SAMPLING_REQUEST_SHOTDETECT,
+            alg_shotdetect_context.energy_transferred > alg_shotdetect_context.idle_threshold);
+    }
 }
 
 static void application_task(void *parameter)
@@ -209,7 +330,18 @@ static void application_task(void *parameter)
 
     application_setup_task();
 
-    application_alg_shotdetect_setup();
+#ifdef ALG_SHOTDETECT_Q15
+    application_alg_shotdetect_q15_setup(&alg_shotdetect_context);
+#else
+    application_alg_shotdetect_setup(&alg_shotdetect_context);
+#endif
+    application_alg_matched_filter_setup();
+#if SENSORS_VIBRATION
+    application_alg_spectrum_setup(&alg_spectrum);
+#endif
+    application_alg_ahrs_setup(&ahrs);
+    resampler_init(&resampler, SENSORS_RESAMPLE_RATE_HZ, SENSORS_RESAMPLE_MAG_MODE);
+    decimator_init(&decimator);
 
     // Set sampling rate to 100Hz
     // Period is 1 / 100Hz = 10ms
@@ -251,12 +383,22 @@ static void application_task(void *parameter)
             case APP_MSG_SAMPLING_TRIGGER:
                 if (application_state == APP_STATE_CALIBRATION)
                 {
-                    application_sensors_read(&imu_context, &mag_context, NULL);
-                    mag_calibrate_step(&mag_context, &mag_cal);
+                    if (application_sensors_read(&imu_context, &mag_context, NULL))
+                    {
+                        mag_calibrate_step(&mag_context, &mag_cal);
+                    }
                 }
                 else
                 {
-                    application_sensors_read(&imu_context, &mag_context, &mag_cal);
+                    bool mag_read = application_sensors_read(&imu_context, &mag_context, &mag_cal);
+                    application_capture_push(&imu_context, 1, &mag_context);
+                    resampler_push_imu(&resampler, &imu_context, 1);
+                    if (mag_read)
+                    {
+                        resampler_push_mag(&resampler, &mag_context);
+                    }
+                    application_resample_run();
+
                     // For each algorithm:
                         // Step 1: Re-map axes as required by the algorithm.  Aerospace
                         //   coordinates are usually in NED (North East Down) whereas
@@ -269,35 +411,82 @@ static void application_task(void *parameter)
                     //
                     // Avoid doing serial print here as it is SLOW and could potentially
                     // impact algorithms that are jitter sensitive.
+                    //
+                    // The sample rate follows the profile.  The algorithms
+                    // are fed through the decimator so that their windows
+                    // span the same time in the burst profile.
+                    application_alg_run(&imu_context, 1);
+                }
+                break;
+
+            case APP_MSG_SAMPLING_WATERMARK:
+                if (application_state == APP_STATE_CALIBRATION)
+                {
+                    bool mag_read;
 
-                    if (application_alg_shotdetect_step(&imu_context, &alg_shotdetect_context))
+                    application_sensors_read_fifo(imu_frames, IMU_FIFO_MAX_FRAMES, &mag_context, NULL, &mag_read);
+                    if (mag_read)
                     {
-                        application_shot_count++;
-                        am_util_stdio_printf("Shot Detected: %d\n", application_shot_count);
+                        mag_calibrate_step(&mag_context, &mag_cal);
+                    }
+                }
+                else
+                {
+                    bool mag_read;
+                    uint32_t count = application_sensors_read_fifo(imu_frames, IMU_FIFO_MAX_FRAMES, &mag_context, &mag_cal, &mag_read);
+                    application_capture_push(imu_frames, count, &mag_context);
+                    resampler_push_imu(&resampler, imu_frames, count);
+                    if (mag_read)
+                    {
+                        resampler_push_mag(&resampler, &mag_context);
+                    }
+                    application_resample_run();
+                    application_alg_run(imu_frames, count);
+
+                    if (count)
+                    {
+                        imu_context = imu_frames[count - 1];
                     }
                 }
                 break;
 
-            case APP_MSG_SAMPLING_START:
-                application_sensors_start();
-                if (sampling_always_on == 0)
+            case APP_MSG_MAG_DRDY:
+                if (application_state == APP_STATE_CALIBRATION)
+                {
+                    if (application_sensors_read_mag(&mag_context, NULL))
+                    {
+                        mag_calibrate_step(&mag_context, &mag_cal);
+                    }
+                }
+                else if (application_sensors_read_mag(&mag_context, &mag_cal))
                 {
-                    am_util_stdio_printf("Motion detected.  Sampling...\r\n");
+                    resampler_push_mag(&resampler, &mag_context);
+                    application_resample_run();
                 }
                 break;
 
-            case APP_MSG_SAMPLING_STOP:
-                // Keep sampling if we are calibrating. 
-                if ((application_state != APP_STATE_CALIBRATION) && (sampling_always_on == 0))
+            case APP_MSG_MOTION_EVENT:
+                // Keep the normal profile if we are calibrating.
+                application_sensors_hold_normal(
+                    (application_state == APP_STATE_CALIBRATION) || (sampling_always_on != 0));
+                application_sensors_motion_event();
+                break;
+
+            case APP_MSG_CAPTURE_CONFIGURE:
+                if (!application_capture_configure(message.size & 0xFFFF, message.size >> 16))
                 {
-                    application_sensors_stop();
-                    am_util_stdio_printf("No motion detected.  Sampling paused...\r\n");
+                    am_util_stdio_printf("Capture window not changed.\r\n");
                 }
                 break;
 
+            case APP_MSG_AHRS_SHOW:
+                application_alg_ahrs_show(&ahrs);
+                break;
+
             case APP_MSG_CALIBRATE_START:
                 application_state = APP_STATE_CALIBRATION;
                 memset(&mag_cal, 0, sizeof(mag_cal_t));
+                application_sensors_hold_normal(true);
 
                 am_util_stdio_printf("Calibration started.  Long press to exit when done.\r\n");
                 break;
@@ -308,14 +497,45 @@ static void application_task(void *parameter)
                 application_lfs_write_cal(&mag_cal);
                 application_lfs_deinit();
                 application_state = APP_STATE_NORMAL;
+                application_sensors_hold_normal(sampling_always_on != 0);
 
                 am_util_stdio_printf("Calibration completed.\r\n");
-                am_util_stdio_printf("Calibration State: %d\r\n", mag_cal.initialised);
-                am_util_stdio_printf("Hard Iron Offsets: %4.2f, %4.2f, %4.2f\r\n",
-                    (double)mag_cal.ox,
-                    (double)mag_cal.oy,
-                    (double)mag_cal.oz);
+                application_mag_cal_print();
                 break;
+
+            case APP_MSG_MAG_CAL_UPDATED:
+                // The online fit is refined continuously.  Limit how often
+                // it is written to flash.
+                if (!mag_cal_saved ||
+                    (xTaskGetTickCount() - mag_cal_saved_ticks >= pdMS_TO_TICKS(SENSORS_MAG_AUTOCAL_SAVE_MS)))
+                {
+                    application_lfs_init();
+                    application_lfs_write_cal(&mag_cal);
+                    application_lfs_deinit();
+                    mag_cal_saved = true;
+                    mag_cal_saved_ticks = xTaskGetTickCount();
+
+                    am_util_stdio_printf("Calibration updated.\r\n");
+                    application_mag_cal_print();
+                }
+                break;
+
+            case APP_MSG_SENSORS_BENCHMARK:
+                // The sample count is carried in the size field.
+                application_sensors_benchmark(message.size);
+                am_util_stdio_printf("Benchmark completed.  See app profile.\r\n");
+                break;
+
+#if SENSORS_FIFO_BENCH
+            case APP_MSG_FIFO_BENCHMARK:
+                // The iteration count is carried in the size field.  The
+                // cycle counter runs at the core clock.
+                if (imu_fifo_bench_report(message.size, AM_HAL_CLKGEN_FREQ_MAX_HZ))
+                {
+                    am_util_stdio_printf("FIFO extraction mismatch.\r\n");
+                }
+                break;
+#endif
             }
         }
     }
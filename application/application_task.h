@@ -34,20 +34,50 @@
 
 #include "imu.h"
 #include "mag.h"
+#include "ahrs.h"
+#include "resampler.h"
+#include "decimator.h"
 #include "alg_shotdetect.h"
+#include "alg_shotdetect_q15.h"
+#include "alg_matched_filter.h"
+#include "alg_spectrum.h"
+#include "application_capture.h"
 
 extern void application_task_create(uint32_t priority);
 extern void application_setup_sensors(uint32_t sampling_period_ms);
-extern void application_sensors_read(imu_context_t *imu_context, mag_context_t *mag_context, mag_cal_t *mag_cal);
+extern bool application_sensors_read(imu_context_t *imu_context, mag_context_t *mag_context, mag_cal_t *mag_cal);
+extern uint32_t application_sensors_read_fifo(imu_context_t *imu_frames, uint32_t max_frames, mag_context_t *mag_context, mag_cal_t *mag_cal, bool *mag_read);
+extern bool application_sensors_read_mag(mag_context_t *mag_context, mag_cal_t *mag_cal);
 extern void application_sensors_start(void);
 extern void application_sensors_stop(void);
+extern void application_sensors_motion_event(void);
+extern void application_sensors_request_burst(uint32_t requester, bool active);
+extern void application_sensors_hold_normal(bool hold);
+extern void application_sensors_benchmark(uint32_t samples);
 
+extern void application_alg_shotdetect_setup(alg_shotdetect_context_t *alg_shotdetect_context);
+extern void application_alg_shotdetect_q15_setup(alg_shotdetect_q15_context_t *alg_shotdetect_context);
 extern bool application_alg_shotdetect_step(imu_context_t *imu_context, alg_shotdetect_context_t *alg_shotdetect_context);
+extern uint32_t application_alg_shotdetect_block(const imu_context_t *frames, uint32_t count, alg_shotdetect_context_t *alg_shotdetect_context, uint32_t *shots, uint32_t max_shots);
+extern bool application_alg_shotdetect_q15_step(imu_context_t *imu_context, alg_shotdetect_q15_context_t *alg_shotdetect_context);
+extern uint32_t application_alg_shotdetect_q15_block(const imu_context_t *frames, uint32_t count, alg_shotdetect_q15_context_t *alg_shotdetect_context, uint32_t *shots, uint32_t max_shots);
+extern void application_alg_ahrs_setup(ahrs_t *ahrs);
+extern void application_alg_ahrs_update(const resampler_frame_t *frames, uint32_t count, ahrs_t *ahrs);
+extern void application_alg_ahrs_show(const ahrs_t *ahrs);
+extern uint32_t application_alg_matched_filter_block(const imu_context_t *frames, uint32_t count, alg_matched_filter_t *bank, alg_matched_filter_detection_t *detections, uint32_t max_detections);
+extern void application_alg_spectrum_setup(alg_spectrum_t *spectrum);
+extern bool application_alg_spectrum_block(const imu_context_t *frames, uint32_t count, alg_spectrum_t *spectrum, alg_spectrum_summary_t *summary);
+extern void application_alg_spectrum_show(const alg_spectrum_summary_t *summary);
 
+extern void application_lfs_setup(void);
 extern void application_lfs_init(void);
 extern void application_lfs_deinit(void);
 extern void application_lfs_load_cal(mag_cal_t *cal_data);
 extern void application_lfs_write_cal(mag_cal_t *cal_data);
+extern int32_t application_lfs_load_templates(alg_matched_filter_t *bank);
+extern int32_t application_lfs_write_template(uint32_t id, const float32_t *reference, uint32_t length, float32_t threshold);
+extern uint32_t application_lfs_capture_sequence(void);
+extern int32_t application_lfs_write_capture(const capture_header_t *header, const capture_frame_t *frames);
 
 #ifdef RAT_LORAWAN_ENABLE
 extern void application_setup_lorawan();
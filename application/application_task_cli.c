@@ -39,7 +39,12 @@
 #include <FreeRTOS_CLI.h>
 
 #include "ota_config.h"
+#include "sensors_config.h"
+#include "latency_probe.h"
+#include "profile.h"
+#include "application.h"
 #include "application_task_cli.h"
+#include "application_trace.h"
 
 static portBASE_TYPE application_task_cli_entry(char *pui8OutBuffer,
                                                 size_t ui32OutBufferLength,
@@ -68,6 +73,15 @@ static void help(char *pui8OutBuffer, size_t argc, char **argv)
     strcat(pui8OutBuffer, "supported commands are:\r\n");
     strcat(pui8OutBuffer, "  reset  perform a soft reset\r\n");
     strcat(pui8OutBuffer, "  ota    < |set|erase> manages the OTA descriptor\r\n");
+    strcat(pui8OutBuffer, "  profile < |reset> show or clear the cycle count probes\r\n");
+    strcat(pui8OutBuffer, "  latency < |start [us]|stop|reset> measures interrupt latency\r\n");
+    strcat(pui8OutBuffer, "  bench  [n] compares IMU read paths over n samples\r\n");
+#if SENSORS_FIFO_BENCH
+    strcat(pui8OutBuffer, "  bench  fifo [n] times n FIFO extractions per buffer\r\n");
+#endif
+    strcat(pui8OutBuffer, "  capture <pre> <post> sets the event capture window in frames\r\n");
+    strcat(pui8OutBuffer, "  trace  < |start|stop> streams raw sensor records over RTT\r\n");
+    strcat(pui8OutBuffer, "  ahrs   prints the current orientation\r\n");
 }
 
 static void ota(char *pui8OutBuffer, size_t argc, char **argv)
@@ -135,6 +149,136 @@ static void ota(char *pui8OutBuffer, size_t argc, char **argv)
     }
 }
 
+static void profile(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    if (argc == 3 && strcmp(argv[2], "reset") == 0)
+    {
+        profile_reset_all();
+        strcat(pui8OutBuffer, "\r\nProfile probes cleared.\r\n");
+        return;
+    }
+
+    strcat(pui8OutBuffer, "\r\n");
+    for (uint32_t i = 0; i < profile_probe_count(); i++)
+    {
+        profile_t *probe = profile_probe_get(i);
+        uint32_t avg = probe->count ? (uint32_t)(probe->total / probe->count) : 0;
+        uint32_t min = probe->count ? probe->min : 0;
+
+        char *buffer = pui8OutBuffer + strlen(pui8OutBuffer);
+        am_util_stdio_sprintf(buffer, "%s: count %u avg %u min %u max %u cycles\r\n",
+            probe->name, probe->count, avg, min, probe->max);
+    }
+}
+
+static void latency(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    if (argc >= 3)
+    {
+        if (strcmp(argv[2], "start") == 0)
+        {
+            uint32_t period_us = 1000;
+            if (argc == 4)
+            {
+                period_us = strtol(argv[3], NULL, 10);
+            }
+            latency_probe_start(period_us);
+            strcat(pui8OutBuffer, "\r\nLatency probe started.\r\n");
+        }
+        else if (strcmp(argv[2], "stop") == 0)
+        {
+            latency_probe_stop();
+            strcat(pui8OutBuffer, "\r\nLatency probe stopped.\r\n");
+        }
+        else if (strcmp(argv[2], "reset") == 0)
+        {
+            latency_probe_reset();
+            strcat(pui8OutBuffer, "\r\nLatency probe cleared.\r\n");
+        }
+        return;
+    }
+
+    latency_probe_stats_t stats;
+    latency_probe_get(&stats);
+
+    uint32_t avg = stats.count ? (uint32_t)(stats.total / stats.count) : 0;
+    char *buffer = pui8OutBuffer + strlen(pui8OutBuffer);
+    am_util_stdio_sprintf(buffer, "\r\ninterrupts: %u avg: %u.%02uus max: %u.%02uus\r\n",
+        stats.count,
+        avg / LATENCY_PROBE_TICKS_PER_US,
+        (avg % LATENCY_PROBE_TICKS_PER_US) * 100 / LATENCY_PROBE_TICKS_PER_US,
+        stats.max / LATENCY_PROBE_TICKS_PER_US,
+        (stats.max % LATENCY_PROBE_TICKS_PER_US) * 100 / LATENCY_PROBE_TICKS_PER_US);
+}
+
+static void bench(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    application_msg_t message = { .message = APP_MSG_SENSORS_BENCHMARK, .size = 100, .payload = NULL };
+
+#if SENSORS_FIFO_BENCH
+    if ((argc >= 3) && (strcmp(argv[2], "fifo") == 0))
+    {
+        message.message = APP_MSG_FIFO_BENCHMARK;
+        if (argc == 4)
+        {
+            message.size = strtol(argv[3], NULL, 10);
+        }
+    }
+    else
+#endif
+    if (argc == 3)
+    {
+        message.size = strtol(argv[2], NULL, 10);
+    }
+
+    // Run in the application task which owns the sensors.
+    application_send_message(&message);
+    strcat(pui8OutBuffer, "\r\nBenchmark started.\r\n");
+}
+
+static void capture(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    if (argc != 4)
+    {
+        strcat(pui8OutBuffer, "\r\nusage: app capture <pre> <post>\r\n");
+        return;
+    }
+
+    // Both windows are packed into size, pre in the low half.
+    uint32_t pre = strtol(argv[2], NULL, 10);
+    uint32_t post = strtol(argv[3], NULL, 10);
+    application_msg_t message = {
+        .message = APP_MSG_CAPTURE_CONFIGURE,
+        .size = (pre & 0xFFFF) | (post << 16),
+        .payload = NULL };
+
+    application_send_message(&message);
+    strcat(pui8OutBuffer, "\r\nCapture window requested.\r\n");
+}
+
+static void trace(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    if (argc == 3 && strcmp(argv[2], "start") == 0)
+    {
+        application_trace_start();
+        strcat(pui8OutBuffer, "\r\nTrace started.\r\n");
+        return;
+    }
+    else if (argc == 3 && strcmp(argv[2], "stop") == 0)
+    {
+        application_trace_stop();
+        strcat(pui8OutBuffer, "\r\nTrace stopped.\r\n");
+        return;
+    }
+
+    application_trace_stats_t stats;
+    application_trace_stats(&stats);
+
+    char *buffer = pui8OutBuffer + strlen(pui8OutBuffer);
+    am_util_stdio_sprintf(buffer, "\r\ntrace %s: records %u dropped %u bytes %u\r\n",
+        stats.active ? "on" : "off", stats.records, stats.dropped, stats.bytes);
+}
+
 portBASE_TYPE
 application_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const char *pui8Command)
 {
@@ -155,6 +299,31 @@ application_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, cons
     {
         ota(pui8OutBuffer, argc, argv);
     }
+    else if (strcmp(argv[1], "profile") == 0)
+    {
+        profile(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "latency") == 0)
+    {
+        latency(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "bench") == 0)
+    {
+        bench(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "capture") == 0)
+    {
+        capture(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "trace") == 0)
+    {
+        trace(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "ahrs") == 0)
+    {
+        application_msg_t message = { .message = APP_MSG_AHRS_SHOW, .size = 0, .payload = NULL };
+        application_send_message(&message);
+    }
 
     return pdFALSE;
 }
@@ -0,0 +1,192 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "SEGGER_RTT.h"
+
+#include "sensors_config.h"
+
+#include "imu.h"
+#include "mag.h"
+#include "sensor_time.h"
+
+#include "application_trace.h"
+
+static uint8_t trace_buffer[SENSORS_TRACE_BUFFER_SIZE];
+
+static bool trace_active;
+static uint16_t trace_sequence;
+static uint32_t trace_records;
+static uint32_t trace_dropped;
+static uint32_t trace_bytes;
+
+// The correction last written to the trace.
+static bool trace_cal_valid;
+static mag_cal_t trace_cal;
+
+static void application_trace_write(uint8_t type, const void *payload, uint8_t length)
+{
+    uint8_t record[sizeof(trace_record_t) + TRACE_PAYLOAD_MAX];
+    trace_record_t header = { .type = type, .length = length };
+    uint32_t size = sizeof(trace_record_t) + length;
+
+    // Records come from the application task and the CLI.  The sequence
+    // number and the write must not interleave.
+    taskENTER_CRITICAL();
+    header.sequence = trace_sequence++;
+    memcpy(record, &header, sizeof(header));
+    memcpy(&record[sizeof(header)], payload, length);
+
+    if (SEGGER_RTT_Write(SENSORS_TRACE_RTT_CHANNEL, record, size) == size)
+    {
+        trace_records++;
+        trace_bytes += size;
+    }
+    else
+    {
+        trace_dropped++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void application_trace_start(void)
+{
+    trace_start_t start = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_VERSION,
+        .timestamp = sensor_time_mcu_us(),
+    };
+
+    application_trace_stop();
+
+    // The channel is skipped rather than blocked on when the probe falls
+    // behind, so tracing never stalls sampling.
+    SEGGER_RTT_ConfigUpBuffer(SENSORS_TRACE_RTT_CHANNEL, "trace",
+        trace_buffer, sizeof(trace_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+
+    trace_sequence = 0;
+    trace_records = 0;
+    trace_dropped = 0;
+    trace_bytes = 0;
+    trace_cal_valid = false;
+
+    application_trace_write(TRACE_RECORD_START, &start, sizeof(start));
+    trace_active = true;
+}
+
+void application_trace_stop(void)
+{
+    trace_active = false;
+}
+
+void application_trace_stats(application_trace_stats_t *stats)
+{
+    stats->active = trace_active;
+    stats->records = trace_records;
+    stats->dropped = trace_dropped;
+    stats->bytes = trace_bytes;
+}
+
+void application_trace_imu(const imu_context_t *frames, uint32_t count)
+{
+    if (!trace_active)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        trace_imu_t imu = {
+            .timestamp = frames[i].timestamp,
+            .sensortime = frames[i].sensortime,
+            .dropped = frames[i].dropped,
+            .status = frames[i].status,
+            .acc_range = frames[i].acc_range,
+            .gyr_range = frames[i].gyr_range,
+            .ax = frames[i].ax,
+            .ay = frames[i].ay,
+            .az = frames[i].az,
+            .gx = frames[i].gx,
+            .gy = frames[i].gy,
+            .gz = frames[i].gz,
+        };
+
+        application_trace_write(TRACE_RECORD_IMU, &imu, sizeof(imu));
+    }
+}
+
+void application_trace_mag(const mag_context_t *mag_context)
+{
+    if (!trace_active)
+    {
+        return;
+    }
+
+    trace_mag_t mag = {
+        .timestamp = mag_context->timestamp,
+        .sensortime = mag_context->sensortime,
+        .dropped = mag_context->dropped,
+        .mx = mag_context->mx,
+        .my = mag_context->my,
+        .mz = mag_context->mz,
+    };
+
+    application_trace_write(TRACE_RECORD_MAG, &mag, sizeof(mag));
+}
+
+// Only changes are written.  A correction that was dropped is tried again
+// on the next call.
+void application_trace_cal(const mag_cal_t *mag_cal)
+{
+    if (!trace_active)
+    {
+        return;
+    }
+
+    if (trace_cal_valid && (memcmp(&trace_cal, mag_cal, sizeof(mag_cal_t)) == 0))
+    {
+        return;
+    }
+
+    uint32_t dropped = trace_dropped;
+    application_trace_write(TRACE_RECORD_CAL, mag_cal, sizeof(mag_cal_t));
+    if (trace_dropped == dropped)
+    {
+        trace_cal = *mag_cal;
+        trace_cal_valid = true;
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _APPLICATION_TRACE_H_
+#define _APPLICATION_TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "imu.h"
+#include "mag.h"
+
+/*
+ * A trace is a stream of records, each a trace_record_t followed by length
+ * bytes of payload.  Records are written whole or not at all, and every
+ * record written or dropped takes the next sequence number so that a
+ * reader can tell where records were lost.  A trace starts with a
+ * TRACE_RECORD_START.
+ *
+ * The sensor readings are recorded as the drivers return them, before any
+ * correction.  The IMU frames are left in LSBs at the range they were
+ * measured at.  The magnetometer samples are the BMM350 compensated
+ * readings in uT before the hard and soft iron correction, which is
+ * recorded separately whenever it changes.
+ *
+ * All fields are little endian and the payloads have no padding, so the
+ * structures below can be copied in and out of the stream as they are.
+ */
+#define TRACE_MAGIC                 (0x31435254)    // "TRC1"
+#define TRACE_VERSION               (1)
+
+#define TRACE_RECORD_START          (1)
+#define TRACE_RECORD_IMU            (2)
+#define TRACE_RECORD_MAG            (3)
+#define TRACE_RECORD_CAL            (4)
+
+typedef struct trace_record_s
+{
+    uint8_t type;
+    uint8_t length;
+    uint16_t sequence;
+} trace_record_t;
+
+typedef struct trace_start_s
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint64_t timestamp;     // microseconds on the MCU timebase
+} trace_start_t;
+
+typedef struct trace_imu_s
+{
+    uint64_t timestamp;
+    uint32_t sensortime;
+    uint32_t dropped;
+    uint8_t status;
+    uint8_t acc_range;
+    uint8_t gyr_range;
+    uint8_t reserved;
+    int16_t ax, ay, az;
+    int16_t gx, gy, gz;
+} trace_imu_t;
+
+typedef struct trace_mag_s
+{
+    uint64_t timestamp;
+    uint32_t sensortime;
+    uint32_t dropped;
+    float mx, my, mz;
+    uint32_t reserved;
+} trace_mag_t;
+
+// A TRACE_RECORD_CAL payload is a mag_cal_t.
+#define TRACE_PAYLOAD_MAX           (sizeof(mag_cal_t))
+
+typedef struct application_trace_stats_s
+{
+    bool active;
+    uint32_t records;       // written
+    uint32_t dropped;       // did not fit in the channel
+    uint32_t bytes;
+} application_trace_stats_t;
+
+extern void application_trace_start(void);
+extern void application_trace_stop(void);
+extern void application_trace_stats(application_trace_stats_t *stats);
+extern void application_trace_imu(const imu_context_t *frames, uint32_t count);
+extern void application_trace_mag(const mag_context_t *mag_context);
+extern void application_trace_cal(const mag_cal_t *mag_cal);
+
+#endif
@@ -43,21 +43,23 @@
 #define READ_WRITE_LEN  UINT8_C(46)
 
 #define BMI270_IOM_MODULE 0
+#define BMI270_IOM_IRQ    ((IRQn_Type)(IOMSTR0_IRQn + BMI270_IOM_MODULE))
+
+// Command queue memory for non-blocking transfers.  Each queued transaction
+// takes a handful of words; this leaves room for several outstanding ones.
+#define BMI270_IOM_NB_TXN_BUF_SIZE  64
 
 static void    *iom_handle;
 static uint8_t  dev_addr;
+static uint32_t iom_nb_txn_buffer[BMI270_IOM_NB_TXN_BUF_SIZE];
 
 static am_hal_iom_config_t iom_spi_config =
 {
-    .eInterfaceMode  = AM_HAL_IOM_SPI_MODE,
-    .ui32ClockFreq   = AM_HAL_IOM_8MHZ,
-    .eSpiMode        = AM_HAL_IOM_SPI_MODE_0,
-};
-
-static am_hal_iom_config_t iom_i2c_config =
-{
-    .eInterfaceMode  = AM_HAL_IOM_I2C_MODE,
-    .ui32ClockFreq   = AM_HAL_IOM_1MHZ,
+    .eInterfaceMode     = AM_HAL_IOM_SPI_MODE,
+    .ui32ClockFreq      = AM_HAL_IOM_8MHZ,
+    .eSpiMode           = AM_HAL_IOM_SPI_MODE_0,
+    .pNBTxnBuf          = iom_nb_txn_buffer,
+    .ui32NBTxnBufLength = BMI270_IOM_NB_TXN_BUF_SIZE,
 };
 
 
@@ -138,6 +140,60 @@ BMI2_INTF_RETURN_TYPE bmi2_spi_write(uint8_t reg_addr, const uint8_t *reg_data,
     return am_hal_iom_blocking_transfer(iom_handle, &transaction);
 }
 
+BMI2_INTF_RETURN_TYPE bmi2_spi_read_async(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr,
+                                          bmi2_async_callback_t callback, void *context)
+{
+    am_hal_iom_transfer_t  transaction;
+
+    transaction.uPeerInfo.ui32SpiChipSelect = AM_BSP_IMU_CS_CHNL;
+    transaction.ui8Priority = 1;
+    transaction.eDirection = AM_HAL_IOM_RX;
+    transaction.ui32InstrLen = 1;
+    transaction.ui32Instr = reg_addr;
+    transaction.ui32NumBytes = len;
+    transaction.pui32RxBuffer = (uint32_t *)reg_data;
+    transaction.ui8RepeatCount = 0;
+    transaction.ui32PauseCondition = 0;
+    transaction.ui32StatusSetClr = 0;
+    transaction.bContinue = false;
+
+    return am_hal_iom_nonblocking_transfer(iom_handle, &transaction, callback, context);
+}
+
+BMI2_INTF_RETURN_TYPE bmi2_spi_write_async(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr,
+                                           bmi2_async_callback_t callback, void *context)
+{
+    am_hal_iom_transfer_t  transaction;
+
+    transaction.uPeerInfo.ui32SpiChipSelect = AM_BSP_IMU_CS_CHNL;
+    transaction.ui8Priority = 1;
+    transaction.eDirection = AM_HAL_IOM_TX;
+    transaction.ui32InstrLen = 1;
+    transaction.ui32Instr = reg_addr;
+    transaction.ui32NumBytes = len;
+    transaction.pui32TxBuffer = (uint32_t *)reg_data;
+    transaction.ui8RepeatCount = 0;
+    transaction.ui32PauseCondition = 0;
+    transaction.ui32StatusSetClr = 0;
+    transaction.bContinue = false;
+
+    return am_hal_iom_nonblocking_transfer(iom_handle, &transaction, callback, context);
+}
+
+void am_iomaster0_isr(void)
+{
+    uint32_t status;
+
+    if (am_hal_iom_interrupt_status_get(iom_handle, true, &status) == AM_HAL_STATUS_SUCCESS)
+    {
+        if (status)
+        {
+            am_hal_iom_interrupt_clear(iom_handle, status);
+            am_hal_iom_interrupt_service(iom_handle, status);
+        }
+    }
+}
+
 void bmi2_delay_us(uint32_t period, void *intf_ptr)
 {
     am_util_delay_us(period);
@@ -166,6 +222,12 @@ int8_t bmi2_interface_init(struct bmi2_dev *bmi, uint8_t intf)
             am_hal_iom_configure(iom_handle, &iom_spi_config);
             am_hal_iom_enable(iom_handle);
 
+            // Completion of non-blocking transfers is reported through the
+            // IOM interrupt.
+            am_hal_iom_interrupt_clear(iom_handle, AM_HAL_IOM_INT_ALL);
+            am_hal_iom_interrupt_enable(iom_handle, AM_HAL_IOM_INT_CMDCMP | AM_HAL_IOM_INT_ERR);
+            NVIC_EnableIRQ(BMI270_IOM_IRQ);
+
             am_hal_gpio_pinconfig(AM_BSP_GPIO_IMU_MISO, g_AM_BSP_GPIO_IMU_MISO);
             am_hal_gpio_pinconfig(AM_BSP_GPIO_IMU_MOSI, g_AM_BSP_GPIO_IMU_MOSI);
             am_hal_gpio_pinconfig(AM_BSP_GPIO_IMU_SCK, g_AM_BSP_GPIO_IMU_SCK);
@@ -391,6 +453,9 @@ void bmi2_interface_deinit(struct bmi2_dev *bmi)
             am_hal_gpio_pinconfig(AM_BSP_GPIO_IMU_SCK, g_AM_HAL_GPIO_DISABLE);
             am_hal_gpio_pinconfig(AM_BSP_GPIO_IMU_CS, g_AM_HAL_GPIO_DISABLE);
 
+            NVIC_DisableIRQ(BMI270_IOM_IRQ);
+            am_hal_iom_interrupt_disable(iom_handle, AM_HAL_IOM_INT_ALL);
+
             am_hal_iom_disable(iom_handle);
             am_hal_iom_power_ctrl(iom_handle, AM_HAL_SYSCTRL_DEEPSLEEP, false);
             am_hal_iom_uninitialize(iom_handle);
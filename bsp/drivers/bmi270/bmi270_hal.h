@@ -37,6 +37,12 @@
 extern "C" {
 #endif
 
+/*!
+ *  @brief Completion callback for non-blocking transfers.  Called from the
+ *  IOM interrupt with the HAL status of the finished transaction.
+ */
+typedef void (*bmi2_async_callback_t)(void *context, uint32_t status);
+
 /*!
  *  @brief Function for reading the sensor's registers through I2C bus.
  *
@@ -97,6 +103,46 @@ BMI2_INTF_RETURN_TYPE bmi2_spi_read(uint8_t reg_addr, uint8_t *reg_data, uint32_
  */
 BMI2_INTF_RETURN_TYPE bmi2_spi_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr);
 
+/*!
+ *  @brief Function for starting a non-blocking (DMA) read of the sensor's
+ *  registers through SPI bus.
+ *
+ *  @param[in] reg_addr     : Register address.
+ *  @param[out] reg_data    : Pointer to the data buffer to store the read data.
+ *                            Must remain valid until the callback is invoked.
+ *  @param[in] length       : No of bytes to read.
+ *  @param[in] intf_ptr     : Interface pointer
+ *  @param[in] callback     : Called from the IOM interrupt on completion.
+ *  @param[in] context      : Passed back to the callback.
+ *
+ *  @return Status of queuing the transfer
+ *  @retval = BMI2_INTF_RET_SUCCESS -> Transfer queued
+ *  @retval != BMI2_INTF_RET_SUCCESS  -> Failure Info
+ *
+ */
+BMI2_INTF_RETURN_TYPE bmi2_spi_read_async(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr,
+                                          bmi2_async_callback_t callback, void *context);
+
+/*!
+ *  @brief Function for starting a non-blocking (DMA) write of the sensor's
+ *  registers through SPI bus.
+ *
+ *  @param[in] reg_addr     : Register address.
+ *  @param[in] reg_data     : Pointer to the data buffer whose data has to be written.
+ *                            Must remain valid until the callback is invoked.
+ *  @param[in] length       : No of bytes to write.
+ *  @param[in] intf_ptr     : Interface pointer
+ *  @param[in] callback     : Called from the IOM interrupt on completion.
+ *  @param[in] context      : Passed back to the callback.
+ *
+ *  @return Status of queuing the transfer
+ *  @retval = BMI2_INTF_RET_SUCCESS -> Transfer queued
+ *  @retval != BMI2_INTF_RET_SUCCESS  -> Failure Info
+ *
+ */
+BMI2_INTF_RETURN_TYPE bmi2_spi_write_async(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr,
+                                           bmi2_async_callback_t callback, void *context);
+
 /*!
  * @brief This function provides the delay for required time (Microsecond) as per the input provided in some of the
  * APIs.
@@ -105,6 +105,16 @@ static int8_t read_otp_word(uint8_t addr, uint16_t *lsb_msb, struct bmm350_dev *
  */
 static int8_t read_out_raw_data(float *out_data, struct bmm350_dev *dev);
 
+/*!
+ * @brief This internal API is used to convert raw magnetic x,y and z axis data along with temperature to uT and degC.
+ *
+ * @param[in]   raw_data     : Structure instance of bmm350_raw_mag_data.
+ * @param[out]  out_data     : Pointer variable to store mag and temperature data.
+ *
+ * @return void
+ */
+static void convert_raw_data(const struct bmm350_raw_mag_data *raw_data, float *out_data);
+
 /*!
  * @brief This internal API is used to convert raw mag lsb data to uT and raw temperature data to degC.
  *
@@ -695,8 +705,6 @@ int8_t bmm350_read_uncomp_mag_temp_data(struct bmm350_raw_mag_data *raw_data, st
 
     uint8_t mag_data[12] = { 0 };
 
-    uint32_t raw_mag_x, raw_mag_y, raw_mag_z, raw_temp;
-
     if (raw_data != NULL)
     {
         /* Get uncompensated mag data */
@@ -704,40 +712,65 @@ int8_t bmm350_read_uncomp_mag_temp_data(struct bmm350_raw_mag_data *raw_data, st
 
         if (rslt == BMM350_OK)
         {
-            raw_mag_x = mag_data[0] + ((uint32_t)mag_data[1] << 8) + ((uint32_t)mag_data[2] << 16);
-            raw_mag_y = mag_data[3] + ((uint32_t)mag_data[4] << 8) + ((uint32_t)mag_data[5] << 16);
-            raw_mag_z = mag_data[6] + ((uint32_t)mag_data[7] << 8) + ((uint32_t)mag_data[8] << 16);
-            raw_temp = mag_data[9] + ((uint32_t)mag_data[10] << 8) + ((uint32_t)mag_data[11] << 16);
+            rslt = bmm350_parse_uncomp_mag_temp_data(mag_data, raw_data, dev);
+        }
+    }
+    else
+    {
+        rslt = BMM350_E_NULL_PTR;
+    }
 
-            if ((dev->axis_en & BMM350_EN_X_MSK) == BMM350_DISABLE)
-            {
-                raw_data->raw_xdata = BMM350_DISABLE;
-            }
-            else
-            {
-                raw_data->raw_xdata = fix_sign(raw_mag_x, BMM350_SIGNED_24_BIT);
-            }
+    return rslt;
+}
 
-            if ((dev->axis_en & BMM350_EN_Y_MSK) == BMM350_DISABLE)
-            {
-                raw_data->raw_ydata = BMM350_DISABLE;
-            }
-            else
-            {
-                raw_data->raw_ydata = fix_sign(raw_mag_y, BMM350_SIGNED_24_BIT);
-            }
+/*!
+ * @brief This API decodes the uncompensated mag and temperature data registers
+ * read starting at BMM350_REG_MAG_X_XLSB.
+ */
+int8_t bmm350_parse_uncomp_mag_temp_data(const uint8_t *mag_data,
+                                         struct bmm350_raw_mag_data *raw_data,
+                                         const struct bmm350_dev *dev)
+{
+    /* Variable to store the function result */
+    int8_t rslt = BMM350_OK;
 
-            if ((dev->axis_en & BMM350_EN_Z_MSK) == BMM350_DISABLE)
-            {
-                raw_data->raw_zdata = BMM350_DISABLE;
-            }
-            else
-            {
-                raw_data->raw_zdata = fix_sign(raw_mag_z, BMM350_SIGNED_24_BIT);
-            }
+    uint32_t raw_mag_x, raw_mag_y, raw_mag_z, raw_temp;
+
+    if ((mag_data != NULL) && (raw_data != NULL) && (dev != NULL))
+    {
+        raw_mag_x = mag_data[0] + ((uint32_t)mag_data[1] << 8) + ((uint32_t)mag_data[2] << 16);
+        raw_mag_y = mag_data[3] + ((uint32_t)mag_data[4] << 8) + ((uint32_t)mag_data[5] << 16);
+        raw_mag_z = mag_data[6] + ((uint32_t)mag_data[7] << 8) + ((uint32_t)mag_data[8] << 16);
+        raw_temp = mag_data[9] + ((uint32_t)mag_data[10] << 8) + ((uint32_t)mag_data[11] << 16);
+
+        if ((dev->axis_en & BMM350_EN_X_MSK) == BMM350_DISABLE)
+        {
+            raw_data->raw_xdata = BMM350_DISABLE;
+        }
+        else
+        {
+            raw_data->raw_xdata = fix_sign(raw_mag_x, BMM350_SIGNED_24_BIT);
+        }
 
-            raw_data->raw_data_t = fix_sign(raw_temp, BMM350_SIGNED_24_BIT);
+        if ((dev->axis_en & BMM350_EN_Y_MSK) == BMM350_DISABLE)
+        {
+            raw_data->raw_ydata = BMM350_DISABLE;
+        }
+        else
+        {
+            raw_data->raw_ydata = fix_sign(raw_mag_y, BMM350_SIGNED_24_BIT);
         }
+
+        if ((dev->axis_en & BMM350_EN_Z_MSK) == BMM350_DISABLE)
+        {
+            raw_data->raw_zdata = BMM350_DISABLE;
+        }
+        else
+        {
+            raw_data->raw_zdata = fix_sign(raw_mag_z, BMM350_SIGNED_24_BIT);
+        }
+
+        raw_data->raw_data_t = fix_sign(raw_temp, BMM350_SIGNED_24_BIT);
     }
     else
     {
@@ -901,15 +934,46 @@ int8_t bmm350_get_compensated_mag_xyz_temp_data(struct bmm350_mag_temp_data *mag
     /* Variable to store the function result */
     int8_t rslt;
 
+    struct bmm350_raw_mag_data raw_data = { 0 };
+
+    if (mag_temp_data != NULL)
+    {
+        /* Reads raw magnetic x,y and z axis along with temperature */
+        rslt = bmm350_read_uncomp_mag_temp_data(&raw_data, dev);
+
+        if (rslt == BMM350_OK)
+        {
+            rslt = bmm350_compensate_mag_xyz_temp_data(&raw_data, mag_temp_data, dev);
+        }
+    }
+    else
+    {
+        rslt = BMM350_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
+/*!
+ * @brief This API applies the OTP compensation to uncompensated mag and temperature data.
+ */
+int8_t bmm350_compensate_mag_xyz_temp_data(const struct bmm350_raw_mag_data *raw_data,
+                                           struct bmm350_mag_temp_data *mag_temp_data,
+                                           const struct bmm350_dev *dev)
+{
+    /* Variable to store the function result */
+    int8_t rslt;
+
     uint8_t indx;
     float out_data[4] = { 0.0f };
     float dut_offset_coef[3], dut_sensit_coef[3], dut_tco[3], dut_tcs[3];
     float cr_ax_comp_x, cr_ax_comp_y, cr_ax_comp_z;
 
-    if (mag_temp_data != NULL)
+    if ((raw_data != NULL) && (mag_temp_data != NULL) && (dev != NULL))
     {
-        /* Reads raw magnetic x,y and z axis along with temperature */
-        rslt = read_out_raw_data(out_data, dev);
+        /* Convert raw magnetic x,y and z axis along with temperature */
+        convert_raw_data(raw_data, out_data);
+        rslt = BMM350_OK;
 
         if (rslt == BMM350_OK)
         {
@@ -1401,40 +1465,15 @@ static int8_t read_out_raw_data(float *out_data, struct bmm350_dev *dev)
     /* Variable to store the function result */
     int8_t rslt;
 
-    float temp = 0.0;
     struct bmm350_raw_mag_data raw_data = { 0 };
 
-    /* Float variable to convert mag lsb to uT and temp lsb to degC */
-    float lsb_to_ut_degc[4];
-
     if (out_data != NULL)
     {
         rslt = bmm350_read_uncomp_mag_temp_data(&raw_data, dev);
 
         if (rslt == BMM350_OK)
         {
-            /* Convert mag lsb to uT and temp lsb to degC */
-            update_default_coefiecents(lsb_to_ut_degc);
-
-            out_data[0] = (float)raw_data.raw_xdata * lsb_to_ut_degc[0];
-            out_data[1] = (float)raw_data.raw_ydata * lsb_to_ut_degc[1];
-            out_data[2] = (float)raw_data.raw_zdata * lsb_to_ut_degc[2];
-            out_data[3] = (float)raw_data.raw_data_t * lsb_to_ut_degc[3];
-
-            if (out_data[3] > 0.0f)
-            {
-                temp = (float)(out_data[3] - (1.0f * 25.49f));
-            }
-            else if (out_data[3] < 0.0f)
-            {
-                temp = (float)(out_data[3] - (-1.0f * 25.49f));
-            }
-            else
-            {
-                temp = (float)(out_data[3]);
-            }
-
-            out_data[3] = temp;
+            convert_raw_data(&raw_data, out_data);
         }
     }
     else
@@ -1445,6 +1484,40 @@ static int8_t read_out_raw_data(float *out_data, struct bmm350_dev *dev)
     return rslt;
 }
 
+/*!
+ * @brief This internal API is used to convert raw magnetic x,y and z axis data along with temperature to uT and degC.
+ */
+static void convert_raw_data(const struct bmm350_raw_mag_data *raw_data, float *out_data)
+{
+    float temp = 0.0;
+
+    /* Float variable to convert mag lsb to uT and temp lsb to degC */
+    float lsb_to_ut_degc[4];
+
+    /* Convert mag lsb to uT and temp lsb to degC */
+    update_default_coefiecents(lsb_to_ut_degc);
+
+    out_data[0] = (float)raw_data->raw_xdata * lsb_to_ut_degc[0];
+    out_data[1] = (float)raw_data->raw_ydata * lsb_to_ut_degc[1];
+    out_data[2] = (float)raw_data->raw_zdata * lsb_to_ut_degc[2];
+    out_data[3] = (float)raw_data->raw_data_t * lsb_to_ut_degc[3];
+
+    if (out_data[3] > 0.0f)
+    {
+        temp = (float)(out_data[3] - (1.0f * 25.49f));
+    }
+    else if (out_data[3] < 0.0f)
+    {
+        temp = (float)(out_data[3] - (-1.0f * 25.49f));
+    }
+    else
+    {
+        temp = (float)(out_data[3]);
+    }
+
+    out_data[3] = temp;
+}
+
 /*!
  * @brief This internal API is used to convert lsb to uT and degC.
  */
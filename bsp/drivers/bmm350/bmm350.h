@@ -399,6 +399,31 @@ int8_t  bmm350_configure_interrupt(enum bmm350_intr_latch latching,
 */
 int8_t bmm350_read_uncomp_mag_temp_data(struct bmm350_raw_mag_data *raw_data, struct bmm350_dev *dev);
 
+/*!
+* \ingroup bmm350ApiUncompMag
+* \page bmm350_api_bmm350_parse_uncomp_mag_temp_data bmm350_parse_uncomp_mag_temp_data
+* \code
+* int8_t bmm350_parse_uncomp_mag_temp_data(const uint8_t *mag_data,
+*                                          struct bmm350_raw_mag_data *raw_data,
+*                                          const struct bmm350_dev *dev);
+* \endcode
+* @details This API decodes the BMM350_MAG_TEMP_DATA_LEN bytes read starting at
+* BMM350_REG_MAG_X_XLSB into uncompensated mag and temperature data.  It allows
+* the registers to be read by the caller, for example with a non-blocking
+* transfer.
+*
+* @param[in] mag_data          : Register data without the interface dummy bytes.
+* @param[out] raw_data         : Structure instance of bmm350_raw_mag_data.
+* @param[in] dev               : Structure instance of bmm350_dev.
+*
+* @return Result of API execution status
+*  @retval = 0 -> Success
+*  @retval < 0 -> Error
+*/
+int8_t bmm350_parse_uncomp_mag_temp_data(const uint8_t *mag_data,
+                                         struct bmm350_raw_mag_data *raw_data,
+                                         const struct bmm350_dev *dev);
+
 /*!
 * \ingroup bmm350ApiSetGet
 * \page bmm350_api_bmm350_set_int_ctrl_ibi bmm350_set_int_ctrl_ibi
@@ -479,6 +504,29 @@ int8_t bmm350_magnetic_reset_and_wait(struct bmm350_dev *dev);
 */
 int8_t bmm350_get_compensated_mag_xyz_temp_data(struct bmm350_mag_temp_data *mag_temp_data, struct bmm350_dev *dev);
 
+/*!
+* \ingroup bmm350ApiMagComp
+* \page bmm350_api_bmm350_compensate_mag_xyz_temp_data bmm350_compensate_mag_xyz_temp_data
+* \code
+* int8_t bmm350_compensate_mag_xyz_temp_data(const struct bmm350_raw_mag_data *raw_data,
+*                                            struct bmm350_mag_temp_data *mag_temp_data,
+*                                            const struct bmm350_dev *dev);
+* \endcode
+* @details This API performs the same compensation as
+* bmm350_get_compensated_mag_xyz_temp_data on data that has already been read.
+*
+* @param[in] raw_data          : Structure instance of bmm350_raw_mag_data.
+* @param[out] mag_temp_data    : Structure instance of bmm350_mag_temp_data.
+* @param[in] dev               : Structure instance of bmm350_dev.
+*
+* @return Result of API execution status
+*  @retval = 0 -> Success
+*  @retval < 0 -> Error
+*/
+int8_t bmm350_compensate_mag_xyz_temp_data(const struct bmm350_raw_mag_data *raw_data,
+                                           struct bmm350_mag_temp_data *mag_temp_data,
+                                           const struct bmm350_dev *dev);
+
 /**
  * \ingroup bmm350
  * \defgroup bmm350ApiSelftest Self-test
@@ -48,16 +48,23 @@
 /******************************************************************************/
 /*!                Structure definition                                       */
 #define BMM350_IOM_MODULE  (1)
+#define BMM350_IOM_IRQ     ((IRQn_Type)(IOMSTR0_IRQn + BMM350_IOM_MODULE))
+
+/*! Command queue memory for non-blocking transfers */
+#define BMM350_IOM_NB_TXN_BUF_SIZE  (64)
 
 /******************************************************************************/
 /*!                Static variable definition                                 */
 static void    *iom_handle;
 static uint8_t dev_addr;
+static uint32_t iom_nb_txn_buffer[BMM350_IOM_NB_TXN_BUF_SIZE];
 
 static am_hal_iom_config_t iom_i2c_config =
 {
-    .eInterfaceMode  = AM_HAL_IOM_I2C_MODE,
-    .ui32ClockFreq   = AM_HAL_IOM_400KHZ,
+    .eInterfaceMode     = AM_HAL_IOM_I2C_MODE,
+    .ui32ClockFreq      = AM_HAL_IOM_400KHZ,
+    .pNBTxnBuf          = iom_nb_txn_buffer,
+    .ui32NBTxnBufLength = BMM350_IOM_NB_TXN_BUF_SIZE,
 };
 
 /******************************************************************************/
@@ -109,6 +116,76 @@ BMM350_INTF_RET_TYPE bmm350_i2c_write(uint8_t reg_addr, const uint8_t *reg_data,
     return am_hal_iom_blocking_transfer(iom_handle, &transaction);
 }
 
+/*!
+ * Non-blocking I2C read.  The callback is invoked from the IOM interrupt.
+ */
+BMM350_INTF_RET_TYPE bmm350_i2c_read_async(uint8_t reg_addr,
+                                           uint8_t *reg_data,
+                                           uint32_t length,
+                                           void *intf_ptr,
+                                           bmm350_async_callback_t callback,
+                                           void *context)
+{
+    am_hal_iom_transfer_t  transaction;
+    uint8_t device_addr = *(uint8_t*)intf_ptr;
+
+    transaction.uPeerInfo.ui32I2CDevAddr = device_addr;
+    transaction.ui8Priority = 1;
+    transaction.eDirection = AM_HAL_IOM_RX;
+    transaction.ui32InstrLen = 1;
+    transaction.ui32Instr = reg_addr;
+    transaction.ui32NumBytes = length;
+    transaction.pui32RxBuffer = (uint32_t *)reg_data;
+    transaction.ui8RepeatCount = 0;
+    transaction.ui32PauseCondition = 0;
+    transaction.ui32StatusSetClr = 0;
+    transaction.bContinue = false;
+
+    return am_hal_iom_nonblocking_transfer(iom_handle, &transaction, callback, context);
+}
+
+/*!
+ * Non-blocking I2C write.  The callback is invoked from the IOM interrupt.
+ */
+BMM350_INTF_RET_TYPE bmm350_i2c_write_async(uint8_t reg_addr,
+                                            const uint8_t *reg_data,
+                                            uint32_t length,
+                                            void *intf_ptr,
+                                            bmm350_async_callback_t callback,
+                                            void *context)
+{
+    am_hal_iom_transfer_t  transaction;
+    uint8_t device_addr = *(uint8_t*)intf_ptr;
+
+    transaction.uPeerInfo.ui32I2CDevAddr = device_addr;
+    transaction.ui8Priority = 1;
+    transaction.eDirection = AM_HAL_IOM_TX;
+    transaction.ui32InstrLen = 1;
+    transaction.ui32Instr = reg_addr;
+    transaction.ui32NumBytes = length;
+    transaction.pui32TxBuffer = (uint32_t *)reg_data;
+    transaction.ui8RepeatCount = 0;
+    transaction.ui32PauseCondition = 0;
+    transaction.ui32StatusSetClr = 0;
+    transaction.bContinue = false;
+
+    return am_hal_iom_nonblocking_transfer(iom_handle, &transaction, callback, context);
+}
+
+void am_iomaster1_isr(void)
+{
+    uint32_t status;
+
+    if (am_hal_iom_interrupt_status_get(iom_handle, true, &status) == AM_HAL_STATUS_SUCCESS)
+    {
+        if (status)
+        {
+            am_hal_iom_interrupt_clear(iom_handle, status);
+            am_hal_iom_interrupt_service(iom_handle, status);
+        }
+    }
+}
+
 /*!
  * Delay function map to COINES platform
  */
@@ -202,6 +279,10 @@ int8_t bmm350_interface_init(struct bmm350_dev *dev)
         am_hal_iom_configure(iom_handle, &iom_i2c_config);
         am_hal_iom_enable(iom_handle);
 
+        am_hal_iom_interrupt_clear(iom_handle, AM_HAL_IOM_INT_ALL);
+        am_hal_iom_interrupt_enable(iom_handle, AM_HAL_IOM_INT_CMDCMP | AM_HAL_IOM_INT_ERR);
+        NVIC_EnableIRQ(BMM350_IOM_IRQ);
+
         am_hal_gpio_pinconfig(AM_BSP_GPIO_MAG_SDA, g_AM_BSP_GPIO_MAG_SDA);
         am_hal_gpio_pinconfig(AM_BSP_GPIO_MAG_SCL, g_AM_BSP_GPIO_MAG_SCL);
     }
@@ -220,6 +301,9 @@ void bmm350_interface_deinit(struct bmm350_dev *dev)
         am_hal_gpio_pinconfig(AM_BSP_GPIO_MAG_SDA, g_AM_HAL_GPIO_DISABLE);
         am_hal_gpio_pinconfig(AM_BSP_GPIO_MAG_SCL, g_AM_HAL_GPIO_DISABLE);
 
+        NVIC_DisableIRQ(BMM350_IOM_IRQ);
+        am_hal_iom_interrupt_disable(iom_handle, AM_HAL_IOM_INT_ALL);
+
         am_hal_iom_disable(iom_handle);
         am_hal_iom_power_ctrl(iom_handle, AM_HAL_SYSCTRL_DEEPSLEEP, false);
         am_hal_iom_uninitialize(iom_handle);
@@ -50,6 +50,12 @@ extern "C" {
 /*!                 User function prototypes
  ****************************************************************************/
 
+/*!
+ *  @brief Completion callback for non-blocking transfers.  Called from the
+ *  IOM interrupt with the HAL status of the finished transaction.
+ */
+typedef void (*bmm350_async_callback_t)(void *context, uint32_t status);
+
 /*!
  *  @brief Function for reading the sensor's registers through I2C bus.
  *
@@ -85,6 +91,59 @@ BMM350_INTF_RET_TYPE bmm350_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32
  */
 BMM350_INTF_RET_TYPE bmm350_i2c_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t length, void *intf_ptr);
 
+/*!
+ *  @brief Function for starting a non-blocking (DMA) read of the sensor's
+ *  registers through I2C bus.
+ *
+ * @param[in] reg_addr       : Register address from which data is read.
+ * @param[out] reg_data      : Pointer to data buffer where read data is stored.
+ *                             Must remain valid until the callback is invoked.
+ * @param[in] length         : Number of bytes of data to be read.
+ * @param[in, out] intf_ptr  : Void pointer that can enable the linking of descriptors
+ *                             for interface related call backs.
+ * @param[in] callback       : Called from the IOM interrupt on completion.
+ * @param[in] context        : Passed back to the callback.
+ *
+ *  @return Status of queuing the transfer
+ *
+ *  @retval BMM350_INTF_RET_SUCCESS -> Transfer queued.
+ *  @retval != BMM350_INTF_RET_SUCCESS -> Fail.
+ *
+ */
+BMM350_INTF_RET_TYPE bmm350_i2c_read_async(uint8_t reg_addr,
+                                           uint8_t *reg_data,
+                                           uint32_t length,
+                                           void *intf_ptr,
+                                           bmm350_async_callback_t callback,
+                                           void *context);
+
+/*!
+ *  @brief Function for starting a non-blocking (DMA) write of the sensor's
+ *  registers through I2C bus.
+ *
+ * @param[in] reg_addr      : Register address to which the data is written.
+ * @param[in] reg_data      : Pointer to data buffer in which data to be written
+ *                            is stored.  Must remain valid until the callback
+ *                            is invoked.
+ * @param[in] length        : Number of bytes of data to be written.
+ * @param[in, out] intf_ptr : Void pointer that can enable the linking of descriptors
+ *                            for interface related call backs
+ * @param[in] callback      : Called from the IOM interrupt on completion.
+ * @param[in] context       : Passed back to the callback.
+ *
+ *  @return Status of queuing the transfer
+ *
+ *  @retval BMM350_INTF_RET_SUCCESS -> Transfer queued.
+ *  @retval != BMM350_INTF_RET_SUCCESS -> Failure.
+ *
+ */
+BMM350_INTF_RET_TYPE bmm350_i2c_write_async(uint8_t reg_addr,
+                                            const uint8_t *reg_data,
+                                            uint32_t length,
+                                            void *intf_ptr,
+                                            bmm350_async_callback_t callback,
+                                            void *context);
+
 /*!
  * @brief This function provides the delay for required time (Microsecond) as per the input provided in some of the
  * APIs.
@@ -0,0 +1,166 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _SENSORS_CONFIG_H_
+#define _SENSORS_CONFIG_H_
+
+/*
+ * Sensor acquisition modes
+ *
+ * SENSORS_ACQUISITION_TIMER
+ *   The CTIMER sampling clock triggers a single accel/gyro read on every
+ *   tick.  The effective sampling rate is set by the sampling period passed
+ *   to application_setup_sensors().
+ *
+ * SENSORS_ACQUISITION_FIFO
+ *   The BMI270 buffers accel/gyro frames at its configured ODR (400Hz) and
+ *   raises the FIFO watermark interrupt on INT2.  All buffered frames are
+ *   drained in a single SPI burst per wakeup.  The algorithms receive the
+ *   frames at the rates set below.
+ */
+#define SENSORS_ACQUISITION_TIMER       0
+#define SENSORS_ACQUISITION_FIFO        1
+
+#define SENSORS_ACQUISITION_MODE        SENSORS_ACQUISITION_TIMER
+
+/*
+ * Magnetometer acquisition modes
+ *
+ * SENSORS_MAG_ACQUISITION_POLLED
+ *   The magnetometer is read together with the IMU on every sampling
+ *   clock tick or FIFO watermark.
+ *
+ * SENSORS_MAG_ACQUISITION_DRDY
+ *   The BMM350 data ready interrupt on MAG_INT triggers a read at the
+ *   magnetometer's own ODR.  Every sample is read exactly once and is
+ *   timestamped at its data ready instant.  The IMU reads no longer touch
+ *   the magnetometer bus.
+ */
+#define SENSORS_MAG_ACQUISITION_POLLED  0
+#define SENSORS_MAG_ACQUISITION_DRDY    1
+
+#define SENSORS_MAG_ACQUISITION_MODE    SENSORS_MAG_ACQUISITION_POLLED
+
+// Number of accel/gyro frames buffered before the watermark interrupt is
+// raised.  At 400Hz, 20 frames give one wakeup every 50ms.  Must be less
+// than IMU_FIFO_MAX_FRAMES so that frames arriving while the FIFO is being
+// drained are not lost.
+#define SENSORS_FIFO_WATERMARK_FRAMES   (20)
+
+// In both acquisition modes each algorithm is given the frames at the
+// lowest rate that is still at least its rate below, band limited by a
+// shared anti-aliasing decimator (see decimator.h).  A rate of 0 gives the
+// algorithm every frame at the full ODR, in which case its thresholds
+// should be tuned for that rate.  The shot detection thresholds and its 32
+// sample reference were tuned at 100Hz.
+#define SENSORS_SHOTDETECT_RATE_HZ      (100)
+#define SENSORS_MATCHED_FILTER_RATE_HZ  (100)
+#define SENSORS_VIBRATION_RATE_HZ       (400)
+
+// Vibration monitoring.  A Welch spectrum of the three accelerometer axes
+// is averaged over SENSORS_VIBRATION_AVERAGES half overlapping windows of
+// ALG_SPECTRUM_FFT_LENGTH samples, after which a summary of the band
+// levels is printed.  Set SENSORS_VIBRATION to 0 to disable it.
+#define SENSORS_VIBRATION               1
+#define SENSORS_VIBRATION_AVERAGES      (8)
+
+// Sampling profiles are switched at runtime based on the motion state.  No
+// motion drops to the idle profile and any motion restores the normal
+// profile.  Significant motion, or an algorithm request, raises sampling
+// to the burst profile which is then held for at least this long.  The
+// profiles are defined in application_sensors.c.
+#define SENSORS_PROFILE_BURST_HOLD_MS   (500)
+
+// Accelerometer auto-ranging.  The range steps up to 16G as soon as a
+// sample reaches SENSORS_ACC_AUTORANGE_UP_PCT of full scale.  It steps
+// down one range at a time once every sample has stayed within
+// SENSORS_ACC_AUTORANGE_DOWN_PCT of the next lower range for
+// SENSORS_ACC_AUTORANGE_HOLD_MS.  Set SENSORS_ACC_AUTORANGE to 0 to keep
+// the 16G range.
+#define SENSORS_ACC_AUTORANGE           1
+#define SENSORS_ACC_AUTORANGE_MIN_G     4
+#define SENSORS_ACC_AUTORANGE_UP_PCT    (90)
+#define SENSORS_ACC_AUTORANGE_DOWN_PCT  (45)
+#define SENSORS_ACC_AUTORANGE_HOLD_MS   (2000)
+
+// Online magnetometer calibration.  An ellipsoid is fitted to the raw
+// samples during normal use and solved every
+// SENSORS_MAG_AUTOCAL_SOLVE_SAMPLES accepted samples.  A good solution
+// replaces the correction in use and is saved to littlefs at most once
+// every SENSORS_MAG_AUTOCAL_SAVE_MS.  Set SENSORS_MAG_AUTOCAL to 0 to only
+// use the min/max calibration procedure.
+#define SENSORS_MAG_AUTOCAL                 1
+#define SENSORS_MAG_AUTOCAL_SOLVE_SAMPLES   (50)
+#define SENSORS_MAG_AUTOCAL_SAVE_MS         (600000)
+
+// Fusion algorithms receive time aligned IMU and magnetometer frames at
+// SENSORS_RESAMPLE_RATE_HZ, the IMU rate of the normal profile.  Both
+// sensors are placed on the output grid using their own timestamps, so the
+// magnetometer is read at its own ODR.  SENSORS_RESAMPLE_MAG_MODE selects
+// RESAMPLER_MAG_LINEAR or RESAMPLER_MAG_POLYPHASE interpolation of the
+// magnetometer, see resampler.h.
+#if SENSORS_ACQUISITION_MODE == SENSORS_ACQUISITION_FIFO
+#define SENSORS_RESAMPLE_RATE_HZ        (400)
+#else
+#define SENSORS_RESAMPLE_RATE_HZ        (100)
+#endif
+#define SENSORS_RESAMPLE_MAG_MODE       RESAMPLER_MAG_LINEAR
+
+// Sensor tracing.  "app trace start" streams every raw IMU frame, every
+// magnetometer sample before correction and each new correction over RTT
+// up channel SENSORS_TRACE_RTT_CHANNEL, see application_trace.h.  Records
+// that do not fit in the channel buffer are dropped whole.  Set
+// SENSORS_TRACE to 0 to remove the hooks.
+#define SENSORS_TRACE                   1
+#define SENSORS_TRACE_RTT_CHANNEL       (1)
+#define SENSORS_TRACE_BUFFER_SIZE       (4096)
+
+// FIFO parser benchmark.  "app bench fifo [n]" times the Bosch FIFO frame
+// extraction n times over generated header mode and headerless buffers of
+// up to SENSORS_FIFO_BENCH_FRAMES frames, see imu_fifo_bench.h.  The
+// buffers take about 60 bytes of RAM per frame, so it is left out of the
+// firmware unless SENSORS_FIFO_BENCH is set to 1.  The host build always
+// defines it.
+#ifndef SENSORS_FIFO_BENCH
+#define SENSORS_FIFO_BENCH              0
+#endif
+#define SENSORS_FIFO_BENCH_FRAMES       (256)
+
+// The IMU and magnetometer interfaces are kept powered between samples and
+// only shut down after the bus has been idle for this long.  This should be
+// longer than the sampling period.  Set to 0 to power the interfaces down
+// after every sample.
+#define SENSORS_BUS_IDLE_TIMEOUT_MS     (100)
+
+// Longest time a task waits for another task to release a sensor bus.
+#define SENSORS_BUS_LOCK_TIMEOUT_MS     (20)
+
+#endif
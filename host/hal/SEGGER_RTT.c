@@ -0,0 +1,129 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "SEGGER_RTT.h"
+
+typedef struct host_rtt_up_s
+{
+    uint8_t *buffer;
+    unsigned size;
+    unsigned flags;
+    unsigned wr;
+    unsigned rd;
+} host_rtt_up_t;
+
+static host_rtt_up_t host_rtt_up[SEGGER_RTT_MAX_NUM_UP_BUFFERS];
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char *sName, void *pBuffer, unsigned BufferSize, unsigned Flags)
+{
+    (void)sName;
+
+    if (BufferIndex >= SEGGER_RTT_MAX_NUM_UP_BUFFERS)
+    {
+        return -1;
+    }
+
+    host_rtt_up_t *up = &host_rtt_up[BufferIndex];
+    if (pBuffer)
+    {
+        up->buffer = pBuffer;
+        up->size = BufferSize;
+        up->wr = 0;
+        up->rd = 0;
+    }
+    up->flags = Flags;
+
+    return 0;
+}
+
+// As on the target one byte is left unused to tell a full ring from an
+// empty one.
+unsigned SEGGER_RTT_GetAvailWriteSpace(unsigned BufferIndex)
+{
+    host_rtt_up_t *up = &host_rtt_up[BufferIndex];
+
+    if (up->buffer == NULL)
+    {
+        return 0;
+    }
+
+    return (up->rd + up->size - up->wr - 1) % up->size;
+}
+
+unsigned SEGGER_RTT_Write(unsigned BufferIndex, const void *pBuffer, unsigned NumBytes)
+{
+    host_rtt_up_t *up = &host_rtt_up[BufferIndex];
+    const uint8_t *data = pBuffer;
+    unsigned space = SEGGER_RTT_GetAvailWriteSpace(BufferIndex);
+
+    if (NumBytes > space)
+    {
+        if (up->flags == SEGGER_RTT_MODE_NO_BLOCK_TRIM)
+        {
+            NumBytes = space;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    for (unsigned i = 0; i < NumBytes; i++)
+    {
+        up->buffer[up->wr] = data[i];
+        up->wr = (up->wr + 1) % up->size;
+    }
+
+    return NumBytes;
+}
+
+unsigned SEGGER_RTT_ReadUpBuffer(unsigned BufferIndex, void *pBuffer, unsigned BufferSize)
+{
+    host_rtt_up_t *up = &host_rtt_up[BufferIndex];
+    uint8_t *data = pBuffer;
+    unsigned count = 0;
+
+    if (up->buffer == NULL)
+    {
+        return 0;
+    }
+
+    while ((count < BufferSize) && (up->rd != up->wr))
+    {
+        data[count++] = up->buffer[up->rd];
+        up->rd = (up->rd + 1) % up->size;
+    }
+
+    return count;
+}
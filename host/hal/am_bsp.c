@@ -0,0 +1,42 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "am_bsp.h"
+
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_CS = {.ui32Config = 2};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_MISO = {.ui32Config = 1};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_MOSI = {.ui32Config = 2};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_SCK = {.ui32Config = 2};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_INT1 = {.ui32Config = 1};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_INT2 = {.ui32Config = 1};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_MAG_SDA = {.ui32Config = 2};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_MAG_SCL = {.ui32Config = 2};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_MAG_INT = {.ui32Config = 1};
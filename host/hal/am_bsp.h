@@ -0,0 +1,81 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _HOST_AM_BSP_H_
+#define _HOST_AM_BSP_H_
+
+/*
+ * Host stand-in for the petal_imu BSP.  The pin numbers follow
+ * bsp/petal_imu/bsp_pins.src so that interrupts fired with
+ * am_hal_host_gpio_fire() reach the same handlers as on the board.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "am_mcu_apollo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AM_BSP_GPIO_BUTTON0     16
+#define AM_BSP_GPIO_LED0        17
+#define AM_BSP_GPIO_LED1        14
+#define AM_BSP_GPIO_IO_EN       30
+
+#define AM_BSP_GPIO_IMU_CS      31
+#define AM_BSP_IMU_CS_CHNL      0
+#define AM_BSP_GPIO_IMU_MISO    6
+#define AM_BSP_GPIO_IMU_MOSI    7
+#define AM_BSP_GPIO_IMU_SCK     5
+#define AM_BSP_GPIO_IMU_INT1    32
+#define AM_BSP_GPIO_IMU_INT2    46
+
+#define AM_BSP_GPIO_MAG_SDA     9
+#define AM_BSP_GPIO_MAG_SCL     8
+#define AM_BSP_GPIO_MAG_INT     45
+
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_CS;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_MISO;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_MOSI;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_SCK;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_INT1;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IMU_INT2;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_MAG_SDA;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_MAG_SCL;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_MAG_INT;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,787 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "am_mcu_apollo.h"
+
+//*****************************************************************************
+//
+// Core
+//
+//*****************************************************************************
+static DWT_Type dwt;
+static uint32_t dwt_offset;
+static uint32_t dwt_last;
+CoreDebug_Type am_hal_host_core_debug;
+
+static uint32_t interrupt_primask;
+static uint32_t interrupt_depth;
+
+static uint32_t host_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+}
+
+DWT_Type *am_hal_host_dwt(void)
+{
+    uint32_t now = host_ns();
+
+    // A value other than the one last handed out was written by the caller,
+    // e.g. the reset in profile_setup().  Count on from it.
+    if (dwt.CYCCNT != dwt_last || !(dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk))
+    {
+        dwt_offset = dwt.CYCCNT - now;
+    }
+    if (dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk)
+    {
+        dwt.CYCCNT = now + dwt_offset;
+    }
+    dwt_last = dwt.CYCCNT;
+
+    return &dwt;
+}
+
+// Handlers are run synchronously by the host, so masking only needs to be
+// tracked, not enforced.
+uint32_t am_hal_interrupt_master_disable(void)
+{
+    uint32_t primask = interrupt_primask;
+
+    interrupt_primask = 1;
+    return primask;
+}
+
+uint32_t am_hal_interrupt_master_enable(void)
+{
+    uint32_t primask = interrupt_primask;
+
+    interrupt_primask = 0;
+    return primask;
+}
+
+void am_hal_interrupt_master_set(uint32_t primask)
+{
+    interrupt_primask = primask;
+}
+
+bool am_hal_host_in_isr(void)
+{
+    return interrupt_depth > 0;
+}
+
+static void host_isr_run(void (*handler)(void))
+{
+    interrupt_depth++;
+    handler();
+    interrupt_depth--;
+}
+
+//*****************************************************************************
+//
+// Virtual time
+//
+//*****************************************************************************
+static uint64_t time_us;
+
+void am_hal_host_time_advance_us(uint64_t us)
+{
+    time_us += us;
+}
+
+uint64_t am_hal_host_time_us(void)
+{
+    return time_us;
+}
+
+uint32_t am_hal_stimer_counter_get(void)
+{
+    // The STIMER runs from the 32768Hz XT.
+    return (uint32_t)((time_us * 32768) / 1000000);
+}
+
+//*****************************************************************************
+//
+// GPIO
+//
+//*****************************************************************************
+const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_DISABLE = {.ui32Config = 0};
+const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_INPUT = {.ui32Config = 1};
+const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_OUTPUT = {.ui32Config = 2};
+
+static am_hal_gpio_pincfg_t gpio_config[AM_HAL_GPIO_MAX_PADS];
+static am_hal_gpio_handler_t gpio_handler[AM_HAL_GPIO_MAX_PADS];
+static uint64_t gpio_state;
+static uint64_t gpio_interrupt_enabled;
+
+uint32_t am_hal_gpio_pinconfig(uint32_t pin, am_hal_gpio_pincfg_t config)
+{
+    if (pin >= AM_HAL_GPIO_MAX_PADS)
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    gpio_config[pin] = config;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_gpio_state_write(uint32_t pin, am_hal_gpio_write_type_e type)
+{
+    if (pin >= AM_HAL_GPIO_MAX_PADS)
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    switch (type)
+    {
+    case AM_HAL_GPIO_OUTPUT_CLEAR:
+        gpio_state &= ~AM_HAL_GPIO_BIT(pin);
+        break;
+    case AM_HAL_GPIO_OUTPUT_SET:
+        gpio_state |= AM_HAL_GPIO_BIT(pin);
+        break;
+    case AM_HAL_GPIO_OUTPUT_TOGGLE:
+        gpio_state ^= AM_HAL_GPIO_BIT(pin);
+        break;
+    default:
+        break;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_gpio_state_read(uint32_t pin, am_hal_gpio_read_type_e type, uint32_t *value)
+{
+    if (pin >= AM_HAL_GPIO_MAX_PADS)
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    if (type == AM_HAL_GPIO_ENABLE_READ)
+    {
+        *value = gpio_config[pin].ui32Config == g_AM_HAL_GPIO_OUTPUT.ui32Config;
+    }
+    else
+    {
+        *value = (gpio_state >> pin) & 1;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_gpio_interrupt_register(uint32_t pin, am_hal_gpio_handler_t handler)
+{
+    if (pin >= AM_HAL_GPIO_MAX_PADS)
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    gpio_handler[pin] = handler;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_gpio_interrupt_enable(uint64_t mask)
+{
+    gpio_interrupt_enabled |= mask;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_gpio_interrupt_disable(uint64_t mask)
+{
+    gpio_interrupt_enabled &= ~mask;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_gpio_interrupt_clear(uint64_t mask)
+{
+    (void)mask;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+bool am_hal_host_gpio_fire(uint32_t pin)
+{
+    if (pin >= AM_HAL_GPIO_MAX_PADS ||
+        !(gpio_interrupt_enabled & AM_HAL_GPIO_BIT(pin)) ||
+        !gpio_handler[pin])
+    {
+        return false;
+    }
+
+    host_isr_run(gpio_handler[pin]);
+    return true;
+}
+
+//*****************************************************************************
+//
+// CTIMER
+//
+//*****************************************************************************
+#define CTIMER_NUM_TIMERS   (8)
+#define CTIMER_NUM_SEGMENTS (2)
+#define CTIMER_NUM_INTS     (2 * CTIMER_NUM_TIMERS)
+
+typedef struct ctimer_segment_s
+{
+    uint32_t config;
+    uint32_t period;
+    bool running;
+} ctimer_segment_t;
+
+static ctimer_segment_t ctimer[CTIMER_NUM_TIMERS][CTIMER_NUM_SEGMENTS];
+static am_hal_ctimer_handler_t ctimer_handler[CTIMER_NUM_INTS];
+static uint32_t ctimer_interrupt_enabled;
+
+static void ctimer_apply(uint32_t timer, uint32_t segment, void (*op)(ctimer_segment_t *, uint32_t), uint32_t arg)
+{
+    if (timer >= CTIMER_NUM_TIMERS)
+    {
+        return;
+    }
+
+    if (segment & AM_HAL_CTIMER_TIMERA)
+    {
+        op(&ctimer[timer][0], arg);
+    }
+    if (segment & AM_HAL_CTIMER_TIMERB)
+    {
+        op(&ctimer[timer][1], arg);
+    }
+}
+
+static void ctimer_op_config(ctimer_segment_t *segment, uint32_t config) { segment->config = config; }
+static void ctimer_op_period(ctimer_segment_t *segment, uint32_t period) { segment->period = period; }
+static void ctimer_op_run(ctimer_segment_t *segment, uint32_t running) { segment->running = running; }
+
+void am_hal_ctimer_config_single(uint32_t timer, uint32_t segment, uint32_t config)
+{
+    ctimer_apply(timer, segment, ctimer_op_config, config);
+}
+
+void am_hal_ctimer_period_set(uint32_t timer, uint32_t segment, uint32_t period, uint32_t on_time)
+{
+    (void)on_time;
+    ctimer_apply(timer, segment, ctimer_op_period, period);
+}
+
+void am_hal_ctimer_start(uint32_t timer, uint32_t segment)
+{
+    ctimer_apply(timer, segment, ctimer_op_run, true);
+}
+
+void am_hal_ctimer_stop(uint32_t timer, uint32_t segment)
+{
+    ctimer_apply(timer, segment, ctimer_op_run, false);
+}
+
+void am_hal_ctimer_clear(uint32_t timer, uint32_t segment)
+{
+    ctimer_apply(timer, segment, ctimer_op_run, false);
+}
+
+uint32_t am_hal_ctimer_read(uint32_t timer, uint32_t segment)
+{
+    // Interrupts are only raised on the period boundary, where the count
+    // has just wrapped.
+    (void)timer;
+    (void)segment;
+    return 0;
+}
+
+void am_hal_ctimer_int_register(uint32_t interrupt, am_hal_ctimer_handler_t handler)
+{
+    for (uint32_t i = 0; i < CTIMER_NUM_INTS; i++)
+    {
+        if (interrupt & (1 << i))
+        {
+            ctimer_handler[i] = handler;
+        }
+    }
+}
+
+void am_hal_ctimer_int_enable(uint32_t interrupt)
+{
+    ctimer_interrupt_enabled |= interrupt;
+}
+
+void am_hal_ctimer_int_disable(uint32_t interrupt)
+{
+    ctimer_interrupt_enabled &= ~interrupt;
+}
+
+void am_hal_ctimer_int_clear(uint32_t interrupt)
+{
+    (void)interrupt;
+}
+
+bool am_hal_host_ctimer_fire(uint32_t interrupt)
+{
+    for (uint32_t i = 0; i < CTIMER_NUM_INTS; i++)
+    {
+        if (interrupt == (1u << i))
+        {
+            // Interrupt bits alternate between the A and B segments of
+            // successive timers.
+            if (!(ctimer_interrupt_enabled & interrupt) ||
+                !ctimer[i / 2][i % 2].running ||
+                !ctimer_handler[i])
+            {
+                return false;
+            }
+
+            host_isr_run(ctimer_handler[i]);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t am_hal_host_ctimer_period_us(uint32_t timer, uint32_t segment)
+{
+    if (timer >= CTIMER_NUM_TIMERS)
+    {
+        return 0;
+    }
+
+    ctimer_segment_t *s = &ctimer[timer][(segment & AM_HAL_CTIMER_TIMERA) ? 0 : 1];
+    uint64_t clock_hz;
+
+    if (!s->running)
+    {
+        return 0;
+    }
+
+    switch (s->config & AM_HAL_CTIMER_CLK_MASK)
+    {
+    case AM_HAL_CTIMER_HFRC_12MHZ:
+        clock_hz = 12000000;
+        break;
+    case AM_HAL_CTIMER_HFRC_3MHZ:
+        clock_hz = 3000000;
+        break;
+    case AM_HAL_CTIMER_HFRC_187_5KHZ:
+        clock_hz = 187500;
+        break;
+    case AM_HAL_CTIMER_HFRC_47KHZ:
+        clock_hz = 46875;
+        break;
+    case AM_HAL_CTIMER_HFRC_12KHZ:
+        clock_hz = 11719;
+        break;
+    default:
+        return 0;
+    }
+
+    return (uint32_t)(((uint64_t)s->period * 1000000) / clock_hz);
+}
+
+//*****************************************************************************
+//
+// IOM
+//
+//*****************************************************************************
+typedef struct iom_queued_s
+{
+    am_hal_iom_transfer_t transfer;
+    am_hal_iom_callback_t callback;
+    void *context;
+} iom_queued_t;
+
+typedef struct iom_module_s
+{
+    uint32_t module;
+    bool enabled;
+    am_hal_iom_config_t config;
+    uint32_t interrupt_enabled;
+    am_hal_host_iom_peer_t peer;
+    void *peer_context;
+    am_hal_host_iom_stats_t stats;
+
+    bool defer;
+    bool stall;
+    // The task adds at the tail and the tick takes from the head, so each
+    // index has a single writer.  Both count up without wrapping.
+    iom_queued_t queue[AM_HAL_HOST_IOM_QUEUE_DEPTH];
+    volatile uint32_t queue_head;
+    volatile uint32_t queue_tail;
+
+    uint32_t inject_status;
+    uint32_t inject_count;
+} iom_module_t;
+
+static iom_module_t iom[AM_REG_IOM_NUM_MODULES];
+
+uint32_t am_hal_iom_initialize(uint32_t module, void **handle)
+{
+    if (module >= AM_REG_IOM_NUM_MODULES)
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    iom[module].module = module;
+    *handle = &iom[module];
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_uninitialize(void *handle)
+{
+    if (!handle)
+    {
+        return AM_HAL_STATUS_INVALID_HANDLE;
+    }
+
+    ((iom_module_t *)handle)->queue_head = ((iom_module_t *)handle)->queue_tail;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_power_ctrl(void *handle, am_hal_sysctrl_power_state_e state, bool retain)
+{
+    (void)state;
+    (void)retain;
+    return handle ? AM_HAL_STATUS_SUCCESS : AM_HAL_STATUS_INVALID_HANDLE;
+}
+
+uint32_t am_hal_iom_configure(void *handle, const am_hal_iom_config_t *config)
+{
+    if (!handle)
+    {
+        return AM_HAL_STATUS_INVALID_HANDLE;
+    }
+
+    ((iom_module_t *)handle)->config = *config;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_enable(void *handle)
+{
+    if (!handle)
+    {
+        return AM_HAL_STATUS_INVALID_HANDLE;
+    }
+
+    ((iom_module_t *)handle)->enabled = true;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_disable(void *handle)
+{
+    if (!handle)
+    {
+        return AM_HAL_STATUS_INVALID_HANDLE;
+    }
+
+    ((iom_module_t *)handle)->enabled = false;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+static uint32_t iom_transfer(iom_module_t *m, const am_hal_iom_transfer_t *transfer)
+{
+    m->stats.transfers++;
+    m->stats.bytes += transfer->ui32InstrLen + transfer->ui32NumBytes;
+
+    if (m->inject_count)
+    {
+        m->inject_count--;
+        return m->inject_status;
+    }
+
+    if (!m->peer)
+    {
+        return AM_HAL_STATUS_FAIL;
+    }
+
+    return m->peer(m->peer_context, transfer);
+}
+
+// Reports a completed transfer as the command complete interrupt would.
+static void iom_complete(am_hal_iom_callback_t callback, void *context, uint32_t status)
+{
+    if (callback)
+    {
+        interrupt_depth++;
+        callback(context, status);
+        interrupt_depth--;
+    }
+}
+
+uint32_t am_hal_iom_blocking_transfer(void *handle, am_hal_iom_transfer_t *transfer)
+{
+    iom_module_t *m = (iom_module_t *)handle;
+
+    if (!m)
+    {
+        return AM_HAL_STATUS_INVALID_HANDLE;
+    }
+    if (!m->enabled)
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    return iom_transfer(m, transfer);
+}
+
+uint32_t am_hal_iom_nonblocking_transfer(void *handle, am_hal_iom_transfer_t *transfer,
+                                         am_hal_iom_callback_t callback, void *context)
+{
+    iom_module_t *m = (iom_module_t *)handle;
+
+    if (!m)
+    {
+        return AM_HAL_STATUS_INVALID_HANDLE;
+    }
+    if (!m->enabled)
+    {
+        return AM_HAL_STATUS_INVALID_OPERATION;
+    }
+
+    if (m->defer)
+    {
+        if (m->queue_tail - m->queue_head == AM_HAL_HOST_IOM_QUEUE_DEPTH)
+        {
+            return AM_HAL_STATUS_OUT_OF_RANGE;
+        }
+
+        iom_queued_t *queued = &m->queue[m->queue_tail % AM_HAL_HOST_IOM_QUEUE_DEPTH];
+        queued->transfer = *transfer;
+        queued->callback = callback;
+        queued->context = context;
+        m->queue_tail++;
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
+    iom_complete(callback, context, iom_transfer(m, transfer));
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_enable(void *handle, uint32_t mask)
+{
+    if (!handle)
+    {
+        return AM_HAL_STATUS_INVALID_HANDLE;
+    }
+
+    ((iom_module_t *)handle)->interrupt_enabled |= mask;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_disable(void *handle, uint32_t mask)
+{
+    if (!handle)
+    {
+        return AM_HAL_STATUS_INVALID_HANDLE;
+    }
+
+    ((iom_module_t *)handle)->interrupt_enabled &= ~mask;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_clear(void *handle, uint32_t mask)
+{
+    (void)mask;
+    return handle ? AM_HAL_STATUS_SUCCESS : AM_HAL_STATUS_INVALID_HANDLE;
+}
+
+uint32_t am_hal_iom_interrupt_status_get(void *handle, bool enabled_only, uint32_t *status)
+{
+    (void)enabled_only;
+    *status = 0;
+    return handle ? AM_HAL_STATUS_SUCCESS : AM_HAL_STATUS_INVALID_HANDLE;
+}
+
+uint32_t am_hal_iom_interrupt_service(void *handle, uint32_t status)
+{
+    (void)status;
+    return handle ? AM_HAL_STATUS_SUCCESS : AM_HAL_STATUS_INVALID_HANDLE;
+}
+
+void am_hal_host_iom_attach(uint32_t module, am_hal_host_iom_peer_t peer, void *context)
+{
+    if (module < AM_REG_IOM_NUM_MODULES)
+    {
+        iom[module].peer = peer;
+        iom[module].peer_context = context;
+    }
+}
+
+void am_hal_host_iom_stats(uint32_t module, am_hal_host_iom_stats_t *stats)
+{
+    if (module < AM_REG_IOM_NUM_MODULES)
+    {
+        *stats = iom[module].stats;
+    }
+}
+
+void am_hal_host_iom_stats_reset(uint32_t module)
+{
+    if (module < AM_REG_IOM_NUM_MODULES)
+    {
+        memset(&iom[module].stats, 0, sizeof(iom[module].stats));
+    }
+}
+
+void am_hal_host_iom_defer(uint32_t module, bool defer)
+{
+    if (module < AM_REG_IOM_NUM_MODULES)
+    {
+        iom[module].defer = defer;
+    }
+}
+
+void am_hal_host_iom_stall(uint32_t module, bool stall)
+{
+    if (module < AM_REG_IOM_NUM_MODULES)
+    {
+        iom[module].stall = stall;
+    }
+}
+
+uint32_t am_hal_host_iom_queued(uint32_t module)
+{
+    return (module < AM_REG_IOM_NUM_MODULES) ? iom[module].queue_tail - iom[module].queue_head : 0;
+}
+
+bool am_hal_host_iom_service(uint32_t module)
+{
+    if (module >= AM_REG_IOM_NUM_MODULES)
+    {
+        return false;
+    }
+
+    iom_module_t *m = &iom[module];
+
+    if (m->stall || (m->queue_tail == m->queue_head))
+    {
+        return false;
+    }
+
+    // Copied out so that the callback can queue the next transfer.
+    iom_queued_t queued = m->queue[m->queue_head % AM_HAL_HOST_IOM_QUEUE_DEPTH];
+    m->queue_head++;
+
+    iom_complete(queued.callback, queued.context, iom_transfer(m, &queued.transfer));
+
+    return true;
+}
+
+void am_hal_host_iom_tick(void)
+{
+    for (uint32_t module = 0; module < AM_REG_IOM_NUM_MODULES; module++)
+    {
+        am_hal_host_iom_service(module);
+    }
+}
+
+void am_hal_host_iom_inject(uint32_t module, uint32_t status, uint32_t count)
+{
+    if (module < AM_REG_IOM_NUM_MODULES)
+    {
+        iom[module].inject_status = status;
+        iom[module].inject_count = count;
+    }
+}
+
+//*****************************************************************************
+//
+// Flash
+//
+//*****************************************************************************
+static uint8_t flash_image[AM_HAL_FLASH_TOTAL_SIZE];
+static bool flash_ready;
+
+static uint8_t *flash(void)
+{
+    if (!flash_ready)
+    {
+        memset(flash_image, 0xFF, sizeof(flash_image));
+        flash_ready = true;
+    }
+
+    return flash_image;
+}
+
+void *am_hal_host_flash_address(uint32_t address)
+{
+    if (address - AM_HAL_FLASH_ADDR >= AM_HAL_FLASH_TOTAL_SIZE)
+    {
+        return NULL;
+    }
+
+    return flash() + (address - AM_HAL_FLASH_ADDR);
+}
+
+int am_hal_flash_page_erase(uint32_t key, uint32_t instance, uint32_t page)
+{
+    if (key != AM_HAL_FLASH_PROGRAM_KEY)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+    if (instance >= 2 || page >= AM_HAL_FLASH_INSTANCE_PAGES)
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    memset(flash() + instance * AM_HAL_FLASH_INSTANCE_SIZE + page * AM_HAL_FLASH_PAGE_SIZE,
+           0xFF, AM_HAL_FLASH_PAGE_SIZE);
+    return 0;
+}
+
+int am_hal_flash_program_main(uint32_t key, uint32_t *src, uint32_t *dst, uint32_t words)
+{
+    uint8_t *image = flash();
+    uint8_t *to = (uint8_t *)dst;
+
+    if (key != AM_HAL_FLASH_PROGRAM_KEY)
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    // dst is a host address from am_hal_host_flash_address().
+    if (to < image || to + 4 * (size_t)words > image + sizeof(flash_image))
+    {
+        return AM_HAL_STATUS_OUT_OF_RANGE;
+    }
+
+    // Programming can only clear bits, as on the real array.
+    const uint8_t *from = (const uint8_t *)src;
+    for (uint32_t i = 0; i < 4 * words; i++)
+    {
+        to[i] &= from[i];
+    }
+
+    return 0;
+}
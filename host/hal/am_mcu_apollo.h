@@ -0,0 +1,419 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _HOST_AM_MCU_APOLLO_H_
+#define _HOST_AM_MCU_APOLLO_H_
+
+/*
+ * Host stand-in for the Apollo3 HAL
+ *
+ * Only the parts of the HAL used by the sensor, algorithm and storage code
+ * are provided.  Peripherals are modelled just far enough for that code to
+ * run unchanged:
+ *
+ * - IOM transfers are handed to a peer attached to the module with
+ *   am_hal_host_iom_attach().  Non-blocking transfers complete before they
+ *   return, with the callback run as if from the IOM interrupt, unless
+ *   completion is deferred with am_hal_host_iom_defer().
+ * - GPIO and CTIMER interrupt handlers are run by am_hal_host_gpio_fire()
+ *   and am_hal_host_ctimer_fire() when they are enabled.
+ * - The STIMER counts a virtual clock that only moves with
+ *   am_hal_host_time_advance_us() and am_util_delay_us(), so runs are
+ *   repeatable.
+ * - The main flash is a RAM image, erased on start up.
+ * - DWT->CYCCNT counts nanoseconds of host time, so the profile probes
+ *   report nanoseconds instead of cycles.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*****************************************************************************
+//
+// Status codes
+//
+//*****************************************************************************
+enum
+{
+    AM_HAL_STATUS_SUCCESS,
+    AM_HAL_STATUS_FAIL,
+    AM_HAL_STATUS_INVALID_HANDLE,
+    AM_HAL_STATUS_IN_USE,
+    AM_HAL_STATUS_TIMEOUT,
+    AM_HAL_STATUS_OUT_OF_RANGE,
+    AM_HAL_STATUS_INVALID_ARG,
+    AM_HAL_STATUS_INVALID_OPERATION,
+    AM_HAL_STATUS_MEM_ERR,
+    AM_HAL_STATUS_HW_ERR,
+};
+
+//*****************************************************************************
+//
+// Core
+//
+//*****************************************************************************
+typedef enum
+{
+    GPIO_IRQn,
+    CTIMER_IRQn,
+    IOMSTR0_IRQn,
+    IOMSTR1_IRQn,
+    IOMSTR2_IRQn,
+    IOMSTR3_IRQn,
+    IOMSTR4_IRQn,
+    IOMSTR5_IRQn,
+    STIMER_IRQn,
+} IRQn_Type;
+
+static inline void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+static inline void NVIC_DisableIRQ(IRQn_Type irq) { (void)irq; }
+static inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+static inline void NVIC_SystemReset(void) { abort(); }
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+
+extern DWT_Type *am_hal_host_dwt(void);
+extern CoreDebug_Type am_hal_host_core_debug;
+
+// CYCCNT is refreshed from the host clock on every access.
+#define DWT         (am_hal_host_dwt())
+#define CoreDebug   (&am_hal_host_core_debug)
+
+extern uint32_t am_hal_interrupt_master_disable(void);
+extern uint32_t am_hal_interrupt_master_enable(void);
+extern void am_hal_interrupt_master_set(uint32_t primask);
+
+#define AM_CRITICAL_BEGIN                                                   \
+    if (1)                                                                  \
+    {                                                                       \
+        volatile uint32_t ui32Primask_04172010 = am_hal_interrupt_master_disable();
+
+#define AM_CRITICAL_END                                                     \
+        am_hal_interrupt_master_set(ui32Primask_04172010);                  \
+    }
+
+//*****************************************************************************
+//
+// GPIO
+//
+//*****************************************************************************
+#define AM_HAL_GPIO_MAX_PADS        (50)
+
+#define AM_HAL_GPIO_BIT(n)          (((uint64_t)0x1) << (n))
+#define AM_HAL_GPIO_MASKBIT(mask, n) ((mask) = AM_HAL_GPIO_BIT(n))
+
+typedef struct
+{
+    uint32_t ui32Config;
+} am_hal_gpio_pincfg_t;
+
+extern const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_DISABLE;
+extern const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_INPUT;
+extern const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_OUTPUT;
+
+typedef enum
+{
+    AM_HAL_GPIO_OUTPUT_CLEAR,
+    AM_HAL_GPIO_OUTPUT_SET,
+    AM_HAL_GPIO_OUTPUT_TOGGLE,
+    AM_HAL_GPIO_OUTPUT_TRISTATE_DISABLE,
+    AM_HAL_GPIO_OUTPUT_TRISTATE_ENABLE,
+    AM_HAL_GPIO_OUTPUT_TRISTATE_TOGGLE,
+} am_hal_gpio_write_type_e;
+
+typedef enum
+{
+    AM_HAL_GPIO_INPUT_READ,
+    AM_HAL_GPIO_OUTPUT_READ,
+    AM_HAL_GPIO_ENABLE_READ,
+} am_hal_gpio_read_type_e;
+
+typedef void (*am_hal_gpio_handler_t)(void);
+
+extern uint32_t am_hal_gpio_pinconfig(uint32_t pin, am_hal_gpio_pincfg_t config);
+extern uint32_t am_hal_gpio_state_write(uint32_t pin, am_hal_gpio_write_type_e type);
+extern uint32_t am_hal_gpio_state_read(uint32_t pin, am_hal_gpio_read_type_e type, uint32_t *value);
+extern uint32_t am_hal_gpio_interrupt_register(uint32_t pin, am_hal_gpio_handler_t handler);
+extern uint32_t am_hal_gpio_interrupt_enable(uint64_t mask);
+extern uint32_t am_hal_gpio_interrupt_disable(uint64_t mask);
+extern uint32_t am_hal_gpio_interrupt_clear(uint64_t mask);
+
+//*****************************************************************************
+//
+// CTIMER
+//
+//*****************************************************************************
+#define AM_HAL_CTIMER_TIMERA        (0x0000FFFF)
+#define AM_HAL_CTIMER_TIMERB        (0xFFFF0000)
+#define AM_HAL_CTIMER_BOTH          (0xFFFFFFFF)
+
+#define AM_HAL_CTIMER_CLK_PIN       (0x00)
+#define AM_HAL_CTIMER_HFRC_12MHZ    (0x02)
+#define AM_HAL_CTIMER_HFRC_3MHZ     (0x04)
+#define AM_HAL_CTIMER_HFRC_187_5KHZ (0x06)
+#define AM_HAL_CTIMER_HFRC_47KHZ    (0x08)
+#define AM_HAL_CTIMER_HFRC_12KHZ    (0x0A)
+#define AM_HAL_CTIMER_CLK_MASK      (0x3E)
+
+#define AM_HAL_CTIMER_FN_ONCE       (0 << 6)
+#define AM_HAL_CTIMER_FN_REPEAT     (1 << 6)
+#define AM_HAL_CTIMER_FN_PWM_ONCE   (2 << 6)
+#define AM_HAL_CTIMER_FN_PWM_REPEAT (3 << 6)
+#define AM_HAL_CTIMER_INT_ENABLE    (1 << 9)
+
+#define AM_HAL_CTIMER_INT_TIMERA0C0 (1 << 0)
+#define AM_HAL_CTIMER_INT_TIMERB0C0 (1 << 1)
+#define AM_HAL_CTIMER_INT_TIMERA1C0 (1 << 2)
+#define AM_HAL_CTIMER_INT_TIMERB1C0 (1 << 3)
+#define AM_HAL_CTIMER_INT_TIMERA2C0 (1 << 4)
+#define AM_HAL_CTIMER_INT_TIMERB2C0 (1 << 5)
+#define AM_HAL_CTIMER_INT_TIMERA3C0 (1 << 6)
+#define AM_HAL_CTIMER_INT_TIMERB3C0 (1 << 7)
+
+typedef void (*am_hal_ctimer_handler_t)(void);
+
+extern void am_hal_ctimer_config_single(uint32_t timer, uint32_t segment, uint32_t config);
+extern void am_hal_ctimer_period_set(uint32_t timer, uint32_t segment, uint32_t period, uint32_t on_time);
+extern void am_hal_ctimer_start(uint32_t timer, uint32_t segment);
+extern void am_hal_ctimer_stop(uint32_t timer, uint32_t segment);
+extern void am_hal_ctimer_clear(uint32_t timer, uint32_t segment);
+extern uint32_t am_hal_ctimer_read(uint32_t timer, uint32_t segment);
+extern void am_hal_ctimer_int_register(uint32_t interrupt, am_hal_ctimer_handler_t handler);
+extern void am_hal_ctimer_int_enable(uint32_t interrupt);
+extern void am_hal_ctimer_int_disable(uint32_t interrupt);
+extern void am_hal_ctimer_int_clear(uint32_t interrupt);
+
+//*****************************************************************************
+//
+// STIMER
+//
+//*****************************************************************************
+extern uint32_t am_hal_stimer_counter_get(void);
+
+//*****************************************************************************
+//
+// IOM
+//
+//*****************************************************************************
+#define AM_REG_IOM_NUM_MODULES      (6)
+
+#define AM_HAL_IOM_100KHZ           (100000)
+#define AM_HAL_IOM_400KHZ           (400000)
+#define AM_HAL_IOM_1MHZ             (1000000)
+#define AM_HAL_IOM_4MHZ             (4000000)
+#define AM_HAL_IOM_8MHZ             (8000000)
+#define AM_HAL_IOM_12MHZ            (12000000)
+#define AM_HAL_IOM_16MHZ            (16000000)
+#define AM_HAL_IOM_24MHZ            (24000000)
+
+#define AM_HAL_IOM_INT_CMDCMP       (1 << 0)
+#define AM_HAL_IOM_INT_ERR          (1 << 1)
+#define AM_HAL_IOM_INT_ALL          (0xFFFFFFFF)
+
+typedef enum
+{
+    AM_HAL_IOM_SPI_MODE,
+    AM_HAL_IOM_I2C_MODE,
+    AM_HAL_IOM_NUM_MODES
+} am_hal_iom_mode_e;
+
+typedef enum
+{
+    AM_HAL_IOM_SPI_MODE_0,
+    AM_HAL_IOM_SPI_MODE_1,
+    AM_HAL_IOM_SPI_MODE_2,
+    AM_HAL_IOM_SPI_MODE_3,
+} am_hal_iom_spi_mode_e;
+
+typedef enum
+{
+    AM_HAL_IOM_TX,
+    AM_HAL_IOM_RX,
+    AM_HAL_IOM_FULLDUPLEX,
+} am_hal_iom_dir_e;
+
+typedef enum
+{
+    AM_HAL_SYSCTRL_WAKE,
+    AM_HAL_SYSCTRL_NORMALSLEEP,
+    AM_HAL_SYSCTRL_DEEPSLEEP
+} am_hal_sysctrl_power_state_e;
+
+typedef struct
+{
+    am_hal_iom_mode_e eInterfaceMode;
+    uint32_t ui32ClockFreq;
+    am_hal_iom_spi_mode_e eSpiMode;
+    uint32_t *pNBTxnBuf;
+    uint32_t ui32NBTxnBufLength;
+} am_hal_iom_config_t;
+
+typedef struct
+{
+    union
+    {
+        uint32_t ui32SpiChipSelect;
+        uint32_t ui32I2CDevAddr;
+    } uPeerInfo;
+    uint32_t ui32InstrLen;
+    uint32_t ui32Instr;
+    uint32_t ui32NumBytes;
+    am_hal_iom_dir_e eDirection;
+    uint32_t *pui32TxBuffer;
+    uint32_t *pui32RxBuffer;
+    bool bContinue;
+    uint8_t ui8RepeatCount;
+    uint8_t ui8Priority;
+    uint32_t ui32PauseCondition;
+    uint32_t ui32StatusSetClr;
+} am_hal_iom_transfer_t;
+
+typedef void (*am_hal_iom_callback_t)(void *context, uint32_t status);
+
+extern uint32_t am_hal_iom_initialize(uint32_t module, void **handle);
+extern uint32_t am_hal_iom_uninitialize(void *handle);
+extern uint32_t am_hal_iom_power_ctrl(void *handle, am_hal_sysctrl_power_state_e state, bool retain);
+extern uint32_t am_hal_iom_configure(void *handle, const am_hal_iom_config_t *config);
+extern uint32_t am_hal_iom_enable(void *handle);
+extern uint32_t am_hal_iom_disable(void *handle);
+extern uint32_t am_hal_iom_blocking_transfer(void *handle, am_hal_iom_transfer_t *transfer);
+extern uint32_t am_hal_iom_nonblocking_transfer(void *handle, am_hal_iom_transfer_t *transfer,
+                                                am_hal_iom_callback_t callback, void *context);
+extern uint32_t am_hal_iom_interrupt_enable(void *handle, uint32_t mask);
+extern uint32_t am_hal_iom_interrupt_disable(void *handle, uint32_t mask);
+extern uint32_t am_hal_iom_interrupt_clear(void *handle, uint32_t mask);
+extern uint32_t am_hal_iom_interrupt_status_get(void *handle, bool enabled_only, uint32_t *status);
+extern uint32_t am_hal_iom_interrupt_service(void *handle, uint32_t status);
+
+//*****************************************************************************
+//
+// Flash
+//
+//*****************************************************************************
+#define AM_HAL_FLASH_PROGRAM_KEY    (0x12344321)
+#define AM_HAL_FLASH_ADDR           (0x00000000)
+#define AM_HAL_FLASH_PAGE_SIZE      (8 * 1024)
+#define AM_HAL_FLASH_INSTANCE_SIZE  (512 * 1024)
+#define AM_HAL_FLASH_INSTANCE_PAGES (AM_HAL_FLASH_INSTANCE_SIZE / AM_HAL_FLASH_PAGE_SIZE)
+#define AM_HAL_FLASH_TOTAL_SIZE     (2 * AM_HAL_FLASH_INSTANCE_SIZE)
+
+#define AM_HAL_FLASH_ADDR2INST(addr) (((addr) >> 19) & 0x1)
+#define AM_HAL_FLASH_ADDR2PAGE(addr) (((addr) >> 13) & 0x3F)
+
+extern int am_hal_flash_page_erase(uint32_t key, uint32_t instance, uint32_t page);
+extern int am_hal_flash_program_main(uint32_t key, uint32_t *src, uint32_t *dst, uint32_t words);
+
+//*****************************************************************************
+//
+// Host control of the stand-in peripherals
+//
+//*****************************************************************************
+
+/*
+ * An IOM peer answers the transfers of one module.  It returns an
+ * AM_HAL_STATUS_* code.  A module without a peer fails every transfer.
+ */
+typedef uint32_t (*am_hal_host_iom_peer_t)(void *context, const am_hal_iom_transfer_t *transfer);
+
+typedef struct am_hal_host_iom_stats_s
+{
+    uint32_t transfers;
+    uint64_t bytes;
+} am_hal_host_iom_stats_t;
+
+extern void am_hal_host_iom_attach(uint32_t module, am_hal_host_iom_peer_t peer, void *context);
+extern void am_hal_host_iom_stats(uint32_t module, am_hal_host_iom_stats_t *stats);
+extern void am_hal_host_iom_stats_reset(uint32_t module);
+
+/*
+ * With deferred completion, non-blocking transfers are queued, up to
+ * AM_HAL_HOST_IOM_QUEUE_DEPTH per module, and carried out in order by
+ * am_hal_host_iom_service(), or one per kernel tick by
+ * am_hal_host_iom_tick().  The peer only sees a transfer, and the buffer
+ * is only filled, when it completes.  A stalled module keeps its queue, as
+ * a hung bus would.  Uninitialising the module drops the queue without
+ * running the callbacks, as the abort does on the target.
+ */
+#define AM_HAL_HOST_IOM_QUEUE_DEPTH (4)
+
+extern void am_hal_host_iom_defer(uint32_t module, bool defer);
+extern void am_hal_host_iom_stall(uint32_t module, bool stall);
+extern uint32_t am_hal_host_iom_queued(uint32_t module);
+extern bool am_hal_host_iom_service(uint32_t module);
+extern void am_hal_host_iom_tick(void);
+
+// The next count transfers on the module, blocking or not, fail with
+// status without reaching the peer.
+extern void am_hal_host_iom_inject(uint32_t module, uint32_t status, uint32_t count);
+
+// Runs the handler registered for the pin if its interrupt is enabled.
+extern bool am_hal_host_gpio_fire(uint32_t pin);
+
+// Runs the handler registered for the interrupt if it is enabled and its
+// timer is running.
+extern bool am_hal_host_ctimer_fire(uint32_t interrupt);
+
+// Period of a running timer segment in microseconds, or 0 if it is stopped.
+extern uint32_t am_hal_host_ctimer_period_us(uint32_t timer, uint32_t segment);
+
+extern void am_hal_host_time_advance_us(uint64_t us);
+extern uint64_t am_hal_host_time_us(void);
+
+// True while a handler run by the host is executing.
+extern bool am_hal_host_in_isr(void);
+
+// Host address of a main flash address.
+extern void *am_hal_host_flash_address(uint32_t address);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
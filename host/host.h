@@ -0,0 +1,96 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _HOST_H_
+#define _HOST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A check run by the host build.  It returns false, after printing the
+ * reason with host_fail(), if the code under test misbehaves.  Checks may
+ * register profile probes, which are reported once all checks have run.
+ */
+typedef struct host_check_s
+{
+    const char *name;
+    bool (*run)(void);
+} host_check_t;
+
+extern bool host_fail(const char *format, ...);
+
+// host_checks.c
+extern bool host_check_shotdetect(void);
+extern bool host_check_shotdetect_q15(void);
+extern bool host_check_correlator(void);
+extern bool host_check_matched_filter(void);
+extern bool host_check_spectrum(void);
+extern bool host_check_ahrs(void);
+extern bool host_check_mag_fit(void);
+extern bool host_check_lfs(void);
+extern bool host_check_trace(void);
+extern bool host_check_bmi270(void);
+extern bool host_check_bmm350(void);
+extern bool host_check_fifo(void);
+extern bool host_check_decimator(void);
+extern bool host_check_sensor_bus(void);
+
+// host_replay.c
+typedef struct host_replay_detection_s
+{
+    uint32_t frame;         // index of the IMU frame in the trace
+    uint64_t timestamp;
+} host_replay_detection_t;
+
+typedef struct host_replay_s
+{
+    uint32_t imu_frames;
+    uint32_t mag_samples;
+    uint32_t cal_records;
+    uint32_t starts;
+    uint32_t lost;          // sequence numbers missing from the trace
+    bool truncated;
+    uint64_t elapsed_ns;
+    uint32_t detection_count;
+    uint32_t detection_max;
+    host_replay_detection_t *detections;
+} host_replay_t;
+
+extern bool host_replay_run(const uint8_t *data, size_t size, host_replay_t *replay);
+extern void host_replay_free(host_replay_t *replay);
+extern int host_replay_main(int argc, char **argv);
+
+// Deterministic noise in [-1, 1).
+extern float host_noise(uint32_t *seed);
+
+#endif
@@ -0,0 +1,1761 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <arm_math.h>
+
+#include "SEGGER_RTT.h"
+
+#include "sensors_config.h"
+#include "profile.h"
+
+#include "ahrs.h"
+#include "decimator.h"
+#include "imu.h"
+#include "imu_fifo_bench.h"
+#include "mag.h"
+#include "mag_fit.h"
+#include "sensor_bus.h"
+#include "sensor_time.h"
+
+#include "alg_matched_filter.h"
+#include "alg_shotdetect.h"
+#include "alg_shotdetect_q15.h"
+#include "alg_spectrum.h"
+
+#include "application_task.h"
+#include "application_trace.h"
+
+#include "bmi270_sim.h"
+#include "bmm350_oor.h"
+#include "bmm350_sim.h"
+
+#include "lfs.h"
+#include "lfs_hal.h"
+
+#include "host.h"
+
+#define GRAVITY                 (9.80665f)
+
+/*
+ * Shot detection.  The detectors are set up as in application_task.c and
+ * fed 10s of 400Hz frames at rest with an impact every 2.5s.
+ */
+#define SHOT_RATE_HZ            (400)
+#define SHOT_FRAMES             (4000)
+#define SHOT_INTERVAL           (1000)
+#define SHOT_LENGTH             (8)
+#define SHOT_EXPECTED           (SHOT_FRAMES / SHOT_INTERVAL)
+#define SHOT_SIGNAL_LENGTH      (32)
+#define SHOT_TRIGGER            (1500)
+#define SHOT_IDLE               (1000)
+#define SHOT_Q15_LSB            (32.0f * GRAVITY / 32768.0f)
+
+// One 16G LSB in m/s^2.
+#define ACC_16G_LSB             (16.0f * GRAVITY / 32768.0f)
+
+static float32_t shot_reference[SHOT_SIGNAL_LENGTH] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 1.0f,
+    1.0f, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static imu_context_t shot_frames[SHOT_FRAMES];
+
+static void shot_frames_generate(void)
+{
+    uint32_t seed = 1;
+
+    for (uint32_t i = 0; i < SHOT_FRAMES; i++)
+    {
+        imu_context_t *frame = &shot_frames[i];
+        uint32_t phase = i % SHOT_INTERVAL;
+        float32_t az = GRAVITY;
+
+        // Impacts start half way through each interval.
+        if ((phase >= SHOT_INTERVAL / 2) && (phase < SHOT_INTERVAL / 2 + SHOT_LENGTH))
+        {
+            az = 12.0f * GRAVITY;
+        }
+
+        memset(frame, 0, sizeof(*frame));
+        frame->timestamp = (uint64_t)i * 1000000 / SHOT_RATE_HZ;
+        frame->acc_range = BMI2_ACC_RANGE_16G;
+        frame->ax = (int16_t)(0.05f * GRAVITY * host_noise(&seed) / ACC_16G_LSB);
+        frame->ay = (int16_t)(0.05f * GRAVITY * host_noise(&seed) / ACC_16G_LSB);
+        frame->az = (int16_t)(az / ACC_16G_LSB);
+    }
+}
+
+bool host_check_shotdetect(void)
+{
+    static profile_t probe = {.name = "shotdetect"};
+    static alg_shotdetect_context_t context;
+    static float32_t sampled[SHOT_SIGNAL_LENGTH];
+    static q15_t accel[3 * ALG_SHOTDETECT_BLOCK_MAX];
+    static float32_t scale[ALG_SHOTDETECT_BLOCK_MAX];
+    static float32_t scratch[3 * ALG_SHOTDETECT_BLOCK_MAX];
+    uint32_t shots[ALG_SHOTDETECT_BLOCK_MAX];
+    uint32_t detected = 0;
+
+    shot_frames_generate();
+    profile_register(&probe);
+
+    context.state = ALG_SHOTDETECT_IDLE;
+    context.trigger_threshold = SHOT_TRIGGER;
+    context.idle_threshold = SHOT_IDLE;
+    context.sampled_signal = sampled;
+    context.reference_signal = shot_reference;
+    context.signal_length = SHOT_SIGNAL_LENGTH;
+    context.sampling_period_ms = 1000 / SHOT_RATE_HZ;
+    if (alg_shotdetect_init(&context) != 0)
+    {
+        return host_fail("init failed");
+    }
+
+    // The scale normally comes from imu_lsb_to_mps2(), which needs a
+    // configured BMI270.
+    for (uint32_t i = 0; i < ALG_SHOTDETECT_BLOCK_MAX; i++)
+    {
+        scale[i] = ACC_16G_LSB * 32768.0f;
+    }
+
+    for (uint32_t i = 0; i < SHOT_FRAMES; i += ALG_SHOTDETECT_BLOCK_MAX)
+    {
+        uint32_t count = SHOT_FRAMES - i < ALG_SHOTDETECT_BLOCK_MAX ? SHOT_FRAMES - i : ALG_SHOTDETECT_BLOCK_MAX;
+
+        for (uint32_t j = 0; j < count; j++)
+        {
+            accel[3 * j + 0] = shot_frames[i + j].ax;
+            accel[3 * j + 1] = shot_frames[i + j].ay;
+            accel[3 * j + 2] = shot_frames[i + j].az;
+        }
+
+        profile_start(&probe);
+        detected += alg_shotdetect_block(&context, accel, scale, count, scratch, shots, ALG_SHOTDETECT_BLOCK_MAX);
+        profile_stop(&probe);
+    }
+
+    if (detected != SHOT_EXPECTED)
+    {
+        return host_fail("%u shots detected, expected %u", detected, SHOT_EXPECTED);
+    }
+
+    return true;
+}
+
+bool host_check_shotdetect_q15(void)
+{
+    static profile_t probe = {.name = "shotdetect q15"};
+    static alg_shotdetect_q15_context_t context;
+    static q15_t sampled[2 * SHOT_SIGNAL_LENGTH];
+    static q15_t weights[SHOT_SIGNAL_LENGTH];
+    uint32_t shots[ALG_SHOTDETECT_BLOCK_MAX];
+    uint32_t detected = 0;
+
+    shot_frames_generate();
+    profile_register(&probe);
+
+    if (alg_shotdetect_q15_init(&context, shot_reference, weights, sampled, SHOT_SIGNAL_LENGTH,
+                                SHOT_TRIGGER, SHOT_IDLE, SHOT_Q15_LSB) != 0)
+    {
+        return host_fail("init failed");
+    }
+
+    for (uint32_t i = 0; i < SHOT_FRAMES; i += ALG_SHOTDETECT_BLOCK_MAX)
+    {
+        uint32_t count = SHOT_FRAMES - i < ALG_SHOTDETECT_BLOCK_MAX ? SHOT_FRAMES - i : ALG_SHOTDETECT_BLOCK_MAX;
+
+        profile_start(&probe);
+        detected += application_alg_shotdetect_q15_block(&shot_frames[i], count, &context, shots, ALG_SHOTDETECT_BLOCK_MAX);
+        profile_stop(&probe);
+    }
+
+    if (detected != SHOT_EXPECTED)
+    {
+        return host_fail("%u shots detected, expected %u", detected, SHOT_EXPECTED);
+    }
+
+    return true;
+}
+
+/*
+ * Trace record and replay.  The shot frames are traced as FIFO drains of
+ * TRACE_CHUNK frames, each with a magnetometer sample, and the channel is
+ * emptied after every drain as the probe would.  The replay must see every
+ * record and detect every shot.
+ */
+#define TRACE_CHUNK             (20)
+#define TRACE_CHUNKS            (SHOT_FRAMES / TRACE_CHUNK)
+#define TRACE_RECORD_SIZE(t)    (sizeof(trace_record_t) + sizeof(t))
+#define TRACE_SIZE              (TRACE_RECORD_SIZE(trace_start_t) + \
+                                 TRACE_RECORD_SIZE(mag_cal_t) + \
+                                 SHOT_FRAMES * TRACE_RECORD_SIZE(trace_imu_t) + \
+                                 TRACE_CHUNKS * TRACE_RECORD_SIZE(trace_mag_t))
+
+bool host_check_trace(void)
+{
+    static uint8_t trace[TRACE_SIZE];
+    application_trace_stats_t stats;
+    host_replay_t replay;
+    mag_context_t mag;
+    mag_cal_t cal;
+    size_t size = 0;
+
+    shot_frames_generate();
+    memset(&cal, 0, sizeof(cal));
+    mag_cal_reset(&cal);
+    cal.initialised = 1;
+    memset(&mag, 0, sizeof(mag));
+
+    application_trace_start();
+    for (uint32_t i = 0; i < TRACE_CHUNKS; i++)
+    {
+        mag.timestamp = shot_frames[i * TRACE_CHUNK].timestamp;
+        mag.mx = 20.0f;
+
+        application_trace_imu(&shot_frames[i * TRACE_CHUNK], TRACE_CHUNK);
+        application_trace_mag(&mag);
+        application_trace_cal(&cal);
+        size += SEGGER_RTT_ReadUpBuffer(SENSORS_TRACE_RTT_CHANNEL, &trace[size], sizeof(trace) - size);
+    }
+    application_trace_stop();
+    application_trace_stats(&stats);
+
+    if (stats.dropped || (size != TRACE_SIZE) || (stats.bytes != size))
+    {
+        return host_fail("%u bytes traced, %u dropped", size, stats.dropped);
+    }
+
+    if (!host_replay_run(trace, size, &replay))
+    {
+        return false;
+    }
+
+    bool passed = true;
+    if ((replay.imu_frames != SHOT_FRAMES) || (replay.mag_samples != TRACE_CHUNKS) ||
+        (replay.cal_records != 1) || replay.lost || replay.truncated)
+    {
+        passed = host_fail("replayed %u frames, %u samples, %u corrections, %u lost",
+            replay.imu_frames, replay.mag_samples, replay.cal_records, replay.lost);
+    }
+    else if (replay.detection_count != SHOT_EXPECTED)
+    {
+        passed = host_fail("%u shots detected, expected %u", replay.detection_count, SHOT_EXPECTED);
+    }
+
+    host_replay_free(&replay);
+
+    return passed;
+}
+
+/*
+ * Correlator.  The window sums are kept in single precision, so an hour of
+ * 400Hz samples riding on gravity is pushed through it and the output must
+ * still agree with the arm_conv_f32() form.
+ */
+#define CORRELATOR_SAMPLES      (400 * 3600)
+#define CORRELATOR_COMPARE      (100000)
+#define CORRELATOR_TOLERANCE    (1.0e-7f)
+
+bool host_check_correlator(void)
+{
+    static alg_correlator_t correlator;
+    static float32_t buffer[SHOT_SIGNAL_LENGTH];
+    static float32_t signal[SHOT_SIGNAL_LENGTH];
+    static float32_t convolved[2 * SHOT_SIGNAL_LENGTH - 1];
+    uint32_t seed = 1;
+    float32_t scale = 0.0f;
+    float32_t worst = 0.0f;
+
+    if (alg_correlator_init(&correlator, shot_reference, buffer, SHOT_SIGNAL_LENGTH) != 0)
+    {
+        return host_fail("init failed");
+    }
+
+    // Errors are measured against the output for a buffer of samples at
+    // the largest magnitude pushed.
+    for (uint32_t i = 0; i < correlator.tap_count; i++)
+    {
+        const alg_correlator_tap_t *tap = &correlator.taps[i];
+        scale += fabsf(tap->weight) * (tap->age_oldest - tap->age_newest + 1) * 13.0f * GRAVITY;
+    }
+
+    for (uint32_t i = 1; i <= CORRELATOR_SAMPLES; i++)
+    {
+        float32_t sample = GRAVITY + 0.05f * GRAVITY * host_noise(&seed);
+
+        if (i % SHOT_INTERVAL < SHOT_LENGTH)
+        {
+            sample = 12.0f * GRAVITY;
+        }
+
+        float32_t output = alg_correlator_push(&correlator, sample);
+        if (i % CORRELATOR_COMPARE == 0)
+        {
+            float32_t error = fabsf(output - alg_correlator_reference(&correlator, shot_reference, signal, convolved));
+
+            worst = error > worst ? error : worst;
+        }
+    }
+
+    am_util_stdio_printf("    worst error %e of %e after %u samples\n", worst, scale, CORRELATOR_SAMPLES);
+
+    if (worst > CORRELATOR_TOLERANCE * scale)
+    {
+        return host_fail("output drifted by %e", worst);
+    }
+
+    return true;
+}
+
+/*
+ * Matched filter.  A chirp template is buried in low level noise on top of
+ * gravity, as in the acceleration magnitude, and must be reported once, at
+ * the end of the window that holds it, within a hop and a template length
+ * of it.  The second run adds a longer template after the chirp, which
+ * grows the block and must carry the chirp over.
+ */
+#define MATCHED_SAMPLES         (6000)
+#define MATCHED_TEMPLATE_LENGTH (64)
+#define MATCHED_TEMPLATE_ID     (7)
+#define MATCHED_LONG_LENGTH     (300)
+#define MATCHED_LONG_ID         (8)
+#define MATCHED_POSITION        (2500)
+#define MATCHED_CHUNK           (32)
+
+static bool host_check_matched_filter_run(alg_matched_filter_t *bank, const float32_t *signal, profile_t *probe)
+{
+    alg_matched_filter_detection_t detections[4];
+    uint32_t expected = MATCHED_POSITION + MATCHED_TEMPLATE_LENGTH - 1;
+    uint32_t found = 0;
+
+    for (uint32_t i = 0; i < MATCHED_SAMPLES; i += MATCHED_CHUNK)
+    {
+        profile_start(probe);
+        uint32_t detected = alg_matched_filter_push(bank, &signal[i], MATCHED_CHUNK, detections, 4);
+        profile_stop(probe);
+
+        for (uint32_t j = 0; j < detected && j < 4; j++)
+        {
+            if (detections[j].id != MATCHED_TEMPLATE_ID ||
+                detections[j].position + 1 < expected ||
+                detections[j].position > expected + 1)
+            {
+                return host_fail("template %u detected at %u, expected %u at %u",
+                                 detections[j].id, detections[j].position,
+                                 MATCHED_TEMPLATE_ID, expected);
+            }
+            if (i + MATCHED_CHUNK > expected + bank->hop + bank->template_max + MATCHED_CHUNK)
+            {
+                return host_fail("detection at %u reported at %u, block %u", expected, i + MATCHED_CHUNK, bank->fft_length);
+            }
+        }
+        found += detected;
+    }
+
+    if (found != 1)
+    {
+        return host_fail("%u detections, expected 1", found);
+    }
+
+    return true;
+}
+
+bool host_check_matched_filter(void)
+{
+    static profile_t probe = {.name = "matched filter"};
+    static alg_matched_filter_t bank;
+    static float32_t reference[MATCHED_TEMPLATE_LENGTH];
+    static float32_t reference_long[MATCHED_LONG_LENGTH];
+    static float32_t signal[MATCHED_SAMPLES];
+    uint32_t seed = 2;
+
+    profile_register(&probe);
+
+    for (uint32_t i = 0; i < MATCHED_TEMPLATE_LENGTH; i++)
+    {
+        float32_t t = (float32_t)i / MATCHED_TEMPLATE_LENGTH;
+        reference[i] = sinf(2.0f * PI * (2.0f + 6.0f * t) * t) * sinf(PI * t);
+    }
+    for (uint32_t i = 0; i < MATCHED_LONG_LENGTH; i++)
+    {
+        reference_long[i] = sinf(2.0f * PI * 17.0f * i / MATCHED_LONG_LENGTH);
+    }
+    for (uint32_t i = 0; i < MATCHED_SAMPLES; i++)
+    {
+        signal[i] = GRAVITY + 0.05f * host_noise(&seed);
+    }
+    for (uint32_t i = 0; i < MATCHED_TEMPLATE_LENGTH; i++)
+    {
+        signal[MATCHED_POSITION + i] += 3.0f * reference[i];
+    }
+
+    alg_matched_filter_init(&bank, 0.01f);
+    if (alg_matched_filter_add(&bank, MATCHED_TEMPLATE_ID, reference, MATCHED_TEMPLATE_LENGTH, 0.8f) != 0)
+    {
+        return host_fail("template rejected");
+    }
+    am_util_stdio_printf("    %u sample template: block %u, hop %u\n", MATCHED_TEMPLATE_LENGTH, bank.fft_length, bank.hop);
+    if (!host_check_matched_filter_run(&bank, signal, &probe))
+    {
+        return false;
+    }
+
+    alg_matched_filter_init(&bank, 0.01f);
+    if ((alg_matched_filter_add(&bank, MATCHED_TEMPLATE_ID, reference, MATCHED_TEMPLATE_LENGTH, 0.8f) != 0) ||
+        (alg_matched_filter_add(&bank, MATCHED_LONG_ID, reference_long, MATCHED_LONG_LENGTH, 0.8f) != 0))
+    {
+        return host_fail("templates rejected");
+    }
+    am_util_stdio_printf("    %u sample template: block %u, hop %u\n", MATCHED_LONG_LENGTH, bank.fft_length, bank.hop);
+
+    return host_check_matched_filter_run(&bank, signal, &probe);
+}
+
+/*
+ * Vibration spectrum.  Tones on x and y must come out at their frequency
+ * with their RMS amplitude.
+ */
+#define SPECTRUM_RATE_HZ        (400.0f)
+#define SPECTRUM_SAMPLES        (8 * ALG_SPECTRUM_HOP + ALG_SPECTRUM_FFT_LENGTH)
+#define SPECTRUM_CHUNK          (32)
+#define SPECTRUM_X_HZ           (50.0f)
+#define SPECTRUM_X_AMPLITUDE    (2.0f)
+#define SPECTRUM_Y_HZ           (120.0f)
+#define SPECTRUM_Y_AMPLITUDE    (0.5f)
+
+static const float32_t spectrum_band_edges[] = {
+    2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 100.0f, 200.0f
+};
+
+bool host_check_spectrum(void)
+{
+    static profile_t probe = {.name = "spectrum"};
+    static alg_spectrum_t spectrum;
+    alg_spectrum_summary_t summary;
+    float32_t x[SPECTRUM_CHUNK];
+    float32_t y[SPECTRUM_CHUNK];
+    float32_t z[SPECTRUM_CHUNK];
+    bool ready = false;
+
+    profile_register(&probe);
+
+    if (alg_spectrum_init(&spectrum, SPECTRUM_RATE_HZ, spectrum_band_edges,
+                          sizeof(spectrum_band_edges) / sizeof(spectrum_band_edges[0]) - 1, 8) != 0)
+    {
+        return host_fail("init failed");
+    }
+
+    for (uint32_t i = 0; i < SPECTRUM_SAMPLES && !ready; i += SPECTRUM_CHUNK)
+    {
+        for (uint32_t j = 0; j < SPECTRUM_CHUNK; j++)
+        {
+            float32_t t = (float32_t)(i + j) / SPECTRUM_RATE_HZ;
+            x[j] = SPECTRUM_X_AMPLITUDE * sinf(2.0f * PI * SPECTRUM_X_HZ * t);
+            y[j] = SPECTRUM_Y_AMPLITUDE * sinf(2.0f * PI * SPECTRUM_Y_HZ * t);
+            z[j] = GRAVITY;
+        }
+
+        profile_start(&probe);
+        alg_spectrum_push(&spectrum, x, y, z, SPECTRUM_CHUNK);
+        profile_stop(&probe);
+
+        ready = alg_spectrum_summary(&spectrum, &summary);
+    }
+
+    if (!ready)
+    {
+        return host_fail("no summary");
+    }
+
+    float32_t resolution = SPECTRUM_RATE_HZ / ALG_SPECTRUM_FFT_LENGTH;
+    if (fabsf(summary.peak_hz[0] - SPECTRUM_X_HZ) > resolution ||
+        fabsf(summary.peak_hz[1] - SPECTRUM_Y_HZ) > resolution)
+    {
+        return host_fail("peaks at %.1fHz and %.1fHz", summary.peak_hz[0], summary.peak_hz[1]);
+    }
+
+    if (fabsf(summary.rms[0] - SPECTRUM_X_AMPLITUDE / sqrtf(2.0f)) > 0.02f * SPECTRUM_X_AMPLITUDE ||
+        fabsf(summary.rms[1] - SPECTRUM_Y_AMPLITUDE / sqrtf(2.0f)) > 0.02f * SPECTRUM_Y_AMPLITUDE ||
+        summary.rms[2] > 0.001f)
+    {
+        return host_fail("RMS %.3f %.3f %.3f", summary.rms[0], summary.rms[1], summary.rms[2]);
+    }
+
+    return true;
+}
+
+/*
+ * AHRS.  A device held still at 30 degrees of roll must converge to it
+ * from the identity.  A device that starts 69 degrees away from the
+ * identity and turns at 1.2 rad/s about a tilted axis must be within a
+ * degree half a second after the start up gain is dropped, and then track
+ * the rotation.  The gradient step is taken against the orientation of the
+ * previous sample, so the tracking error settles at about one sample of
+ * rotation (0.7 degrees at 1.2 rad/s and 100Hz).
+ */
+#define AHRS_RATE_HZ            (100)
+#define AHRS_SECONDS            (5)
+#define AHRS_ROLL               (30.0f * PI / 180.0f)
+#define AHRS_TOLERANCE          (1.0f * PI / 180.0f)
+#define AHRS_TRACK_SECONDS      (12)
+#define AHRS_TRACK_RATE         (1.2f)
+#define AHRS_TRACK_OFFSET       (69.0f * PI / 180.0f)
+#define AHRS_TRACK_SETTLE_US    (AHRS_STARTUP_US + 500000)
+#define AHRS_TRACK_TOLERANCE    (0.8f * PI / 180.0f)
+
+// a * b for quaternions stored w, x, y, z.
+static void ahrs_quat_mult(const float32_t a[4], const float32_t b[4], float32_t q[4])
+{
+    q[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+    q[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+    q[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+    q[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+// Rotates an earth frame vector into the sensor frame of orientation q.
+static void ahrs_earth_to_sensor(const float32_t q[4], const float32_t earth[3], float32_t sensor[3])
+{
+    const float32_t conj[4] = {q[0], -q[1], -q[2], -q[3]};
+    const float32_t v[4] = {0.0f, earth[0], earth[1], earth[2]};
+    float32_t t[4];
+    float32_t r[4];
+
+    ahrs_quat_mult(conj, v, t);
+    ahrs_quat_mult(t, q, r);
+    sensor[0] = r[1];
+    sensor[1] = r[2];
+    sensor[2] = r[3];
+}
+
+static bool host_check_ahrs_tracking(profile_t *probe)
+{
+    // The rotation axis is fixed in the sensor frame.
+    const float32_t axis[3] = {0.36f, -0.48f, 0.80f};
+    const float32_t gravity[3] = {0.0f, 0.0f, GRAVITY};
+    const float32_t field[3] = {20.0f, 0.0f, -40.0f};
+    const float32_t start[4] = {cosf(AHRS_TRACK_OFFSET / 2.0f), sinf(AHRS_TRACK_OFFSET / 2.0f), 0.0f, 0.0f};
+    float32_t converged = 0.0f;
+    float32_t tracking = 0.0f;
+    ahrs_t ahrs;
+
+    ahrs_init(&ahrs, AHRS_BETA);
+
+    for (uint32_t i = 1; i <= AHRS_RATE_HZ * AHRS_TRACK_SECONDS; i++)
+    {
+        float32_t half = 0.5f * AHRS_TRACK_RATE * i / AHRS_RATE_HZ;
+        const float32_t turn[4] = {cosf(half), axis[0] * sinf(half), axis[1] * sinf(half), axis[2] * sinf(half)};
+        const float32_t gyr[3] = {AHRS_TRACK_RATE * axis[0], AHRS_TRACK_RATE * axis[1], AHRS_TRACK_RATE * axis[2]};
+        float32_t truth[4];
+        float32_t acc[3];
+        float32_t mag[3];
+
+        ahrs_quat_mult(start, turn, truth);
+        ahrs_earth_to_sensor(truth, gravity, acc);
+        ahrs_earth_to_sensor(truth, field, mag);
+
+        profile_start(probe);
+        ahrs_update(&ahrs, gyr, acc, mag, (uint64_t)i * 1000000 / AHRS_RATE_HZ);
+        profile_stop(probe);
+
+        float32_t dot = fabsf(ahrs.q0 * truth[0] + ahrs.q1 * truth[1] + ahrs.q2 * truth[2] + ahrs.q3 * truth[3]);
+        float32_t error = 2.0f * acosf(dot > 1.0f ? 1.0f : dot);
+
+        if (i == AHRS_RATE_HZ * AHRS_TRACK_SETTLE_US / 1000000)
+        {
+            converged = error;
+        }
+        else if (i > AHRS_RATE_HZ * AHRS_TRACK_SETTLE_US / 1000000)
+        {
+            tracking = error > tracking ? error : tracking;
+        }
+    }
+
+    am_util_stdio_printf("    tracking: %.2f degrees after %ums, worst %.2f degrees after\n",
+        converged * 180.0f / PI, AHRS_TRACK_SETTLE_US / 1000, tracking * 180.0f / PI);
+
+    if (converged > AHRS_TOLERANCE)
+    {
+        return host_fail("%.2f degrees off after %ums", converged * 180.0f / PI, AHRS_TRACK_SETTLE_US / 1000);
+    }
+    if (tracking > AHRS_TRACK_TOLERANCE)
+    {
+        return host_fail("tracking error reached %.2f degrees", tracking * 180.0f / PI);
+    }
+
+    return true;
+}
+
+bool host_check_ahrs(void)
+{
+    static profile_t probe = {.name = "ahrs"};
+    ahrs_t ahrs;
+    ahrs_euler_t euler;
+
+    // Gravity and a 45uT field dipping at 63 degrees, in the frame of a
+    // device rolled about x.
+    const float32_t gyr[3] = {0.0f, 0.0f, 0.0f};
+    const float32_t acc[3] = {0.0f, GRAVITY * sinf(AHRS_ROLL), GRAVITY * cosf(AHRS_ROLL)};
+    const float32_t mag[3] = {20.0f, -40.0f * sinf(AHRS_ROLL), -40.0f * cosf(AHRS_ROLL)};
+
+    profile_register(&probe);
+    ahrs_init(&ahrs, AHRS_BETA);
+
+    for (uint32_t i = 1; i <= AHRS_RATE_HZ * AHRS_SECONDS; i++)
+    {
+        profile_start(&probe);
+        ahrs_update(&ahrs, gyr, acc, mag, (uint64_t)i * 1000000 / AHRS_RATE_HZ);
+        profile_stop(&probe);
+    }
+
+    ahrs_euler(&ahrs, &euler);
+    if (fabsf(euler.roll - AHRS_ROLL) > AHRS_TOLERANCE || fabsf(euler.pitch) > AHRS_TOLERANCE)
+    {
+        return host_fail("roll %.2f pitch %.2f degrees", euler.roll * 180.0f / PI, euler.pitch * 180.0f / PI);
+    }
+
+    return host_check_ahrs_tracking(&probe);
+}
+
+/*
+ * Magnetometer ellipsoid fit.  Samples of a 45uT field seen through a hard
+ * and soft iron distortion are taken over a sweep of orientations.  Once
+ * corrected with the fit their magnitude must be constant.
+ */
+#define MAG_SAMPLES             (2000)
+#define MAG_FIELD               (45.0f)
+
+static void mag_sample_distorted(uint32_t i, mag_context_t *context)
+{
+    float32_t azimuth = 2.0f * PI * (float32_t)i / 97.0f;
+    float32_t elevation = PI * ((float32_t)i / MAG_SAMPLES - 0.5f);
+    float32_t fx = MAG_FIELD * cosf(elevation) * cosf(azimuth);
+    float32_t fy = MAG_FIELD * cosf(elevation) * sinf(azimuth);
+    float32_t fz = MAG_FIELD * sinf(elevation);
+
+    memset(context, 0, sizeof(*context));
+    context->timestamp = (uint64_t)i * MAG_ODR_PERIOD_US;
+    context->mx = 1.10f * fx + 0.05f * fy + 12.0f;
+    context->my = 0.05f * fx + 0.90f * fy - 0.03f * fz - 7.0f;
+    context->mz = -0.03f * fy + 1.02f * fz + 25.0f;
+}
+
+bool host_check_mag_fit(void)
+{
+    static profile_t probe = {.name = "mag fit"};
+    static mag_fit_t fit;
+    mag_context_t context;
+    mag_cal_t cal;
+
+    profile_register(&probe);
+    mag_fit_init(&fit);
+
+    for (uint32_t i = 0; i < MAG_SAMPLES; i++)
+    {
+        mag_sample_distorted(i, &context);
+
+        profile_start(&probe);
+        mag_fit_step(&fit, &context);
+        profile_stop(&probe);
+    }
+
+    memset(&cal, 0, sizeof(cal));
+    if (!mag_fit_solve(&fit, &cal))
+    {
+        return host_fail("no solution after %u samples, error %.4f", fit.samples, fit.error);
+    }
+
+    float32_t min = INFINITY;
+    float32_t max = 0.0f;
+    for (uint32_t i = 0; i < MAG_SAMPLES; i++)
+    {
+        mag_sample_distorted(i, &context);
+        mag_cal_apply(&cal, &context);
+
+        float32_t magnitude = sqrtf(context.mx * context.mx + context.my * context.my + context.mz * context.mz);
+        min = magnitude < min ? magnitude : min;
+        max = magnitude > max ? magnitude : max;
+    }
+
+    if (max - min > 0.02f * max)
+    {
+        return host_fail("corrected magnitude from %.2f to %.2f", min, max);
+    }
+
+    return true;
+}
+
+/*
+ * Storage.  A min/max calibration left by an earlier release on the 4 page
+ * file system at the top of the data pages must be carried over when the
+ * current one is formatted.  A calibration and a template written through
+ * littlefs must then read back unchanged after a remount.
+ */
+#define LFS_LEGACY_NUM_PAGES    (4)
+#define LFS_LEGACY_START_PAGE   ((AM_HAL_FLASH_INSTANCE_PAGES - 1) - 2 - 2 - LFS_LEGACY_NUM_PAGES)
+#define LFS_FIRST_PAGE          ((AM_HAL_FLASH_INSTANCE_PAGES - 1) - 2 - 2 - 16)
+
+static bool host_check_lfs_legacy(void)
+{
+    static uint8_t read_buffer[16];
+    static uint8_t prog_buffer[16];
+    static uint8_t lookahead_buffer[16];
+    static const struct lfs_config legacy = {
+        .context = (void *)LFS_LEGACY_START_PAGE,
+        .read = littlefs_hal_read,
+        .prog = littlefs_hal_prog,
+        .erase = littlefs_hal_erase,
+        .sync = littlefs_hal_sync,
+        .read_size = 4,
+        .prog_size = 4,
+        .block_size = AM_HAL_FLASH_PAGE_SIZE,
+        .block_count = LFS_LEGACY_NUM_PAGES,
+        .cache_size = 16,
+        .lookahead_size = 16,
+        .block_cycles = 500,
+        .read_buffer = read_buffer,
+        .prog_buffer = prog_buffer,
+        .lookahead_buffer = lookahead_buffer,
+    };
+    static lfs_t lfs;
+    lfs_file_t file;
+    mag_cal_t written;
+    mag_cal_t loaded;
+
+    for (uint32_t page = LFS_FIRST_PAGE; page < LFS_LEGACY_START_PAGE + LFS_LEGACY_NUM_PAGES; page++)
+    {
+        am_hal_flash_page_erase(AM_HAL_FLASH_PROGRAM_KEY, 0, page);
+    }
+
+    memset(&written, 0, sizeof(written));
+    written.initialised = 1;
+    written.mx_min = -30.0f;
+    written.mx_max = 50.0f;
+    written.my_min = -45.0f;
+    written.my_max = 35.0f;
+    written.mz_min = -20.0f;
+    written.mz_max = 60.0f;
+
+    lfs_format(&lfs, &legacy);
+    lfs_mount(&lfs, &legacy);
+    lfs_file_open(&lfs, &file, "cal_data", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    lfs_file_write(&lfs, &file, &written, MAG_CAL_V1_SIZE);
+    lfs_file_close(&lfs, &file);
+    lfs_unmount(&lfs);
+
+    memset(&loaded, 0, sizeof(loaded));
+    application_lfs_init();
+    application_lfs_load_cal(&loaded);
+    application_lfs_deinit();
+
+    if (!loaded.initialised || (loaded.source != MAG_CAL_SOURCE_RANGE) ||
+        (loaded.mx_max != written.mx_max) || (loaded.my_min != written.my_min) ||
+        (loaded.mz_max != written.mz_max))
+    {
+        return host_fail("legacy calibration not carried over");
+    }
+
+    return true;
+}
+
+bool host_check_lfs(void)
+{
+    static profile_t probe = {.name = "lfs"};
+    static alg_matched_filter_t bank;
+    float32_t reference[MATCHED_TEMPLATE_LENGTH];
+    mag_cal_t written;
+    mag_cal_t loaded;
+
+    profile_register(&probe);
+
+    if (!host_check_lfs_legacy())
+    {
+        return false;
+    }
+
+    memset(&written, 0, sizeof(written));
+    written.initialised = 1;
+    written.ox = 1.5f;
+    written.oy = -2.5f;
+    written.oz = 3.5f;
+    written.source = MAG_CAL_SOURCE_ELLIPSOID;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        written.transform[i][i] = 1.0f + 0.1f * i;
+        written.transform[i][3] = -(float32_t)i;
+    }
+    for (uint32_t i = 0; i < MATCHED_TEMPLATE_LENGTH; i++)
+    {
+        reference[i] = sinf(2.0f * PI * 3.0f * i / MATCHED_TEMPLATE_LENGTH);
+    }
+
+    profile_start(&probe);
+    application_lfs_init();
+    application_lfs_write_cal(&written);
+    int32_t status = application_lfs_write_template(MATCHED_TEMPLATE_ID, reference, MATCHED_TEMPLATE_LENGTH, 0.7f);
+    application_lfs_deinit();
+    profile_stop(&probe);
+
+    if (status < 0)
+    {
+        return host_fail("template write failed");
+    }
+
+    memset(&loaded, 0, sizeof(loaded));
+    alg_matched_filter_init(&bank, 0.01f);
+
+    profile_start(&probe);
+    application_lfs_init();
+    application_lfs_load_cal(&loaded);
+    int32_t templates = application_lfs_load_templates(&bank);
+    application_lfs_deinit();
+    profile_stop(&probe);
+
+    if (memcmp(&written, &loaded, sizeof(written)) != 0)
+    {
+        return host_fail("calibration read back differs");
+    }
+
+    if (templates != 1 || bank.templates[0].id != MATCHED_TEMPLATE_ID ||
+        bank.templates[0].length != MATCHED_TEMPLATE_LENGTH)
+    {
+        return host_fail("%d templates loaded", templates);
+    }
+
+    return true;
+}
+
+/*
+ * BMI270.  imu_setup() runs against the register model, including the
+ * configuration upload, and the FIFO is then drained on watermark
+ * interrupts while the model samples a known waveform.  Every frame must
+ * carry the waveform at its sensor time, one ODR period after the last.
+ * A rate change must keep the frames buffered before it.
+ */
+#define BMI270_IOM_MODULE       (0)
+#define BMI270_WAKEUPS          (8)
+#define BMI270_STEP_US          (250)
+#define BMI270_PERIOD_TICKS     (IMU_FIFO_FRAME_PERIOD_US * 16 / 625)
+#define BMI270_BURST_TICKS      (16)
+#define BMI270_SWITCH_BEFORE_US (4 * IMU_FIFO_FRAME_PERIOD_US)
+#define BMI270_SWITCH_AFTER_US  (4750)
+
+static volatile bool bmi270_watermark;
+
+static void bmi270_watermark_handler(void)
+{
+    bmi270_watermark = true;
+}
+
+static void bmi270_motion(void *context, uint64_t time_us, float acc[3], float gyr[3])
+{
+    float t = (float)time_us / 1000000.0f;
+
+    (void)context;
+
+    acc[0] = 2.0f * sinf(2.0f * PI * 5.0f * t);
+    acc[1] = cosf(2.0f * PI * 3.0f * t);
+    acc[2] = GRAVITY;
+    gyr[0] = 0.5f * sinf(2.0f * PI * 2.0f * t);
+    gyr[1] = 0.0f;
+    gyr[2] = -0.25f;
+}
+
+// Compares a frame with the waveform at the ODR boundary it was produced
+// on, in LSB at 16G and 2000dps.
+static bool bmi270_frame_matches(const bmi270_sim_t *sim, const imu_context_t *frame)
+{
+    float acc[3];
+    float gyr[3];
+    int16_t measured[6] = {frame->ax, frame->ay, frame->az, frame->gx, frame->gy, frame->gz};
+    uint32_t ticks = frame->sensortime & ~(uint32_t)(BMI270_PERIOD_TICKS - 1);
+
+    bmi270_motion(NULL, sim->origin_us + (uint64_t)ticks * 625 / 16, acc, gyr);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        float acc_lsb = acc[i] / ACC_16G_LSB;
+        float gyr_lsb = gyr[i] * 180.0f / PI * 32768.0f / 2000.0f;
+
+        if ((fabsf(measured[i] - acc_lsb) > 1.0f) || (fabsf(measured[3 + i] - gyr_lsb) > 1.0f))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool host_check_bmi270(void)
+{
+    static profile_t probe_init = {.name = "bmi270 init"};
+    static profile_t probe_fifo = {.name = "bmi270 fifo"};
+    static bmi270_sim_t sim;
+    static struct bmi2_dev bmi;
+    static imu_context_t frames[IMU_FIFO_MAX_FRAMES];
+    am_hal_host_iom_stats_t bus;
+    imu_context_t sample;
+    uint32_t count;
+    uint32_t total = 0;
+    uint32_t previous = 0;
+    const imu_rate_t burst = {BMI2_ACC_ODR_1600HZ, BMI2_ACC_NORMAL_AVG4, BMI2_GYR_NORMAL_MODE, BMI2_PERF_OPT_MODE};
+
+    profile_register(&probe_init);
+    profile_register(&probe_fifo);
+
+    bmi270_sim_init(&sim);
+    bmi270_sim_motion(&sim, bmi270_motion, NULL);
+    bmi270_sim_attach(&sim, BMI270_IOM_MODULE);
+    am_hal_host_iom_stats_reset(BMI270_IOM_MODULE);
+    memset(&bmi, 0, sizeof(bmi));
+
+    uint64_t start_us = am_hal_host_time_us();
+    profile_start(&probe_init);
+    imu_status_t status = imu_setup(&bmi);
+    profile_stop(&probe_init);
+    am_hal_host_iom_stats(BMI270_IOM_MODULE, &bus);
+
+    if ((status != IMU_STATUS_OK) || !sim.initialised)
+    {
+        return host_fail("imu_setup failed, INTERNAL_STATUS 0x%02x", sim.regs[BMI2_INTERNAL_STATUS_ADDR]);
+    }
+    if (sim.stats.aps_violations)
+    {
+        return host_fail("%u accesses inside the power save spacing", sim.stats.aps_violations);
+    }
+
+    am_util_stdio_printf("    init %u us, %u transfers, %u bytes\n",
+        (uint32_t)(am_hal_host_time_us() - start_us), bus.transfers, bus.bytes);
+
+    if (imu_fifo_setup(&bmi, SENSORS_FIFO_WATERMARK_FRAMES) != IMU_STATUS_OK)
+    {
+        return host_fail("imu_fifo_setup failed");
+    }
+    imu_int2_register(&bmi, bmi270_watermark_handler);
+    imu_int2_enable(&bmi);
+    imu_timebase_start(&bmi, IMU_FIFO_FRAME_PERIOD_US);
+
+    for (uint32_t wakeup = 0; wakeup < BMI270_WAKEUPS; wakeup++)
+    {
+        uint32_t waited = 0;
+
+        bmi270_watermark = false;
+        while (!bmi270_watermark && (waited < 4 * SENSORS_FIFO_WATERMARK_FRAMES * IMU_FIFO_FRAME_PERIOD_US))
+        {
+            am_hal_host_time_advance_us(BMI270_STEP_US);
+            waited += BMI270_STEP_US;
+            bmi270_sim_update(&sim);
+        }
+        if (!bmi270_watermark)
+        {
+            return host_fail("no watermark interrupt after %u us", waited);
+        }
+
+        profile_start(&probe_fifo);
+        count = imu_fifo_read(&bmi, frames, IMU_FIFO_MAX_FRAMES);
+        profile_stop(&probe_fifo);
+
+        if (count < SENSORS_FIFO_WATERMARK_FRAMES)
+        {
+            return host_fail("wakeup %u read %u frames", wakeup, count);
+        }
+
+        // Frames are stamped from the sensor time read after the drain, so
+        // they were produced on the ODR boundary at or before their stamp.
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t produced = frames[i].sensortime & ~(uint32_t)(BMI270_PERIOD_TICKS - 1);
+
+            if (!bmi270_frame_matches(&sim, &frames[i]))
+            {
+                return host_fail("wakeup %u frame %u differs from the waveform", wakeup, i);
+            }
+            if (total && (((produced - previous) & SENSOR_TIME_MASK) != BMI270_PERIOD_TICKS))
+            {
+                return host_fail("wakeup %u frame %u is %u ticks after the previous one",
+                    wakeup, i, (produced - previous) & SENSOR_TIME_MASK);
+            }
+            previous = produced;
+            total++;
+        }
+    }
+
+    if (sim.stats.fifo_overflows || sim.stats.aps_violations || sim.stats.rejected_writes)
+    {
+        return host_fail("%u overflows, %u spacing violations, %u rejected writes",
+            sim.stats.fifo_overflows, sim.stats.aps_violations, sim.stats.rejected_writes);
+    }
+
+    am_hal_host_time_advance_us(IMU_FIFO_FRAME_PERIOD_US);
+    imu_sample(&bmi, &sample);
+    if (!(sample.status & BMI2_DRDY_ACC) || !bmi270_frame_matches(&sim, &sample))
+    {
+        return host_fail("direct sample differs from the waveform");
+    }
+
+    // A rate change keeps the frames already buffered.  They stay one
+    // previous period apart up to the change and one new period apart
+    // after it, and none is counted as dropped.
+    count = imu_fifo_read(&bmi, frames, IMU_FIFO_MAX_FRAMES);
+    previous = count ? frames[count - 1].sensortime & ~(uint32_t)(BMI270_PERIOD_TICKS - 1) : previous;
+    for (uint32_t waited = 0; waited < BMI270_SWITCH_BEFORE_US; waited += BMI270_STEP_US)
+    {
+        am_hal_host_time_advance_us(BMI270_STEP_US);
+        bmi270_sim_update(&sim);
+    }
+    if (imu_set_rate(&bmi, &burst) != IMU_STATUS_OK)
+    {
+        return host_fail("imu_set_rate failed");
+    }
+    for (uint32_t waited = 0; waited < BMI270_SWITCH_AFTER_US; waited += BMI270_STEP_US)
+    {
+        am_hal_host_time_advance_us(BMI270_STEP_US);
+        bmi270_sim_update(&sim);
+    }
+    count = imu_fifo_read(&bmi, frames, IMU_FIFO_MAX_FRAMES);
+
+    // The first frame at the new rate follows the last one at the previous
+    // rate by at most the previous period.
+    uint32_t slow = 0;
+    uint32_t fast = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t produced = frames[i].sensortime & ~(uint32_t)(BMI270_BURST_TICKS - 1);
+        uint32_t step = (produced - previous) & SENSOR_TIME_MASK;
+
+        if ((step == BMI270_PERIOD_TICKS) && !fast)
+        {
+            slow++;
+        }
+        else if ((step == BMI270_BURST_TICKS) || (slow && !fast && (step < BMI270_PERIOD_TICKS)))
+        {
+            fast++;
+        }
+        else
+        {
+            return host_fail("rate change frame %u is %u ticks after the previous one", i, step);
+        }
+        if ((i > 0) && (frames[i].timestamp <= frames[i - 1].timestamp))
+        {
+            return host_fail("rate change frame %u is not after the previous one", i);
+        }
+        previous = produced;
+    }
+    if (!count || frames[0].dropped || !slow || (fast < BMI270_SWITCH_AFTER_US / 625))
+    {
+        return host_fail("rate change read %u frames at the previous rate, %u at the new, %u dropped",
+            slow, fast, count ? frames[0].dropped : 0);
+    }
+
+    am_util_stdio_printf("    %u frames, %u FIFO bytes, %u interrupts, %u + %u across a rate change\n",
+        total, sim.stats.fifo_bytes, sim.stats.interrupts[1], slow, fast);
+
+    return true;
+}
+
+/*
+ * BMM350.  mag_setup() runs against the register model, including the OTP
+ * dump, and the compensated output must reproduce the field and
+ * temperature given to the model.  The bus transfers of each driver API
+ * are counted, and the out of range detector of bmm350_oor.c is taken
+ * through a field beyond the sensor range and the reset sequence.
+ */
+#define BMM350_IOM_MODULE       (1)
+#define BMM350_PERIOD_US        (10000)
+#define BMM350_READS            (200)
+#define BMM350_DRDY_PERIODS     (20)
+#define BMM350_OOR_STEP_US      (20000)
+#define BMM350_OOR_READS        (20)
+#define BMM350_TOLERANCE_UT     (0.05f)
+#define BMM350_TOLERANCE_DEGC   (0.05f)
+
+typedef struct bmm350_input_s
+{
+    float field[3];
+    float temperature;
+} bmm350_input_t;
+
+typedef struct bmm350_cost_s
+{
+    bmm350_sim_stats_t stats;
+    uint64_t start_us;
+} bmm350_cost_t;
+
+static volatile uint32_t bmm350_drdy_count;
+
+static void bmm350_drdy_handler(void)
+{
+    bmm350_drdy_count++;
+}
+
+static void bmm350_field(void *context, uint64_t time_us, float field[3], float *temperature)
+{
+    const bmm350_input_t *input = (const bmm350_input_t *)context;
+
+    (void)time_us;
+
+    memcpy(field, input->field, sizeof(input->field));
+    *temperature = input->temperature;
+}
+
+static void bmm350_input_set(bmm350_input_t *input, float x, float y, float z)
+{
+    input->field[0] = x;
+    input->field[1] = y;
+    input->field[2] = z;
+}
+
+static bool bmm350_data_matches(const bmm350_input_t *input, const struct bmm350_mag_temp_data *data)
+{
+    return (fabsf(data->x - input->field[0]) <= BMM350_TOLERANCE_UT) &&
+           (fabsf(data->y - input->field[1]) <= BMM350_TOLERANCE_UT) &&
+           (fabsf(data->z - input->field[2]) <= BMM350_TOLERANCE_UT) &&
+           (fabsf(data->temperature - input->temperature) <= BMM350_TOLERANCE_DEGC);
+}
+
+static void bmm350_cost_start(const bmm350_sim_t *sim, bmm350_cost_t *cost)
+{
+    cost->stats = sim->stats;
+    cost->start_us = am_hal_host_time_us();
+}
+
+// Prints the transfers, bytes and time, delays included, since
+// bmm350_cost_start().
+static void bmm350_cost_print(const bmm350_sim_t *sim, const bmm350_cost_t *cost, const char *api)
+{
+    am_util_stdio_printf("    %-40s %3u transfers %4u bytes %6u us\n", api,
+        (sim->stats.reads + sim->stats.writes) - (cost->stats.reads + cost->stats.writes),
+        sim->stats.bytes - cost->stats.bytes,
+        (uint32_t)(am_hal_host_time_us() - cost->start_us));
+}
+
+// Conversions are produced lazily, so the model is brought up to date
+// before the input changes.
+static void bmm350_wait(bmm350_sim_t *sim, uint32_t us)
+{
+    am_hal_host_time_advance_us(us);
+    bmm350_sim_update(sim);
+}
+
+// Runs the out of range detector in forced mode until it reports expected,
+// and returns the number of reads taken, 0 if it did not within
+// BMM350_OOR_READS.
+static uint32_t bmm350_oor_until(bmm350_sim_t *sim, struct bmm350_dev *bmm, struct bmm350_oor_params *oor,
+                                 profile_t *probe, bool *out_of_range, bool expected,
+                                 struct bmm350_mag_temp_data *data)
+{
+    for (uint32_t i = 1; i <= BMM350_OOR_READS; i++)
+    {
+        profile_start(probe);
+        int8_t rslt = bmm350_oor_read(out_of_range, data, oor, bmm);
+        profile_stop(probe);
+        bmm350_wait(sim, BMM350_OOR_STEP_US);
+
+        if ((rslt == BMM350_OK) && (*out_of_range == expected))
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+bool host_check_bmm350(void)
+{
+    static profile_t probe_read = {.name = "bmm350 read"};
+    static profile_t probe_compensate = {.name = "bmm350 compensate"};
+    static profile_t probe_oor = {.name = "bmm350 oor"};
+    static bmm350_sim_t sim;
+    static struct bmm350_dev bmm;
+    static struct bmm350_oor_params oor;
+    bmm350_input_t input = {.field = {22.0f, -4.0f, 41.0f}, .temperature = 31.5f};
+    struct bmm350_mag_temp_data data;
+    struct bmm350_raw_mag_data raw;
+    bmm350_cost_t cost;
+    mag_context_t context;
+    bool out_of_range = false;
+
+    profile_register(&probe_read);
+    profile_register(&probe_compensate);
+    profile_register(&probe_oor);
+
+    bmm350_sim_init(&sim);
+    bmm350_sim_field(&sim, bmm350_field, &input);
+    bmm350_sim_attach(&sim, BMM350_IOM_MODULE);
+    memset(&bmm, 0, sizeof(bmm));
+
+    bmm350_cost_start(&sim, &cost);
+    if (mag_setup(&bmm) != MAG_STATUS_OK)
+    {
+        return host_fail("mag_setup failed");
+    }
+    bmm350_cost_print(&sim, &cost, "mag_setup");
+
+    if ((bmm.chip_id != BMM350_CHIP_ID) || (bmm.var_id != sim.trim.var_id) ||
+        memcmp(bmm.otp_data, sim.otp, sizeof(sim.otp)))
+    {
+        return host_fail("OTP dump differs from the model");
+    }
+
+    // The same sequence one API at a time.
+    bmm350_interface_init(&bmm);
+
+    bmm350_cost_start(&sim, &cost);
+    int8_t rslt = bmm350_init(&bmm);
+    bmm350_cost_print(&sim, &cost, "bmm350_init");
+
+    bmm350_cost_start(&sim, &cost);
+    rslt |= bmm350_set_odr_performance(BMM350_DATA_RATE_100HZ, BMM350_AVERAGING_4, &bmm);
+    bmm350_cost_print(&sim, &cost, "bmm350_set_odr_performance");
+
+    bmm350_cost_start(&sim, &cost);
+    rslt |= bmm350_enable_axes(BMM350_X_EN, BMM350_Y_EN, BMM350_Z_EN, &bmm);
+    bmm350_cost_print(&sim, &cost, "bmm350_enable_axes");
+
+    bmm350_cost_start(&sim, &cost);
+    rslt |= bmm350_set_powermode(BMM350_NORMAL_MODE, &bmm);
+    bmm350_cost_print(&sim, &cost, "bmm350_set_powermode normal");
+
+    am_hal_host_time_advance_us(BMM350_PERIOD_US);
+    bmm350_cost_start(&sim, &cost);
+    rslt |= bmm350_get_compensated_mag_xyz_temp_data(&data, &bmm);
+    bmm350_cost_print(&sim, &cost, "bmm350_get_compensated_mag_xyz_temp_data");
+
+    if ((rslt != BMM350_OK) || !bmm350_data_matches(&input, &data))
+    {
+        return host_fail("read %d: %.3f %.3f %.3f uT %.3f degC", rslt,
+            (double)data.x, (double)data.y, (double)data.z, (double)data.temperature);
+    }
+
+    mag_timebase_start(&bmm, BMM350_PERIOD_US);
+    am_hal_host_time_advance_us(BMM350_PERIOD_US);
+    bmm350_cost_start(&sim, &cost);
+    mag_status_t status = mag_sample(&bmm, &context);
+    bmm350_cost_print(&sim, &cost, "mag_sample");
+
+    if ((status != MAG_STATUS_OK) ||
+        (fabsf(context.mx - input.field[0]) > BMM350_TOLERANCE_UT) ||
+        (fabsf(context.my - input.field[1]) > BMM350_TOLERANCE_UT) ||
+        (fabsf(context.mz - input.field[2]) > BMM350_TOLERANCE_UT))
+    {
+        return host_fail("mag_sample differs from the field");
+    }
+
+    // A failed read is reported and leaves the previous sample alone, so
+    // that the caller does not correct it a second time.
+    mag_context_t previous = context;
+    am_hal_host_time_advance_us(BMM350_PERIOD_US);
+    am_hal_host_iom_inject(BMM350_IOM_MODULE, AM_HAL_STATUS_HW_ERR, 1);
+    if ((mag_sample(&bmm, &context) != MAG_STATUS_ERROR) || memcmp(&previous, &context, sizeof(context)))
+    {
+        return host_fail("failed mag_sample not reported");
+    }
+
+    // One data ready pulse per conversion at the 100Hz ODR.
+    mag_drdy_register(&bmm, bmm350_drdy_handler);
+    bmm350_cost_start(&sim, &cost);
+    if (mag_drdy_setup(&bmm) != MAG_STATUS_OK)
+    {
+        return host_fail("mag_drdy_setup failed");
+    }
+    bmm350_cost_print(&sim, &cost, "mag_drdy_setup");
+
+    mag_drdy_enable(&bmm);
+    bmm350_drdy_count = 0;
+    for (uint32_t i = 0; i < BMM350_DRDY_PERIODS * 10; i++)
+    {
+        bmm350_wait(&sim, BMM350_PERIOD_US / 10);
+    }
+    mag_drdy_disable(&bmm);
+
+    if ((bmm350_drdy_count < BMM350_DRDY_PERIODS - 1) || (bmm350_drdy_count > BMM350_DRDY_PERIODS + 1))
+    {
+        return host_fail("%u data ready interrupts in %u periods", bmm350_drdy_count, BMM350_DRDY_PERIODS);
+    }
+
+    bmm350_interface_init(&bmm);
+    bmm350_cost_start(&sim, &cost);
+    rslt = bmm350_magnetic_reset_and_wait(&bmm);
+    bmm350_cost_print(&sim, &cost, "bmm350_magnetic_reset_and_wait");
+
+    bmm350_cost_start(&sim, &cost);
+    rslt |= bmm350_set_powermode(BMM350_SUSPEND_MODE, &bmm);
+    bmm350_cost_print(&sim, &cost, "bmm350_set_powermode suspend");
+
+    bmm350_cost_start(&sim, &cost);
+    rslt |= bmm350_oor_read(&out_of_range, &data, &oor, &bmm);
+    bmm350_cost_print(&sim, &cost, "bmm350_oor_read");
+    bmm350_wait(&sim, BMM350_OOR_STEP_US);
+
+    if (rslt != BMM350_OK)
+    {
+        return host_fail("driver API failed");
+    }
+
+    // Compensation benchmark, bound to the model without the IOM.
+    bmm350_sim_interface_init(&sim, &bmm);
+    if (bmm350_set_powermode(BMM350_NORMAL_MODE, &bmm) != BMM350_OK)
+    {
+        return host_fail("bmm350_set_powermode failed");
+    }
+
+    for (uint32_t i = 0; i < BMM350_READS; i++)
+    {
+        float angle = 2.0f * PI * (float)i / BMM350_READS;
+
+        bmm350_input_set(&input, 40.0f * cosf(angle), 40.0f * sinf(angle), -30.0f + 0.1f * (float)i);
+        input.temperature = 20.0f + 0.1f * (float)i;
+        am_hal_host_time_advance_us(BMM350_PERIOD_US);
+
+        profile_start(&probe_read);
+        rslt = bmm350_get_compensated_mag_xyz_temp_data(&data, &bmm);
+        profile_stop(&probe_read);
+
+        if ((rslt != BMM350_OK) || !bmm350_data_matches(&input, &data))
+        {
+            return host_fail("read %u: %.3f %.3f %.3f uT %.3f degC", i,
+                (double)data.x, (double)data.y, (double)data.z, (double)data.temperature);
+        }
+
+        bmm350_read_uncomp_mag_temp_data(&raw, &bmm);
+        profile_start(&probe_compensate);
+        bmm350_compensate_mag_xyz_temp_data(&raw, &data, &bmm);
+        profile_stop(&probe_compensate);
+    }
+
+    // Out of range detection in forced mode.  A field beyond the range
+    // saturates the sensor and leaves a remanent offset, which the reset
+    // sequence removes.
+    input.temperature = 25.0f;
+    bmm350_input_set(&input, 30.0f, -20.0f, 45.0f);
+    memset(&oor, 0, sizeof(oor));
+    out_of_range = false;
+    if (bmm350_set_powermode(BMM350_SUSPEND_MODE, &bmm) != BMM350_OK)
+    {
+        return host_fail("bmm350_set_powermode failed");
+    }
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        bmm350_oor_read(&out_of_range, &data, &oor, &bmm);
+        bmm350_wait(&sim, BMM350_OOR_STEP_US);
+    }
+    if (out_of_range || !bmm350_data_matches(&input, &data))
+    {
+        return host_fail("out of range in the earth field");
+    }
+
+    bmm350_input_set(&input, 4000.0f, 0.0f, 40.0f);
+    uint32_t detected = bmm350_oor_until(&sim, &bmm, &oor, &probe_oor, &out_of_range, true, &data);
+    bmm350_input_set(&input, 30.0f, -20.0f, 45.0f);
+    uint32_t cleared = bmm350_oor_until(&sim, &bmm, &oor, &probe_oor, &out_of_range, false, &data);
+    if (!detected || !cleared)
+    {
+        return host_fail("out of range detected after %u reads, cleared after %u", detected, cleared);
+    }
+    if (fabsf(data.x - input.field[0] - BMM350_SIM_REMANENCE_UT) > BMM350_TOLERANCE_UT)
+    {
+        return host_fail("no remanent offset after the field step");
+    }
+
+    uint32_t resets = 0;
+    oor.trigger_reset = true;
+    while (oor.trigger_reset && (resets < BMM350_OOR_READS))
+    {
+        bmm350_oor_read(&out_of_range, &data, &oor, &bmm);
+        bmm350_wait(&sim, BMM350_OOR_STEP_US);
+        bmm350_oor_perform_reset_sequence_forced(&oor, &bmm);
+        bmm350_wait(&sim, BMM350_OOR_STEP_US);
+        resets++;
+    }
+
+    // The first read after the sequence returns the conversion started
+    // before it completed.
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        bmm350_oor_read(&out_of_range, &data, &oor, &bmm);
+        bmm350_wait(&sim, BMM350_OOR_STEP_US);
+    }
+    if (oor.trigger_reset || out_of_range || !bmm350_data_matches(&input, &data))
+    {
+        return host_fail("remanent offset left after the reset sequence");
+    }
+
+    if (sim.stats.illegal_commands || sim.stats.busy_commands || sim.stats.rejected_writes || sim.stats.nacks)
+    {
+        return host_fail("%u illegal, %u early PMU commands, %u rejected writes, %u NACKs",
+            sim.stats.illegal_commands, sim.stats.busy_commands, sim.stats.rejected_writes, sim.stats.nacks);
+    }
+
+    am_util_stdio_printf("    out of range after %u reads, back in range after %u, reset in %u steps\n",
+        detected, cleared, resets);
+    am_util_stdio_printf("    %u OTP reads, %u PMU commands, %u conversions\n",
+        sim.stats.otp_reads, sim.stats.pmu_commands, sim.stats.conversions);
+
+    return true;
+}
+
+/*
+ * Sensor bus completion.  The IMU bus is pointed at a spare IOM whose
+ * transfers complete on the kernel tick, out of line with the task that
+ * started them.  Queued transfers must complete in order, an injected
+ * error must reach the caller, and a transfer that never completes must
+ * time out and be aborted without touching its buffer or completing the
+ * next transfer.  imu_setup() restores the IMU bus.
+ */
+#define BUS_IOM_MODULE          (5)
+#define BUS_LENGTH              (8)
+#define BUS_QUEUED              (3)
+
+static void *bus_iom;
+static uint32_t bus_opens;
+static uint32_t bus_closes;
+static uint32_t bus_order[BUS_QUEUED];
+static uint32_t bus_completions;
+
+// Fills a read with its instruction byte.
+static uint32_t bus_peer(void *context, const am_hal_iom_transfer_t *transfer)
+{
+    if (transfer->eDirection == AM_HAL_IOM_RX)
+    {
+        memset(transfer->pui32RxBuffer, (uint8_t)transfer->ui32Instr, transfer->ui32NumBytes);
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+static void bus_open(void *arg)
+{
+    am_hal_iom_initialize(BUS_IOM_MODULE, &bus_iom);
+    am_hal_iom_enable(bus_iom);
+    bus_opens++;
+}
+
+static void bus_close(void *arg)
+{
+    am_hal_iom_disable(bus_iom);
+    am_hal_iom_uninitialize(bus_iom);
+    bus_closes++;
+}
+
+static void bus_order_complete(void *context, uint32_t status)
+{
+    if (bus_completions < BUS_QUEUED)
+    {
+        bus_order[bus_completions] = (uint32_t)(uintptr_t)context;
+    }
+    bus_completions++;
+}
+
+static void bus_transfer(am_hal_iom_transfer_t *transfer, uint8_t instr, uint8_t *buffer)
+{
+    memset(transfer, 0, sizeof(*transfer));
+    transfer->eDirection = AM_HAL_IOM_RX;
+    transfer->ui32InstrLen = 1;
+    transfer->ui32Instr = instr;
+    transfer->ui32NumBytes = BUS_LENGTH;
+    transfer->pui32RxBuffer = (uint32_t *)buffer;
+}
+
+// A read as done by the sampling paths.
+static uint32_t bus_read(uint8_t instr, uint8_t *buffer)
+{
+    am_hal_iom_transfer_t transfer;
+    uint32_t status;
+
+    bus_transfer(&transfer, instr, buffer);
+    sensor_bus_begin(SENSOR_BUS_IMU);
+    status = am_hal_iom_nonblocking_transfer(bus_iom, &transfer,
+                                             sensor_bus_complete, sensor_bus_context(SENSOR_BUS_IMU));
+    if (status == AM_HAL_STATUS_SUCCESS)
+    {
+        status = sensor_bus_wait(SENSOR_BUS_IMU);
+    }
+
+    return status;
+}
+
+static bool bus_filled(const uint8_t *buffer, uint8_t value)
+{
+    for (uint32_t i = 0; i < BUS_LENGTH; i++)
+    {
+        if (buffer[i] != value)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool host_check_sensor_bus(void)
+{
+    static uint32_t buffer[BUS_QUEUED + 2][BUS_LENGTH / sizeof(uint32_t)];
+    uint8_t *data[BUS_QUEUED + 2];
+    am_hal_iom_transfer_t transfer[BUS_QUEUED];
+    bool passed = true;
+    uint32_t status;
+
+    for (uint32_t i = 0; i < BUS_QUEUED + 2; i++)
+    {
+        data[i] = (uint8_t *)buffer[i];
+        memset(data[i], 0, BUS_LENGTH);
+    }
+
+    bus_opens = 0;
+    bus_closes = 0;
+    bus_completions = 0;
+    am_hal_host_iom_attach(BUS_IOM_MODULE, bus_peer, NULL);
+    am_hal_host_iom_defer(BUS_IOM_MODULE, true);
+    sensor_bus_setup(SENSOR_BUS_IMU, bus_open, bus_close, NULL);
+
+    if (!sensor_bus_acquire(SENSOR_BUS_IMU))
+    {
+        return host_fail("bus not acquired");
+    }
+
+    // Queued transfers only fill their buffers as they complete, in order.
+    // The tick is kept from servicing the queue meanwhile.
+    am_hal_host_iom_stall(BUS_IOM_MODULE, true);
+    for (uint32_t i = 0; i < BUS_QUEUED; i++)
+    {
+        bus_transfer(&transfer[i], (uint8_t)(i + 1), data[i]);
+        am_hal_iom_nonblocking_transfer(bus_iom, &transfer[i], bus_order_complete, (void *)(uintptr_t)(i + 1));
+    }
+    if ((am_hal_host_iom_queued(BUS_IOM_MODULE) != BUS_QUEUED) || (bus_completions != 0) || !bus_filled(data[0], 0))
+    {
+        passed = host_fail("transfers completed before they were serviced");
+    }
+    am_hal_host_iom_stall(BUS_IOM_MODULE, false);
+    am_hal_host_iom_service(BUS_IOM_MODULE);
+    if ((bus_completions != 1) || !bus_filled(data[0], 1) || !bus_filled(data[1], 0))
+    {
+        passed = host_fail("first transfer not completed alone");
+    }
+    while (am_hal_host_iom_service(BUS_IOM_MODULE))
+    {
+    }
+    for (uint32_t i = 0; i < BUS_QUEUED; i++)
+    {
+        if ((bus_order[i] != i + 1) || !bus_filled(data[i], (uint8_t)(i + 1)))
+        {
+            passed = host_fail("transfer %u completed as %u", i + 1, bus_order[i]);
+        }
+    }
+
+    // Completion on the tick wakes the waiting task.
+    status = bus_read(0x21, data[0]);
+    if ((status != AM_HAL_STATUS_SUCCESS) || !bus_filled(data[0], 0x21))
+    {
+        passed = host_fail("read completed on the tick with status %u", status);
+    }
+
+    // An error is reported to the caller.
+    am_hal_host_iom_inject(BUS_IOM_MODULE, AM_HAL_STATUS_HW_ERR, 1);
+    status = bus_read(0x32, data[1]);
+    if (status != AM_HAL_STATUS_HW_ERR)
+    {
+        passed = host_fail("injected error returned as status %u", status);
+    }
+
+    // A hung transfer times out and is aborted by a power cycle.  Once the
+    // bus recovers, the late completion must not be taken for the next
+    // read, and the aborted buffer must stay untouched.
+    uint32_t closes = bus_closes;
+    am_hal_host_iom_stall(BUS_IOM_MODULE, true);
+    status = bus_read(0x43, data[BUS_QUEUED]);
+    am_hal_host_iom_stall(BUS_IOM_MODULE, false);
+    if (status != AM_HAL_STATUS_TIMEOUT)
+    {
+        passed = host_fail("hung read returned status %u", status);
+    }
+    if ((bus_closes != closes + 1) || (am_hal_host_iom_queued(BUS_IOM_MODULE) != 0))
+    {
+        passed = host_fail("hung read not aborted, %u closes, %u queued",
+            bus_closes - closes, am_hal_host_iom_queued(BUS_IOM_MODULE));
+    }
+
+    status = bus_read(0x54, data[BUS_QUEUED + 1]);
+    if ((status != AM_HAL_STATUS_SUCCESS) || !bus_filled(data[BUS_QUEUED + 1], 0x54))
+    {
+        passed = host_fail("read after the timeout returned status %u", status);
+    }
+    if (!bus_filled(data[BUS_QUEUED], 0))
+    {
+        passed = host_fail("aborted read wrote its buffer");
+    }
+
+    sensor_bus_release(SENSOR_BUS_IMU);
+    sensor_bus_shutdown(SENSOR_BUS_IMU);
+    am_hal_host_iom_defer(BUS_IOM_MODULE, false);
+    am_hal_host_iom_attach(BUS_IOM_MODULE, NULL, NULL);
+
+    return passed;
+}
+
+/*
+ * Bosch FIFO parsing.  Every buffer of the FIFO parser benchmark, header
+ * mode and headerless, is extracted once and must give back each generated
+ * sample.  "petal_imu_host bench [n]" times them.
+ */
+bool host_check_fifo(void)
+{
+    imu_fifo_bench_result_t result;
+    bool passed = true;
+
+    for (uint32_t i = 0; i < imu_fifo_bench_count(); i++)
+    {
+        if (!imu_fifo_bench_run(i, 1, &result))
+        {
+            passed = host_fail("%s %s, %u frames: extracted %u accel, %u gyro, %u aux",
+                result.header ? "header" : "headerless", result.mix, result.frames,
+                result.extracted[IMU_FIFO_BENCH_ACCEL],
+                result.extracted[IMU_FIFO_BENCH_GYRO],
+                result.extracted[IMU_FIFO_BENCH_AUX]);
+        }
+    }
+
+    return passed;
+}
+
+/*
+ * Decimator.  1600Hz frames carry a 5Hz tone on x and a 730Hz tone on y,
+ * pushed in blocks of uneven length as FIFO acquisition does, then one at
+ * a time as timer acquisition does.  At 400Hz and 100Hz the 5Hz tone must
+ * come out at its timestamp and the 730Hz tone, which would alias into
+ * the pass band, must be filtered out.
+ */
+#define DECIMATOR_RATE_HZ       (1600)
+#define DECIMATOR_SECONDS       (4)
+#define DECIMATOR_START_US      (1000000)
+#define DECIMATOR_SETTLE_US     (500000)
+#define DECIMATOR_TONE_G        (2.0f)
+#define DECIMATOR_ALIAS_G       (1.0f)
+#define DECIMATOR_TOLERANCE_G   (0.01f)
+
+static const uint32_t decimator_fifo_blocks[] = {16, 7, 25, 1, 32, 9};
+static const uint32_t decimator_timer_blocks[] = {1};
+static const uint32_t decimator_rates[] = {400, 100};
+
+static bool host_check_decimator_run(const char *name, const uint32_t *blocks, uint32_t block_count)
+{
+    static decimator_t decimator;
+    static imu_context_t frames[DECIMATOR_BLOCK_FRAMES];
+    float32_t worst_tone[2] = {0.0f, 0.0f};
+    float32_t worst_alias[2] = {0.0f, 0.0f};
+    uint32_t outputs[2] = {0, 0};
+    uint32_t block = 0;
+
+    decimator_init(&decimator);
+
+    for (uint32_t n = 0; n < DECIMATOR_RATE_HZ * DECIMATOR_SECONDS;)
+    {
+        uint32_t count = blocks[block++ % block_count];
+
+        if (count > DECIMATOR_RATE_HZ * DECIMATOR_SECONDS - n)
+        {
+            count = DECIMATOR_RATE_HZ * DECIMATOR_SECONDS - n;
+        }
+
+        for (uint32_t i = 0; i < count; i++, n++)
+        {
+            float32_t t = (float32_t)n / DECIMATOR_RATE_HZ;
+
+            memset(&frames[i], 0, sizeof(frames[i]));
+            frames[i].timestamp = DECIMATOR_START_US + (uint64_t)n * 1000000 / DECIMATOR_RATE_HZ;
+            frames[i].acc_range = BMI2_ACC_RANGE_16G;
+            frames[i].gyr_range = BMI2_GYR_RANGE_2000;
+            frames[i].ax = (int16_t)(DECIMATOR_TONE_G * GRAVITY * sinf(2.0f * PI * 5.0f * t) / ACC_16G_LSB);
+            frames[i].ay = (int16_t)(DECIMATOR_ALIAS_G * GRAVITY * sinf(2.0f * PI * 730.0f * t) / ACC_16G_LSB);
+            frames[i].az = (int16_t)(GRAVITY / ACC_16G_LSB);
+        }
+        decimator_push(&decimator, frames, count);
+
+        for (uint32_t r = 0; r < sizeof(decimator_rates) / sizeof(decimator_rates[0]); r++)
+        {
+            const imu_context_t *output;
+            uint32_t produced = decimator_output(&decimator, decimator_rates[r], &output);
+
+            for (uint32_t k = 0; k < produced; k++)
+            {
+                float32_t t = (float32_t)(output[k].timestamp - DECIMATOR_START_US) / 1000000.0f;
+                float32_t tone = fabsf(output[k].ax * ACC_16G_LSB / GRAVITY - DECIMATOR_TONE_G * sinf(2.0f * PI * 5.0f * t));
+                float32_t alias = fabsf(output[k].ay * ACC_16G_LSB / GRAVITY);
+
+                outputs[r]++;
+                if (output[k].timestamp < DECIMATOR_START_US + DECIMATOR_SETTLE_US)
+                {
+                    continue;
+                }
+                worst_tone[r] = tone > worst_tone[r] ? tone : worst_tone[r];
+                worst_alias[r] = alias > worst_alias[r] ? alias : worst_alias[r];
+            }
+        }
+    }
+
+    for (uint32_t r = 0; r < sizeof(decimator_rates) / sizeof(decimator_rates[0]); r++)
+    {
+        // A first push of a single frame has no period to pick a stage
+        // with and is passed through.
+        uint32_t expected = decimator_rates[r] * DECIMATOR_SECONDS + (blocks[0] == 1 ? 1 : 0);
+
+        am_util_stdio_printf("    %s %uHz: %u frames, tone error %.4fg, alias %.4fg\n",
+            name, decimator_rates[r], outputs[r], worst_tone[r], worst_alias[r]);
+
+        if (outputs[r] != expected)
+        {
+            return host_fail("%s %uHz gave %u frames, expected %u", name, decimator_rates[r], outputs[r], expected);
+        }
+        if ((worst_tone[r] > DECIMATOR_TOLERANCE_G) || (worst_alias[r] > DECIMATOR_TOLERANCE_G))
+        {
+            return host_fail("%s %uHz output is off by %.4fg, alias %.4fg", name, decimator_rates[r], worst_tone[r], worst_alias[r]);
+        }
+    }
+
+    return true;
+}
+
+bool host_check_decimator(void)
+{
+    imu_scale_setup(16);
+
+    return host_check_decimator_run("fifo", decimator_fifo_blocks,
+               sizeof(decimator_fifo_blocks) / sizeof(decimator_fifo_blocks[0])) &&
+           host_check_decimator_run("timer", decimator_timer_blocks,
+               sizeof(decimator_timer_blocks) / sizeof(decimator_timer_blocks[0]));
+}
@@ -0,0 +1,246 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "profile.h"
+
+#include "imu_fifo_bench.h"
+
+#include "application.h"
+#include "application_task.h"
+
+#include "host.h"
+
+// The checks run in one task so that the code under test can block on
+// the kernel as it does on the target.
+#define HOST_TASK_STACK_SIZE    (16 * 1024)
+#define HOST_TASK_PRIORITY      (1)
+
+// Default number of calls timed per buffer by the bench command.
+#define HOST_BENCH_ITERATIONS   (1000)
+
+// Rate of DWT->CYCCNT for the bench command.
+#define HOST_TICKS_PER_S        (1000000000UL)
+
+static const host_check_t host_checks[] = {
+    {"shotdetect",      host_check_shotdetect},
+    {"shotdetect_q15",  host_check_shotdetect_q15},
+    {"correlator",      host_check_correlator},
+    {"matched_filter",  host_check_matched_filter},
+    {"spectrum",        host_check_spectrum},
+    {"ahrs",            host_check_ahrs},
+    {"mag_fit",         host_check_mag_fit},
+    {"lfs",             host_check_lfs},
+    {"trace",           host_check_trace},
+    {"sensor_bus",      host_check_sensor_bus},
+    {"bmi270",          host_check_bmi270},
+    {"bmm350",          host_check_bmm350},
+    {"fifo",            host_check_fifo},
+    {"decimator",       host_check_decimator},
+};
+
+#define HOST_CHECK_COUNT (sizeof(host_checks) / sizeof(host_checks[0]))
+
+static int host_argc;
+static char **host_argv;
+
+// application_task.c is not part of the host build.  Messages posted to
+// the application task are dropped.
+void application_send_message(application_msg_t *message)
+{
+    (void)message;
+}
+
+bool host_fail(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    am_util_stdio_printf("    ");
+    vprintf(format, args);
+    am_util_stdio_printf("\n");
+    va_end(args);
+
+    return false;
+}
+
+float host_noise(uint32_t *seed)
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return (float)(int32_t)*seed / 2147483648.0f;
+}
+
+static bool host_check_selected(const char *name)
+{
+    if (host_argc < 2)
+    {
+        return true;
+    }
+
+    for (int i = 1; i < host_argc; i++)
+    {
+        if (strcmp(host_argv[i], name) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// DWT->CYCCNT counts nanoseconds on the host.
+static void host_profile_show(void)
+{
+    am_util_stdio_printf("\n%-16s %10s %12s %12s %12s\n", "probe", "count", "mean ns", "min ns", "max ns");
+    for (uint32_t i = 0; i < profile_probe_count(); i++)
+    {
+        profile_t *probe = profile_probe_get(i);
+
+        if (probe->count == 0)
+        {
+            continue;
+        }
+
+        am_util_stdio_printf("%-16s %10u %12u %12u %12u\n",
+            probe->name,
+            probe->count,
+            (uint32_t)(probe->total / probe->count),
+            probe->min,
+            probe->max);
+    }
+}
+
+static void host_task(void *parameter)
+{
+    uint32_t run = 0;
+    uint32_t failed = 0;
+
+    (void)parameter;
+
+    profile_setup();
+    application_lfs_setup();
+
+    if ((host_argc >= 2) && (strcmp(host_argv[1], "replay") == 0))
+    {
+        int status = host_replay_main(host_argc - 1, &host_argv[1]);
+
+        fflush(stdout);
+        exit(status);
+    }
+
+    if ((host_argc >= 2) && (strcmp(host_argv[1], "bench") == 0))
+    {
+        uint32_t iterations = HOST_BENCH_ITERATIONS;
+
+        if (host_argc >= 3)
+        {
+            iterations = strtoul(host_argv[2], NULL, 10);
+        }
+
+        uint32_t failed = imu_fifo_bench_report(iterations, HOST_TICKS_PER_S);
+
+        fflush(stdout);
+        exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
+    for (uint32_t i = 0; i < HOST_CHECK_COUNT; i++)
+    {
+        if (!host_check_selected(host_checks[i].name))
+        {
+            continue;
+        }
+
+        am_util_stdio_printf("%s\n", host_checks[i].name);
+        bool passed = host_checks[i].run();
+        am_util_stdio_printf("    %s\n", passed ? "pass" : "FAIL");
+
+        run++;
+        failed += passed ? 0 : 1;
+    }
+
+    host_profile_show();
+    am_util_stdio_printf("\n%u checks, %u failed\n", run, failed);
+
+    fflush(stdout);
+    exit((run == 0 || failed) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+//*****************************************************************************
+//
+// FreeRTOS hooks.
+//
+//*****************************************************************************
+// Deferred IOM transfers complete on the tick, as from the IOM interrupt.
+void vApplicationTickHook(void)
+{
+    am_hal_host_iom_tick();
+}
+
+void vApplicationMallocFailedHook(void)
+{
+    am_util_stdio_printf("malloc failed\n");
+    abort();
+}
+
+void vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName)
+{
+    (void)pxTask;
+
+    am_util_stdio_printf("stack overflow in %s\n", pcTaskName);
+    abort();
+}
+
+int main(int argc, char **argv)
+{
+    host_argc = argc;
+    host_argv = argv;
+
+    xTaskCreate(host_task, "Host", HOST_TASK_STACK_SIZE, NULL, HOST_TASK_PRIORITY, NULL);
+
+    //
+    // Start the scheduler.
+    //
+    vTaskStartScheduler();
+
+    return EXIT_FAILURE;
+}
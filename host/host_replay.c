@@ -0,0 +1,529 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <arm_math.h>
+
+#include "profile.h"
+
+#include "imu.h"
+#include "mag.h"
+
+#include "alg_shotdetect.h"
+#include "alg_shotdetect_q15.h"
+
+#include "application_task.h"
+#include "application_trace.h"
+
+#include "host.h"
+
+// IMU frames are processed in batches of this many, as they would be
+// drained from the FIFO.
+#define HOST_REPLAY_BATCH           (32)
+
+// Resolution of the BMI270 readings.
+#define HOST_REPLAY_IMU_RESOLUTION  (16)
+
+typedef struct host_replay_frame_s
+{
+    float32_t acc[3];       // m/s^2
+    float32_t gyr[3];       // rad/s
+} host_replay_frame_t;
+
+static profile_t probe_convert = {.name = "replay convert"};
+static profile_t probe_mag_cal = {.name = "replay mag cal"};
+static profile_t probe_shotdetect = {.name = "replay shotdetect"};
+
+#ifdef ALG_SHOTDETECT_Q15
+static alg_shotdetect_q15_context_t replay_shotdetect;
+#else
+static alg_shotdetect_context_t replay_shotdetect;
+#endif
+
+// Stage outputs.  They are kept so that the work is not optimised away.
+host_replay_frame_t host_replay_frames[HOST_REPLAY_BATCH];
+mag_context_t host_replay_mag_sample;
+
+static uint64_t host_replay_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void host_replay_detection_add(host_replay_t *replay, uint32_t frame, uint64_t timestamp)
+{
+    if (replay->detection_count == replay->detection_max)
+    {
+        replay->detection_max = replay->detection_max ? 2 * replay->detection_max : 64;
+        replay->detections = realloc(replay->detections, replay->detection_max * sizeof(host_replay_detection_t));
+    }
+
+    replay->detections[replay->detection_count].frame = frame;
+    replay->detections[replay->detection_count].timestamp = timestamp;
+    replay->detection_count++;
+}
+
+static void host_replay_imu(host_replay_t *replay, imu_context_t *frames, uint32_t count)
+{
+    profile_start(&probe_convert);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        host_replay_frames[i].acc[0] = imu_lsb_to_mps2(&frames[i], frames[i].ax);
+        host_replay_frames[i].acc[1] = imu_lsb_to_mps2(&frames[i], frames[i].ay);
+        host_replay_frames[i].acc[2] = imu_lsb_to_mps2(&frames[i], frames[i].az);
+        host_replay_frames[i].gyr[0] = imu_lsb_to_rps(&frames[i], frames[i].gx);
+        host_replay_frames[i].gyr[1] = imu_lsb_to_rps(&frames[i], frames[i].gy);
+        host_replay_frames[i].gyr[2] = imu_lsb_to_rps(&frames[i], frames[i].gz);
+    }
+    profile_stop(&probe_convert);
+
+    profile_start(&probe_shotdetect);
+    for (uint32_t i = 0; i < count; i++)
+    {
+#ifdef ALG_SHOTDETECT_Q15
+        if (application_alg_shotdetect_q15_step(&frames[i], &replay_shotdetect))
+#else
+        if (application_alg_shotdetect_step(&frames[i], &replay_shotdetect))
+#endif
+        {
+            host_replay_detection_add(replay, replay->imu_frames + i, frames[i].timestamp);
+        }
+    }
+    profile_stop(&probe_shotdetect);
+
+    replay->imu_frames += count;
+}
+
+static void host_replay_mag(host_replay_t *replay, const trace_mag_t *mag, const mag_cal_t *cal)
+{
+    profile_start(&probe_mag_cal);
+    host_replay_mag_sample.timestamp = mag->timestamp;
+    host_replay_mag_sample.sensortime = mag->sensortime;
+    host_replay_mag_sample.dropped = mag->dropped;
+    host_replay_mag_sample.mx = mag->mx;
+    host_replay_mag_sample.my = mag->my;
+    host_replay_mag_sample.mz = mag->mz;
+    if (cal->initialised)
+    {
+        mag_cal_apply(cal, &host_replay_mag_sample);
+    }
+    profile_stop(&probe_mag_cal);
+
+    replay->mag_samples++;
+}
+
+static bool host_replay_is_start(const uint8_t *data, size_t size)
+{
+    trace_record_t header;
+    trace_start_t start;
+
+    if (size < sizeof(header) + sizeof(start))
+    {
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+    memcpy(&start, &data[sizeof(header)], sizeof(start));
+
+    return (header.type == TRACE_RECORD_START) &&
+           (header.length == sizeof(start)) &&
+           (start.magic == TRACE_MAGIC);
+}
+
+bool host_replay_run(const uint8_t *data, size_t size, host_replay_t *replay)
+{
+    static imu_context_t batch[HOST_REPLAY_BATCH];
+    uint32_t batched = 0;
+    uint16_t expected = 0;
+    size_t offset = 0;
+    mag_cal_t cal;
+
+    memset(replay, 0, sizeof(*replay));
+    memset(&cal, 0, sizeof(cal));
+
+    imu_scale_setup(HOST_REPLAY_IMU_RESOLUTION);
+#ifdef ALG_SHOTDETECT_Q15
+    application_alg_shotdetect_q15_setup(&replay_shotdetect);
+#else
+    application_alg_shotdetect_setup(&replay_shotdetect);
+#endif
+
+    profile_register(&probe_convert);
+    profile_register(&probe_mag_cal);
+    profile_register(&probe_shotdetect);
+
+    // Anything before the first start record, such as the end of an
+    // earlier trace left in the channel, is skipped.
+    while ((offset < size) && !host_replay_is_start(&data[offset], size - offset))
+    {
+        offset++;
+    }
+    if (offset == size)
+    {
+        return host_fail("no trace start record");
+    }
+
+    uint64_t start_ns = host_replay_now_ns();
+
+    while (offset + sizeof(trace_record_t) <= size)
+    {
+        trace_record_t header;
+        const uint8_t *payload = &data[offset + sizeof(header)];
+
+        memcpy(&header, &data[offset], sizeof(header));
+        if (offset + sizeof(header) + header.length > size)
+        {
+            replay->truncated = true;
+            break;
+        }
+
+        if (header.type == TRACE_RECORD_START)
+        {
+            replay->starts++;
+        }
+        else
+        {
+            replay->lost += (uint16_t)(header.sequence - expected);
+        }
+        expected = header.sequence + 1;
+
+        switch (header.type)
+        {
+        case TRACE_RECORD_START:
+        {
+            trace_start_t start;
+
+            memcpy(&start, payload, sizeof(start));
+            if ((header.length != sizeof(start)) || (start.version != TRACE_VERSION))
+            {
+                return host_fail("trace version %u not supported", start.version);
+            }
+            break;
+        }
+
+        case TRACE_RECORD_IMU:
+        {
+            trace_imu_t imu;
+
+            if (header.length != sizeof(imu))
+            {
+                return host_fail("IMU record of %u bytes", header.length);
+            }
+
+            memcpy(&imu, payload, sizeof(imu));
+            batch[batched].timestamp = imu.timestamp;
+            batch[batched].sensortime = imu.sensortime;
+            batch[batched].dropped = imu.dropped;
+            batch[batched].status = imu.status;
+            batch[batched].acc_range = imu.acc_range;
+            batch[batched].gyr_range = imu.gyr_range;
+            batch[batched].ax = imu.ax;
+            batch[batched].ay = imu.ay;
+            batch[batched].az = imu.az;
+            batch[batched].gx = imu.gx;
+            batch[batched].gy = imu.gy;
+            batch[batched].gz = imu.gz;
+
+            if (++batched == HOST_REPLAY_BATCH)
+            {
+                host_replay_imu(replay, batch, batched);
+                batched = 0;
+            }
+            break;
+        }
+
+        case TRACE_RECORD_MAG:
+        {
+            trace_mag_t mag;
+
+            if (header.length != sizeof(mag))
+            {
+                return host_fail("magnetometer record of %u bytes", header.length);
+            }
+
+            memcpy(&mag, payload, sizeof(mag));
+            host_replay_mag(replay, &mag, &cal);
+            break;
+        }
+
+        case TRACE_RECORD_CAL:
+            if (header.length != sizeof(mag_cal_t))
+            {
+                return host_fail("correction record of %u bytes", header.length);
+            }
+
+            memcpy(&cal, payload, sizeof(cal));
+            replay->cal_records++;
+            break;
+
+        default:
+            // Records added by later versions are skipped.
+            break;
+        }
+
+        offset += sizeof(header) + header.length;
+    }
+
+    if (batched)
+    {
+        host_replay_imu(replay, batch, batched);
+    }
+
+    replay->elapsed_ns = host_replay_now_ns() - start_ns;
+
+    return true;
+}
+
+void host_replay_free(host_replay_t *replay)
+{
+    free(replay->detections);
+    replay->detections = NULL;
+    replay->detection_count = 0;
+    replay->detection_max = 0;
+}
+
+static uint8_t *host_replay_load(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    uint8_t *data = NULL;
+    long length;
+
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    if ((fseek(file, 0, SEEK_END) == 0) && ((length = ftell(file)) > 0))
+    {
+        rewind(file);
+        data = malloc(length);
+        if (data && (fread(data, 1, length, file) != (size_t)length))
+        {
+            free(data);
+            data = NULL;
+        }
+        *size = length;
+    }
+
+    fclose(file);
+
+    return data;
+}
+
+/*
+ * The golden file holds one line per detection, the index of the IMU frame
+ * in the trace and its timestamp in microseconds.  Lines starting with #
+ * are comments.
+ */
+static bool host_replay_golden_write(const char *path, const host_replay_t *replay)
+{
+    FILE *file = fopen(path, "w");
+
+    if (file == NULL)
+    {
+        return host_fail("cannot write %s", path);
+    }
+
+    fprintf(file, "# frame timestamp_us\n");
+    for (uint32_t i = 0; i < replay->detection_count; i++)
+    {
+        fprintf(file, "%u %llu\n",
+            replay->detections[i].frame,
+            (unsigned long long)replay->detections[i].timestamp);
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+static bool host_replay_golden_read(const char *path, host_replay_t *golden)
+{
+    FILE *file = fopen(path, "r");
+    char line[80];
+
+    memset(golden, 0, sizeof(*golden));
+    if (file == NULL)
+    {
+        return host_fail("cannot read %s", path);
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+        unsigned int frame;
+        unsigned long long timestamp;
+
+        if ((line[0] == '#') || (sscanf(line, "%u %llu", &frame, &timestamp) != 2))
+        {
+            continue;
+        }
+
+        host_replay_detection_add(golden, frame, timestamp);
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+// Both lists are in frame order.  Returns the number of differences.
+static uint32_t host_replay_golden_diff(const host_replay_t *golden, const host_replay_t *replay)
+{
+    uint32_t g = 0;
+    uint32_t r = 0;
+    uint32_t differences = 0;
+
+    while ((g < golden->detection_count) || (r < replay->detection_count))
+    {
+        const host_replay_detection_t *expected = g < golden->detection_count ? &golden->detections[g] : NULL;
+        const host_replay_detection_t *detected = r < replay->detection_count ? &replay->detections[r] : NULL;
+
+        if (expected && detected &&
+            (expected->frame == detected->frame) &&
+            (expected->timestamp == detected->timestamp))
+        {
+            g++;
+            r++;
+            continue;
+        }
+
+        if (expected && (!detected || (expected->frame <= detected->frame)))
+        {
+            am_util_stdio_printf("- %u %llu\n", expected->frame, (unsigned long long)expected->timestamp);
+            g++;
+        }
+        else
+        {
+            am_util_stdio_printf("+ %u %llu\n", detected->frame, (unsigned long long)detected->timestamp);
+            r++;
+        }
+        differences++;
+    }
+
+    return differences;
+}
+
+static void host_replay_show(const host_replay_t *replay)
+{
+    uint32_t samples = replay->imu_frames ? replay->imu_frames : 1;
+    uint32_t mag_samples = replay->mag_samples ? replay->mag_samples : 1;
+
+    am_util_stdio_printf("%u IMU frames, %u magnetometer samples, %u corrections\n",
+        replay->imu_frames, replay->mag_samples, replay->cal_records);
+    am_util_stdio_printf("%u records lost, %u starts%s\n",
+        replay->lost, replay->starts, replay->truncated ? ", last record truncated" : "");
+
+    am_util_stdio_printf("\n%-18s %12s\n", "stage", "ns/sample");
+    am_util_stdio_printf("%-18s %12.1f\n", "convert", (double)probe_convert.total / samples);
+    am_util_stdio_printf("%-18s %12.1f\n", "mag cal", (double)probe_mag_cal.total / mag_samples);
+    am_util_stdio_printf("%-18s %12.1f\n", "shotdetect", (double)probe_shotdetect.total / samples);
+
+    if (replay->elapsed_ns)
+    {
+        am_util_stdio_printf("\n%.0f samples/s\n", (double)replay->imu_frames * 1e9 / replay->elapsed_ns);
+    }
+    am_util_stdio_printf("%u detections\n", replay->detection_count);
+}
+
+/*
+ * host replay <trace> [golden [-u]]
+ *
+ * Replays a trace recorded with "app trace" and compares the detections
+ * with the golden file, if given.  -u writes the golden file instead.
+ * Returns a process exit status.
+ */
+int host_replay_main(int argc, char **argv)
+{
+    host_replay_t replay;
+    host_replay_t golden;
+    uint8_t *data;
+    size_t size = 0;
+    int status = EXIT_SUCCESS;
+
+    if ((argc < 2) || (argc > 4) || ((argc == 4) && (strcmp(argv[3], "-u") != 0)))
+    {
+        am_util_stdio_printf("usage: replay <trace> [golden [-u]]\n");
+        return EXIT_FAILURE;
+    }
+
+    data = host_replay_load(argv[1], &size);
+    if (data == NULL)
+    {
+        am_util_stdio_printf("cannot read %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (!host_replay_run(data, size, &replay))
+    {
+        free(data);
+        return EXIT_FAILURE;
+    }
+    host_replay_show(&replay);
+
+    if (argc == 4)
+    {
+        if (!host_replay_golden_write(argv[2], &replay))
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+    else if (argc == 3)
+    {
+        if (!host_replay_golden_read(argv[2], &golden))
+        {
+            status = EXIT_FAILURE;
+        }
+        else
+        {
+            uint32_t differences = host_replay_golden_diff(&golden, &replay);
+
+            am_util_stdio_printf("%u differences from %s\n", differences, argv[2]);
+            status = differences ? EXIT_FAILURE : EXIT_SUCCESS;
+            host_replay_free(&golden);
+        }
+    }
+
+    host_replay_free(&replay);
+    free(data);
+
+    return status;
+}
@@ -0,0 +1,847 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include "am_bsp.h"
+
+#include "bmi270.h"
+
+#include "bmi270_sim.h"
+
+#define GRAVITY                 (9.80665f)
+
+#define REG_CHIP_ID             BMI2_CHIP_ID_ADDR
+#define REG_STATUS              BMI2_STATUS_ADDR
+#define REG_ACC_X_LSB           BMI2_ACC_X_LSB_ADDR
+#define REG_GYR_X_LSB           BMI2_GYR_X_LSB_ADDR
+#define REG_SENSORTIME_0        UINT8_C(0x18)
+#define REG_INT_STATUS_1        BMI2_INT_STATUS_1_ADDR
+#define REG_INTERNAL_STATUS     BMI2_INTERNAL_STATUS_ADDR
+#define REG_FIFO_LENGTH_0       BMI2_FIFO_LENGTH_0_ADDR
+#define REG_FIFO_LENGTH_1       UINT8_C(0x25)
+#define REG_FIFO_DATA           BMI2_FIFO_DATA_ADDR
+#define REG_FEAT_PAGE           BMI2_FEAT_PAGE_ADDR
+#define REG_FEATURES            BMI2_FEATURES_REG_ADDR
+#define REG_ACC_CONF            BMI2_ACC_CONF_ADDR
+#define REG_ACC_RANGE           UINT8_C(0x41)
+#define REG_GYR_CONF            BMI2_GYR_CONF_ADDR
+#define REG_GYR_RANGE           UINT8_C(0x43)
+#define REG_FIFO_WTM_0          BMI2_FIFO_WTM_0_ADDR
+#define REG_FIFO_WTM_1          BMI2_FIFO_WTM_1_ADDR
+#define REG_FIFO_CONFIG_0       BMI2_FIFO_CONFIG_0_ADDR
+#define REG_FIFO_CONFIG_1       BMI2_FIFO_CONFIG_1_ADDR
+#define REG_INT1_IO_CTRL        BMI2_INT1_IO_CTRL_ADDR
+#define REG_INT2_IO_CTRL        BMI2_INT2_IO_CTRL_ADDR
+#define REG_INT_MAP_DATA        BMI2_INT_MAP_DATA_ADDR
+#define REG_INIT_CTRL           BMI2_INIT_CTRL_ADDR
+#define REG_INIT_ADDR_0         BMI2_INIT_ADDR_0
+#define REG_INIT_ADDR_1         UINT8_C(0x5C)
+#define REG_INIT_DATA           BMI2_INIT_DATA_ADDR
+#define REG_PWR_CONF            BMI2_PWR_CONF_ADDR
+#define REG_PWR_CTRL            BMI2_PWR_CTRL_ADDR
+#define REG_CMD                 BMI2_CMD_REG_ADDR
+
+#define STATUS_CMD_RDY          (0x10)
+#define STATUS_DRDY_GYR         (0x40)
+#define STATUS_DRDY_ACC         (0x80)
+
+#define INT_FFULL               (0x01)
+#define INT_FWM                 (0x02)
+#define INT_DRDY                (0x04)
+
+#define INT_STATUS_1_DRDY_GYR   (0x40)
+#define INT_STATUS_1_DRDY_ACC   (0x80)
+
+#define IO_CTRL_OUTPUT_EN       (0x08)
+
+#define INTERNAL_STATUS_NOT_INIT    (0x00)
+#define INTERNAL_STATUS_INIT_OK     (0x01)
+#define INTERNAL_STATUS_INIT_ERR    (0x02)
+
+#define PWR_CONF_APS            (0x01)
+#define PWR_CTRL_GYR            (0x02)
+#define PWR_CTRL_ACC            (0x04)
+
+#define FIFO_CONFIG_0_STOP_ON_FULL  (0x01)
+#define FIFO_CONFIG_0_TIME_EN       (0x02)
+#define FIFO_CONFIG_1_HEADER        (BMI2_FIFO_HEADER_EN >> 8)
+#define FIFO_CONFIG_1_AUX           (BMI2_FIFO_AUX_EN >> 8)
+#define FIFO_CONFIG_1_ACC           (BMI2_FIFO_ACC_EN >> 8)
+#define FIFO_CONFIG_1_GYR           (BMI2_FIFO_GYR_EN >> 8)
+
+#define FIFO_FRAME_MAX          (1 + BMI2_FIFO_ALL_LENGTH)
+
+// Sensor time runs at 25.6kHz, 39.0625us per tick.
+#define SENSORTIME_MASK         (0xFFFFFF)
+#define US_TO_TICKS(us)         ((us) * 16 / 625)
+#define TICKS_TO_US(ticks)      ((ticks) * 625 / 16)
+
+// The BMI270 firmware.  bmi270.c does not declare it in a header.
+extern const uint8_t bmi270_config_file[];
+
+static const struct
+{
+    uint8_t reg;
+    uint8_t value;
+} bmi270_sim_defaults[] = {
+    {REG_CHIP_ID,       BMI270_CHIP_ID},
+    {REG_STATUS,        STATUS_CMD_RDY},
+    {REG_ACC_CONF,      0xA8},
+    {REG_ACC_RANGE,     0x02},
+    {REG_GYR_CONF,      0xA9},
+    {REG_FIFO_WTM_1,    0x02},
+    {REG_FIFO_CONFIG_0, FIFO_CONFIG_0_TIME_EN},
+    {REG_FIFO_CONFIG_1, FIFO_CONFIG_1_HEADER},
+    {REG_PWR_CONF,      0x03},
+};
+
+static void bmi270_sim_reset(bmi270_sim_t *sim)
+{
+    memset(sim->regs, 0, sizeof(sim->regs));
+    for (uint32_t i = 0; i < sizeof(bmi270_sim_defaults) / sizeof(bmi270_sim_defaults[0]); i++)
+    {
+        sim->regs[bmi270_sim_defaults[i].reg] = bmi270_sim_defaults[i].value;
+    }
+    memset(sim->features, 0, sizeof(sim->features));
+    memset(sim->config_written, 0, sizeof(sim->config_written));
+
+    sim->initialised = false;
+    sim->init_pending = false;
+    sim->spi = false;
+    sim->accessed = false;
+    sim->origin_us = am_hal_host_time_us();
+    sim->tick = 0;
+
+    sim->fifo_length = 0;
+    sim->frame_count = 0;
+    sim->fifo_skipped = 0;
+    sim->sources = 0;
+    sim->pins = 0;
+    sim->pending = 0;
+}
+
+//*****************************************************************************
+//
+// Interrupts
+//
+//*****************************************************************************
+static uint8_t bmi270_sim_pin_levels(const bmi270_sim_t *sim, uint8_t sources)
+{
+    uint8_t map = sim->regs[REG_INT_MAP_DATA];
+    uint8_t levels = 0;
+
+    if ((sim->regs[REG_INT1_IO_CTRL] & IO_CTRL_OUTPUT_EN) && (sources & map & 0x07))
+    {
+        levels |= 0x01;
+    }
+    if ((sim->regs[REG_INT2_IO_CTRL] & IO_CTRL_OUTPUT_EN) && (sources & (map >> 4) & 0x07))
+    {
+        levels |= 0x02;
+    }
+
+    return levels;
+}
+
+// Re-evaluates the level sources.  pulse adds the data ready pulse of a
+// new sample, which raises an edge even if the pin is already active.
+static void bmi270_sim_interrupts(bmi270_sim_t *sim, uint8_t pulse)
+{
+    uint16_t watermark = sim->regs[REG_FIFO_WTM_0] | ((sim->regs[REG_FIFO_WTM_1] & 0x1F) << 8);
+    uint8_t sources = 0;
+
+    if (sim->fifo_length + FIFO_FRAME_MAX > BMI270_SIM_FIFO_SIZE)
+    {
+        sources |= INT_FFULL;
+    }
+    if (watermark && (sim->fifo_length >= watermark))
+    {
+        sources |= INT_FWM;
+    }
+
+    sim->regs[REG_INT_STATUS_1] |= sources & ~sim->sources;
+
+    uint8_t levels = bmi270_sim_pin_levels(sim, sources);
+    sim->pending |= (levels & ~sim->pins) | bmi270_sim_pin_levels(sim, pulse);
+    sim->pins = levels;
+    sim->sources = sources;
+}
+
+//*****************************************************************************
+//
+// FIFO
+//
+//*****************************************************************************
+static void bmi270_sim_le16(uint8_t *data, int16_t value)
+{
+    data[0] = (uint8_t)((uint16_t)value & 0xFF);
+    data[1] = (uint8_t)((uint16_t)value >> 8);
+}
+
+uint32_t bmi270_sim_frame(uint8_t *frame, uint8_t fifo_config_1,
+                          const int16_t acc[3], const int16_t gyr[3], const uint8_t *aux)
+{
+    uint32_t length = 0;
+
+    if (!(fifo_config_1 & (FIFO_CONFIG_1_AUX | FIFO_CONFIG_1_GYR | FIFO_CONFIG_1_ACC)))
+    {
+        return 0;
+    }
+
+    // The header carries the aux, gyro and accel bits in the positions of
+    // BMI2_FIFO_HEADER_ALL_FRM.  The payload follows in that order.
+    if (fifo_config_1 & FIFO_CONFIG_1_HEADER)
+    {
+        frame[length++] = (uint8_t)(0x80 |
+            ((fifo_config_1 & FIFO_CONFIG_1_AUX) ? 0x10 : 0) |
+            ((fifo_config_1 & FIFO_CONFIG_1_GYR) ? 0x08 : 0) |
+            ((fifo_config_1 & FIFO_CONFIG_1_ACC) ? 0x04 : 0));
+    }
+    if (fifo_config_1 & FIFO_CONFIG_1_AUX)
+    {
+        if (aux)
+        {
+            memcpy(&frame[length], aux, BMI2_FIFO_AUX_LENGTH);
+        }
+        else
+        {
+            memset(&frame[length], 0, BMI2_FIFO_AUX_LENGTH);
+        }
+        length += BMI2_FIFO_AUX_LENGTH;
+    }
+    if (fifo_config_1 & FIFO_CONFIG_1_GYR)
+    {
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            bmi270_sim_le16(&frame[length + 2 * i], gyr[i]);
+        }
+        length += BMI2_FIFO_GYR_LENGTH;
+    }
+    if (fifo_config_1 & FIFO_CONFIG_1_ACC)
+    {
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            bmi270_sim_le16(&frame[length + 2 * i], acc[i]);
+        }
+        length += BMI2_FIFO_ACC_LENGTH;
+    }
+
+    return length;
+}
+
+static void bmi270_sim_fifo_pop(bmi270_sim_t *sim, uint16_t frames)
+{
+    uint16_t bytes = 0;
+
+    for (uint16_t i = 0; i < frames; i++)
+    {
+        bytes += sim->frame_length[i];
+    }
+
+    memmove(sim->fifo, &sim->fifo[bytes], sim->fifo_length - bytes);
+    memmove(sim->frame_length, &sim->frame_length[frames], sim->frame_count - frames);
+    sim->fifo_length -= bytes;
+    sim->frame_count -= frames;
+}
+
+static void bmi270_sim_fifo_push(bmi270_sim_t *sim, const uint8_t *frame, uint32_t length)
+{
+    if (sim->fifo_length + length > BMI270_SIM_FIFO_SIZE)
+    {
+        if (sim->regs[REG_FIFO_CONFIG_0] & FIFO_CONFIG_0_STOP_ON_FULL)
+        {
+            sim->stats.fifo_overflows++;
+            return;
+        }
+
+        // The oldest frames make room.  Header mode reports them with a
+        // skip frame at the start of the next read.
+        uint16_t frames = 0;
+        uint32_t freed = 0;
+        while (sim->fifo_length - freed + length > BMI270_SIM_FIFO_SIZE)
+        {
+            freed += sim->frame_length[frames++];
+        }
+        bmi270_sim_fifo_pop(sim, frames);
+        sim->fifo_skipped += frames;
+        sim->stats.fifo_overflows += frames;
+    }
+
+    memcpy(&sim->fifo[sim->fifo_length], frame, length);
+    sim->fifo_length += length;
+    sim->frame_length[sim->frame_count++] = (uint8_t)length;
+}
+
+static void bmi270_sim_fifo_flush(bmi270_sim_t *sim)
+{
+    sim->fifo_length = 0;
+    sim->frame_count = 0;
+    sim->fifo_skipped = 0;
+    bmi270_sim_interrupts(sim, 0);
+}
+
+/*
+ * A burst from FIFO_DATA returns a pending skip frame, the stored frames
+ * and then, once they run out, a sensor time frame in header mode followed
+ * by the over-read pattern.  Only frames read whole leave the FIFO.
+ */
+static void bmi270_sim_fifo_read(bmi270_sim_t *sim, uint8_t *data, uint32_t len)
+{
+    bool header = sim->regs[REG_FIFO_CONFIG_1] & FIFO_CONFIG_1_HEADER;
+    uint32_t index = 0;
+    uint32_t offset = 0;
+    uint16_t frames = 0;
+
+    if (header && sim->fifo_skipped && (len >= 2))
+    {
+        data[index++] = BMI2_FIFO_HEADER_SKIP_FRM;
+        data[index++] = (uint8_t)(sim->fifo_skipped > 0xFF ? 0xFF : sim->fifo_skipped);
+        sim->fifo_skipped = 0;
+    }
+
+    while ((index < len) && (frames < sim->frame_count))
+    {
+        uint32_t length = sim->frame_length[frames];
+        uint32_t copy = (len - index < length) ? len - index : length;
+
+        memcpy(&data[index], &sim->fifo[offset], copy);
+        index += copy;
+        if (copy < length)
+        {
+            break;
+        }
+        offset += length;
+        frames++;
+    }
+
+    if ((frames == sim->frame_count) && header &&
+        (sim->regs[REG_FIFO_CONFIG_0] & FIFO_CONFIG_0_TIME_EN) &&
+        (len - index >= 1 + BMI2_SENSOR_TIME_LENGTH))
+    {
+        data[index++] = BMI2_FIFO_HEADER_SENS_TIME_FRM;
+        data[index++] = sim->regs[REG_SENSORTIME_0];
+        data[index++] = sim->regs[REG_SENSORTIME_0 + 1];
+        data[index++] = sim->regs[REG_SENSORTIME_0 + 2];
+    }
+
+    for (uint32_t i = 0; index < len; i++)
+    {
+        data[index++] = (i & 1) ? BMI2_FIFO_LSB_CONFIG_CHECK : BMI2_FIFO_MSB_CONFIG_CHECK;
+    }
+
+    bmi270_sim_fifo_pop(sim, frames);
+    sim->stats.fifo_bytes += len;
+    sim->stats.fifo_frames += frames;
+    bmi270_sim_interrupts(sim, 0);
+}
+
+//*****************************************************************************
+//
+// Sampling
+//
+//*****************************************************************************
+static void bmi270_sim_motion_rest(void *context, uint64_t time_us, float acc[3], float gyr[3])
+{
+    (void)context;
+    (void)time_us;
+
+    acc[0] = 0.0f;
+    acc[1] = 0.0f;
+    acc[2] = GRAVITY;
+    gyr[0] = 0.0f;
+    gyr[1] = 0.0f;
+    gyr[2] = 0.0f;
+}
+
+static int16_t bmi270_sim_lsb(float value, float full_scale)
+{
+    float lsb = roundf(value * 32768.0f / full_scale);
+
+    if (lsb > 32767.0f)
+    {
+        return 32767;
+    }
+    if (lsb < -32768.0f)
+    {
+        return -32768;
+    }
+
+    return (int16_t)lsb;
+}
+
+// Sensor time ticks per sample of ODR code odr, 0 if it is not a rate.
+static uint64_t bmi270_sim_period_ticks(uint8_t odr)
+{
+    if ((odr == 0) || (odr > BMI2_GYR_ODR_3200HZ))
+    {
+        return 0;
+    }
+
+    // Each step doubles the rate.  100Hz is 256 ticks.
+    return odr >= BMI2_ACC_ODR_100HZ ? 256 >> (odr - BMI2_ACC_ODR_100HZ) : 256 << (BMI2_ACC_ODR_100HZ - odr);
+}
+
+static void bmi270_sim_sample(bmi270_sim_t *sim, uint64_t time_us)
+{
+    uint8_t power = sim->regs[REG_PWR_CTRL];
+    float acc[3];
+    float gyr[3];
+    int16_t acc_lsb[3];
+    int16_t gyr_lsb[3];
+    float acc_scale = GRAVITY * (float)(2 << (sim->regs[REG_ACC_RANGE] & 0x03));
+    float gyr_scale = (float)(2000 >> (sim->regs[REG_GYR_RANGE] & 0x07)) * (float)M_PI / 180.0f;
+
+    sim->motion(sim->motion_context, time_us, acc, gyr);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        acc_lsb[i] = (power & PWR_CTRL_ACC) ? bmi270_sim_lsb(acc[i], acc_scale) : 0;
+        gyr_lsb[i] = (power & PWR_CTRL_GYR) ? bmi270_sim_lsb(gyr[i], gyr_scale) : 0;
+    }
+
+    if (power & PWR_CTRL_ACC)
+    {
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            bmi270_sim_le16(&sim->regs[REG_ACC_X_LSB + 2 * i], acc_lsb[i]);
+        }
+        sim->regs[REG_STATUS] |= STATUS_DRDY_ACC;
+        sim->regs[REG_INT_STATUS_1] |= INT_STATUS_1_DRDY_ACC;
+    }
+    if (power & PWR_CTRL_GYR)
+    {
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            bmi270_sim_le16(&sim->regs[REG_GYR_X_LSB + 2 * i], gyr_lsb[i]);
+        }
+        sim->regs[REG_STATUS] |= STATUS_DRDY_GYR;
+        sim->regs[REG_INT_STATUS_1] |= INT_STATUS_1_DRDY_GYR;
+    }
+
+    // Sensors that are powered down are left out of the frame.
+    uint8_t fifo_config = sim->regs[REG_FIFO_CONFIG_1];
+    if (!(power & PWR_CTRL_ACC))
+    {
+        fifo_config &= ~FIFO_CONFIG_1_ACC;
+    }
+    if (!(power & PWR_CTRL_GYR))
+    {
+        fifo_config &= ~FIFO_CONFIG_1_GYR;
+    }
+
+    uint8_t frame[FIFO_FRAME_MAX];
+    uint32_t length = bmi270_sim_frame(frame, fifo_config, acc_lsb, gyr_lsb, NULL);
+    if (length)
+    {
+        bmi270_sim_fifo_push(sim, frame, length);
+    }
+
+    sim->stats.samples++;
+    bmi270_sim_interrupts(sim, INT_DRDY);
+}
+
+// Produces the samples due up to the virtual clock and latches the sensor
+// time registers.
+static void bmi270_sim_catch_up(bmi270_sim_t *sim)
+{
+    uint64_t now = am_hal_host_time_us();
+    uint64_t tick = US_TO_TICKS(now - sim->origin_us);
+    uint8_t power = sim->regs[REG_PWR_CTRL];
+    uint8_t odr = sim->regs[(power & PWR_CTRL_ACC) ? REG_ACC_CONF : REG_GYR_CONF] & 0x0F;
+    uint64_t period = bmi270_sim_period_ticks(odr);
+
+    if (sim->init_pending && (now >= sim->init_done_us))
+    {
+        sim->init_pending = false;
+        sim->initialised = sim->init_result == INTERNAL_STATUS_INIT_OK;
+        sim->regs[REG_INTERNAL_STATUS] = sim->init_result;
+    }
+
+    if (sim->initialised && period && (power & (PWR_CTRL_ACC | PWR_CTRL_GYR)))
+    {
+        for (uint64_t t = (sim->tick / period + 1) * period; t <= tick; t += period)
+        {
+            bmi270_sim_sample(sim, sim->origin_us + TICKS_TO_US(t));
+        }
+    }
+    sim->tick = tick;
+
+    uint32_t sensortime = (uint32_t)(tick & SENSORTIME_MASK);
+    sim->regs[REG_SENSORTIME_0 + 0] = (uint8_t)(sensortime);
+    sim->regs[REG_SENSORTIME_0 + 1] = (uint8_t)(sensortime >> 8);
+    sim->regs[REG_SENSORTIME_0 + 2] = (uint8_t)(sensortime >> 16);
+}
+
+//*****************************************************************************
+//
+// Registers
+//
+//*****************************************************************************
+static void bmi270_sim_config_load(bmi270_sim_t *sim)
+{
+    bool complete = true;
+
+    for (uint32_t i = 0; i < sizeof(sim->config_written); i++)
+    {
+        complete = complete && (sim->config_written[i] == 0xFF);
+    }
+
+    sim->stats.config_loads++;
+    sim->init_pending = true;
+    sim->init_done_us = am_hal_host_time_us() + BMI270_SIM_INIT_US;
+    sim->init_result = (complete && (memcmp(sim->config, bmi270_config_file, BMI270_SIM_CONFIG_SIZE) == 0))
+        ? INTERNAL_STATUS_INIT_OK
+        : INTERNAL_STATUS_INIT_ERR;
+    sim->regs[REG_INTERNAL_STATUS] = INTERNAL_STATUS_NOT_INIT;
+}
+
+static uint8_t bmi270_sim_reg_read(bmi270_sim_t *sim, uint8_t reg)
+{
+    uint8_t value = sim->regs[reg];
+
+    if ((reg >= REG_FEATURES) && (reg < REG_FEATURES + BMI270_SIM_FEATURE_SIZE))
+    {
+        return sim->features[sim->regs[REG_FEAT_PAGE] % BMI270_SIM_FEATURE_PAGES][reg - REG_FEATURES];
+    }
+
+    switch (reg)
+    {
+    case REG_ACC_X_LSB + 5:
+        sim->regs[REG_STATUS] &= ~STATUS_DRDY_ACC;
+        break;
+    case REG_GYR_X_LSB + 5:
+        sim->regs[REG_STATUS] &= ~STATUS_DRDY_GYR;
+        break;
+    case REG_INT_STATUS_1:
+        sim->regs[reg] = 0;
+        break;
+    case REG_FIFO_LENGTH_0:
+        value = (uint8_t)(sim->fifo_length & 0xFF);
+        break;
+    case REG_FIFO_LENGTH_1:
+        value = (uint8_t)((sim->fifo_length >> 8) & 0x3F);
+        break;
+    default:
+        break;
+    }
+
+    return value;
+}
+
+static void bmi270_sim_reg_write(bmi270_sim_t *sim, uint8_t reg, uint8_t value)
+{
+    if ((reg >= REG_FEATURES) && (reg < REG_FEATURES + BMI270_SIM_FEATURE_SIZE))
+    {
+        sim->features[sim->regs[REG_FEAT_PAGE] % BMI270_SIM_FEATURE_PAGES][reg - REG_FEATURES] = value;
+        return;
+    }
+
+    switch (reg)
+    {
+    case REG_CHIP_ID:
+    case REG_STATUS:
+    case REG_INT_STATUS_1:
+    case REG_INTERNAL_STATUS:
+    case REG_FIFO_LENGTH_0:
+    case REG_FIFO_LENGTH_1:
+        sim->stats.rejected_writes++;
+        return;
+    case REG_CMD:
+        if (value == BMI2_SOFT_RESET_CMD)
+        {
+            bmi270_sim_reset(sim);
+        }
+        else if (value == BMI2_FIFO_FLUSH_CMD)
+        {
+            bmi270_sim_fifo_flush(sim);
+        }
+        return;
+    default:
+        break;
+    }
+
+    sim->regs[reg] = value;
+
+    switch (reg)
+    {
+    case REG_INIT_CTRL:
+        if (value & 0x01)
+        {
+            bmi270_sim_config_load(sim);
+        }
+        else
+        {
+            // A new upload starts.
+            memset(sim->config_written, 0, sizeof(sim->config_written));
+            sim->initialised = false;
+            sim->init_pending = false;
+            sim->regs[REG_INTERNAL_STATUS] = INTERNAL_STATUS_NOT_INIT;
+        }
+        break;
+    case REG_FIFO_WTM_0:
+    case REG_FIFO_WTM_1:
+    case REG_INT1_IO_CTRL:
+    case REG_INT2_IO_CTRL:
+    case REG_INT_MAP_DATA:
+        bmi270_sim_interrupts(sim, 0);
+        break;
+    default:
+        break;
+    }
+}
+
+// INIT_DATA traps the address.  Bytes go to the configuration memory at
+// the word address held in INIT_ADDR_0 and INIT_ADDR_1.
+static void bmi270_sim_init_data(bmi270_sim_t *sim, const uint8_t *data, uint32_t len)
+{
+    uint32_t offset = 2 * ((sim->regs[REG_INIT_ADDR_0] & 0x0F) | ((uint32_t)sim->regs[REG_INIT_ADDR_1] << 4));
+
+    if (sim->regs[REG_PWR_CONF] & PWR_CONF_APS)
+    {
+        sim->stats.rejected_writes++;
+        return;
+    }
+
+    for (uint32_t i = 0; (i < len) && (offset + i < BMI270_SIM_CONFIG_SIZE); i++)
+    {
+        sim->config[offset + i] = data[i];
+        sim->config_written[(offset + i) / 8] |= (uint8_t)(1 << ((offset + i) % 8));
+    }
+}
+
+/*
+ * Common to reads and writes.  Returns false if the access is lost: the
+ * first transfer after reset only switches the interface to SPI, and an
+ * access less than BMI270_SIM_APS_SPACING_US after one made in advanced
+ * power save is not reliable.  The power save state is that of the device
+ * when the previous access started, so the access right after the write
+ * that enables it is still allowed.
+ */
+static bool bmi270_sim_access(bmi270_sim_t *sim, uint32_t len)
+{
+    uint64_t now = am_hal_host_time_us();
+    bool valid = true;
+
+    bmi270_sim_catch_up(sim);
+
+    if (!sim->spi)
+    {
+        sim->spi = true;
+        valid = false;
+    }
+    else if (sim->accessed && sim->last_access_aps &&
+             (now - sim->last_access_us < BMI270_SIM_APS_SPACING_US))
+    {
+        sim->stats.aps_violations++;
+        valid = false;
+    }
+
+    // Address byte plus data.  The clock moves on by the transfer time.
+    if (sim->bus_hz)
+    {
+        sim->bus_ns += (uint64_t)(1 + len) * 8 * 1000000000 / sim->bus_hz;
+        am_hal_host_time_advance_us(sim->bus_ns / 1000);
+        sim->bus_ns %= 1000;
+    }
+
+    sim->accessed = true;
+    sim->last_access_aps = sim->regs[REG_PWR_CONF] & PWR_CONF_APS;
+    sim->last_access_us = am_hal_host_time_us();
+    sim->stats.bytes += len;
+
+    return valid;
+}
+
+uint32_t bmi270_sim_read(bmi270_sim_t *sim, uint8_t reg, uint8_t *data, uint32_t len)
+{
+    sim->stats.reads++;
+
+    if (!(reg & BMI2_SPI_RD_MASK) || (len == 0))
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    if (!bmi270_sim_access(sim, len - 1))
+    {
+        memset(data, 0, len);
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
+    // The dummy byte is clocked out while the address is decoded.
+    data[0] = 0xFF;
+    reg &= ~BMI2_SPI_RD_MASK;
+    for (uint32_t i = 1; i < len; i++)
+    {
+        if (reg == REG_FIFO_DATA)
+        {
+            bmi270_sim_fifo_read(sim, &data[i], len - i);
+            break;
+        }
+
+        data[i] = bmi270_sim_reg_read(sim, reg);
+        reg = (reg + 1) & 0x7F;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t bmi270_sim_write(bmi270_sim_t *sim, uint8_t reg, const uint8_t *data, uint32_t len)
+{
+    sim->stats.writes++;
+
+    if ((reg & BMI2_SPI_RD_MASK) || (len == 0))
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    // The write that switches the interface to SPI is lost without being
+    // counted, as the driver expects.
+    bool spi = sim->spi;
+    if (!bmi270_sim_access(sim, len))
+    {
+        sim->stats.rejected_writes += spi ? 1 : 0;
+        return AM_HAL_STATUS_SUCCESS;
+    }
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (reg == REG_INIT_DATA)
+        {
+            bmi270_sim_init_data(sim, &data[i], len - i);
+            break;
+        }
+
+        bmi270_sim_reg_write(sim, reg, data[i]);
+        reg = (reg + 1) & 0x7F;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Bus bindings
+//
+//*****************************************************************************
+static uint32_t bmi270_sim_iom_peer(void *context, const am_hal_iom_transfer_t *transfer)
+{
+    bmi270_sim_t *sim = (bmi270_sim_t *)context;
+
+    if ((transfer->ui32InstrLen != 1) || (transfer->uPeerInfo.ui32SpiChipSelect != AM_BSP_IMU_CS_CHNL))
+    {
+        return AM_HAL_STATUS_FAIL;
+    }
+
+    if (transfer->eDirection == AM_HAL_IOM_RX)
+    {
+        return bmi270_sim_read(sim, (uint8_t)transfer->ui32Instr,
+                               (uint8_t *)transfer->pui32RxBuffer, transfer->ui32NumBytes);
+    }
+
+    return bmi270_sim_write(sim, (uint8_t)transfer->ui32Instr,
+                            (const uint8_t *)transfer->pui32TxBuffer, transfer->ui32NumBytes);
+}
+
+static BMI2_INTF_RETURN_TYPE bmi270_sim_dev_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    uint32_t status = bmi270_sim_read((bmi270_sim_t *)intf_ptr, reg_addr, reg_data, len);
+
+    return status == AM_HAL_STATUS_SUCCESS ? BMI2_INTF_RET_SUCCESS : BMI2_E_COM_FAIL;
+}
+
+static BMI2_INTF_RETURN_TYPE bmi270_sim_dev_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    uint32_t status = bmi270_sim_write((bmi270_sim_t *)intf_ptr, reg_addr, reg_data, len);
+
+    return status == AM_HAL_STATUS_SUCCESS ? BMI2_INTF_RET_SUCCESS : BMI2_E_COM_FAIL;
+}
+
+static void bmi270_sim_dev_delay_us(uint32_t period, void *intf_ptr)
+{
+    (void)intf_ptr;
+
+    am_util_delay_us(period);
+}
+
+void bmi270_sim_init(bmi270_sim_t *sim)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->bus_hz = BMI270_SIM_BUS_HZ;
+    sim->motion = bmi270_sim_motion_rest;
+    bmi270_sim_reset(sim);
+}
+
+void bmi270_sim_motion(bmi270_sim_t *sim, bmi270_sim_motion_t motion, void *context)
+{
+    sim->motion = motion ? motion : bmi270_sim_motion_rest;
+    sim->motion_context = context;
+}
+
+void bmi270_sim_attach(bmi270_sim_t *sim, uint32_t module)
+{
+    am_hal_host_iom_attach(module, bmi270_sim_iom_peer, sim);
+}
+
+// Same settings as bmi2_interface_init() without the IOM in between.
+void bmi270_sim_interface_init(bmi270_sim_t *sim, struct bmi2_dev *dev)
+{
+    dev->intf = BMI2_SPI_INTF;
+    dev->read = bmi270_sim_dev_read;
+    dev->write = bmi270_sim_dev_write;
+    dev->delay_us = bmi270_sim_dev_delay_us;
+    dev->intf_ptr = sim;
+    dev->read_write_len = 46;
+    dev->config_file_ptr = NULL;
+}
+
+void bmi270_sim_update(bmi270_sim_t *sim)
+{
+    bmi270_sim_catch_up(sim);
+
+    uint8_t pending = sim->pending;
+    sim->pending = 0;
+
+    if (pending & 0x01)
+    {
+        sim->stats.interrupts[0]++;
+        am_hal_host_gpio_fire(AM_BSP_GPIO_IMU_INT1);
+    }
+    if (pending & 0x02)
+    {
+        sim->stats.interrupts[1]++;
+        am_hal_host_gpio_fire(AM_BSP_GPIO_IMU_INT2);
+    }
+}
@@ -0,0 +1,157 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _BMI270_SIM_H_
+#define _BMI270_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <bmi2.h>
+
+/*
+ * Register level model of the BMI270 for the host build.
+ *
+ * The model answers the SPI transfers issued by the Bosch driver, either
+ * as the IOM peer of bmi270_hal.c (bmi270_sim_attach()) or directly as the
+ * read, write and delay callbacks of a bmi2_dev
+ * (bmi270_sim_interface_init()).  It covers:
+ *
+ * - the SPI switch after reset, soft reset and FIFO flush commands,
+ * - the configuration upload through INIT_ADDR/INIT_DATA and the
+ *   INTERNAL_STATUS handshake checked by bmi270_init(), which only reports
+ *   success 20ms after the load is enabled with the complete, unmodified
+ *   bmi270_config_file image,
+ * - the 450us access spacing required while advanced power save is on,
+ * - feature pages through FEAT_PAGE and the 16 byte feature window,
+ * - the data, STATUS, INT_STATUS_1 and 24 bit sensor time registers,
+ * - the 6KB FIFO in header and headerless modes, with sensor time, skip
+ *   and over-read frames, the watermark and both overflow policies,
+ * - the data ready, watermark and FIFO full interrupts on INT1 and INT2.
+ *
+ * Samples are produced on sensor time boundaries of the accelerometer ODR,
+ * which the gyroscope follows as imu_set_rate() keeps both at one rate.
+ * The motion features are not modelled: their configuration is stored but
+ * they never raise an interrupt.
+ *
+ * Time is the virtual clock of the host HAL.  Each access also takes the
+ * time its bytes would occupy the bus at bus_hz.  Samples are produced
+ * lazily on every access, while interrupts are only delivered by
+ * bmi270_sim_update().
+ */
+#define BMI270_SIM_FIFO_SIZE        (6144)
+#define BMI270_SIM_CONFIG_SIZE      (8192)
+#define BMI270_SIM_FEATURE_PAGES    (8)
+#define BMI270_SIM_FEATURE_SIZE     (16)
+#define BMI270_SIM_BUS_HZ           (8000000)
+
+// Internal processing time from enabling the configuration load to
+// INTERNAL_STATUS reporting the result.
+#define BMI270_SIM_INIT_US          (20000)
+
+// Shortest spacing between accesses while advanced power save is enabled.
+#define BMI270_SIM_APS_SPACING_US   (450)
+
+/*
+ * Sensor input at time_us on the virtual clock.  acc is in m/s^2 and gyr
+ * in rad/s, in the sensor frame.
+ */
+typedef void (*bmi270_sim_motion_t)(void *context, uint64_t time_us, float acc[3], float gyr[3]);
+
+typedef struct bmi270_sim_stats_s
+{
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t bytes;             // register bytes, without address or dummy bytes
+    uint32_t fifo_bytes;        // bytes read from FIFO_DATA
+    uint32_t fifo_frames;       // frames read whole from the FIFO
+    uint32_t fifo_overflows;    // frames lost to a full FIFO
+    uint32_t aps_violations;    // accesses too close together in power save
+    uint32_t rejected_writes;   // writes dropped by the device
+    uint32_t config_loads;
+    uint32_t samples;
+    uint32_t interrupts[2];     // edges delivered on INT1 and INT2
+} bmi270_sim_stats_t;
+
+typedef struct bmi270_sim_s
+{
+    uint8_t regs[128];
+    uint8_t features[BMI270_SIM_FEATURE_PAGES][BMI270_SIM_FEATURE_SIZE];
+
+    uint8_t config[BMI270_SIM_CONFIG_SIZE];
+    uint8_t config_written[BMI270_SIM_CONFIG_SIZE / 8];
+    bool initialised;
+    bool init_pending;
+    uint64_t init_done_us;
+    uint8_t init_result;
+
+    bool spi;                   // false until the first transfer after reset
+    bool accessed;
+    bool last_access_aps;       // power save was on when it started
+    uint64_t last_access_us;
+    uint64_t bus_hz;
+    uint64_t bus_ns;            // bus time not yet added to the clock
+
+    uint64_t origin_us;         // virtual time at sensor time 0
+    uint64_t tick;              // sensor time ticks already processed
+
+    uint8_t fifo[BMI270_SIM_FIFO_SIZE];
+    uint16_t fifo_length;
+    uint8_t frame_length[BMI270_SIM_FIFO_SIZE / 6];
+    uint16_t frame_count;
+    uint16_t fifo_skipped;      // frames dropped since the last read
+
+    uint8_t sources;            // current FIFO full and watermark levels
+    uint8_t pins;               // INT1 and INT2 output levels
+    uint8_t pending;            // INT1 and INT2 edges not yet delivered
+
+    bmi270_sim_motion_t motion;
+    void *motion_context;
+
+    bmi270_sim_stats_t stats;
+} bmi270_sim_t;
+
+extern void bmi270_sim_init(bmi270_sim_t *sim);
+extern void bmi270_sim_motion(bmi270_sim_t *sim, bmi270_sim_motion_t motion, void *context);
+extern void bmi270_sim_attach(bmi270_sim_t *sim, uint32_t module);
+extern void bmi270_sim_interface_init(bmi270_sim_t *sim, struct bmi2_dev *dev);
+extern void bmi270_sim_update(bmi270_sim_t *sim);
+
+// Transfers as seen on the bus.  A read returns the SPI dummy byte first.
+extern uint32_t bmi270_sim_read(bmi270_sim_t *sim, uint8_t reg, uint8_t *data, uint32_t len);
+extern uint32_t bmi270_sim_write(bmi270_sim_t *sim, uint8_t reg, const uint8_t *data, uint32_t len);
+
+// Encodes one FIFO frame of the sensors in fifo_config_1 (BMI2_FIFO_*_EN
+// >> 8) and returns its length.  aux may be NULL.
+extern uint32_t bmi270_sim_frame(uint8_t *frame, uint8_t fifo_config_1,
+                                 const int16_t acc[3], const int16_t gyr[3], const uint8_t *aux);
+
+#endif
@@ -0,0 +1,762 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include "am_bsp.h"
+
+#include "bmm350.h"
+
+#include "bmm350_sim.h"
+
+#define INT_STATUS_DRDY         BMM350_DRDY_DATA_REG_MSK
+
+#define INT_CTRL_LATCHED        BMM350_INT_MODE_MSK
+#define INT_CTRL_OUTPUT_EN      BMM350_INT_OUTPUT_EN_MSK
+#define INT_CTRL_DRDY_EN        BMM350_DRDY_DATA_REG_EN_MSK
+
+#define SELF_TEST_ENABLE        (0x01)
+#define SELF_TEST_NEGATIVE      (0x02)
+#define SELF_TEST_POSITIVE      (0x04)
+#define SELF_TEST_X             (0x08)
+#define SELF_TEST_Y             (0x10)
+
+#define PMU_NONE                (0xFF)
+
+#define RAW_MAX                 (0x7FFFFF)
+
+// Sensor time runs at 25.6kHz, 39.0625us per tick.
+#define SENSORTIME_MASK         (0xFFFFFF)
+#define US_TO_TICKS(us)         ((us) * 16 / 625)
+
+// Conversion of the raw values to uT and degC, as in the driver.
+#define LSB_POWER               (1000000.0 / 1048576.0)
+#define LSB_ADC_GAIN            (1.0 / 1.5)
+#define LSB_LUT_GAIN            (0.714607238769531)
+#define LSB_TO_UT_XY            (LSB_POWER / (14.55 * 19.46 * LSB_ADC_GAIN * LSB_LUT_GAIN))
+#define LSB_TO_UT_Z             (LSB_POWER / (9.0 * 31.0 * LSB_ADC_GAIN * LSB_LUT_GAIN))
+#define LSB_TO_DEGC             (1.0 / (0.00204 * LSB_ADC_GAIN * LSB_LUT_GAIN * 1048576.0))
+#define TEMP_OFFSET_DEGC        (25.49)
+
+static const uint8_t bmm350_sim_read_only[] = {
+    BMM350_REG_CHIP_ID,
+    BMM350_REG_REV_ID,
+    BMM350_REG_ERR_REG,
+    BMM350_REG_PMU_CMD_STATUS_0,
+    BMM350_REG_PMU_CMD_STATUS_1,
+    BMM350_REG_INT_STATUS,
+    BMM350_REG_OTP_DATA_MSB_REG,
+    BMM350_REG_OTP_DATA_LSB_REG,
+    BMM350_REG_OTP_STATUS_REG,
+};
+
+static const bmm350_sim_trim_t bmm350_sim_default_trim = {
+    .offset = {12, -7, 25},
+    .sens = {5, -3, 8},
+    .tco = {3, -2, 1},
+    .tcs = {-20, 15, 30},
+    .t_offs = 4,
+    .t_sens = -3,
+    .t0 = 768,
+    .cross_x_y = 6,
+    .cross_y_x = -4,
+    .cross_z_x = 9,
+    .cross_z_y = -5,
+    .var_id = 0x0A,
+};
+
+// Compensation terms in the units the driver decodes the trim codes to.
+typedef struct bmm350_sim_coef_s
+{
+    double offset[3];
+    double sens[3];
+    double tco[3];
+    double tcs[3];
+    double t_offs;
+    double t_sens;
+    double t0;
+    double cross_x_y;
+    double cross_y_x;
+    double cross_z_x;
+    double cross_z_y;
+} bmm350_sim_coef_t;
+
+//*****************************************************************************
+//
+// OTP
+//
+//*****************************************************************************
+static void bmm350_sim_otp_encode(bmm350_sim_t *sim)
+{
+    const bmm350_sim_trim_t *trim = &sim->trim;
+    uint16_t offset[3];
+    uint16_t *otp = sim->otp;
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        offset[i] = (uint16_t)trim->offset[i] & 0x0FFF;
+    }
+
+    memset(sim->otp, 0, sizeof(sim->otp));
+
+    // The Y and Z offsets have their top nibble in the previous word.
+    otp[BMM350_TEMP_OFF_SENS] = ((uint8_t)trim->t_sens << 8) | (uint8_t)trim->t_offs;
+    otp[BMM350_MAG_OFFSET_X] = offset[0] | ((offset[1] & 0x0F00) << 4);
+    otp[BMM350_MAG_OFFSET_Y] = (offset[1] & 0x00FF) | (offset[2] & 0x0F00);
+    otp[BMM350_MAG_OFFSET_Z] = (offset[2] & 0x00FF) | ((uint8_t)trim->sens[0] << 8);
+    otp[BMM350_MAG_SENS_Y] = (uint8_t)trim->sens[1] | ((uint8_t)trim->sens[2] << 8);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        otp[BMM350_MAG_TCO_X + i] = (uint8_t)trim->tco[i] | ((uint8_t)trim->tcs[i] << 8);
+    }
+    otp[BMM350_CROSS_X_Y] = (uint8_t)trim->cross_x_y | ((uint8_t)trim->cross_y_x << 8);
+    otp[BMM350_CROSS_Z_X] = (uint8_t)trim->cross_z_x | ((uint8_t)trim->cross_z_y << 8);
+    otp[BMM350_MAG_DUT_T_0] = (uint16_t)trim->t0;
+    otp[30] = (uint16_t)((trim->var_id & 0x3F) << 9);
+}
+
+static void bmm350_sim_otp_command(bmm350_sim_t *sim, uint8_t command)
+{
+    switch (command & BMM350_OTP_CMD_MSK)
+    {
+    case BMM350_OTP_CMD_DIR_READ:
+        if (!sim->otp_powered)
+        {
+            sim->regs[BMM350_REG_OTP_STATUS_REG] = BMM350_OTP_STATUS_INV_CMD_ERR;
+            break;
+        }
+        sim->otp_word = sim->otp[command & BMM350_OTP_WORD_ADDR_MSK];
+        sim->otp_busy = true;
+        sim->otp_done_us = am_hal_host_time_us() + BMM350_SIM_OTP_READ_US;
+        sim->regs[BMM350_REG_OTP_STATUS_REG] = BMM350_OTP_STATUS_NO_ERROR;
+        sim->stats.otp_reads++;
+        break;
+
+    case BMM350_OTP_CMD_PWR_OFF_OTP:
+        sim->otp_powered = false;
+        sim->otp_busy = false;
+        sim->regs[BMM350_REG_OTP_STATUS_REG] = BMM350_OTP_STATUS_CMD_DONE;
+        break;
+
+    default:
+        // Programming is not modelled.
+        sim->regs[BMM350_REG_OTP_STATUS_REG] = BMM350_OTP_STATUS_INV_CMD_ERR;
+        break;
+    }
+}
+
+//*****************************************************************************
+//
+// Conversions
+//
+//*****************************************************************************
+static void bmm350_sim_field_earth(void *context, uint64_t time_us, float field[3], float *temperature)
+{
+    (void)context;
+    (void)time_us;
+
+    field[0] = 22.0f;
+    field[1] = -4.0f;
+    field[2] = 41.0f;
+    *temperature = 25.0f;
+}
+
+static void bmm350_sim_coef(const bmm350_sim_trim_t *trim, bmm350_sim_coef_t *coef)
+{
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        coef->offset[i] = trim->offset[i];
+        coef->sens[i] = trim->sens[i] / 256.0;
+        coef->tco[i] = trim->tco[i] / 32.0;
+        coef->tcs[i] = trim->tcs[i] / 16384.0;
+    }
+
+    // The driver adds these corrections to the trimmed values.
+    coef->sens[1] += BMM350_SENS_CORR_Y;
+    coef->tcs[2] -= BMM350_TCS_CORR_Z;
+
+    coef->t_offs = trim->t_offs / 5.0;
+    coef->t_sens = trim->t_sens / 512.0;
+    coef->t0 = trim->t0 / 512.0 + 23.0;
+    coef->cross_x_y = trim->cross_x_y / 800.0;
+    coef->cross_y_x = trim->cross_y_x / 800.0;
+    coef->cross_z_x = trim->cross_z_x / 800.0;
+    coef->cross_z_y = trim->cross_z_y / 800.0;
+}
+
+static int32_t bmm350_sim_raw(double value, double lsb)
+{
+    double raw = round(value / lsb);
+
+    if (raw > RAW_MAX)
+    {
+        return RAW_MAX;
+    }
+    if (raw < -RAW_MAX - 1)
+    {
+        return -RAW_MAX - 1;
+    }
+
+    return (int32_t)raw;
+}
+
+// Raw values that bmm350_compensate_mag_xyz_temp_data() turns back into
+// field and temperature.
+static void bmm350_sim_uncompensate(const bmm350_sim_trim_t *trim, const double field[3], double temperature,
+                                    int32_t raw[4])
+{
+    static const double lsb[3] = {LSB_TO_UT_XY, LSB_TO_UT_XY, LSB_TO_UT_Z};
+    bmm350_sim_coef_t coef;
+    double axis[3];
+
+    bmm350_sim_coef(trim, &coef);
+
+    // Temperature, with the fixed offset the driver removes away from 0.
+    double t = (temperature - coef.t_offs) / (1.0 + coef.t_sens);
+    t += t >= 0.0 ? TEMP_OFFSET_DEGC : -TEMP_OFFSET_DEGC;
+    raw[3] = bmm350_sim_raw(t, LSB_TO_DEGC);
+
+    // Cross axis terms.
+    double det = 1.0 - coef.cross_y_x * coef.cross_x_y;
+    axis[0] = field[0] + coef.cross_x_y * field[1];
+    axis[1] = coef.cross_y_x * field[0] + field[1];
+    axis[2] = field[2] - (axis[0] * (coef.cross_y_x * coef.cross_z_y - coef.cross_z_x) -
+                          axis[1] * (coef.cross_z_y - coef.cross_x_y * coef.cross_z_x)) / det;
+
+    // Offset, sensitivity and their temperature coefficients.
+    double dt = temperature - coef.t0;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        double value = axis[i] * (1.0 + coef.tcs[i] * dt) - coef.offset[i] - coef.tco[i] * dt;
+        raw[i] = bmm350_sim_raw(value / (1.0 + coef.sens[i]), lsb[i]);
+    }
+}
+
+static float bmm350_sim_clip(float value, float range)
+{
+    return value > range ? range : (value < -range ? -range : value);
+}
+
+static void bmm350_sim_convert(bmm350_sim_t *sim, uint64_t time_us)
+{
+    uint8_t self_test = sim->regs[BMM350_REG_TMR_SELFTEST_USER];
+    float field[3];
+    float temperature;
+    double sensed[3];
+    int32_t raw[4];
+
+    sim->field(sim->field_context, time_us, field, &temperature);
+
+    float current = 0.0f;
+    if (self_test & SELF_TEST_ENABLE)
+    {
+        current = (self_test & SELF_TEST_POSITIVE) ? BMM350_SIM_SELF_TEST_UT :
+                  (self_test & SELF_TEST_NEGATIVE) ? -BMM350_SIM_SELF_TEST_UT : 0.0f;
+    }
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        float excursion = 0.0f;
+
+        if (fabsf(field[i]) > sim->range_ut)
+        {
+            sim->remanence[i] = copysignf(BMM350_SIM_REMANENCE_UT, field[i]);
+        }
+        if (((i == 0) && (self_test & SELF_TEST_X)) || ((i == 1) && (self_test & SELF_TEST_Y)))
+        {
+            excursion = current;
+        }
+
+        sensed[i] = bmm350_sim_clip(field[i] + excursion + sim->remanence[i], sim->range_ut);
+    }
+
+    bmm350_sim_uncompensate(&sim->trim, sensed, temperature, raw);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        uint8_t *reg = &sim->regs[BMM350_REG_MAG_X_XLSB + 3 * i];
+
+        reg[0] = (uint8_t)(raw[i]);
+        reg[1] = (uint8_t)(raw[i] >> 8);
+        reg[2] = (uint8_t)(raw[i] >> 16);
+    }
+
+    sim->stats.conversions++;
+
+    // Pulsed mode raises an edge per conversion, latched mode only while
+    // the status is clear.
+    uint8_t ctrl = sim->regs[BMM350_REG_INT_CTRL];
+    if ((ctrl & INT_CTRL_DRDY_EN) && (ctrl & INT_CTRL_OUTPUT_EN))
+    {
+        if (!(ctrl & INT_CTRL_LATCHED) || !sim->pin)
+        {
+            sim->pending = true;
+        }
+        sim->pin = (ctrl & INT_CTRL_LATCHED) != 0;
+    }
+    sim->regs[BMM350_REG_INT_STATUS] |= INT_STATUS_DRDY;
+}
+
+//*****************************************************************************
+//
+// Power management
+//
+//*****************************************************************************
+static uint64_t bmm350_sim_period_us(uint8_t odr)
+{
+    // 400Hz is the fastest rate with a code, each further code halves it.
+    if (odr < BMM350_ODR_400HZ)
+    {
+        odr = BMM350_ODR_400HZ;
+    }
+    if (odr > BMM350_ODR_1_5625HZ)
+    {
+        odr = BMM350_ODR_1_5625HZ;
+    }
+
+    return 2500ULL << (odr - BMM350_ODR_400HZ);
+}
+
+static uint8_t bmm350_sim_pmu_value(uint8_t command)
+{
+    switch (command)
+    {
+    case BMM350_PMU_CMD_NM_TC:
+        return BMM350_PMU_CMD_STATUS_0_NM;
+    case BMM350_PMU_CMD_BR_FAST:
+        return BMM350_PMU_CMD_STATUS_0_BR_FAST;
+    default:
+        return command;
+    }
+}
+
+// Settling time of command, started in the current mode.
+static uint32_t bmm350_sim_pmu_duration(const bmm350_sim_t *sim, uint8_t command)
+{
+    static const uint32_t forced[4] = {
+        BMM350_SUS_TO_FORCEDMODE_NO_AVG_DELAY, BMM350_SUS_TO_FORCEDMODE_AVG_2_DELAY,
+        BMM350_SUS_TO_FORCEDMODE_AVG_4_DELAY, BMM350_SUS_TO_FORCEDMODE_AVG_8_DELAY,
+    };
+    static const uint32_t forced_fast[4] = {
+        BMM350_SUS_TO_FORCEDMODE_FAST_NO_AVG_DELAY, BMM350_SUS_TO_FORCEDMODE_FAST_AVG_2_DELAY,
+        BMM350_SUS_TO_FORCEDMODE_FAST_AVG_4_DELAY, BMM350_SUS_TO_FORCEDMODE_FAST_AVG_8_DELAY,
+    };
+    uint8_t avg = (sim->regs[BMM350_REG_PMU_CMD_AGGR_SET] & BMM350_AVG_MSK) >> BMM350_AVG_POS;
+
+    switch (command)
+    {
+    case BMM350_PMU_CMD_SUS:
+        return sim->normal ? BMM350_GOTO_SUSPEND_DELAY : 0;
+    case BMM350_PMU_CMD_NM:
+    case BMM350_PMU_CMD_NM_TC:
+        return sim->normal ? 0 : BMM350_SUSPEND_TO_NORMAL_DELAY;
+    case BMM350_PMU_CMD_UPD_OAE:
+        return BMM350_UPD_OAE_DELAY;
+    case BMM350_PMU_CMD_FM:
+        return forced[avg];
+    case BMM350_PMU_CMD_FM_FAST:
+        return forced_fast[avg];
+    case BMM350_PMU_CMD_FGR:
+        return BMM350_FGR_DELAY;
+    case BMM350_PMU_CMD_FGR_FAST:
+        return BMM350_SIM_FGR_FAST_US;
+    case BMM350_PMU_CMD_BR:
+        return BMM350_BR_DELAY;
+    case BMM350_PMU_CMD_BR_FAST:
+        return BMM350_SIM_BR_FAST_US;
+    default:
+        return 0;
+    }
+}
+
+static void bmm350_sim_pmu_command(bmm350_sim_t *sim, uint8_t command)
+{
+    uint64_t now = am_hal_host_time_us();
+
+    sim->stats.pmu_commands++;
+
+    // Forced conversions and resets are only accepted in suspend.
+    bool suspend_only = (command >= BMM350_PMU_CMD_FM) && (command <= BMM350_PMU_CMD_BR_FAST);
+    bool normal = sim->normal || (sim->pmu_pending == BMM350_PMU_CMD_NM) ||
+                  (sim->pmu_pending == BMM350_PMU_CMD_NM_TC);
+    if ((command > BMM350_PMU_CMD_NM_TC) || (suspend_only && normal))
+    {
+        sim->illegal = true;
+        sim->stats.illegal_commands++;
+        return;
+    }
+
+    if (sim->pmu_pending != PMU_NONE)
+    {
+        sim->stats.busy_commands++;
+    }
+
+    sim->illegal = false;
+    sim->pmu_pending = command;
+    sim->busy_until_us = now + bmm350_sim_pmu_duration(sim, command);
+}
+
+static void bmm350_sim_pmu_complete(bmm350_sim_t *sim, uint64_t time_us)
+{
+    uint8_t command = sim->pmu_pending;
+
+    sim->pmu_pending = PMU_NONE;
+
+    switch (command)
+    {
+    case BMM350_PMU_CMD_SUS:
+        sim->normal = false;
+        break;
+
+    case BMM350_PMU_CMD_NM:
+    case BMM350_PMU_CMD_NM_TC:
+        if (!sim->normal)
+        {
+            sim->normal = true;
+            sim->next_conversion_us = time_us + bmm350_sim_period_us(sim->odr);
+        }
+        break;
+
+    case BMM350_PMU_CMD_UPD_OAE:
+        sim->odr = (sim->regs[BMM350_REG_PMU_CMD_AGGR_SET] & BMM350_ODR_MSK) >> BMM350_ODR_POS;
+        sim->avg = (sim->regs[BMM350_REG_PMU_CMD_AGGR_SET] & BMM350_AVG_MSK) >> BMM350_AVG_POS;
+        sim->next_conversion_us = time_us + bmm350_sim_period_us(sim->odr);
+        break;
+
+    case BMM350_PMU_CMD_FM:
+    case BMM350_PMU_CMD_FM_FAST:
+        bmm350_sim_convert(sim, time_us);
+        break;
+
+    case BMM350_PMU_CMD_FGR:
+    case BMM350_PMU_CMD_FGR_FAST:
+        memset(sim->remanence, 0, sizeof(sim->remanence));
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Runs the conversions and command completions due up to the virtual
+// clock, in time order, and latches the status and sensor time registers.
+static void bmm350_sim_catch_up(bmm350_sim_t *sim)
+{
+    uint64_t now = am_hal_host_time_us();
+
+    for (;;)
+    {
+        bool command = (sim->pmu_pending != PMU_NONE) && (sim->busy_until_us <= now);
+        bool conversion = sim->normal && (sim->next_conversion_us <= now);
+
+        if (command && (!conversion || (sim->busy_until_us <= sim->next_conversion_us)))
+        {
+            bmm350_sim_pmu_complete(sim, sim->busy_until_us);
+        }
+        else if (conversion)
+        {
+            bmm350_sim_convert(sim, sim->next_conversion_us);
+            sim->next_conversion_us += bmm350_sim_period_us(sim->odr);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (sim->otp_busy && (sim->otp_done_us <= now))
+    {
+        sim->otp_busy = false;
+        sim->regs[BMM350_REG_OTP_DATA_MSB_REG] = (uint8_t)(sim->otp_word >> 8);
+        sim->regs[BMM350_REG_OTP_DATA_LSB_REG] = (uint8_t)(sim->otp_word);
+        sim->regs[BMM350_REG_OTP_STATUS_REG] |= BMM350_OTP_STATUS_CMD_DONE;
+    }
+
+    uint8_t value = sim->pmu_pending != PMU_NONE ? bmm350_sim_pmu_value(sim->pmu_pending) :
+                                                   bmm350_sim_pmu_value(sim->regs[BMM350_REG_PMU_CMD]);
+    sim->regs[BMM350_REG_PMU_CMD_STATUS_0] =
+        (sim->pmu_pending != PMU_NONE ? BMM350_PMU_CMD_BUSY_MSK : 0) |
+        (sim->normal ? BMM350_PWR_MODE_IS_NORMAL_MSK : 0) |
+        (sim->illegal ? BMM350_CMD_IS_ILLEGAL_MSK : 0) |
+        ((value << BMM350_PMU_CMD_VALUE_POS) & BMM350_PMU_CMD_VALUE_MSK);
+    sim->regs[BMM350_REG_PMU_CMD_STATUS_1] =
+        (sim->odr << BMM350_PMU_ODR_S_POS) | (sim->avg << BMM350_PMU_AVG_S_POS);
+
+    uint32_t sensortime = (uint32_t)(US_TO_TICKS(now - sim->origin_us) & SENSORTIME_MASK);
+    sim->regs[BMM350_REG_SENSORTIME_XLSB] = (uint8_t)(sensortime);
+    sim->regs[BMM350_REG_SENSORTIME_LSB] = (uint8_t)(sensortime >> 8);
+    sim->regs[BMM350_REG_SENSORTIME_MSB] = (uint8_t)(sensortime >> 16);
+}
+
+//*****************************************************************************
+//
+// Registers
+//
+//*****************************************************************************
+static void bmm350_sim_reset(bmm350_sim_t *sim)
+{
+    memset(sim->regs, 0, sizeof(sim->regs));
+    sim->regs[BMM350_REG_CHIP_ID] = BMM350_CHIP_ID;
+    sim->regs[BMM350_REG_PMU_CMD_AGGR_SET] = (BMM350_AVG_2 << BMM350_AVG_POS) | BMM350_ODR_100HZ;
+    sim->regs[BMM350_REG_PMU_CMD_AXIS_EN] = BMM350_EN_XYZ_MSK;
+
+    sim->otp_powered = true;
+    sim->otp_busy = false;
+    sim->normal = false;
+    sim->odr = BMM350_ODR_100HZ;
+    sim->avg = BMM350_AVG_2;
+    sim->pmu_pending = PMU_NONE;
+    sim->illegal = false;
+    memset(sim->remanence, 0, sizeof(sim->remanence));
+    sim->origin_us = am_hal_host_time_us();
+    sim->pin = false;
+    sim->pending = false;
+}
+
+static uint8_t bmm350_sim_reg_read(bmm350_sim_t *sim, uint8_t reg)
+{
+    uint8_t value = sim->regs[reg];
+
+    if (reg == BMM350_REG_INT_STATUS)
+    {
+        sim->regs[reg] &= ~INT_STATUS_DRDY;
+        sim->pin = false;
+    }
+
+    return value;
+}
+
+static void bmm350_sim_reg_write(bmm350_sim_t *sim, uint8_t reg, uint8_t value)
+{
+    for (uint32_t i = 0; i < sizeof(bmm350_sim_read_only); i++)
+    {
+        if (reg == bmm350_sim_read_only[i])
+        {
+            sim->stats.rejected_writes++;
+            return;
+        }
+    }
+    if ((reg >= BMM350_REG_MAG_X_XLSB) && (reg <= BMM350_REG_SENSORTIME_MSB))
+    {
+        sim->stats.rejected_writes++;
+        return;
+    }
+
+    switch (reg)
+    {
+    case BMM350_REG_PMU_CMD:
+        sim->regs[reg] = value;
+        bmm350_sim_pmu_command(sim, value);
+        break;
+
+    case BMM350_REG_OTP_CMD_REG:
+        sim->regs[reg] = value;
+        bmm350_sim_otp_command(sim, value);
+        break;
+
+    case BMM350_REG_CMD:
+        if (value == BMM350_CMD_SOFTRESET)
+        {
+            bmm350_sim_reset(sim);
+        }
+        break;
+
+    default:
+        sim->regs[reg] = value;
+        break;
+    }
+}
+
+// Common to reads and writes.  bits is the length of the transfer on the
+// bus, which moves the clock on by its transfer time.
+static void bmm350_sim_access(bmm350_sim_t *sim, uint32_t bits)
+{
+    bmm350_sim_catch_up(sim);
+
+    if (sim->bus_hz)
+    {
+        sim->bus_ns += (uint64_t)bits * 1000000000 / sim->bus_hz;
+        am_hal_host_time_advance_us(sim->bus_ns / 1000);
+        sim->bus_ns %= 1000;
+    }
+}
+
+uint32_t bmm350_sim_read(bmm350_sim_t *sim, uint8_t reg, uint8_t *data, uint32_t len)
+{
+    sim->stats.reads++;
+
+    if ((reg & 0x80) || (len == 0))
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    // Address and register, repeated start and address, then the data,
+    // 9 bits a byte.
+    bmm350_sim_access(sim, (3 + len) * 9);
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (i < BMM350_DUMMY_BYTES)
+        {
+            data[i] = 0x00;
+            continue;
+        }
+
+        data[i] = bmm350_sim_reg_read(sim, reg);
+        reg = (reg + 1) & 0x7F;
+        sim->stats.bytes++;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t bmm350_sim_write(bmm350_sim_t *sim, uint8_t reg, const uint8_t *data, uint32_t len)
+{
+    sim->stats.writes++;
+
+    if ((reg & 0x80) || (len == 0))
+    {
+        return AM_HAL_STATUS_INVALID_ARG;
+    }
+
+    bmm350_sim_access(sim, (2 + len) * 9);
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        bmm350_sim_reg_write(sim, reg, data[i]);
+        reg = (reg + 1) & 0x7F;
+        sim->stats.bytes++;
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+//*****************************************************************************
+//
+// Bus bindings
+//
+//*****************************************************************************
+static uint32_t bmm350_sim_iom_peer(void *context, const am_hal_iom_transfer_t *transfer)
+{
+    bmm350_sim_t *sim = (bmm350_sim_t *)context;
+
+    if ((transfer->ui32InstrLen != 1) || (transfer->uPeerInfo.ui32I2CDevAddr != sim->address))
+    {
+        sim->stats.nacks++;
+        return AM_HAL_STATUS_FAIL;
+    }
+
+    if (transfer->eDirection == AM_HAL_IOM_RX)
+    {
+        return bmm350_sim_read(sim, (uint8_t)transfer->ui32Instr,
+                               (uint8_t *)transfer->pui32RxBuffer, transfer->ui32NumBytes);
+    }
+
+    return bmm350_sim_write(sim, (uint8_t)transfer->ui32Instr,
+                            (const uint8_t *)transfer->pui32TxBuffer, transfer->ui32NumBytes);
+}
+
+static BMM350_INTF_RET_TYPE bmm350_sim_dev_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    uint32_t status = bmm350_sim_read((bmm350_sim_t *)intf_ptr, reg_addr, reg_data, len);
+
+    return status == AM_HAL_STATUS_SUCCESS ? BMM350_INTF_RET_SUCCESS : BMM350_E_COM_FAIL;
+}
+
+static BMM350_INTF_RET_TYPE bmm350_sim_dev_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    uint32_t status = bmm350_sim_write((bmm350_sim_t *)intf_ptr, reg_addr, reg_data, len);
+
+    return status == AM_HAL_STATUS_SUCCESS ? BMM350_INTF_RET_SUCCESS : BMM350_E_COM_FAIL;
+}
+
+static void bmm350_sim_dev_delay_us(uint32_t period, void *intf_ptr)
+{
+    (void)intf_ptr;
+
+    am_util_delay_us(period);
+}
+
+void bmm350_sim_init(bmm350_sim_t *sim)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->address = BMM350_I2C_ADSEL_SET_LOW;
+    sim->bus_hz = BMM350_SIM_BUS_HZ;
+    sim->range_ut = BMM350_SIM_RANGE_UT;
+    sim->field = bmm350_sim_field_earth;
+    bmm350_sim_trim(sim, &bmm350_sim_default_trim);
+    bmm350_sim_reset(sim);
+}
+
+void bmm350_sim_field(bmm350_sim_t *sim, bmm350_sim_field_t field, void *context)
+{
+    sim->field = field ? field : bmm350_sim_field_earth;
+    sim->field_context = context;
+}
+
+void bmm350_sim_trim(bmm350_sim_t *sim, const bmm350_sim_trim_t *trim)
+{
+    sim->trim = *trim;
+    bmm350_sim_otp_encode(sim);
+}
+
+void bmm350_sim_attach(bmm350_sim_t *sim, uint32_t module)
+{
+    am_hal_host_iom_attach(module, bmm350_sim_iom_peer, sim);
+}
+
+// Binds the driver to the model without the IOM in between.  The sampling
+// path in mag.c passes intf_ptr to bmm350_hal.c, so bmm350_interface_init()
+// must be used again before it runs.
+void bmm350_sim_interface_init(bmm350_sim_t *sim, struct bmm350_dev *dev)
+{
+    dev->read = bmm350_sim_dev_read;
+    dev->write = bmm350_sim_dev_write;
+    dev->delay_us = bmm350_sim_dev_delay_us;
+    dev->intf_ptr = sim;
+}
+
+void bmm350_sim_update(bmm350_sim_t *sim)
+{
+    bmm350_sim_catch_up(sim);
+
+    if (sim->pending)
+    {
+        sim->pending = false;
+        sim->stats.interrupts++;
+        am_hal_host_gpio_fire(AM_BSP_GPIO_MAG_INT);
+    }
+}
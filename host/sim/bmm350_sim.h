@@ -0,0 +1,176 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _BMM350_SIM_H_
+#define _BMM350_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <bmm350.h>
+
+/*
+ * Register level model of the BMM350 for the host build.
+ *
+ * The model answers the I2C transfers issued by the Bosch driver, either
+ * as the IOM peer of bmm350_hal.c (bmm350_sim_attach()) or directly as the
+ * read, write and delay callbacks of a bmm350_dev
+ * (bmm350_sim_interface_init()).  It covers:
+ *
+ * - the chip id, soft reset and the two dummy bytes ahead of read data,
+ * - the OTP words read through OTP_CMD_REG, OTP_STATUS_REG and the OTP
+ *   data registers, encoded from the trim codes in bmm350_sim_trim_t, and
+ *   the OTP power off,
+ * - the PMU command state machine: suspend, normal, forced and fast
+ *   forced modes, UPD_OAE, bit and flux guide resets, each busy for its
+ *   settling time, with PMU_CMD_STATUS_0 and PMU_CMD_STATUS_1,
+ * - the data, temperature and 24 bit sensor time registers, and the data
+ *   ready interrupt on MAG_INT in pulsed and latched modes,
+ * - the user self-test currents of TMR_SELFTEST_USER.
+ *
+ * Raw data is the inverse of the driver compensation applied to the field
+ * and temperature returned by the field callback, so the compensated
+ * output reproduces the input.  Each axis clips at range_ut, where the
+ * self-test excursion disappears, and a field beyond it leaves a
+ * remanent offset until the next flux guide reset.  ODR and averaging
+ * combinations that the device would override are not checked, and the
+ * interrupt polarity and drive settings are ignored.
+ *
+ * Time is the virtual clock of the host HAL.  Each access also takes the
+ * time its bits would occupy the bus at bus_hz.  Conversions are produced
+ * lazily on every access, while interrupts are only delivered by
+ * bmm350_sim_update().
+ */
+#define BMM350_SIM_BUS_HZ           (400000)
+#define BMM350_SIM_RANGE_UT         (3000.0f)
+#define BMM350_SIM_REMANENCE_UT     (50.0f)
+
+// Field added along the selected axis by the user self-test current.
+#define BMM350_SIM_SELF_TEST_UT     (200.0f)
+
+// Time from an OTP read command to OTP_STATUS_REG reporting it done.
+#define BMM350_SIM_OTP_READ_US      (100)
+
+// The driver has no delays for the fast resets.  The model takes half
+// the time of the normal ones.
+#define BMM350_SIM_BR_FAST_US       (BMM350_BR_DELAY / 2)
+#define BMM350_SIM_FGR_FAST_US      (BMM350_FGR_DELAY / 2)
+
+/*
+ * Sensor input at time_us on the virtual clock.  field is in uT in the
+ * sensor frame and temperature in degC.
+ */
+typedef void (*bmm350_sim_field_t)(void *context, uint64_t time_us, float field[3], float *temperature);
+
+/*
+ * Trim codes as stored in OTP, in the units the driver decodes them with:
+ * offsets in uT (12 bit), sensitivities in 1/256, TCO in 1/32 uT/K, TCS in
+ * 1/16384 1/K, t_offs in 1/5 K, t_sens in 1/512, t0 in 1/512 K from 23degC
+ * and the cross axis terms in 1/800.
+ */
+typedef struct bmm350_sim_trim_s
+{
+    int16_t offset[3];
+    int8_t sens[3];
+    int8_t tco[3];
+    int8_t tcs[3];
+    int8_t t_offs;
+    int8_t t_sens;
+    int16_t t0;
+    int8_t cross_x_y;
+    int8_t cross_y_x;
+    int8_t cross_z_x;
+    int8_t cross_z_y;
+    uint8_t var_id;
+} bmm350_sim_trim_t;
+
+typedef struct bmm350_sim_stats_s
+{
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t bytes;             // register bytes, without address or dummy bytes
+    uint32_t nacks;             // transfers to another address
+    uint32_t otp_reads;
+    uint32_t pmu_commands;
+    uint32_t illegal_commands;  // PMU commands not allowed in the current mode
+    uint32_t busy_commands;     // PMU commands issued before the last one settled
+    uint32_t rejected_writes;   // writes to read only registers
+    uint32_t conversions;
+    uint32_t interrupts;        // edges delivered on MAG_INT
+} bmm350_sim_stats_t;
+
+typedef struct bmm350_sim_s
+{
+    uint8_t regs[128];
+    uint8_t address;
+
+    bmm350_sim_trim_t trim;
+    uint16_t otp[BMM350_OTP_DATA_LENGTH];
+    bool otp_powered;
+    bool otp_busy;
+    uint64_t otp_done_us;
+    uint16_t otp_word;
+
+    bool normal;                // normal mode, converting at the active ODR
+    uint8_t odr;                // active ODR and averaging, set by UPD_OAE
+    uint8_t avg;
+    uint8_t pmu_pending;        // command settling, 0xFF if none
+    uint64_t busy_until_us;
+    bool illegal;
+    uint64_t next_conversion_us;
+    float remanence[3];
+
+    uint64_t bus_hz;
+    uint64_t bus_ns;            // bus time not yet added to the clock
+    uint64_t origin_us;         // virtual time at sensor time 0
+
+    float range_ut;
+    bool pin;                   // latched MAG_INT level
+    bool pending;               // MAG_INT edge not yet delivered
+
+    bmm350_sim_field_t field;
+    void *field_context;
+
+    bmm350_sim_stats_t stats;
+} bmm350_sim_t;
+
+extern void bmm350_sim_init(bmm350_sim_t *sim);
+extern void bmm350_sim_field(bmm350_sim_t *sim, bmm350_sim_field_t field, void *context);
+extern void bmm350_sim_trim(bmm350_sim_t *sim, const bmm350_sim_trim_t *trim);
+extern void bmm350_sim_attach(bmm350_sim_t *sim, uint32_t module);
+extern void bmm350_sim_interface_init(bmm350_sim_t *sim, struct bmm350_dev *dev);
+extern void bmm350_sim_update(bmm350_sim_t *sim);
+
+// Transfers as seen on the bus.  A read returns the two dummy bytes first.
+extern uint32_t bmm350_sim_read(bmm350_sim_t *sim, uint8_t reg, uint8_t *data, uint32_t len);
+extern uint32_t bmm350_sim_write(bmm350_sim_t *sim, uint8_t reg, const uint8_t *data, uint32_t len);
+
+#endif
@@ -34,16 +34,23 @@
 
 #include "lfs.h"
 
+// The host build keeps the flash array in RAM.
+#ifdef HOST_BUILD
+#define LFS_HAL_FLASH(address) am_hal_host_flash_address(address)
+#else
+#define LFS_HAL_FLASH(address) ((void *)(address))
+#endif
+
 // Read a region in a block. Negative error codes are propogated
 // to the user.
 int littlefs_hal_read(const struct lfs_config *c, lfs_block_t block,
         lfs_off_t off, void *buffer, lfs_size_t size)
 {
-    uint32_t starting_block = (uint32_t)c->context;
+    uint32_t starting_block = (uint32_t)(uintptr_t)c->context;
     uint32_t page = starting_block + block;
     uint32_t address = (page << 13) + off;
 
-    memcpy(buffer, (void*)address, size);
+    memcpy(buffer, LFS_HAL_FLASH(address), size);
 
     return LFS_ERR_OK;
 }
@@ -54,16 +61,16 @@ int littlefs_hal_read(const struct lfs_config *c, lfs_block_t block,
 int littlefs_hal_prog(const struct lfs_config *c, lfs_block_t block,
         lfs_off_t off, const void *buffer, lfs_size_t size)
 {
-    uint32_t starting_block = (uint32_t)c->context;
+    uint32_t starting_block = (uint32_t)(uintptr_t)c->context;
     uint32_t page = starting_block + block;
 
     uint32_t address = (page << 13) + off;
 
     am_hal_interrupt_master_disable();
-    int err = am_hal_flash_program_main(AM_HAL_FLASH_PROGRAM_KEY, (uint32_t *)buffer, (uint32_t *)address, size >> 2);
+    int err = am_hal_flash_program_main(AM_HAL_FLASH_PROGRAM_KEY, (uint32_t *)buffer, (uint32_t *)LFS_HAL_FLASH(address), size >> 2);
     am_hal_interrupt_master_enable();
 
-    return LFS_ERR_OK;
+    return err ? LFS_ERR_IO : LFS_ERR_OK;
 }
 
 // Erase a block. A block must be erased before being programmed.
@@ -72,7 +79,7 @@ int littlefs_hal_prog(const struct lfs_config *c, lfs_block_t block,
 // May return LFS_ERR_CORRUPT if the block should be considered bad.
 int littlefs_hal_erase(const struct lfs_config *c, lfs_block_t block)
 {
-    uint32_t starting_block = (uint32_t)c->context;
+    uint32_t starting_block = (uint32_t)(uintptr_t)c->context;
     uint32_t page = starting_block + block;
     uint32_t address = (page << 13);
 
@@ -84,7 +91,7 @@ int littlefs_hal_erase(const struct lfs_config *c, lfs_block_t block)
             instance, rel_page);
     am_hal_interrupt_master_enable();
 
-    return LFS_ERR_OK;
+    return err ? LFS_ERR_IO : LFS_ERR_OK;
 }
 
 // Sync the state of the underlying block device. Negative error codes
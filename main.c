@@ -156,6 +156,8 @@ void system_setup(void)
 
     NVIC_SetPriority(GPIO_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
     NVIC_SetPriority(CTIMER_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
+    NVIC_SetPriority(IOMSTR0_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
+    NVIC_SetPriority(IOMSTR1_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
     NVIC_SetPriority(STIMER_CMPR2_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
     NVIC_SetPriority(STIMER_CMPR3_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
     NVIC_SetPriority(STIMER_CMPR4_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
@@ -179,7 +181,11 @@ void system_start(void)
 
     button_task_create(3);
     console_task_create(2, CONSOLE_OUTPUT_UART);
+
+    // The file system lock is shared by the application and capture tasks.
+    application_lfs_setup();
     application_task_create(1);
+    application_capture_task_create(1);
 
     //
     // Start the scheduler.
@@ -0,0 +1,192 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <arm_math.h>
+
+#include "ahrs.h"
+
+void ahrs_init(ahrs_t *ahrs, float32_t beta)
+{
+    ahrs->q0 = 1.0f;
+    ahrs->q1 = 0.0f;
+    ahrs->q2 = 0.0f;
+    ahrs->q3 = 0.0f;
+    ahrs->beta = beta;
+    ahrs->initialised = false;
+}
+
+static inline float32_t ahrs_inv_norm(float32_t squared)
+{
+    float32_t norm;
+
+    arm_sqrt_f32(squared, &norm);
+    return 1.0f / norm;
+}
+
+void ahrs_update(ahrs_t *ahrs, const float32_t gyr[3], const float32_t acc[3], const float32_t mag[3], uint64_t timestamp_us)
+{
+    float32_t q0 = ahrs->q0;
+    float32_t q1 = ahrs->q1;
+    float32_t q2 = ahrs->q2;
+    float32_t q3 = ahrs->q3;
+
+    if (!ahrs->initialised)
+    {
+        // Only the time reference is known from the first sample.
+        ahrs->start = timestamp_us;
+        ahrs->timestamp = timestamp_us;
+        ahrs->initialised = true;
+        return;
+    }
+
+    uint64_t elapsed = timestamp_us - ahrs->timestamp;
+    float32_t dt = (float32_t)(elapsed > AHRS_MAX_DT_US ? AHRS_MAX_DT_US : elapsed) * 1e-6f;
+    ahrs->timestamp = timestamp_us;
+
+    float32_t beta = (timestamp_us - ahrs->start < AHRS_STARTUP_US) ? AHRS_BETA_STARTUP : ahrs->beta;
+
+    // Rate of change from the gyroscope, 0.5 * q x (0, gyr).
+    float32_t dq0 = 0.5f * (-q1 * gyr[0] - q2 * gyr[1] - q3 * gyr[2]);
+    float32_t dq1 = 0.5f * ( q0 * gyr[0] + q2 * gyr[2] - q3 * gyr[1]);
+    float32_t dq2 = 0.5f * ( q0 * gyr[1] - q1 * gyr[2] + q3 * gyr[0]);
+    float32_t dq3 = 0.5f * ( q0 * gyr[2] + q1 * gyr[1] - q2 * gyr[0]);
+
+    float32_t acc_squared = acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2];
+    if (acc_squared > 0.0f)
+    {
+        float32_t inv = ahrs_inv_norm(acc_squared);
+        float32_t ax = acc[0] * inv;
+        float32_t ay = acc[1] * inv;
+        float32_t az = acc[2] * inv;
+
+        // Products shared by the objective function and its Jacobian.
+        float32_t _2q0 = 2.0f * q0;
+        float32_t _2q1 = 2.0f * q1;
+        float32_t _2q2 = 2.0f * q2;
+        float32_t _2q3 = 2.0f * q3;
+        float32_t q0q2 = q0 * q2;
+        float32_t q1q3 = q1 * q3;
+        float32_t q0q1 = q0 * q1;
+        float32_t q2q3 = q2 * q3;
+        float32_t q1q1 = q1 * q1;
+        float32_t q2q2 = q2 * q2;
+
+        // Gravity predicted in the sensor frame minus the measurement.
+        float32_t f1 = 2.0f * (q1q3 - q0q2) - ax;
+        float32_t f2 = 2.0f * (q0q1 + q2q3) - ay;
+        float32_t f3 = 1.0f - 2.0f * (q1q1 + q2q2) - az;
+
+        float32_t s0 = -_2q2 * f1 + _2q1 * f2;
+        float32_t s1 =  _2q3 * f1 + _2q0 * f2 - 2.0f * _2q1 * f3;
+        float32_t s2 = -_2q0 * f1 + _2q3 * f2 - 2.0f * _2q2 * f3;
+        float32_t s3 =  _2q1 * f1 + _2q2 * f2;
+
+        float32_t mag_squared = mag[0] * mag[0] + mag[1] * mag[1] + mag[2] * mag[2];
+        if (mag_squared > 0.0f)
+        {
+            inv = ahrs_inv_norm(mag_squared);
+            float32_t mx = mag[0] * inv;
+            float32_t my = mag[1] * inv;
+            float32_t mz = mag[2] * inv;
+
+            float32_t q0q3 = q0 * q3;
+            float32_t q1q2 = q1 * q2;
+            float32_t q3q3 = q3 * q3;
+
+            // Field in the earth frame.  Its horizontal part defines north.
+            float32_t hx = mx * (1.0f - 2.0f * (q2q2 + q3q3)) + 2.0f * (my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+            float32_t hy = my * (1.0f - 2.0f * (q1q1 + q3q3)) + 2.0f * (mx * (q1q2 + q0q3) + mz * (q2q3 - q0q1));
+            float32_t hz = mz * (1.0f - 2.0f * (q1q1 + q2q2)) + 2.0f * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1));
+            float32_t bx;
+            arm_sqrt_f32(hx * hx + hy * hy, &bx);
+            float32_t _2bx = 2.0f * bx;
+            float32_t _2bz = 2.0f * hz;
+
+            // Reference field (bx, 0, bz) predicted in the sensor frame
+            // minus the measurement.
+            float32_t f4 = _2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+            float32_t f5 = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+            float32_t f6 = _2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz;
+
+            s0 += -_2bz * q2 * f4 + (-_2bx * q3 + _2bz * q1) * f5 + _2bx * q2 * f6;
+            s1 +=  _2bz * q3 * f4 + ( _2bx * q2 + _2bz * q0) * f5 + (_2bx * q3 - 2.0f * _2bz * q1) * f6;
+            s2 += (-2.0f * _2bx * q2 - _2bz * q0) * f4 + (_2bx * q1 + _2bz * q3) * f5 + (_2bx * q0 - 2.0f * _2bz * q2) * f6;
+            s3 += (-2.0f * _2bx * q3 + _2bz * q1) * f4 + (-_2bx * q0 + _2bz * q2) * f5 + _2bx * q1 * f6;
+        }
+
+        float32_t s_squared = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (s_squared > 0.0f)
+        {
+            inv = beta * ahrs_inv_norm(s_squared);
+            dq0 -= s0 * inv;
+            dq1 -= s1 * inv;
+            dq2 -= s2 * inv;
+            dq3 -= s3 * inv;
+        }
+    }
+
+    q0 += dq0 * dt;
+    q1 += dq1 * dt;
+    q2 += dq2 * dt;
+    q3 += dq3 * dt;
+
+    float32_t inv = ahrs_inv_norm(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    ahrs->q0 = q0 * inv;
+    ahrs->q1 = q1 * inv;
+    ahrs->q2 = q2 * inv;
+    ahrs->q3 = q3 * inv;
+}
+
+void ahrs_euler(const ahrs_t *ahrs, ahrs_euler_t *euler)
+{
+    float32_t q0 = ahrs->q0;
+    float32_t q1 = ahrs->q1;
+    float32_t q2 = ahrs->q2;
+    float32_t q3 = ahrs->q3;
+
+    float32_t sin_pitch = 2.0f * (q0 * q2 - q1 * q3);
+    if (sin_pitch > 1.0f)
+    {
+        sin_pitch = 1.0f;
+    }
+    else if (sin_pitch < -1.0f)
+    {
+        sin_pitch = -1.0f;
+    }
+
+    euler->roll = atan2f(2.0f * (q0 * q1 + q2 * q3), 1.0f - 2.0f * (q1 * q1 + q2 * q2));
+    euler->pitch = asinf(sin_pitch);
+    euler->yaw = atan2f(2.0f * (q0 * q3 + q1 * q2), 1.0f - 2.0f * (q2 * q2 + q3 * q3));
+}
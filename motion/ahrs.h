@@ -0,0 +1,88 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _AHRS_H_
+#define _AHRS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <arm_math.h>
+
+// Gradient descent gain.  Larger values follow the accelerometer and
+// magnetometer more closely at the cost of more noise.
+#define AHRS_BETA               (0.1f)
+
+// A higher gain is used for the first AHRS_STARTUP_US so that the
+// estimate converges from the identity quickly.
+#define AHRS_BETA_STARTUP       (2.5f)
+#define AHRS_STARTUP_US         (2000000)
+
+// Steps longer than this, e.g. across a pause in sampling, are clamped.
+#define AHRS_MAX_DT_US          (100000)
+
+// Estimated worst case cost of ahrs_update() on the Apollo3 at 48MHz, from
+// the operation count (about 250 multiply-adds, five square roots and four
+// divides on the FPU).  It has not been measured on a board; the "ahrs"
+// profile probe checks it at run time.
+#define AHRS_CYCLE_BUDGET       (1500)
+
+/*
+ * Madgwick gradient descent orientation filter.
+ *
+ * q rotates the sensor frame into the earth frame: x towards magnetic
+ * north, y west and z up.  All vectors are in the IMU sensor frame, so the
+ * magnetometer has to be re-mapped onto the IMU axes by the caller.  The
+ * accelerometer and magnetometer only give directions and may be in any
+ * unit.  A zero magnetometer vector falls back to the 6 axis update.
+ */
+typedef struct ahrs_s
+{
+    float32_t q0, q1, q2, q3;
+    float32_t beta;
+    uint64_t start;
+    uint64_t timestamp;
+    bool initialised;
+} ahrs_t;
+
+// Z-Y-X Euler angles in radians.
+typedef struct ahrs_euler_s
+{
+    float32_t roll;
+    float32_t pitch;
+    float32_t yaw;
+} ahrs_euler_t;
+
+extern void ahrs_init(ahrs_t *ahrs, float32_t beta);
+extern void ahrs_update(ahrs_t *ahrs, const float32_t gyr[3], const float32_t acc[3], const float32_t mag[3], uint64_t timestamp_us);
+extern void ahrs_euler(const ahrs_t *ahrs, ahrs_euler_t *euler);
+
+#endif
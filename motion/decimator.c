@@ -0,0 +1,251 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <arm_math.h>
+
+#include "imu.h"
+#include "decimator.h"
+
+// Symmetric, so the time reversed order expected by CMSIS-DSP is the same.
+static const float32_t decimator_coeffs[DECIMATOR_FIR_TAPS] = {
+    -1.21432619e-03f, 0.0f, 3.80701109e-03f, 0.0f,
+    -8.48163389e-03f, 0.0f, 1.62470460e-02f, 0.0f,
+    -2.89044657e-02f, 0.0f, 5.08246773e-02f, 0.0f,
+    -9.79871793e-02f, 0.0f, 3.15624216e-01f, 5.00169310e-01f,
+    3.15624216e-01f, 0.0f, -9.79871793e-02f, 0.0f,
+    5.08246773e-02f, 0.0f, -2.89044657e-02f, 0.0f,
+    1.62470460e-02f, 0.0f, -8.48163389e-03f, 0.0f,
+    3.80701109e-03f, 0.0f, -1.21432619e-03f
+};
+
+static inline int16_t decimator_to_lsb(float32_t value, float32_t lsb)
+{
+    float32_t x = value / lsb;
+
+    if (x >= 32767.0f)
+    {
+        return 32767;
+    }
+    if (x <= -32768.0f)
+    {
+        return -32768;
+    }
+    return (int16_t)(x >= 0.0f ? x + 0.5f : x - 0.5f);
+}
+
+void decimator_init(decimator_t *decimator)
+{
+    for (uint32_t s = 0; s < DECIMATOR_STAGES; s++)
+    {
+        decimator_stage_t *stage = &decimator->stage[s];
+
+        for (uint32_t c = 0; c < DECIMATOR_CHANNELS; c++)
+        {
+            arm_fir_decimate_init_f32(&stage->fir[c], DECIMATOR_FIR_TAPS, 2,
+                decimator_coeffs, stage->state[c], DECIMATOR_BLOCK_FRAMES);
+        }
+    }
+    decimator_reset(decimator);
+}
+
+void decimator_reset(decimator_t *decimator)
+{
+    for (uint32_t s = 0; s < DECIMATOR_STAGES; s++)
+    {
+        decimator_stage_t *stage = &decimator->stage[s];
+
+        memset(stage->state, 0, sizeof(stage->state));
+        stage->input_count = 0;
+        stage->output_count = 0;
+    }
+    decimator->period_us = 0;
+    decimator->timestamp = 0;
+    decimator->input = NULL;
+    decimator->input_count = 0;
+}
+
+// Filters the pending input of a stage and carries an odd sample over.
+static void decimator_stage_run(decimator_stage_t *stage)
+{
+    uint32_t n = stage->input_count & ~1UL;
+
+    stage->output_count = n / 2;
+    if (n == 0)
+    {
+        return;
+    }
+
+    for (uint32_t c = 0; c < DECIMATOR_CHANNELS; c++)
+    {
+        arm_fir_decimate_f32(&stage->fir[c], stage->input[c], stage->output[c], n);
+    }
+
+    // Each output lines up with the second input of its pair, delayed by
+    // the group delay of the filter.
+    for (uint32_t k = 0; k < n / 2; k++)
+    {
+        uint64_t t = stage->timestamp[2 * k + 1];
+        uint64_t period = t - stage->timestamp[2 * k];
+
+        stage->frames[k].timestamp = t - DECIMATOR_STAGE_DELAY * period;
+    }
+
+    if (stage->input_count > n)
+    {
+        for (uint32_t c = 0; c < DECIMATOR_CHANNELS; c++)
+        {
+            stage->input[c][0] = stage->input[c][n];
+        }
+        stage->timestamp[0] = stage->timestamp[n];
+    }
+    stage->input_count -= n;
+}
+
+void decimator_push(decimator_t *decimator, const imu_context_t *frames, uint32_t count)
+{
+    decimator_stage_t *first = &decimator->stage[0];
+
+    if (count > DECIMATOR_BLOCK_FRAMES)
+    {
+        count = DECIMATOR_BLOCK_FRAMES;
+    }
+
+    decimator->input = frames;
+    decimator->input_count = count;
+    if (count == 0)
+    {
+        for (uint32_t s = 0; s < DECIMATOR_STAGES; s++)
+        {
+            decimator->stage[s].output_count = 0;
+        }
+        return;
+    }
+    if (count > 1)
+    {
+        decimator->period_us = (uint32_t)((frames[count - 1].timestamp - frames[0].timestamp) / (count - 1));
+    }
+    else if ((decimator->timestamp != 0) && (frames[0].timestamp > decimator->timestamp))
+    {
+        // Timer acquisition pushes one frame at a time.
+        decimator->period_us = (uint32_t)(frames[0].timestamp - decimator->timestamp);
+    }
+    decimator->timestamp = frames[count - 1].timestamp;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t j = first->input_count++;
+
+        first->input[0][j] = imu_lsb_to_mps2(&frames[i], frames[i].ax);
+        first->input[1][j] = imu_lsb_to_mps2(&frames[i], frames[i].ay);
+        first->input[2][j] = imu_lsb_to_mps2(&frames[i], frames[i].az);
+        first->input[3][j] = imu_lsb_to_rps(&frames[i], frames[i].gx);
+        first->input[4][j] = imu_lsb_to_rps(&frames[i], frames[i].gy);
+        first->input[5][j] = imu_lsb_to_rps(&frames[i], frames[i].gz);
+        first->timestamp[j] = frames[i].timestamp;
+    }
+
+    // The output of each stage is the input of the next one.
+    const imu_context_t *reference = &frames[count - 1];
+    float32_t acc_lsb = imu_lsb_to_mps2(reference, 1);
+    float32_t gyr_lsb = imu_lsb_to_rps(reference, 1);
+
+    for (uint32_t s = 0; s < DECIMATOR_STAGES; s++)
+    {
+        decimator_stage_t *stage = &decimator->stage[s];
+
+        decimator_stage_run(stage);
+
+        for (uint32_t k = 0; k < stage->output_count; k++)
+        {
+            imu_context_t *frame = &stage->frames[k];
+
+            frame->sensortime = 0;
+            frame->dropped = 0;
+            frame->status = reference->status;
+            frame->acc_range = reference->acc_range;
+            frame->gyr_range = reference->gyr_range;
+            frame->ax = decimator_to_lsb(stage->output[0][k], acc_lsb);
+            frame->ay = decimator_to_lsb(stage->output[1][k], acc_lsb);
+            frame->az = decimator_to_lsb(stage->output[2][k], acc_lsb);
+            frame->gx = decimator_to_lsb(stage->output[3][k], gyr_lsb);
+            frame->gy = decimator_to_lsb(stage->output[4][k], gyr_lsb);
+            frame->gz = decimator_to_lsb(stage->output[5][k], gyr_lsb);
+        }
+
+        if (s + 1 < DECIMATOR_STAGES)
+        {
+            decimator_stage_t *next = &decimator->stage[s + 1];
+
+            for (uint32_t k = 0; k < stage->output_count; k++)
+            {
+                uint32_t j = next->input_count++;
+
+                for (uint32_t c = 0; c < DECIMATOR_CHANNELS; c++)
+                {
+                    next->input[c][j] = stage->output[c][k];
+                }
+                next->timestamp[j] = stage->frames[k].timestamp;
+            }
+        }
+    }
+}
+
+// Returns the frames of the last push at the lowest rate that is still at
+// least rate_hz.  A rate of 0 returns the input frames.
+uint32_t decimator_output(const decimator_t *decimator, uint32_t rate_hz, const imu_context_t **frames)
+{
+    uint32_t s = 0;
+
+    if ((rate_hz > 0) && (decimator->period_us > 0))
+    {
+        // Allow for the timestamp jitter in the measured input period.
+        uint32_t period_us = 1000000 / rate_hz;
+        period_us += period_us / 8;
+
+        while ((s < DECIMATOR_STAGES) && ((decimator->period_us << (s + 1)) <= period_us))
+        {
+            s++;
+        }
+    }
+
+    if (s == 0)
+    {
+        *frames = decimator->input;
+        return decimator->input_count;
+    }
+
+    *frames = decimator->stage[s - 1].frames;
+    return decimator->stage[s - 1].output_count;
+}
@@ -0,0 +1,99 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _DECIMATOR_H_
+#define _DECIMATOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <arm_math.h>
+
+#include "imu.h"
+
+#define DECIMATOR_CHANNELS      (6)
+
+// Number of decimate by 2 stages.  Four stages take the 1600Hz burst ODR
+// down to 100Hz.
+#define DECIMATOR_STAGES        (4)
+
+// Half band low pass, designed with a Kaiser window (beta 4.5).  The pass
+// band ripple is below 0.05dB up to 0.2 of the input rate and the stop band
+// is below -50dB from 0.3 of the input rate.
+#define DECIMATOR_FIR_TAPS      (31)
+
+// Group delay of one stage in input samples.
+#define DECIMATOR_STAGE_DELAY   ((DECIMATOR_FIR_TAPS - 1) / 2)
+
+// Largest number of frames accepted by one decimator_push().
+#define DECIMATOR_BLOCK_FRAMES  (IMU_FIFO_MAX_FRAMES)
+
+typedef struct decimator_stage_s
+{
+    arm_fir_decimate_instance_f32 fir[DECIMATOR_CHANNELS];
+    float32_t state[DECIMATOR_CHANNELS][DECIMATOR_FIR_TAPS + DECIMATOR_BLOCK_FRAMES - 1];
+
+    // Input waiting to be filtered.  An odd sample is carried over to the
+    // next block.
+    float32_t input[DECIMATOR_CHANNELS][DECIMATOR_BLOCK_FRAMES + 1];
+    uint64_t timestamp[DECIMATOR_BLOCK_FRAMES + 1];
+    uint32_t input_count;
+
+    float32_t output[DECIMATOR_CHANNELS][DECIMATOR_BLOCK_FRAMES / 2];
+    imu_context_t frames[DECIMATOR_BLOCK_FRAMES / 2];
+    uint32_t output_count;
+} decimator_stage_t;
+
+/*
+ * Anti-aliasing decimator for full rate frames, pushed a FIFO batch or a
+ * single timer sample at a time.  A cascade of decimate by 2 FIR stages
+ * produces streams at 1/2, 1/4 ... of the input rate, which are shared by
+ * every consumer that asks for the same rate.
+ * The frames are filtered in physical units so that range changes do not
+ * disturb the filters, and the output frames are converted back at the
+ * ranges of the newest input frame.  Output timestamps are corrected for
+ * the filter delay.  The sensortime of output frames is not set.
+ */
+typedef struct decimator_s
+{
+    decimator_stage_t stage[DECIMATOR_STAGES];
+    uint32_t period_us;     // input sample period, from the timestamps
+    uint64_t timestamp;     // newest input timestamp
+    const imu_context_t *input;
+    uint32_t input_count;
+} decimator_t;
+
+extern void decimator_init(decimator_t *decimator);
+extern void decimator_reset(decimator_t *decimator);
+extern void decimator_push(decimator_t *decimator, const imu_context_t *frames, uint32_t count);
+extern uint32_t decimator_output(const decimator_t *decimator, uint32_t rate_hz, const imu_context_t **frames);
+
+#endif
@@ -34,6 +34,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <math.h>
+#include <stdlib.h>
 
 #include <am_bsp.h>
 #include <am_mcu_apollo.h>
@@ -42,9 +43,11 @@
 #include <FreeRTOS.h>
 #include <task.h>
 
-#include <am_bsp.h>
+#include "sensors_config.h"
 
 #include "imu.h"
+#include "sensor_bus.h"
+#include "sensor_time.h"
 
 #define GRAVITY_EARTH (9.80665f)
 
@@ -63,36 +66,155 @@
 #define GYRO_RANGE_BMI2 BMI2_GYR_RANGE_RESOLVE(GYRO_RANGE)
 
 static float imu_half_scale;
-static float k_acc, kd_gyr, kr_gyr, k_mag;
 
-static struct bmi2_dev bmi270_handle;
+// Conversion factors indexed by the BMI2_ACC_RANGE_* and BMI2_GYR_RANGE_*
+// values.  Each sample is converted with the factor of the range it was
+// measured at.
+static float imu_acc_scale[BMI2_ACC_RANGE_16G + 1];
+static float imu_gyr_scale_dps[BMI2_GYR_RANGE_125 + 1];
+static float imu_gyr_scale_rps[BMI2_GYR_RANGE_125 + 1];
+
+/*
+ * A range change applies to samples produced after the new range was
+ * written.  The BMI270 produces samples on sensor time boundaries of the
+ * ODR period, so the sensor time read back right after the write tells
+ * whether a sample still carries the previous range.
+ */
+typedef struct imu_range_state_s
+{
+    uint8_t range;
+    uint8_t previous;
+    bool pending;
+    uint32_t switch_time;
+    uint64_t quiet_since_us;
+} imu_range_state_t;
+
+#define IMU_REG_ACC_RANGE       UINT8_C(0x41)
+
+#define IMU_AUTORANGE_MIN       BMI2_ACC_RANGE_RESOLVE(SENSORS_ACC_AUTORANGE_MIN_G)
+#define IMU_AUTORANGE_UP_LSB    (32768 * SENSORS_ACC_AUTORANGE_UP_PCT / 100)
+#define IMU_AUTORANGE_DOWN_LSB  (32768 * SENSORS_ACC_AUTORANGE_DOWN_PCT / 100 / 2)
+
+static imu_range_state_t imu_acc_range = { .range = ACCEL_RANGE_BMI2 };
+static uint8_t imu_gyr_range = GYRO_RANGE_BMI2;
+
+// STATUS, accel, gyro and sensor time occupy one block of registers so a
+// sample, its data ready flags and its timestamp are read in a single
+// burst.  The auxiliary data registers between STATUS and accel are read
+// and discarded as skipping them would take a second transaction.  The
+// offsets are relative to STATUS.
+#define IMU_REG_SENSORTIME      UINT8_C(0x18)
+#define IMU_BURST_STATUS        (0)
+#define IMU_BURST_ACC           (BMI2_ACC_X_LSB_ADDR - BMI2_STATUS_ADDR)
+#define IMU_BURST_GYR           (BMI2_GYR_X_LSB_ADDR - BMI2_STATUS_ADDR)
+#define IMU_BURST_SENSORTIME    (IMU_REG_SENSORTIME - BMI2_STATUS_ADDR)
+#define IMU_SAMPLE_BURST_LENGTH (IMU_BURST_SENSORTIME + 3)
+
+static sensor_time_t imu_time;
+static uint32_t imu_period_us = IMU_FIFO_FRAME_PERIOD_US;
+
+/*
+ * An ODR change leaves the frames produced at the previous rate in the
+ * FIFO.  The sensor time read back right after the change marks the
+ * boundary so that the next FIFO read spaces them at the previous period.
+ */
+typedef struct imu_rate_state_s
+{
+    bool pending;
+    uint32_t switch_time;
+    uint32_t previous_period_us;
+} imu_rate_state_t;
+
+static imu_rate_state_t imu_rate;
+
+// Receives the SPI dummy byte followed by the sample burst.
+static uint8_t imu_sample_buffer[IMU_SAMPLE_BURST_LENGTH + 1] __attribute__((aligned(4)));
+
+// Headerless FIFO frames carry accel and gyro only.
+#define IMU_FIFO_BUFFER_SIZE (IMU_FIFO_MAX_FRAMES * BMI2_FIFO_ACC_GYR_LENGTH)
+
+static uint8_t imu_fifo_buffer[IMU_FIFO_BUFFER_SIZE];
+static struct bmi2_sens_axes_data imu_fifo_accel[IMU_FIFO_MAX_FRAMES];
+static struct bmi2_sens_axes_data imu_fifo_gyro[IMU_FIFO_MAX_FRAMES];
 
 static int8_t imu_feature_config_accel(struct bmi2_dev *dev);
+static BMI2_INTF_RETURN_TYPE imu_bus_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr);
+static BMI2_INTF_RETURN_TYPE imu_bus_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr);
 static int8_t imu_feature_config_gyro(struct bmi2_dev *dev);
 static int8_t imu_feature_config_no_motion(struct bmi2_dev *dev);
+static int8_t imu_feature_config_any_motion(struct bmi2_dev *dev);
 static int8_t imu_interrupt_config(struct bmi2_dev *dev);
+static int8_t imu_interrupt_config_int2(struct bmi2_dev *dev);
 
 /*!
  * @brief This function converts lsb to meter per second squared for 16 bit accelerometer at
- * range 2G, 4G, 8G or 16G.
+ * the range the sample was measured at.
  */
-float imu_lsb_to_mps2(int16_t val)
+float imu_lsb_to_mps2(const imu_context_t *context, int16_t val)
 {
-    return k_acc * val;
+    return imu_acc_scale[context->acc_range] * val;
 }
 
 /*!
  * @brief This function converts lsb to degree per second for 16 bit gyro at
- * range 125, 250, 500, 1000 or 2000dps.
+ * the range the sample was measured at.
+ */
+float imu_lsb_to_dps(const imu_context_t *context, int16_t val)
+{
+    return imu_gyr_scale_dps[context->gyr_range] * val;
+}
+
+float imu_lsb_to_rps(const imu_context_t *context, int16_t val)
+{
+    return imu_gyr_scale_rps[context->gyr_range] * val;
+}
+
+/*
+ * Bus hooks used on the sampling paths.  The transfer runs on the IOM DMA
+ * and the calling task sleeps until the completion interrupt.
  */
-float imu_lsb_to_dps(int16_t val)
+static BMI2_INTF_RETURN_TYPE imu_bus_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    uint32_t status;
+
+    sensor_bus_begin(SENSOR_BUS_IMU);
+    status = bmi2_spi_read_async(reg_addr, reg_data, len, intf_ptr,
+                                 sensor_bus_complete, sensor_bus_context(SENSOR_BUS_IMU));
+    if (status == AM_HAL_STATUS_SUCCESS)
+    {
+        status = sensor_bus_wait(SENSOR_BUS_IMU);
+    }
+
+    return status == AM_HAL_STATUS_SUCCESS ? BMI2_INTF_RET_SUCCESS : BMI2_E_COM_FAIL;
+}
+
+static BMI2_INTF_RETURN_TYPE imu_bus_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    uint32_t status;
+
+    sensor_bus_begin(SENSOR_BUS_IMU);
+    status = bmi2_spi_write_async(reg_addr, reg_data, len, intf_ptr,
+                                  sensor_bus_complete, sensor_bus_context(SENSOR_BUS_IMU));
+    if (status == AM_HAL_STATUS_SUCCESS)
+    {
+        status = sensor_bus_wait(SENSOR_BUS_IMU);
+    }
+
+    return status == AM_HAL_STATUS_SUCCESS ? BMI2_INTF_RET_SUCCESS : BMI2_E_COM_FAIL;
+}
+
+static void imu_bus_open(void *arg)
 {
-    return kd_gyr * val;
+    struct bmi2_dev *bmi = (struct bmi2_dev *)arg;
+
+    bmi2_interface_init(bmi, BMI2_SPI_INTF);
+    bmi->read = imu_bus_read;
+    bmi->write = imu_bus_write;
 }
 
-float imu_lsb_to_rps(int16_t val)
+static void imu_bus_close(void *arg)
 {
-    return kr_gyr * val;
+    bmi2_interface_deinit((struct bmi2_dev *)arg);
 }
 
 static int8_t imu_feature_config_accel(struct bmi2_dev *dev)
@@ -154,6 +276,25 @@ static int8_t imu_feature_config_no_motion(struct bmi2_dev *dev)
     return status;
 }
 
+static int8_t imu_feature_config_any_motion(struct bmi2_dev *dev)
+{
+    int8_t status = BMI2_OK;
+    struct bmi2_sens_config config;
+
+    config.type = BMI2_ANY_MOTION;
+    status = bmi270_get_sensor_config(&config, 1, dev);
+    if (status == BMI2_OK)
+    {
+        /* 1LSB equals 20ms. Default is 100ms. Set to 40ms. */
+        config.cfg.any_motion.duration = 2;
+        /* 1LSB equals to 0.48mg. Default is 83mg. Set to 33.6mg. */
+        config.cfg.any_motion.threshold = 70;
+        status = bmi270_set_sensor_config(&config, 1, dev);
+    }
+
+    return status;
+}
+
 static int8_t imu_interrupt_config(struct bmi2_dev *dev)
 {
     int8_t status = BMI2_OK;
@@ -179,6 +320,51 @@ static int8_t imu_interrupt_config(struct bmi2_dev *dev)
     return status;
 }
 
+static int8_t imu_interrupt_config_int2(struct bmi2_dev *dev)
+{
+    int8_t status = BMI2_OK;
+
+    struct bmi2_int_pin_config int_cfg;
+    status = bmi2_get_int_pin_config(&int_cfg, dev);
+    if (status == BMI2_OK)
+    {
+        uint64_t mask_int2;
+        AM_HAL_GPIO_MASKBIT(mask_int2, AM_BSP_GPIO_IMU_INT2);
+        am_hal_gpio_pinconfig(AM_BSP_GPIO_IMU_INT2, g_AM_BSP_GPIO_IMU_INT2);
+        am_hal_gpio_interrupt_clear(mask_int2);
+        NVIC_EnableIRQ(GPIO_IRQn);
+
+        // The GPIO interrupt itself is only enabled while sampling is
+        // active.  See imu_int2_enable().
+        int_cfg.pin_type = BMI2_INT2;
+        int_cfg.pin_cfg[1].lvl = BMI2_INT_ACTIVE_LOW;
+        int_cfg.pin_cfg[1].od = BMI2_INT_PUSH_PULL;
+        int_cfg.pin_cfg[1].output_en = BMI2_INT_OUTPUT_ENABLE;
+        status = bmi2_set_int_pin_config(&int_cfg, dev);
+    }
+
+    return status;
+}
+
+/*
+ * Sets up the conversions of imu_lsb_to_mps2() and friends for samples of
+ * resolution bits.  Called by imu_setup(), and by the host replay which
+ * converts recorded samples without a BMI270.
+ */
+void imu_scale_setup(uint8_t resolution)
+{
+    imu_half_scale = ((float)(1 << (resolution - 1)));
+    for (uint8_t range = BMI2_ACC_RANGE_2G; range <= BMI2_ACC_RANGE_16G; range++)
+    {
+        imu_acc_scale[range] = (float)(GRAVITY_EARTH * (2 << range)) / imu_half_scale;
+    }
+    for (uint8_t range = BMI2_GYR_RANGE_2000; range <= BMI2_GYR_RANGE_125; range++)
+    {
+        imu_gyr_scale_dps[range] = (float)(2000 >> range) / imu_half_scale;
+        imu_gyr_scale_rps[range] = imu_gyr_scale_dps[range] * (float)M_PI / 180.0f;
+    }
+}
+
 imu_status_t imu_setup(struct bmi2_dev *bmi)
 {
     imu_status_t res = IMU_STATUS_OK;
@@ -203,8 +389,8 @@ imu_status_t imu_setup(struct bmi2_dev *bmi)
         goto error;
     }
 
-    uint8_t sensors[4] = {BMI2_ACCEL, BMI2_GYRO, BMI2_NO_MOTION, BMI2_SIG_MOTION};
-    status = bmi270_sensor_enable(sensors, 4, bmi);
+    uint8_t sensors[5] = {BMI2_ACCEL, BMI2_GYRO, BMI2_NO_MOTION, BMI2_ANY_MOTION, BMI2_SIG_MOTION};
+    status = bmi270_sensor_enable(sensors, 5, bmi);
     if (status != BMI2_OK)
     {
         bmi2_error_codes_print_result(status);
@@ -236,9 +422,22 @@ imu_status_t imu_setup(struct bmi2_dev *bmi)
         goto error;
     }
 
-    struct bmi2_sens_int_config sensor_int_no_motion = {.type = BMI2_NO_MOTION,
-                                                        .hw_int_pin = BMI2_INT1};
-    status = bmi270_map_feat_int(&sensor_int_no_motion, 1, bmi);
+    status = imu_feature_config_any_motion(bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        res = IMU_STATUS_ERROR;
+        goto error;
+    }
+
+    // All motion features share INT1.  The source is read back from the
+    // feature interrupt status with imu_int1_status().
+    struct bmi2_sens_int_config sensor_int_motion[3] = {
+        {.type = BMI2_NO_MOTION, .hw_int_pin = BMI2_INT1},
+        {.type = BMI2_ANY_MOTION, .hw_int_pin = BMI2_INT1},
+        {.type = BMI2_SIG_MOTION, .hw_int_pin = BMI2_INT1},
+    };
+    status = bmi270_map_feat_int(sensor_int_motion, 3, bmi);
     if (status != BMI2_OK)
     {
         bmi2_error_codes_print_result(status);
@@ -254,10 +453,11 @@ imu_status_t imu_setup(struct bmi2_dev *bmi)
         goto error;
     }
 
-    imu_half_scale = ((float)(1 << (bmi->resolution - 1)));
-    k_acc = (float)(GRAVITY_EARTH * ACCEL_RANGE) / imu_half_scale;
-    kd_gyr = (float)GYRO_RANGE / imu_half_scale;
-    kr_gyr = (float)GYRO_RANGE / imu_half_scale * (float)M_PI / 180.0f;
+    imu_scale_setup(bmi->resolution);
+    imu_acc_range.range = ACCEL_RANGE_BMI2;
+    imu_acc_range.pending = false;
+
+    sensor_bus_setup(SENSOR_BUS_IMU, imu_bus_open, imu_bus_close, bmi);
 
 error:
     bmi2_interface_deinit(bmi);
@@ -270,32 +470,616 @@ void imu_int1_register(struct bmi2_dev *bmi, am_hal_gpio_handler_t handler)
     am_hal_gpio_interrupt_register(AM_BSP_GPIO_IMU_INT1, handler);
 }
 
+static int16_t imu_le16(const uint8_t *data)
+{
+    return (int16_t)(((uint16_t)data[1] << 8) | data[0]);
+}
+
+static uint32_t imu_le24(const uint8_t *data)
+{
+    return ((uint32_t)data[2] << 16) | ((uint32_t)data[1] << 8) | data[0];
+}
+
+static uint8_t imu_acc_range_tag(uint32_t sensortime)
+{
+    if (imu_acc_range.pending)
+    {
+        // ODR periods are a power of two sensor time ticks.
+        uint32_t period_ticks = imu_period_us * 16 / 625;
+        uint32_t produced = sensortime & ~(period_ticks - 1);
+        uint32_t elapsed = (produced - imu_acc_range.switch_time) & SENSOR_TIME_MASK;
+
+        if ((elapsed == 0) || (elapsed > (SENSOR_TIME_MASK >> 1)))
+        {
+            return imu_acc_range.previous;
+        }
+        imu_acc_range.pending = false;
+    }
+
+    return imu_acc_range.range;
+}
+
+/*
+ * Fixed layout decoder for the STATUS to SENSORTIME burst.  This replaces
+ * the per sensor dispatch in bmi2_get_sensor_data().
+ */
+static void imu_sample_decode(const uint8_t *data, const struct bmi2_dev *bmi, imu_context_t *imu_context)
+{
+    imu_context->status = data[IMU_BURST_STATUS];
+
+    imu_context->ax = imu_le16(&data[IMU_BURST_ACC + 0]);
+    imu_context->ay = imu_le16(&data[IMU_BURST_ACC + 2]);
+    imu_context->az = imu_le16(&data[IMU_BURST_ACC + 4]);
+    imu_context->gx = imu_le16(&data[IMU_BURST_GYR + 0]);
+    imu_context->gy = imu_le16(&data[IMU_BURST_GYR + 2]);
+    imu_context->gz = imu_le16(&data[IMU_BURST_GYR + 4]);
+
+    // Same cross axis compensation as bmi2_get_sensor_data().  The axes are
+    // not remapped on this board so no remapping is applied.
+    imu_context->gx -= (int16_t)(((int32_t)bmi->gyr_cross_sens_zx * (int32_t)imu_context->gz) / 512);
+
+    imu_context->sensortime = imu_le24(&data[IMU_BURST_SENSORTIME]);
+    imu_context->acc_range = imu_acc_range_tag(imu_context->sensortime);
+    imu_context->gyr_range = imu_gyr_range;
+}
+
+void imu_timebase_start(struct bmi2_dev *bmi, uint32_t period_us)
+{
+    sensor_time_start(&imu_time, period_us, 0);
+}
+
+imu_status_t imu_int1_status(struct bmi2_dev *bmi, uint8_t *status)
+{
+    int8_t rslt;
+    uint16_t int_status = 0;
+
+    if (!sensor_bus_acquire(SENSOR_BUS_IMU))
+    {
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return IMU_STATUS_ERROR;
+    }
+    rslt = bmi2_get_int_status(&int_status, bmi);
+    sensor_bus_release(SENSOR_BUS_IMU);
+
+    if (rslt != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(rslt);
+        return IMU_STATUS_ERROR;
+    }
+
+    // INT_STATUS_0 holds the feature interrupts and is cleared on read.
+    *status = (uint8_t)(int_status & (IMU_INT1_NO_MOTION | IMU_INT1_ANY_MOTION | IMU_INT1_SIG_MOTION));
+
+    return IMU_STATUS_OK;
+}
+
+uint32_t imu_odr_period_us(uint8_t odr)
+{
+    // Each ODR step doubles the rate.  BMI2_ACC_ODR_100HZ is the reference.
+    if (odr >= BMI2_ACC_ODR_100HZ)
+    {
+        return 10000 >> (odr - BMI2_ACC_ODR_100HZ);
+    }
+
+    return 10000 << (BMI2_ACC_ODR_100HZ - odr);
+}
+
+imu_status_t imu_set_rate(struct bmi2_dev *bmi, const imu_rate_t *rate)
+{
+    int8_t status;
+    struct bmi2_sens_config config[2];
+    uint8_t sensortime[3];
+
+    config[0].type = BMI2_ACCEL;
+    config[1].type = BMI2_GYRO;
+
+    if (!sensor_bus_acquire(SENSOR_BUS_IMU))
+    {
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return IMU_STATUS_ERROR;
+    }
+    status = bmi270_get_sensor_config(config, 2, bmi);
+    if (status == BMI2_OK)
+    {
+        config[0].cfg.acc.odr = rate->odr;
+        config[0].cfg.acc.bwp = rate->acc_bwp;
+        config[0].cfg.acc.filter_perf = rate->filter_perf;
+        config[1].cfg.gyr.odr = rate->odr;
+        config[1].cfg.gyr.bwp = rate->gyr_bwp;
+        config[1].cfg.gyr.noise_perf = rate->filter_perf;
+        config[1].cfg.gyr.filter_perf = rate->filter_perf;
+        status = bmi270_set_sensor_config(config, 2, bmi);
+    }
+    if (status == BMI2_OK)
+    {
+        status = bmi2_get_regs(IMU_REG_SENSORTIME, sensortime, sizeof(sensortime), bmi);
+    }
+    sensor_bus_release(SENSOR_BUS_IMU);
+
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        return IMU_STATUS_ERROR;
+    }
+
+    uint32_t period_us = imu_odr_period_us(rate->odr);
+    if (period_us != imu_period_us)
+    {
+        // Only the first boundary since the last FIFO read is kept.
+        if (!imu_rate.pending)
+        {
+            imu_rate.previous_period_us = imu_period_us;
+            imu_rate.switch_time = imu_le24(sensortime);
+            imu_rate.pending = true;
+        }
+        imu_period_us = period_us;
+    }
+
+    return IMU_STATUS_OK;
+}
+
+imu_status_t imu_sample_start(struct bmi2_dev *bmi)
+{
+    uint32_t status;
+
+    if (!sensor_bus_acquire(SENSOR_BUS_IMU))
+    {
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return IMU_STATUS_ERROR;
+    }
+
+    // Read the burst directly rather than through bmi2_get_regs() so that
+    // the transfer runs in the background until imu_sample_finish().
+    sensor_bus_begin(SENSOR_BUS_IMU);
+    status = bmi2_spi_read_async(BMI2_STATUS_ADDR | BMI2_SPI_RD_MASK,
+                                 imu_sample_buffer,
+                                 IMU_SAMPLE_BURST_LENGTH + bmi->dummy_byte,
+                                 bmi->intf_ptr,
+                                 sensor_bus_complete,
+                                 sensor_bus_context(SENSOR_BUS_IMU));
+    if (status != AM_HAL_STATUS_SUCCESS)
+    {
+        sensor_bus_release(SENSOR_BUS_IMU);
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return IMU_STATUS_ERROR;
+    }
+
+    return IMU_STATUS_OK;
+}
+
+imu_status_t imu_sample_finish(struct bmi2_dev *bmi, imu_context_t *imu_context)
+{
+    uint32_t status = sensor_bus_wait(SENSOR_BUS_IMU);
+    uint64_t mcu_us = sensor_time_mcu_us();
+
+    // Honour the register access spacing that bmi2_get_regs() applies.
+    bmi->delay_us(bmi->aps_status == BMI2_ENABLE ? 450 : 2, bmi->intf_ptr);
+    sensor_bus_release(SENSOR_BUS_IMU);
+
+    if (status != AM_HAL_STATUS_SUCCESS)
+    {
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return IMU_STATUS_ERROR;
+    }
+
+    imu_sample_decode(&imu_sample_buffer[bmi->dummy_byte], bmi, imu_context);
+    imu_context->timestamp = sensor_time_update(&imu_time, imu_context->sensortime, mcu_us, 1, &imu_context->dropped);
+
+    return IMU_STATUS_OK;
+}
+
 void imu_sample(struct bmi2_dev *bmi, imu_context_t *imu_context)
 {
-    int8_t status = BMI2_OK;
+    if (imu_sample_start(bmi) == IMU_STATUS_OK)
+    {
+        imu_sample_finish(bmi, imu_context);
+    }
+}
+
+/*
+ * Reads a sample through the generic Bosch API.  This is kept as the
+ * reference for the burst read above and is not used on the sampling path.
+ * No timestamp is applied.
+ */
+imu_status_t imu_sample_reference(struct bmi2_dev *bmi, imu_context_t *imu_context)
+{
+    int8_t status;
     struct bmi2_sensor_data sensor_data[2];
 
-    // Get the raw sensor data for accelerometer, gyro and magnetometer
     sensor_data[0].type = BMI2_ACCEL;
     sensor_data[1].type = BMI2_GYRO;
 
-    taskENTER_CRITICAL();
-    bmi2_interface_init(bmi, BMI2_SPI_INTF);
+    if (!sensor_bus_acquire(SENSOR_BUS_IMU))
+    {
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return IMU_STATUS_ERROR;
+    }
     status = bmi2_get_sensor_data(sensor_data, 2, bmi);
-    bmi2_interface_deinit(bmi);
-    taskEXIT_CRITICAL();
+    sensor_bus_release(SENSOR_BUS_IMU);
 
     if (status != BMI2_OK)
     {
         bmi2_error_codes_print_result(status);
-        return;
+        return IMU_STATUS_ERROR;
     }
 
-    imu_context->timestamp++;
     imu_context->ax = sensor_data[0].sens_data.acc.x;
     imu_context->ay = sensor_data[0].sens_data.acc.y;
     imu_context->az = sensor_data[0].sens_data.acc.z;
     imu_context->gx = sensor_data[1].sens_data.gyr.x;
     imu_context->gy = sensor_data[1].sens_data.gyr.y;
     imu_context->gz = sensor_data[1].sens_data.gyr.z;
-}
\ No newline at end of file
+    imu_context->acc_range = imu_acc_range.range;
+    imu_context->gyr_range = imu_gyr_range;
+
+    return IMU_STATUS_OK;
+}
+
+imu_status_t imu_set_acc_range(struct bmi2_dev *bmi, uint8_t range)
+{
+    int8_t status;
+    uint8_t sensortime[3];
+
+    if (range > BMI2_ACC_RANGE_16G)
+    {
+        return IMU_STATUS_ERROR;
+    }
+
+    if (range == imu_acc_range.range)
+    {
+        return IMU_STATUS_OK;
+    }
+
+    // Write ACC_RANGE directly rather than through bmi270_set_sensor_config()
+    // to keep the switch short while a transient is in progress.
+    if (!sensor_bus_acquire(SENSOR_BUS_IMU))
+    {
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return IMU_STATUS_ERROR;
+    }
+    status = bmi2_set_regs(IMU_REG_ACC_RANGE, &range, 1, bmi);
+    if (status == BMI2_OK)
+    {
+        status = bmi2_get_regs(IMU_REG_SENSORTIME, sensortime, sizeof(sensortime), bmi);
+    }
+    sensor_bus_release(SENSOR_BUS_IMU);
+
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        return IMU_STATUS_ERROR;
+    }
+
+    imu_acc_range.previous = imu_acc_range.range;
+    imu_acc_range.range = range;
+    imu_acc_range.switch_time = imu_le24(sensortime);
+    imu_acc_range.pending = true;
+
+    return IMU_STATUS_OK;
+}
+
+uint8_t imu_acc_range_get(struct bmi2_dev *bmi)
+{
+    return imu_acc_range.range;
+}
+
+void imu_autorange(struct bmi2_dev *bmi, const imu_context_t *samples, uint32_t count)
+{
+    int32_t peak = -1;
+    uint64_t now_us = 0;
+
+    // Only samples taken at the current range are considered.
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (samples[i].acc_range != imu_acc_range.range)
+        {
+            continue;
+        }
+
+        int32_t ax = abs(samples[i].ax);
+        int32_t ay = abs(samples[i].ay);
+        int32_t az = abs(samples[i].az);
+        int32_t m = ax > ay ? ax : ay;
+        m = m > az ? m : az;
+        if (m > peak)
+        {
+            peak = m;
+        }
+        now_us = samples[i].timestamp;
+    }
+
+    if (peak < 0)
+    {
+        return;
+    }
+
+    // Step straight up to the widest range so that a rising peak is not
+    // clipped again on the way up.  Step down one range at a time.
+    if (peak >= IMU_AUTORANGE_UP_LSB)
+    {
+        imu_set_acc_range(bmi, BMI2_ACC_RANGE_16G);
+        imu_acc_range.quiet_since_us = now_us;
+    }
+    else if ((peak >= IMU_AUTORANGE_DOWN_LSB) || (imu_acc_range.range <= IMU_AUTORANGE_MIN))
+    {
+        imu_acc_range.quiet_since_us = now_us;
+    }
+    else if (now_us - imu_acc_range.quiet_since_us >= SENSORS_ACC_AUTORANGE_HOLD_MS * 1000ULL)
+    {
+        imu_set_acc_range(bmi, imu_acc_range.range - 1);
+        imu_acc_range.quiet_since_us = now_us;
+    }
+}
+
+imu_status_t imu_fifo_setup(struct bmi2_dev *bmi, uint16_t watermark_frames)
+{
+    imu_status_t res = IMU_STATUS_OK;
+    int8_t status;
+
+    if ((watermark_frames == 0) || (watermark_frames >= IMU_FIFO_MAX_FRAMES))
+    {
+        return IMU_STATUS_ERROR;
+    }
+
+    bmi2_interface_init(bmi, BMI2_SPI_INTF);
+
+    // FIFO reads are not permitted while advanced power save is enabled.
+    status = bmi2_set_adv_power_save(BMI2_DISABLE, bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        res = IMU_STATUS_ERROR;
+        goto error;
+    }
+
+    // Headerless mode with accel and gyro only.  Each frame is then a fixed
+    // 12 bytes and the watermark can be expressed directly in frames.
+    status = bmi2_set_fifo_config(BMI2_FIFO_ALL_EN | BMI2_FIFO_HEADER_EN | BMI2_FIFO_TIME_EN, BMI2_DISABLE, bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        res = IMU_STATUS_ERROR;
+        goto error;
+    }
+
+    status = bmi2_set_fifo_config(BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN, BMI2_ENABLE, bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        res = IMU_STATUS_ERROR;
+        goto error;
+    }
+
+    status = bmi2_set_fifo_wm(watermark_frames * BMI2_FIFO_ACC_GYR_LENGTH, bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        res = IMU_STATUS_ERROR;
+        goto error;
+    }
+
+    status = bmi2_map_data_int(BMI2_FWM_INT, BMI2_INT2, bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        res = IMU_STATUS_ERROR;
+        goto error;
+    }
+
+    status = imu_interrupt_config_int2(bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        res = IMU_STATUS_ERROR;
+        goto error;
+    }
+
+    status = bmi2_set_command_register(BMI2_FIFO_FLUSH_CMD, bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        res = IMU_STATUS_ERROR;
+        goto error;
+    }
+
+error:
+    bmi2_interface_deinit(bmi);
+
+    return res;
+}
+
+imu_status_t imu_fifo_flush(struct bmi2_dev *bmi)
+{
+    int8_t status;
+
+    if (!sensor_bus_acquire(SENSOR_BUS_IMU))
+    {
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return IMU_STATUS_ERROR;
+    }
+    status = bmi2_set_command_register(BMI2_FIFO_FLUSH_CMD, bmi);
+    sensor_bus_release(SENSOR_BUS_IMU);
+
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        return IMU_STATUS_ERROR;
+    }
+
+    // Frames buffered before the flush are gone so the gap tracking
+    // restarts from the next read.
+    sensor_time_start(&imu_time, imu_period_us, 1);
+    imu_rate.pending = false;
+
+    return IMU_STATUS_OK;
+}
+
+imu_status_t imu_fifo_set_watermark(struct bmi2_dev *bmi, uint16_t watermark_frames)
+{
+    int8_t status;
+
+    if ((watermark_frames == 0) || (watermark_frames >= IMU_FIFO_MAX_FRAMES))
+    {
+        return IMU_STATUS_ERROR;
+    }
+
+    if (!sensor_bus_acquire(SENSOR_BUS_IMU))
+    {
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return IMU_STATUS_ERROR;
+    }
+    status = bmi2_set_fifo_wm(watermark_frames * BMI2_FIFO_ACC_GYR_LENGTH, bmi);
+    sensor_bus_release(SENSOR_BUS_IMU);
+
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        return IMU_STATUS_ERROR;
+    }
+
+    return IMU_STATUS_OK;
+}
+
+void imu_int2_register(struct bmi2_dev *bmi, am_hal_gpio_handler_t handler)
+{
+    am_hal_gpio_interrupt_register(AM_BSP_GPIO_IMU_INT2, handler);
+}
+
+void imu_int2_enable(struct bmi2_dev *bmi)
+{
+    uint64_t mask_int2;
+    AM_HAL_GPIO_MASKBIT(mask_int2, AM_BSP_GPIO_IMU_INT2);
+    am_hal_gpio_interrupt_clear(mask_int2);
+    am_hal_gpio_interrupt_enable(mask_int2);
+}
+
+void imu_int2_disable(struct bmi2_dev *bmi)
+{
+    uint64_t mask_int2;
+    AM_HAL_GPIO_MASKBIT(mask_int2, AM_BSP_GPIO_IMU_INT2);
+    am_hal_gpio_interrupt_disable(mask_int2);
+    am_hal_gpio_interrupt_clear(mask_int2);
+}
+
+uint32_t imu_fifo_read(struct bmi2_dev *bmi, imu_context_t *frames, uint32_t max_frames)
+{
+    int8_t status = BMI2_OK;
+    uint16_t fifo_length = 0;
+    uint16_t accel_frames = IMU_FIFO_MAX_FRAMES;
+    uint16_t gyro_frames = IMU_FIFO_MAX_FRAMES;
+    struct bmi2_fifo_frame fifo = { 0 };
+    uint8_t sensortime[3];
+
+    // The FIFO length and the FIFO data are read back to back within the
+    // same bus session.  Only whole frames are read so that a frame being
+    // written during the burst is left in the FIFO for the next wakeup.
+    if (!sensor_bus_acquire(SENSOR_BUS_IMU))
+    {
+        bmi2_error_codes_print_result(BMI2_E_COM_FAIL);
+        return 0;
+    }
+    status = bmi2_get_fifo_length(&fifo_length, bmi);
+    if (status == BMI2_OK)
+    {
+        if (fifo_length > IMU_FIFO_BUFFER_SIZE)
+        {
+            fifo_length = IMU_FIFO_BUFFER_SIZE;
+        }
+        fifo_length -= fifo_length % BMI2_FIFO_ACC_GYR_LENGTH;
+
+        fifo.data = imu_fifo_buffer;
+        fifo.length = fifo_length;
+        if (fifo_length)
+        {
+            status = bmi2_read_fifo_data(&fifo, bmi);
+        }
+    }
+    if (status == BMI2_OK)
+    {
+        status = bmi2_get_regs(IMU_REG_SENSORTIME, sensortime, sizeof(sensortime), bmi);
+    }
+    sensor_bus_release(SENSOR_BUS_IMU);
+
+    uint64_t mcu_us = sensor_time_mcu_us();
+
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        return 0;
+    }
+
+    if (fifo_length == 0)
+    {
+        return 0;
+    }
+
+    status = bmi2_extract_accel(imu_fifo_accel, &accel_frames, &fifo, bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        return 0;
+    }
+
+    status = bmi2_extract_gyro(imu_fifo_gyro, &gyro_frames, &fifo, bmi);
+    if (status != BMI2_OK)
+    {
+        bmi2_error_codes_print_result(status);
+        return 0;
+    }
+
+    uint32_t available = accel_frames < gyro_frames ? accel_frames : gyro_frames;
+    uint32_t count = available;
+    if (count > max_frames)
+    {
+        count = max_frames;
+    }
+
+    // The sensor time read just after the drain stamps the newest frame.
+    // Older frames are spaced back from it at the ODR period, or at the
+    // previous period for frames produced before a rate change.
+    uint32_t dropped;
+    uint32_t raw = imu_le24(sensortime);
+    uint32_t period_ticks = imu_period_us * 16 / 625;
+    uint32_t recent = available;
+    uint32_t previous_ticks = period_ticks;
+    uint32_t switch_ticks = 0;
+
+    if (imu_rate.pending)
+    {
+        // ODR periods are a power of two sensor time ticks.  The last
+        // frame at the previous rate is the one on its ODR boundary at or
+        // before the change.
+        uint32_t since = ((raw & ~(period_ticks - 1)) - (imu_rate.switch_time & ~(period_ticks - 1))) & SENSOR_TIME_MASK;
+
+        recent = since / period_ticks;
+        previous_ticks = imu_rate.previous_period_us * 16 / 625;
+        switch_ticks = (raw - (imu_rate.switch_time & ~(previous_ticks - 1))) & SENSOR_TIME_MASK;
+        sensor_time_set_period(&imu_time, imu_rate.switch_time, imu_period_us);
+        imu_rate.pending = false;
+    }
+    uint64_t newest = sensor_time_update(&imu_time, raw, mcu_us, available, &dropped);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t age = available - 1 - i;
+        uint32_t age_ticks = age * period_ticks;
+        if (age >= recent)
+        {
+            age_ticks = switch_ticks + (age - recent) * previous_ticks;
+        }
+        frames[i].timestamp = newest - sensor_time_ticks_to_us(age_ticks);
+        frames[i].sensortime = (raw - age_ticks) & SENSOR_TIME_MASK;
+        frames[i].dropped = (i == 0) ? dropped : 0;
+        frames[i].status = BMI2_DRDY_ACC | BMI2_DRDY_GYR;
+        frames[i].acc_range = imu_acc_range_tag(frames[i].sensortime);
+        frames[i].gyr_range = imu_gyr_range;
+        frames[i].ax = imu_fifo_accel[i].x;
+        frames[i].ay = imu_fifo_accel[i].y;
+        frames[i].az = imu_fifo_accel[i].z;
+        frames[i].gx = imu_fifo_gyro[i].x;
+        frames[i].gy = imu_fifo_gyro[i].y;
+        frames[i].gz = imu_fifo_gyro[i].z;
+    }
+
+    return count;
+}
@@ -36,25 +36,77 @@
 #include <bmi270.h>
 #include <bmi270_hal.h>
 
+// Maximum number of accel/gyro frames drained from the FIFO per read.
+#define IMU_FIFO_MAX_FRAMES (32)
+
+// FIFO frames are produced at the 400Hz ODR configured by imu_setup().
+// imu_set_rate() changes the frame period.
+#define IMU_FIFO_FRAME_PERIOD_US (2500)
+
+// Feature interrupts routed to INT1.  See imu_int1_status().
+#define IMU_INT1_NO_MOTION  BMI270_NO_MOT_STATUS_MASK
+#define IMU_INT1_ANY_MOTION BMI270_ANY_MOT_STATUS_MASK
+#define IMU_INT1_SIG_MOTION BMI270_SIG_MOT_STATUS_MASK
+
 typedef enum imu_status_e
 {
     IMU_STATUS_OK,
     IMU_STATUS_ERROR
 } imu_status_t;
 
+/*
+ * Accel and gyro run at the same ODR so that headerless FIFO frames stay
+ * paired.  odr takes the BMI2_ACC_ODR_* values which match BMI2_GYR_ODR_*
+ * from 25Hz to 1600Hz.  filter_perf selects between the power optimised
+ * (BMI2_POWER_OPT_MODE) and the performance optimised (BMI2_PERF_OPT_MODE)
+ * filters.  In the power optimised mode acc_bwp is the averaging depth.
+ */
+typedef struct imu_rate_s
+{
+    uint8_t odr;
+    uint8_t acc_bwp;
+    uint8_t gyr_bwp;
+    uint8_t filter_perf;
+} imu_rate_t;
+
 typedef struct imu_context_s
 {
-    uint32_t timestamp;
+    uint64_t timestamp;     // microseconds on the MCU timebase
+    uint32_t sensortime;    // raw BMI270 sensor time (24 bits)
+    uint32_t dropped;       // samples missed immediately before this one
+    uint8_t status;         // BMI2_DRDY_ACC and BMI2_DRDY_GYR flags
+    uint8_t acc_range;      // BMI2_ACC_RANGE_* the sample was measured at
+    uint8_t gyr_range;      // BMI2_GYR_RANGE_* the sample was measured at
     int16_t ax, ay, az;
     int16_t gx, gy, gz;
 } imu_context_t;
 
 extern imu_status_t imu_setup(struct bmi2_dev *bmi);
+extern void imu_scale_setup(uint8_t resolution);
 extern void imu_sample(struct bmi2_dev *bmi, imu_context_t *context);
+extern imu_status_t imu_sample_start(struct bmi2_dev *bmi);
+extern imu_status_t imu_sample_finish(struct bmi2_dev *bmi, imu_context_t *context);
+extern imu_status_t imu_sample_reference(struct bmi2_dev *bmi, imu_context_t *context);
 extern void imu_int1_register(struct bmi2_dev *bmi, am_hal_gpio_handler_t handler);
+extern void imu_timebase_start(struct bmi2_dev *bmi, uint32_t period_us);
+extern imu_status_t imu_int1_status(struct bmi2_dev *bmi, uint8_t *status);
+extern imu_status_t imu_set_rate(struct bmi2_dev *bmi, const imu_rate_t *rate);
+extern uint32_t imu_odr_period_us(uint8_t odr);
+
+extern imu_status_t imu_fifo_setup(struct bmi2_dev *bmi, uint16_t watermark_frames);
+extern imu_status_t imu_fifo_flush(struct bmi2_dev *bmi);
+extern imu_status_t imu_fifo_set_watermark(struct bmi2_dev *bmi, uint16_t watermark_frames);
+extern uint32_t imu_fifo_read(struct bmi2_dev *bmi, imu_context_t *frames, uint32_t max_frames);
+extern void imu_int2_register(struct bmi2_dev *bmi, am_hal_gpio_handler_t handler);
+extern void imu_int2_enable(struct bmi2_dev *bmi);
+extern void imu_int2_disable(struct bmi2_dev *bmi);
+
+extern imu_status_t imu_set_acc_range(struct bmi2_dev *bmi, uint8_t range);
+extern uint8_t imu_acc_range_get(struct bmi2_dev *bmi);
+extern void imu_autorange(struct bmi2_dev *bmi, const imu_context_t *samples, uint32_t count);
 
-extern float imu_lsb_to_mps2(int16_t val);
-extern float imu_lsb_to_dps(int16_t val);
-extern float imu_lsb_to_rps(int16_t val);
+extern float imu_lsb_to_mps2(const imu_context_t *context, int16_t val);
+extern float imu_lsb_to_dps(const imu_context_t *context, int16_t val);
+extern float imu_lsb_to_rps(const imu_context_t *context, int16_t val);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,420 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include "sensors_config.h"
+
+#include "imu.h"
+#include "imu_fifo_bench.h"
+
+// Largest frame, a header followed by aux, gyro and accel data.
+#define IMU_FIFO_BENCH_FRAME_MAX    (1 + BMI2_FIFO_ALL_LENGTH)
+
+// Header mode buffers start with a skip frame and end with a sensor time
+// frame, as they are read after an overflow with the time frame enabled.
+#define IMU_FIFO_BENCH_SKIPPED      (3)
+#define IMU_FIFO_BENCH_SENSOR_TIME  (0x123456)
+
+#define IMU_FIFO_BENCH_BUFFER_SIZE                          \
+    (SENSORS_FIFO_BENCH_FRAMES * IMU_FIFO_BENCH_FRAME_MAX + \
+     1 + BMI2_FIFO_SKIP_FRM_LENGTH + 1 + BMI2_SENSOR_TIME_LENGTH)
+
+/*
+ * In headerless mode every frame carries all of the enabled sensors.  In
+ * header mode the gyro and aux samples can be limited to every nth frame,
+ * as when they run at a lower ODR than the accelerometer, so that the
+ * parsers also have to step over frames of other layouts.
+ */
+typedef struct imu_fifo_bench_mix_s
+{
+    const char *name;
+    bool header;
+    uint16_t data_enable;   // BMI2_FIFO_*_EN
+    uint8_t gyr_every;
+    uint8_t aux_every;
+} imu_fifo_bench_mix_t;
+
+static const imu_fifo_bench_mix_t imu_fifo_bench_mixes[] = {
+    {"acc",             false,  BMI2_FIFO_ACC_EN,                                       1, 1},
+    {"acc+gyr",         false,  BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN,                    1, 1},
+    {"acc+gyr+aux",     false,  BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN | BMI2_FIFO_AUX_EN, 1, 1},
+    {"acc",             true,   BMI2_FIFO_ACC_EN,                                       1, 1},
+    {"acc+gyr",         true,   BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN,                    1, 1},
+    {"acc+gyr+aux",     true,   BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN | BMI2_FIFO_AUX_EN, 1, 1},
+    {"acc+gyr/2",       true,   BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN,                    2, 1},
+    {"acc+gyr+aux/4",   true,   BMI2_FIFO_ACC_EN | BMI2_FIFO_GYR_EN | BMI2_FIFO_AUX_EN, 1, 4},
+};
+
+#define IMU_FIFO_BENCH_MIXES (sizeof(imu_fifo_bench_mixes) / sizeof(imu_fifo_bench_mixes[0]))
+
+// One watermark, one imu_fifo_read() and one bulk drain.
+static const uint32_t imu_fifo_bench_sizes[] = {
+    SENSORS_FIFO_WATERMARK_FRAMES,
+    IMU_FIFO_MAX_FRAMES,
+    SENSORS_FIFO_BENCH_FRAMES,
+};
+
+#define IMU_FIFO_BENCH_SIZES (sizeof(imu_fifo_bench_sizes) / sizeof(imu_fifo_bench_sizes[0]))
+
+static const char *imu_fifo_bench_names[IMU_FIFO_BENCH_EXTRACTS] = {
+    "accel",
+    "gyro",
+    "aux",
+};
+
+// One spare entry so that the header mode parsers do not stop at the last
+// data frame and go on to the sensor time frame.
+#define IMU_FIFO_BENCH_OUTPUT_FRAMES (SENSORS_FIFO_BENCH_FRAMES + 1)
+
+static uint8_t imu_fifo_bench_buffer[IMU_FIFO_BENCH_BUFFER_SIZE];
+static struct bmi2_sens_axes_data imu_fifo_bench_accel[IMU_FIFO_BENCH_OUTPUT_FRAMES];
+static struct bmi2_sens_axes_data imu_fifo_bench_gyro[IMU_FIFO_BENCH_OUTPUT_FRAMES];
+static struct bmi2_aux_fifo_data imu_fifo_bench_aux[IMU_FIFO_BENCH_OUTPUT_FRAMES];
+
+// The extraction only checks that the bus functions are set.
+static BMI2_INTF_RETURN_TYPE imu_fifo_bench_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    return BMI2_E_COM_FAIL;
+}
+
+static BMI2_INTF_RETURN_TYPE imu_fifo_bench_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+    return BMI2_E_COM_FAIL;
+}
+
+static void imu_fifo_bench_delay_us(uint32_t period, void *intf_ptr)
+{
+}
+
+// Sample n of a sensor.  Distinct for every sensor, frame and axis so
+// that misplaced data is caught.
+static int16_t imu_fifo_bench_value(uint32_t sensor, uint32_t n, uint32_t axis)
+{
+    return (int16_t)(sensor * 10000 + axis * 3000 + n * 7 - 15000);
+}
+
+static uint8_t imu_fifo_bench_aux_byte(uint32_t n, uint32_t i)
+{
+    return (uint8_t)(n * BMI2_FIFO_AUX_LENGTH + i);
+}
+
+static uint32_t imu_fifo_bench_axes(uint8_t *data, uint32_t sensor, uint32_t n)
+{
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        uint16_t value = (uint16_t)imu_fifo_bench_value(sensor, n, axis);
+
+        data[2 * axis] = (uint8_t)value;
+        data[2 * axis + 1] = (uint8_t)(value >> 8);
+    }
+
+    return 6;
+}
+
+// Fills the buffer and returns its length.  count[] receives the number of
+// samples of each sensor.
+static uint32_t imu_fifo_bench_generate(const imu_fifo_bench_mix_t *mix, uint32_t frames, uint32_t *count)
+{
+    uint8_t *data = imu_fifo_bench_buffer;
+    uint32_t length = 0;
+
+    memset(count, 0, IMU_FIFO_BENCH_EXTRACTS * sizeof(count[0]));
+
+    if (mix->header)
+    {
+        data[length++] = BMI2_FIFO_HEADER_SKIP_FRM;
+        data[length++] = IMU_FIFO_BENCH_SKIPPED;
+    }
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        bool acc = (mix->data_enable & BMI2_FIFO_ACC_EN) != 0;
+        bool gyr = ((mix->data_enable & BMI2_FIFO_GYR_EN) != 0) && ((i % mix->gyr_every) == 0);
+        bool aux = ((mix->data_enable & BMI2_FIFO_AUX_EN) != 0) && ((i % mix->aux_every) == 0);
+
+        if (mix->header)
+        {
+            data[length++] = (uint8_t)((acc ? BMI2_FIFO_HEADER_ACC_FRM : 0) |
+                                       (gyr ? BMI2_FIFO_HEADER_GYR_FRM : 0) |
+                                       (aux ? BMI2_FIFO_HEADER_AUX_FRM : 0));
+        }
+
+        // The payload is in aux, gyro, accel order.
+        if (aux)
+        {
+            for (uint32_t j = 0; j < BMI2_FIFO_AUX_LENGTH; j++)
+            {
+                data[length + j] = imu_fifo_bench_aux_byte(count[IMU_FIFO_BENCH_AUX], j);
+            }
+            length += BMI2_FIFO_AUX_LENGTH;
+            count[IMU_FIFO_BENCH_AUX]++;
+        }
+        if (gyr)
+        {
+            length += imu_fifo_bench_axes(&data[length], IMU_FIFO_BENCH_GYRO, count[IMU_FIFO_BENCH_GYRO]);
+            count[IMU_FIFO_BENCH_GYRO]++;
+        }
+        if (acc)
+        {
+            length += imu_fifo_bench_axes(&data[length], IMU_FIFO_BENCH_ACCEL, count[IMU_FIFO_BENCH_ACCEL]);
+            count[IMU_FIFO_BENCH_ACCEL]++;
+        }
+    }
+
+    if (mix->header)
+    {
+        data[length++] = BMI2_FIFO_HEADER_SENS_TIME_FRM;
+        data[length++] = (uint8_t)IMU_FIFO_BENCH_SENSOR_TIME;
+        data[length++] = (uint8_t)(IMU_FIFO_BENCH_SENSOR_TIME >> 8);
+        data[length++] = (uint8_t)(IMU_FIFO_BENCH_SENSOR_TIME >> 16);
+    }
+
+    return length;
+}
+
+static bool imu_fifo_bench_axes_match(const struct bmi2_sens_axes_data *data, uint32_t sensor, uint32_t count)
+{
+    for (uint32_t n = 0; n < count; n++)
+    {
+        if ((data[n].x != imu_fifo_bench_value(sensor, n, 0)) ||
+            (data[n].y != imu_fifo_bench_value(sensor, n, 1)) ||
+            (data[n].z != imu_fifo_bench_value(sensor, n, 2)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool imu_fifo_bench_aux_match(uint32_t count)
+{
+    for (uint32_t n = 0; n < count; n++)
+    {
+        for (uint32_t j = 0; j < BMI2_FIFO_AUX_LENGTH; j++)
+        {
+            if (imu_fifo_bench_aux[n].data[j] != imu_fifo_bench_aux_byte(n, j))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Times one extraction from the start of the buffer.
+static int8_t imu_fifo_bench_extract(uint32_t extract, struct bmi2_fifo_frame *fifo, struct bmi2_dev *dev,
+                                     profile_t *probe, uint16_t *length)
+{
+    int8_t status;
+
+    fifo->acc_byte_start_idx = 0;
+    fifo->gyr_byte_start_idx = 0;
+    fifo->aux_byte_start_idx = 0;
+    fifo->sensor_time = 0;
+    fifo->skipped_frame_count = 0;
+    *length = IMU_FIFO_BENCH_OUTPUT_FRAMES;
+
+    profile_start(probe);
+    switch (extract)
+    {
+    case IMU_FIFO_BENCH_ACCEL:
+        status = bmi2_extract_accel(imu_fifo_bench_accel, length, fifo, dev);
+        break;
+    case IMU_FIFO_BENCH_GYRO:
+        status = bmi2_extract_gyro(imu_fifo_bench_gyro, length, fifo, dev);
+        break;
+    default:
+        status = bmi2_extract_aux(imu_fifo_bench_aux, length, fifo, dev);
+        break;
+    }
+    profile_stop(probe);
+
+    return status;
+}
+
+uint32_t imu_fifo_bench_count(void)
+{
+    return IMU_FIFO_BENCH_MIXES * IMU_FIFO_BENCH_SIZES;
+}
+
+bool imu_fifo_bench_run(uint32_t index, uint32_t iterations, imu_fifo_bench_result_t *result)
+{
+    struct bmi2_dev dev = { 0 };
+    struct bmi2_fifo_frame fifo = { 0 };
+    uint32_t count[IMU_FIFO_BENCH_EXTRACTS];
+
+    if (index >= imu_fifo_bench_count())
+    {
+        return false;
+    }
+
+    const imu_fifo_bench_mix_t *mix = &imu_fifo_bench_mixes[index / IMU_FIFO_BENCH_SIZES];
+    uint32_t frames = imu_fifo_bench_sizes[index % IMU_FIFO_BENCH_SIZES];
+
+    if (iterations == 0)
+    {
+        iterations = 1;
+    }
+
+    // Only the bus functions and the axis remapping are used.  The remap
+    // is left as the identity.
+    dev.read = imu_fifo_bench_read;
+    dev.write = imu_fifo_bench_write;
+    dev.delay_us = imu_fifo_bench_delay_us;
+    dev.remap.x_axis = BMI2_MAP_X_AXIS;
+    dev.remap.y_axis = BMI2_MAP_Y_AXIS;
+    dev.remap.z_axis = BMI2_MAP_Z_AXIS;
+    dev.remap.x_axis_sign = BMI2_POS_SIGN;
+    dev.remap.y_axis_sign = BMI2_POS_SIGN;
+    dev.remap.z_axis_sign = BMI2_POS_SIGN;
+
+    // As set up by bmi2_read_fifo_data() without the sensor time in
+    // headerless frames.
+    fifo.data = imu_fifo_bench_buffer;
+    fifo.length = (uint16_t)imu_fifo_bench_generate(mix, frames, count);
+    fifo.header_enable = mix->header ? (uint8_t)(BMI2_FIFO_HEADER_EN >> 8) : 0;
+    fifo.data_enable = mix->data_enable;
+    fifo.acc_frm_len = BMI2_FIFO_ACC_LENGTH;
+    fifo.gyr_frm_len = BMI2_FIFO_GYR_LENGTH;
+    fifo.aux_frm_len = BMI2_FIFO_AUX_LENGTH;
+    fifo.acc_gyr_frm_len = BMI2_FIFO_ACC_GYR_LENGTH;
+    fifo.acc_aux_frm_len = BMI2_FIFO_ACC_AUX_LENGTH;
+    fifo.aux_gyr_frm_len = BMI2_FIFO_GYR_AUX_LENGTH;
+    fifo.all_frm_len = BMI2_FIFO_ALL_LENGTH;
+
+    memset(result, 0, sizeof(*result));
+    result->mix = mix->name;
+    result->header = mix->header;
+    result->frames = frames;
+    result->bytes = fifo.length;
+    result->valid = true;
+
+    for (uint32_t extract = 0; extract < IMU_FIFO_BENCH_EXTRACTS; extract++)
+    {
+        profile_t *probe = &result->probe[extract];
+        uint16_t length = 0;
+
+        probe->name = imu_fifo_bench_names[extract];
+        profile_reset(probe);
+
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            if (imu_fifo_bench_extract(extract, &fifo, &dev, probe, &length) < BMI2_OK)
+            {
+                result->valid = false;
+            }
+        }
+
+        result->extracted[extract] = length;
+        if (length != count[extract])
+        {
+            result->valid = false;
+        }
+        else if (extract == IMU_FIFO_BENCH_AUX)
+        {
+            result->valid &= imu_fifo_bench_aux_match(length);
+        }
+        else
+        {
+            result->valid &= imu_fifo_bench_axes_match((extract == IMU_FIFO_BENCH_ACCEL) ?
+                imu_fifo_bench_accel : imu_fifo_bench_gyro, extract, length);
+        }
+
+        // The whole buffer is walked, including the skip and time frames.
+        if (mix->header &&
+            ((fifo.skipped_frame_count != IMU_FIFO_BENCH_SKIPPED) ||
+             (fifo.sensor_time != IMU_FIFO_BENCH_SENSOR_TIME)))
+        {
+            result->valid = false;
+        }
+    }
+
+    return result->valid;
+}
+
+/*
+ * Frames per second is the rate at which one call returns its sensor's
+ * frames.  Bytes per cycle counts the whole buffer, which every call walks
+ * whatever its sensor, against the mean ticks of a call.
+ */
+uint32_t imu_fifo_bench_report(uint32_t iterations, uint32_t ticks_per_s)
+{
+    imu_fifo_bench_result_t result;
+    uint32_t failed = 0;
+
+    am_util_stdio_printf("\r\n%-10s %-14s %6s %6s %-6s %6s %10s %10s %11s %8s\r\n",
+        "mode", "mix", "frames", "bytes", "call", "out", "mean", "min", "frames/s", "bytes/c");
+
+    for (uint32_t index = 0; index < imu_fifo_bench_count(); index++)
+    {
+        if (!imu_fifo_bench_run(index, iterations, &result))
+        {
+            failed++;
+        }
+
+        for (uint32_t extract = 0; extract < IMU_FIFO_BENCH_EXTRACTS; extract++)
+        {
+            const profile_t *probe = &result.probe[extract];
+            uint32_t mean = (uint32_t)(probe->total / probe->count);
+            float frames_per_s = 0.0f;
+            float bytes_per_tick = 0.0f;
+
+            if (mean)
+            {
+                frames_per_s = (float)result.extracted[extract] * (float)ticks_per_s / (float)mean;
+                bytes_per_tick = (float)result.bytes / (float)mean;
+            }
+
+            am_util_stdio_printf("%-10s %-14s %6u %6u %-6s %6u %10u %10u %11.0f %8.3f%s\r\n",
+                result.header ? "header" : "headerless",
+                result.mix,
+                result.frames,
+                result.bytes,
+                probe->name,
+                result.extracted[extract],
+                mean,
+                probe->min,
+                frames_per_s,
+                bytes_per_tick,
+                result.valid ? "" : " mismatch");
+        }
+    }
+
+    return failed;
+}
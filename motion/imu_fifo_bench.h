@@ -0,0 +1,74 @@
+/*
+ *  BSD 3-Clause License
+ *
+ * Copyright (c) 2024, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _IMU_FIFO_BENCH_H_
+#define _IMU_FIFO_BENCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "profile.h"
+
+// Extraction calls timed for each FIFO buffer.
+enum
+{
+    IMU_FIFO_BENCH_ACCEL,
+    IMU_FIFO_BENCH_GYRO,
+    IMU_FIFO_BENCH_AUX,
+    IMU_FIFO_BENCH_EXTRACTS
+};
+
+/*
+ * Result of one benchmark case.  A FIFO buffer of the given frame mix and
+ * size is generated once, then bmi2_extract_accel(), bmi2_extract_gyro()
+ * and bmi2_extract_aux() are each timed over the whole buffer.  The probes
+ * are not registered and hold the DWT->CYCCNT ticks of every call.
+ */
+typedef struct imu_fifo_bench_result_s
+{
+    const char *mix;
+    bool header;
+    uint32_t frames;        // FIFO frames in the buffer
+    uint32_t bytes;         // buffer length
+    uint32_t extracted[IMU_FIFO_BENCH_EXTRACTS];
+    profile_t probe[IMU_FIFO_BENCH_EXTRACTS];
+    bool valid;             // every extracted frame matched the generated one
+} imu_fifo_bench_result_t;
+
+extern uint32_t imu_fifo_bench_count(void);
+extern bool imu_fifo_bench_run(uint32_t index, uint32_t iterations, imu_fifo_bench_result_t *result);
+
+// Runs every case and prints a table.  ticks_per_s is the DWT->CYCCNT
+// rate used for the frames per second column.  Returns the number of
+// cases whose extracted frames did not match.
+extern uint32_t imu_fifo_bench_report(uint32_t iterations, uint32_t ticks_per_s);
+
+#endif
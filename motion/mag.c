@@ -43,6 +43,65 @@
 #include <task.h>
 
 #include "mag.h"
+#include "sensor_bus.h"
+#include "sensor_time.h"
+
+static sensor_time_t mag_time;
+
+// The sensor time registers directly follow the data and temperature
+// registers so both are read in a single burst.  The I2C interface returns
+// two dummy bytes ahead of the data.
+#define MAG_SAMPLE_BURST_LENGTH (BMM350_MAG_TEMP_DATA_LEN + 3)
+
+static uint8_t mag_sample_buffer[BMM350_DUMMY_BYTES + MAG_SAMPLE_BURST_LENGTH] __attribute__((aligned(4)));
+
+/*
+ * Bus hooks used on the sampling path.  The transfer runs on the IOM DMA
+ * and the calling task sleeps until the completion interrupt.
+ */
+static BMM350_INTF_RET_TYPE mag_bus_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t length, void *intf_ptr)
+{
+    uint32_t status;
+
+    sensor_bus_begin(SENSOR_BUS_MAG);
+    status = bmm350_i2c_read_async(reg_addr, reg_data, length, intf_ptr,
+                                   sensor_bus_complete, sensor_bus_context(SENSOR_BUS_MAG));
+    if (status == AM_HAL_STATUS_SUCCESS)
+    {
+        status = sensor_bus_wait(SENSOR_BUS_MAG);
+    }
+
+    return status == AM_HAL_STATUS_SUCCESS ? BMM350_INTF_RET_SUCCESS : BMM350_E_COM_FAIL;
+}
+
+static BMM350_INTF_RET_TYPE mag_bus_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t length, void *intf_ptr)
+{
+    uint32_t status;
+
+    sensor_bus_begin(SENSOR_BUS_MAG);
+    status = bmm350_i2c_write_async(reg_addr, reg_data, length, intf_ptr,
+                                    sensor_bus_complete, sensor_bus_context(SENSOR_BUS_MAG));
+    if (status == AM_HAL_STATUS_SUCCESS)
+    {
+        status = sensor_bus_wait(SENSOR_BUS_MAG);
+    }
+
+    return status == AM_HAL_STATUS_SUCCESS ? BMM350_INTF_RET_SUCCESS : BMM350_E_COM_FAIL;
+}
+
+static void mag_bus_open(void *arg)
+{
+    struct bmm350_dev *bmm = (struct bmm350_dev *)arg;
+
+    bmm350_interface_init(bmm);
+    bmm->read = mag_bus_read;
+    bmm->write = mag_bus_write;
+}
+
+static void mag_bus_close(void *arg)
+{
+    bmm350_interface_deinit((struct bmm350_dev *)arg);
+}
 
 mag_status_t mag_setup(struct bmm350_dev *bmm)
 {
@@ -81,32 +140,181 @@ mag_status_t mag_setup(struct bmm350_dev *bmm)
         res = MAG_STATUS_ERROR;
         goto error;
     }
+
+    sensor_bus_setup(SENSOR_BUS_MAG, mag_bus_open, mag_bus_close, bmm);
+
 error:
     bmm350_interface_deinit(bmm);
     return res;
 }
 
-void mag_sample(struct bmm350_dev *bmm, mag_context_t *context)
+void mag_timebase_start(struct bmm350_dev *bmm, uint32_t period_us)
+{
+    sensor_time_start(&mag_time, period_us, 0);
+}
+
+mag_status_t mag_set_rate(struct bmm350_dev *bmm, enum bmm350_data_rates odr, enum bmm350_performance_parameters avg)
+{
+    int8_t rslt;
+
+    if (!sensor_bus_acquire(SENSOR_BUS_MAG))
+    {
+        bmm350_error_codes_print_result("sensor_bus_acquire", BMM350_E_COM_FAIL);
+        return MAG_STATUS_ERROR;
+    }
+    rslt = bmm350_set_odr_performance(odr, avg, bmm);
+    sensor_bus_release(SENSOR_BUS_MAG);
+
+    if (rslt != BMM350_OK)
+    {
+        bmm350_error_codes_print_result("bmm350_set_odr_performance", rslt);
+        return MAG_STATUS_ERROR;
+    }
+
+    return MAG_STATUS_OK;
+}
+
+mag_status_t mag_sample_start(struct bmm350_dev *bmm)
+{
+    uint32_t status;
+
+    if (!sensor_bus_acquire(SENSOR_BUS_MAG))
+    {
+        bmm350_error_codes_print_result("sensor_bus_acquire", BMM350_E_COM_FAIL);
+        return MAG_STATUS_ERROR;
+    }
+
+    sensor_bus_begin(SENSOR_BUS_MAG);
+    status = bmm350_i2c_read_async(BMM350_REG_MAG_X_XLSB,
+                                   mag_sample_buffer,
+                                   sizeof(mag_sample_buffer),
+                                   bmm->intf_ptr,
+                                   sensor_bus_complete,
+                                   sensor_bus_context(SENSOR_BUS_MAG));
+    if (status != AM_HAL_STATUS_SUCCESS)
+    {
+        sensor_bus_release(SENSOR_BUS_MAG);
+        bmm350_error_codes_print_result("bmm350_i2c_read_async", BMM350_E_COM_FAIL);
+        return MAG_STATUS_ERROR;
+    }
+
+    return MAG_STATUS_OK;
+}
+
+mag_status_t mag_sample_finish(struct bmm350_dev *bmm, mag_context_t *context)
 {
     int8_t rslt;
+    struct bmm350_raw_mag_data raw_data;
     struct bmm350_mag_temp_data mag_temp_data;
 
-    taskENTER_CRITICAL();
-    bmm350_interface_init(bmm);
-    rslt = bmm350_get_compensated_mag_xyz_temp_data(&mag_temp_data, bmm);
-    bmm350_interface_deinit(bmm);
-    taskEXIT_CRITICAL();
+    uint32_t status = sensor_bus_wait(SENSOR_BUS_MAG);
+    uint64_t mcu_us = sensor_time_mcu_us();
+    sensor_bus_release(SENSOR_BUS_MAG);
+
+    if (status != AM_HAL_STATUS_SUCCESS)
+    {
+        bmm350_error_codes_print_result("sensor_bus_wait", BMM350_E_COM_FAIL);
+        return MAG_STATUS_ERROR;
+    }
 
+    const uint8_t *data = &mag_sample_buffer[BMM350_DUMMY_BYTES];
+
+    rslt = bmm350_parse_uncomp_mag_temp_data(data, &raw_data, bmm);
+    if (rslt == BMM350_OK)
+    {
+        rslt = bmm350_compensate_mag_xyz_temp_data(&raw_data, &mag_temp_data, bmm);
+    }
     if (rslt != BMM350_OK)
     {
-        bmm350_error_codes_print_result("bmm350_get_compensated_mag_xyz_temp_data", rslt);
-        return;
+        bmm350_error_codes_print_result("bmm350_compensate_mag_xyz_temp_data", rslt);
+        return MAG_STATUS_ERROR;
     }
 
-    context->timestamp++;
+    data += BMM350_MAG_TEMP_DATA_LEN;
+    context->sensortime = ((uint32_t)data[2] << 16) | ((uint32_t)data[1] << 8) | data[0];
+    context->timestamp = sensor_time_update(&mag_time, context->sensortime, mcu_us, 1, &context->dropped);
     context->mx = mag_temp_data.x;
     context->my = mag_temp_data.y;
     context->mz = mag_temp_data.z;
+
+    return MAG_STATUS_OK;
+}
+
+mag_status_t mag_sample(struct bmm350_dev *bmm, mag_context_t *context)
+{
+    mag_status_t status = mag_sample_start(bmm);
+
+    if (status == MAG_STATUS_OK)
+    {
+        status = mag_sample_finish(bmm, context);
+    }
+
+    return status;
+}
+
+mag_status_t mag_drdy_setup(struct bmm350_dev *bmm)
+{
+    mag_status_t res = MAG_STATUS_OK;
+    int8_t rslt;
+
+    if (!sensor_bus_acquire(SENSOR_BUS_MAG))
+    {
+        bmm350_error_codes_print_result("sensor_bus_acquire", BMM350_E_COM_FAIL);
+        return MAG_STATUS_ERROR;
+    }
+
+    // A pulse per conversion.  Nothing needs to be acknowledged on the
+    // sensor so the handler only has to read the data.
+    rslt = bmm350_configure_interrupt(BMM350_PULSED,
+                                      BMM350_ACTIVE_HIGH,
+                                      BMM350_INTR_PUSH_PULL,
+                                      BMM350_MAP_TO_PIN,
+                                      bmm);
+    if (rslt != BMM350_OK)
+    {
+        bmm350_error_codes_print_result("bmm350_configure_interrupt", rslt);
+        res = MAG_STATUS_ERROR;
+        goto error;
+    }
+
+    rslt = bmm350_enable_interrupt(BMM350_ENABLE_INTERRUPT, bmm);
+    if (rslt != BMM350_OK)
+    {
+        bmm350_error_codes_print_result("bmm350_enable_interrupt", rslt);
+        res = MAG_STATUS_ERROR;
+        goto error;
+    }
+
+    uint64_t mask_drdy;
+    AM_HAL_GPIO_MASKBIT(mask_drdy, AM_BSP_GPIO_MAG_INT);
+    am_hal_gpio_pinconfig(AM_BSP_GPIO_MAG_INT, g_AM_BSP_GPIO_MAG_INT);
+    am_hal_gpio_interrupt_clear(mask_drdy);
+    NVIC_EnableIRQ(GPIO_IRQn);
+
+error:
+    sensor_bus_release(SENSOR_BUS_MAG);
+    return res;
+}
+
+void mag_drdy_register(struct bmm350_dev *bmm, am_hal_gpio_handler_t handler)
+{
+    am_hal_gpio_interrupt_register(AM_BSP_GPIO_MAG_INT, handler);
+}
+
+void mag_drdy_enable(struct bmm350_dev *bmm)
+{
+    uint64_t mask_drdy;
+    AM_HAL_GPIO_MASKBIT(mask_drdy, AM_BSP_GPIO_MAG_INT);
+    am_hal_gpio_interrupt_clear(mask_drdy);
+    am_hal_gpio_interrupt_enable(mask_drdy);
+}
+
+void mag_drdy_disable(struct bmm350_dev *bmm)
+{
+    uint64_t mask_drdy;
+    AM_HAL_GPIO_MASKBIT(mask_drdy, AM_BSP_GPIO_MAG_INT);
+    am_hal_gpio_interrupt_disable(mask_drdy);
+    am_hal_gpio_interrupt_clear(mask_drdy);
 }
 
 void mag_calibrate_step(mag_context_t *context, mag_cal_t *cal_data)
@@ -158,4 +366,45 @@ void mag_calibrate_step(mag_context_t *context, mag_cal_t *cal_data)
     cal_data->sx = max_range / xrange;
     cal_data->sy = max_range / yrange;
     cal_data->sz = max_range / zrange;
+
+    mag_cal_from_range(cal_data);
+}
+
+void mag_cal_reset(mag_cal_t *cal_data)
+{
+    cal_data->ox = 0.0f;
+    cal_data->oy = 0.0f;
+    cal_data->oz = 0.0f;
+
+    cal_data->sx = 1.0f;
+    cal_data->sy = 1.0f;
+    cal_data->sz = 1.0f;
+
+    mag_cal_from_range(cal_data);
+}
+
+void mag_cal_from_range(mag_cal_t *cal_data)
+{
+    memset(cal_data->transform, 0, sizeof(cal_data->transform));
+
+    cal_data->transform[0][0] = cal_data->sx;
+    cal_data->transform[1][1] = cal_data->sy;
+    cal_data->transform[2][2] = cal_data->sz;
+    cal_data->transform[0][3] = -cal_data->sx * cal_data->ox;
+    cal_data->transform[1][3] = -cal_data->sy * cal_data->oy;
+    cal_data->transform[2][3] = -cal_data->sz * cal_data->oz;
+
+    cal_data->source = MAG_CAL_SOURCE_RANGE;
+}
+
+void mag_cal_apply(const mag_cal_t *cal_data, mag_context_t *context)
+{
+    const float_t (*t)[4] = cal_data->transform;
+    float_t mx = context->mx;
+    float_t my = context->my;
+    float_t mz = context->mz;
+
+    context->mx = t[0][0] * mx + t[0][1] * my + t[0][2] * mz + t[0][3];
+    context->my = t[1][0] * mx + t[1][1] * my + t[1][2] * mz + t[1][3];
+    context->mz = t[2][0] * mx + t[2][1] * my + t[2][2] * mz + t[2][3];
 }
\ No newline at end of file
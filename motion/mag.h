@@ -33,9 +33,16 @@
 #define _MAG_H_
 
 #include <math.h>
+#include <stddef.h>
 #include <bmm350.h>
 #include <bmm350_hal.h>
 
+#include <am_mcu_apollo.h>
+
+// The magnetometer is configured for a 100Hz ODR by mag_setup().
+// mag_set_rate() changes it.
+#define MAG_ODR_PERIOD_US (10000)
+
 typedef enum mag_status_e
 {
     MAG_STATUS_OK,
@@ -44,10 +51,25 @@ typedef enum mag_status_e
 
 typedef struct mag_context_s
 {
-    uint32_t timestamp;
+    uint64_t timestamp;     // microseconds on the MCU timebase
+    uint32_t sensortime;    // raw BMM350 sensor time (24 bits)
+    uint32_t dropped;       // samples missed immediately before this one
     float_t mx, my, mz;
 } mag_context_t;
 
+// Where the correction in a mag_cal_t came from.
+#define MAG_CAL_SOURCE_RANGE        (0)
+#define MAG_CAL_SOURCE_ELLIPSOID    (1)
+
+/*
+ * The correction applied to a raw sample m is the affine transform
+ *
+ *   m' = transform[0..2][0..2] * m + transform[0..2][3]
+ *
+ * i.e. the soft iron matrix W applied after removing the hard iron offset
+ * o, with the last column holding -W * o.  The offsets, scales and ranges
+ * are those of the min/max procedure, which only fills the diagonal of W.
+ */
 typedef struct mag_cal_s
 {
     uint32_t initialised;
@@ -55,10 +77,27 @@ typedef struct mag_cal_s
     float_t sx, sy, sz;
     float_t mx_max, my_max, mz_max;
     float_t mx_min, my_min, mz_min;
+    uint32_t source;
+    float_t transform[3][4];
 } mag_cal_t;
 
+// Size of the first layout, which only had the min/max fields.
+#define MAG_CAL_V1_SIZE             (offsetof(mag_cal_t, source))
+
 extern mag_status_t mag_setup(struct bmm350_dev *bmm);
-extern void mag_sample(struct bmm350_dev *bmm, mag_context_t *context);
+extern mag_status_t mag_sample(struct bmm350_dev *bmm, mag_context_t *context);
+extern mag_status_t mag_sample_start(struct bmm350_dev *bmm);
+extern mag_status_t mag_sample_finish(struct bmm350_dev *bmm, mag_context_t *context);
+extern void mag_timebase_start(struct bmm350_dev *bmm, uint32_t period_us);
+extern mag_status_t mag_set_rate(struct bmm350_dev *bmm, enum bmm350_data_rates odr, enum bmm350_performance_parameters avg);
+
+extern mag_status_t mag_drdy_setup(struct bmm350_dev *bmm);
+extern void mag_drdy_register(struct bmm350_dev *bmm, am_hal_gpio_handler_t handler);
+extern void mag_drdy_enable(struct bmm350_dev *bmm);
+extern void mag_drdy_disable(struct bmm350_dev *bmm);
 extern void mag_calibrate_step(mag_context_t *context, mag_cal_t *cal_data);
+extern void mag_cal_reset(mag_cal_t *cal_data);
+extern void mag_cal_from_range(mag_cal_t *cal_data);
+extern void mag_cal_apply(const mag_cal_t *cal_data, mag_context_t *context);
 
 #endif
\ No newline at end of file
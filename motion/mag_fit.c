@@ -0,0 +1,283 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <arm_math.h>
+
+#include "mag.h"
+#include "mag_fit.h"
+
+// Initial covariance.  Large compared with the parameters, which are of
+// order one at MAG_FIT_SCALE.
+#define MAG_FIT_P0              (100.0f)
+
+// Weight of a new residual in the running fit error.
+#define MAG_FIT_ERROR_WEIGHT    (0.02f)
+
+#define MAG_FIT_JACOBI_SWEEPS   (8)
+
+void mag_fit_init(mag_fit_t *fit)
+{
+    memset(fit, 0, sizeof(mag_fit_t));
+
+    for (uint32_t i = 0; i < MAG_FIT_PARAMETERS; i++)
+    {
+        fit->p[i][i] = MAG_FIT_P0;
+    }
+    fit->error = 1.0f;
+}
+
+bool mag_fit_step(mag_fit_t *fit, const mag_context_t *context)
+{
+    float32_t phi[MAG_FIT_PARAMETERS];
+    float32_t u[MAG_FIT_PARAMETERS];
+
+    float32_t dx = context->mx - fit->last[0];
+    float32_t dy = context->my - fit->last[1];
+    float32_t dz = context->mz - fit->last[2];
+    if (dx * dx + dy * dy + dz * dz < MAG_FIT_MIN_STEP * MAG_FIT_MIN_STEP)
+    {
+        return false;
+    }
+
+    fit->last[0] = context->mx;
+    fit->last[1] = context->my;
+    fit->last[2] = context->mz;
+
+    float32_t x = context->mx / MAG_FIT_SCALE;
+    float32_t y = context->my / MAG_FIT_SCALE;
+    float32_t z = context->mz / MAG_FIT_SCALE;
+
+    phi[0] = x * x;
+    phi[1] = y * y;
+    phi[2] = z * z;
+    phi[3] = 2.0f * x * y;
+    phi[4] = 2.0f * x * z;
+    phi[5] = 2.0f * y * z;
+    phi[6] = 2.0f * x;
+    phi[7] = 2.0f * y;
+    phi[8] = 2.0f * z;
+
+    // u = P * phi, and P is kept symmetric so phi' * P = u'.
+    float32_t denominator = MAG_FIT_LAMBDA;
+    float32_t error = 1.0f;
+    for (uint32_t i = 0; i < MAG_FIT_PARAMETERS; i++)
+    {
+        float32_t sum = 0.0f;
+        for (uint32_t j = 0; j < MAG_FIT_PARAMETERS; j++)
+        {
+            sum += fit->p[i][j] * phi[j];
+        }
+        u[i] = sum;
+        denominator += phi[i] * sum;
+        error -= phi[i] * fit->theta[i];
+    }
+
+    float32_t gain = 1.0f / denominator;
+    for (uint32_t i = 0; i < MAG_FIT_PARAMETERS; i++)
+    {
+        fit->theta[i] += u[i] * gain * error;
+    }
+
+    // P = (P - u * u' / denominator) / lambda, one triangle mirrored.
+    float32_t forget = 1.0f / MAG_FIT_LAMBDA;
+    for (uint32_t i = 0; i < MAG_FIT_PARAMETERS; i++)
+    {
+        float32_t ui = u[i] * gain;
+        for (uint32_t j = i; j < MAG_FIT_PARAMETERS; j++)
+        {
+            float32_t value = (fit->p[i][j] - ui * u[j]) * forget;
+            fit->p[i][j] = value;
+            fit->p[j][i] = value;
+        }
+    }
+
+    fit->error += MAG_FIT_ERROR_WEIGHT * (error * error - fit->error);
+    fit->samples++;
+
+    return true;
+}
+
+/*
+ * Cyclic Jacobi eigen decomposition of a symmetric 3x3 matrix.  a is
+ * destroyed, its diagonal left holding the eigenvalues, and the columns of
+ * v are the eigenvectors.
+ */
+static void mag_fit_jacobi(float32_t a[3][3], float32_t v[3][3])
+{
+    memset(v, 0, 9 * sizeof(float32_t));
+    v[0][0] = v[1][1] = v[2][2] = 1.0f;
+
+    for (uint32_t sweep = 0; sweep < MAG_FIT_JACOBI_SWEEPS; sweep++)
+    {
+        for (uint32_t p = 0; p < 2; p++)
+        {
+            for (uint32_t q = p + 1; q < 3; q++)
+            {
+                if (fabsf(a[p][q]) < 1e-12f)
+                {
+                    continue;
+                }
+
+                float32_t theta = (a[q][q] - a[p][p]) / (2.0f * a[p][q]);
+                float32_t t = (theta >= 0.0f ? 1.0f : -1.0f) / (fabsf(theta) + sqrtf(theta * theta + 1.0f));
+                float32_t c = 1.0f / sqrtf(t * t + 1.0f);
+                float32_t s = t * c;
+
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    float32_t akp = a[k][p];
+                    float32_t akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    float32_t apk = a[p][k];
+                    float32_t aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    float32_t vkp = v[k][p];
+                    float32_t vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+bool mag_fit_solve(const mag_fit_t *fit, mag_cal_t *cal_data)
+{
+    const float32_t *theta = fit->theta;
+    float32_t a[3][3] = {
+        { theta[0], theta[3], theta[4] },
+        { theta[3], theta[1], theta[5] },
+        { theta[4], theta[5], theta[2] },
+    };
+    float32_t v[3][3];
+    float32_t lambda[3];
+    float32_t offset[3];
+    float32_t w[3][3];
+
+    if ((fit->samples < MAG_FIT_MIN_SAMPLES) || (fit->error > MAG_FIT_MAX_ERROR * MAG_FIT_MAX_ERROR))
+    {
+        return false;
+    }
+
+    mag_fit_jacobi(a, v);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        lambda[i] = a[i][i];
+        if (lambda[i] == 0.0f)
+        {
+            return false;
+        }
+    }
+
+    // Centre o = -A^-1 * (g, h, i), with A^-1 = V * diag(1 / lambda) * V'.
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        float32_t sum = 0.0f;
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            float32_t projection = v[0][k] * theta[6] + v[1][k] * theta[7] + v[2][k] * theta[8];
+            sum += v[i][k] * projection / lambda[k];
+        }
+        offset[i] = -sum;
+    }
+
+    // (m - o)' A (m - o) = 1 + o' A o, so the normalised ellipsoid matrix
+    // is A / k and its semi-axes are 1 / sqrt(lambda / k).  A and k are
+    // both negative when the offset is larger than the field, so only
+    // their ratio has to be positive.
+    float32_t k = 1.0f;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        float32_t projection = v[0][i] * offset[0] + v[1][i] * offset[1] + v[2][i] * offset[2];
+        k += lambda[i] * projection * projection;
+    }
+
+    float32_t radius = 1.0f;
+    float32_t root[3];
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        if (lambda[i] / k <= 0.0f)
+        {
+            return false;
+        }
+        root[i] = sqrtf(lambda[i] / k);
+        radius /= root[i];
+    }
+    radius = cbrtf(radius);
+
+    float32_t field = radius * MAG_FIT_SCALE;
+    if ((field < MAG_FIT_FIELD_MIN) || (field > MAG_FIT_FIELD_MAX))
+    {
+        return false;
+    }
+
+    // W = radius * V * diag(sqrt(lambda / k)) * V'.  The scaling of the
+    // inputs cancels: W (m / S - o) = W (m - S o) / S, in units of S.
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            float32_t sum = 0.0f;
+            for (uint32_t n = 0; n < 3; n++)
+            {
+                sum += v[i][n] * root[n] * v[j][n];
+            }
+            w[i][j] = radius * sum;
+        }
+    }
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        float32_t shift = 0.0f;
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            cal_data->transform[i][j] = w[i][j];
+            shift += w[i][j] * offset[j] * MAG_FIT_SCALE;
+        }
+        cal_data->transform[i][3] = -shift;
+    }
+    cal_data->source = MAG_CAL_SOURCE_ELLIPSOID;
+
+    return true;
+}
@@ -0,0 +1,98 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _MAG_FIT_H_
+#define _MAG_FIT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <arm_math.h>
+
+#include "mag.h"
+
+#define MAG_FIT_PARAMETERS      (9)
+
+// Inputs are divided by this, in uT, to keep the regressor near unity.
+#define MAG_FIT_SCALE           (50.0f)
+
+// Forgetting factor.  The fit follows changes over roughly 1 / (1 - lambda)
+// accepted samples.
+#define MAG_FIT_LAMBDA          (0.998f)
+
+// A sample is only accepted once the field has moved this far, in uT,
+// from the last accepted one, so that a stationary device does not wind
+// the covariance up.
+#define MAG_FIT_MIN_STEP        (4.0f)
+
+// A solution needs this many accepted samples and a fit error below
+// MAG_FIT_MAX_ERROR, the RMS of the ellipsoid equation residual.
+#define MAG_FIT_MIN_SAMPLES     (150)
+#define MAG_FIT_MAX_ERROR       (0.05f)
+
+// Plausible range of the geomagnetic field magnitude in uT.
+#define MAG_FIT_FIELD_MIN       (15.0f)
+#define MAG_FIT_FIELD_MAX       (100.0f)
+
+/*
+ * Recursive least squares fit of the ellipsoid
+ *
+ *   a x^2 + b y^2 + c z^2 + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1
+ *
+ * to raw magnetometer samples.  The state is the parameter vector and its
+ * 9x9 covariance, whatever the number of samples.
+ */
+typedef struct mag_fit_s
+{
+    float32_t theta[MAG_FIT_PARAMETERS];
+    float32_t p[MAG_FIT_PARAMETERS][MAG_FIT_PARAMETERS];
+    float32_t last[3];
+    uint32_t samples;
+    float32_t error;
+} mag_fit_t;
+
+extern void mag_fit_init(mag_fit_t *fit);
+
+/*
+ * Adds a raw sample in uT.  Returns true if it was accepted.
+ */
+extern bool mag_fit_step(mag_fit_t *fit, const mag_context_t *context);
+
+/*
+ * Turns the current fit into a correction.  The soft iron matrix is the
+ * symmetric square root of the ellipsoid matrix, scaled so that corrected
+ * samples have the geometric mean radius of the ellipsoid as magnitude.
+ * Only the correction and source of cal_data are changed.  Returns false if
+ * there is no usable solution yet.
+ */
+extern bool mag_fit_solve(const mag_fit_t *fit, mag_cal_t *cal_data);
+
+#endif
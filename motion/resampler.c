@@ -0,0 +1,285 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <arm_math.h>
+
+#include "imu.h"
+#include "mag.h"
+#include "resampler.h"
+
+// Lagrange coefficients for samples at -1, 0, 1 and 2 with the output at
+// phase / RESAMPLER_PHASES between samples 0 and 1.  The last phase is the
+// next sample so that rounding the fractional delay never wraps.
+static float32_t resampler_taps[RESAMPLER_PHASES + 1][4];
+static bool resampler_taps_ready;
+
+static void resampler_taps_init(void)
+{
+    for (uint32_t p = 0; p <= RESAMPLER_PHASES; p++)
+    {
+        float32_t mu = (float32_t)p / RESAMPLER_PHASES;
+
+        resampler_taps[p][0] = -mu * (mu - 1.0f) * (mu - 2.0f) / 6.0f;
+        resampler_taps[p][1] = (mu + 1.0f) * (mu - 1.0f) * (mu - 2.0f) / 2.0f;
+        resampler_taps[p][2] = -(mu + 1.0f) * mu * (mu - 2.0f) / 2.0f;
+        resampler_taps[p][3] = (mu + 1.0f) * mu * (mu - 1.0f) / 6.0f;
+    }
+    resampler_taps_ready = true;
+}
+
+// Sample i of the history, 0 being the oldest.
+static inline resampler_imu_sample_t *resampler_imu(resampler_t *resampler, uint32_t i)
+{
+    return &resampler->imu[(resampler->imu_head + RESAMPLER_IMU_HISTORY - resampler->imu_count + i) % RESAMPLER_IMU_HISTORY];
+}
+
+static inline resampler_mag_sample_t *resampler_mag(resampler_t *resampler, uint32_t i)
+{
+    return &resampler->mag[(resampler->mag_head + RESAMPLER_MAG_HISTORY - resampler->mag_count + i) % RESAMPLER_MAG_HISTORY];
+}
+
+// First output grid point at or after the timestamp.
+static inline uint64_t resampler_grid(const resampler_t *resampler, uint64_t timestamp)
+{
+    return ((timestamp + resampler->period_us - 1) / resampler->period_us) * resampler->period_us;
+}
+
+void resampler_init(resampler_t *resampler, uint32_t rate_hz, uint32_t mag_mode)
+{
+    if (!resampler_taps_ready)
+    {
+        resampler_taps_init();
+    }
+
+    resampler->period_us = 1000000 / rate_hz;
+    resampler->mag_mode = mag_mode;
+    resampler_reset(resampler);
+}
+
+void resampler_reset(resampler_t *resampler)
+{
+    resampler->next = 0;
+    resampler->started = false;
+    resampler->imu_head = 0;
+    resampler->imu_count = 0;
+    resampler->mag_head = 0;
+    resampler->mag_count = 0;
+}
+
+void resampler_push_imu(resampler_t *resampler, const imu_context_t *frames, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // Samples have to be in time order.
+        if (resampler->imu_count &&
+            (frames[i].timestamp <= resampler_imu(resampler, resampler->imu_count - 1)->timestamp))
+        {
+            continue;
+        }
+
+        resampler_imu_sample_t *sample = &resampler->imu[resampler->imu_head];
+        sample->timestamp = frames[i].timestamp;
+        sample->acc[0] = imu_lsb_to_mps2(&frames[i], frames[i].ax);
+        sample->acc[1] = imu_lsb_to_mps2(&frames[i], frames[i].ay);
+        sample->acc[2] = imu_lsb_to_mps2(&frames[i], frames[i].az);
+        sample->gyr[0] = imu_lsb_to_rps(&frames[i], frames[i].gx);
+        sample->gyr[1] = imu_lsb_to_rps(&frames[i], frames[i].gy);
+        sample->gyr[2] = imu_lsb_to_rps(&frames[i], frames[i].gz);
+
+        resampler->imu_head = (resampler->imu_head + 1) % RESAMPLER_IMU_HISTORY;
+        if (resampler->imu_count < RESAMPLER_IMU_HISTORY)
+        {
+            resampler->imu_count++;
+        }
+    }
+}
+
+void resampler_push_mag(resampler_t *resampler, const mag_context_t *mag_context)
+{
+    // A polled magnetometer returns the same sample until the next one is
+    // ready.  Only new samples are kept.
+    if (resampler->mag_count &&
+        (mag_context->timestamp <= resampler_mag(resampler, resampler->mag_count - 1)->timestamp))
+    {
+        return;
+    }
+
+    resampler_mag_sample_t *sample = &resampler->mag[resampler->mag_head];
+    sample->timestamp = mag_context->timestamp;
+    sample->mag[0] = mag_context->mx;
+    sample->mag[1] = mag_context->my;
+    sample->mag[2] = mag_context->mz;
+
+    resampler->mag_head = (resampler->mag_head + 1) % RESAMPLER_MAG_HISTORY;
+    if (resampler->mag_count < RESAMPLER_MAG_HISTORY)
+    {
+        resampler->mag_count++;
+    }
+}
+
+// Magnetometer value at time t.  Returns false if the output has to wait
+// for more magnetometer samples.
+static bool resampler_mag_interpolate(resampler_t *resampler, uint64_t t, uint64_t now, float32_t mag[3])
+{
+    bool timeout = (now - t) > RESAMPLER_MAG_TIMEOUT_US;
+
+    if (resampler->mag_count == 0)
+    {
+        if (!timeout)
+        {
+            return false;
+        }
+        memset(mag, 0, 3 * sizeof(float32_t));
+        return true;
+    }
+
+    const resampler_mag_sample_t *newest = resampler_mag(resampler, resampler->mag_count - 1);
+    if (t >= newest->timestamp)
+    {
+        if ((t > newest->timestamp) && !timeout)
+        {
+            return false;
+        }
+        memcpy(mag, newest->mag, 3 * sizeof(float32_t));
+        return true;
+    }
+
+    const resampler_mag_sample_t *oldest = resampler_mag(resampler, 0);
+    if (t <= oldest->timestamp)
+    {
+        memcpy(mag, oldest->mag, 3 * sizeof(float32_t));
+        return true;
+    }
+
+    uint32_t j = resampler->mag_count - 2;
+    while (resampler_mag(resampler, j)->timestamp > t)
+    {
+        j--;
+    }
+
+    const resampler_mag_sample_t *a = resampler_mag(resampler, j);
+    const resampler_mag_sample_t *b = resampler_mag(resampler, j + 1);
+    float32_t mu = (float32_t)(t - a->timestamp) / (float32_t)(b->timestamp - a->timestamp);
+
+    if ((resampler->mag_mode == RESAMPLER_MAG_POLYPHASE) && (j >= 1))
+    {
+        if (j + 2 < resampler->mag_count)
+        {
+            // The magnetometer samples are assumed to be evenly spaced
+            // around t, which holds to within the ODR jitter.
+            const float32_t *taps = resampler_taps[(uint32_t)(mu * RESAMPLER_PHASES + 0.5f)];
+            const resampler_mag_sample_t *before = resampler_mag(resampler, j - 1);
+            const resampler_mag_sample_t *after = resampler_mag(resampler, j + 2);
+
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                mag[k] = taps[0] * before->mag[k] + taps[1] * a->mag[k] +
+                    taps[2] * b->mag[k] + taps[3] * after->mag[k];
+            }
+            return true;
+        }
+
+        if (!timeout)
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t k = 0; k < 3; k++)
+    {
+        mag[k] = a->mag[k] + mu * (b->mag[k] - a->mag[k]);
+    }
+    return true;
+}
+
+uint32_t resampler_pull(resampler_t *resampler, resampler_frame_t *frames, uint32_t max_frames)
+{
+    uint32_t n = 0;
+
+    if (resampler->imu_count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t oldest = resampler_imu(resampler, 0)->timestamp;
+    uint64_t newest = resampler_imu(resampler, resampler->imu_count - 1)->timestamp;
+
+    // Start on, or skip samples lost from the history to, the first grid
+    // point covered by the IMU samples.
+    if (!resampler->started || (resampler->next < oldest))
+    {
+        resampler->next = resampler_grid(resampler, oldest);
+        resampler->started = true;
+    }
+
+    while ((n < max_frames) && (resampler->next <= newest))
+    {
+        uint64_t t = resampler->next;
+
+        uint32_t i = resampler->imu_count - 1;
+        while (resampler_imu(resampler, i)->timestamp > t)
+        {
+            i--;
+        }
+
+        const resampler_imu_sample_t *a = resampler_imu(resampler, i);
+        const resampler_imu_sample_t *b = (a->timestamp == t) ? a : resampler_imu(resampler, i + 1);
+
+        if ((b->timestamp - a->timestamp) > RESAMPLER_MAX_GAP_US)
+        {
+            resampler->next = resampler_grid(resampler, b->timestamp);
+            continue;
+        }
+
+        resampler_frame_t *frame = &frames[n];
+        if (!resampler_mag_interpolate(resampler, t, newest, frame->mag))
+        {
+            break;
+        }
+
+        float32_t mu = (b == a) ? 0.0f : (float32_t)(t - a->timestamp) / (float32_t)(b->timestamp - a->timestamp);
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            frame->acc[k] = a->acc[k] + mu * (b->acc[k] - a->acc[k]);
+            frame->gyr[k] = a->gyr[k] + mu * (b->gyr[k] - a->gyr[k]);
+        }
+        frame->timestamp = t;
+
+        resampler->next += resampler->period_us;
+        n++;
+    }
+
+    return n;
+}
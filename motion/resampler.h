@@ -0,0 +1,121 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _RESAMPLER_H_
+#define _RESAMPLER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <arm_math.h>
+
+#include "imu.h"
+#include "mag.h"
+
+// Magnetometer interpolation.  The polyphase interpolator uses a 4 tap
+// Lagrange filter and adds one more magnetometer period of latency.
+#define RESAMPLER_MAG_LINEAR    0
+#define RESAMPLER_MAG_POLYPHASE 1
+
+// Samples kept for interpolation.  The IMU history has to cover the time
+// spent waiting for the magnetometer samples that bracket an output frame,
+// i.e. two magnetometer periods at the highest IMU rate.
+#define RESAMPLER_IMU_HISTORY   (64)
+#define RESAMPLER_MAG_HISTORY   (8)
+
+// Number of fractional delays in the polyphase filter table.  The output
+// time is rounded to the nearest phase, i.e. to within 1 / (2 * phases) of
+// a magnetometer period.
+#define RESAMPLER_PHASES        (128)
+
+// Output frames are not held back for the magnetometer for longer than
+// this.  The latest magnetometer sample is used instead so that a stalled
+// magnetometer does not stall the IMU.
+#define RESAMPLER_MAG_TIMEOUT_US    (50000)
+
+// IMU gaps longer than this, e.g. across a pause in sampling, are skipped
+// instead of being interpolated across.
+#define RESAMPLER_MAX_GAP_US        (100000)
+
+// A time aligned IMU and magnetometer frame.
+typedef struct resampler_frame_s
+{
+    uint64_t timestamp;     // microseconds on the MCU timebase
+    float32_t acc[3];       // m/s^2
+    float32_t gyr[3];       // rad/s
+    float32_t mag[3];       // uT, magnetometer axes
+} resampler_frame_t;
+
+typedef struct resampler_imu_sample_s
+{
+    uint64_t timestamp;
+    float32_t acc[3];
+    float32_t gyr[3];
+} resampler_imu_sample_t;
+
+typedef struct resampler_mag_sample_s
+{
+    uint64_t timestamp;
+    float32_t mag[3];
+} resampler_mag_sample_t;
+
+/*
+ * Produces frames on a uniform output grid from the IMU and magnetometer
+ * streams.  Both streams are placed on the grid using their own sample
+ * timestamps, so each sensor can be read at its own rate.  The IMU
+ * channels are interpolated linearly.  Output frames are emitted once both
+ * streams have samples on either side of the frame, so the output lags
+ * the newest magnetometer sample by up to one (linear) or two
+ * (polyphase) magnetometer periods.
+ */
+typedef struct resampler_s
+{
+    uint32_t period_us;
+    uint32_t mag_mode;
+    uint64_t next;
+    bool started;
+
+    resampler_imu_sample_t imu[RESAMPLER_IMU_HISTORY];
+    uint32_t imu_head;
+    uint32_t imu_count;
+
+    resampler_mag_sample_t mag[RESAMPLER_MAG_HISTORY];
+    uint32_t mag_head;
+    uint32_t mag_count;
+} resampler_t;
+
+extern void resampler_init(resampler_t *resampler, uint32_t rate_hz, uint32_t mag_mode);
+extern void resampler_reset(resampler_t *resampler);
+extern void resampler_push_imu(resampler_t *resampler, const imu_context_t *frames, uint32_t count);
+extern void resampler_push_mag(resampler_t *resampler, const mag_context_t *mag_context);
+extern uint32_t resampler_pull(resampler_t *resampler, resampler_frame_t *frames, uint32_t max_frames);
+
+#endif
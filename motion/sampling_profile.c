@@ -0,0 +1,128 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sampling_profile.h"
+
+static const char *sampling_profile_names[SAMPLING_PROFILE_COUNT] = {
+    [SAMPLING_PROFILE_IDLE] = "idle",
+    [SAMPLING_PROFILE_NORMAL] = "normal",
+    [SAMPLING_PROFILE_BURST] = "burst",
+};
+
+static bool sampling_profile_evaluate(sampling_profile_t *sp, uint64_t now_us)
+{
+    sampling_profile_id_t target = sp->moving ? SAMPLING_PROFILE_NORMAL : SAMPLING_PROFILE_IDLE;
+
+    if (sp->requests || (now_us < sp->hold_until_us))
+    {
+        target = SAMPLING_PROFILE_BURST;
+    }
+
+    if (target < sp->floor)
+    {
+        target = sp->floor;
+    }
+
+    if (target == sp->current)
+    {
+        return false;
+    }
+
+    sp->current = target;
+    return true;
+}
+
+void sampling_profile_init(sampling_profile_t *sp, sampling_profile_id_t initial, uint32_t hold_us)
+{
+    sp->current = initial;
+    sp->floor = SAMPLING_PROFILE_IDLE;
+    sp->moving = (initial != SAMPLING_PROFILE_IDLE);
+    sp->requests = 0;
+    sp->hold_us = hold_us;
+    sp->hold_until_us = 0;
+}
+
+bool sampling_profile_event(sampling_profile_t *sp, uint32_t events, uint64_t now_us)
+{
+    // A sample may carry more than one event if the status was read late.
+    // Motion takes precedence over no motion.
+    if (events & SAMPLING_EVENT_NO_MOTION)
+    {
+        sp->moving = false;
+    }
+
+    if (events & (SAMPLING_EVENT_ANY_MOTION | SAMPLING_EVENT_SIG_MOTION))
+    {
+        sp->moving = true;
+    }
+
+    if (events & SAMPLING_EVENT_SIG_MOTION)
+    {
+        sp->hold_until_us = now_us + sp->hold_us;
+    }
+
+    return sampling_profile_evaluate(sp, now_us);
+}
+
+bool sampling_profile_request(sampling_profile_t *sp, uint32_t requester, bool active, uint64_t now_us)
+{
+    if (active)
+    {
+        sp->requests |= requester;
+    }
+    else if (sp->requests & requester)
+    {
+        sp->requests &= ~requester;
+        sp->hold_until_us = now_us + sp->hold_us;
+    }
+
+    return sampling_profile_evaluate(sp, now_us);
+}
+
+bool sampling_profile_set_floor(sampling_profile_t *sp, sampling_profile_id_t floor, uint64_t now_us)
+{
+    sp->floor = floor;
+
+    return sampling_profile_evaluate(sp, now_us);
+}
+
+bool sampling_profile_update(sampling_profile_t *sp, uint64_t now_us)
+{
+    return sampling_profile_evaluate(sp, now_us);
+}
+
+const char *sampling_profile_name(sampling_profile_id_t id)
+{
+    return (id < SAMPLING_PROFILE_COUNT) ? sampling_profile_names[id] : "unknown";
+}
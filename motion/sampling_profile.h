@@ -0,0 +1,88 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _SAMPLING_PROFILE_H_
+#define _SAMPLING_PROFILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Profiles are ordered from the lowest to the highest sampling rate.
+typedef enum sampling_profile_id_e
+{
+    SAMPLING_PROFILE_IDLE,
+    SAMPLING_PROFILE_NORMAL,
+    SAMPLING_PROFILE_BURST,
+    SAMPLING_PROFILE_COUNT
+} sampling_profile_id_t;
+
+// Motion events reported by the IMU feature engine.
+#define SAMPLING_EVENT_NO_MOTION    (1 << 0)
+#define SAMPLING_EVENT_ANY_MOTION   (1 << 1)
+#define SAMPLING_EVENT_SIG_MOTION   (1 << 2)
+
+typedef struct sampling_profile_s
+{
+    sampling_profile_id_t current;
+    sampling_profile_id_t floor;
+    bool moving;
+    uint32_t requests;
+    uint32_t hold_us;
+    uint64_t hold_until_us;
+} sampling_profile_t;
+
+/*
+ * The profile engine picks the acquisition profile from the motion state
+ * and from burst requests made by the algorithms.  It does not touch the
+ * sensors itself.  Every call returns true when the current profile has
+ * changed and the caller should reconfigure the sensors.
+ *
+ * - No motion drops to the idle profile and any motion raises it back to
+ *   the normal profile.
+ * - Significant motion, or any algorithm holding a request, raises it to
+ *   the burst profile.  A burst is held for hold_us after the last request
+ *   is released so that the tail of a transient is captured too.
+ * - The floor keeps the profile from dropping below a given level, e.g.
+ *   during calibration or when sampling is forced on.
+ *
+ * now_us is on the same timebase as the sample timestamps.  The hold is
+ * only evaluated when the engine is called, so sampling_profile_update()
+ * should be called on every sample or batch.
+ */
+extern void sampling_profile_init(sampling_profile_t *sp, sampling_profile_id_t initial, uint32_t hold_us);
+extern bool sampling_profile_event(sampling_profile_t *sp, uint32_t events, uint64_t now_us);
+extern bool sampling_profile_request(sampling_profile_t *sp, uint32_t requester, bool active, uint64_t now_us);
+extern bool sampling_profile_set_floor(sampling_profile_t *sp, sampling_profile_id_t floor, uint64_t now_us);
+extern bool sampling_profile_update(sampling_profile_t *sp, uint64_t now_us);
+
+extern const char *sampling_profile_name(sampling_profile_id_t id);
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <am_mcu_apollo.h>
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+#include <timers.h>
+
+#include "sensors_config.h"
+#include "sensor_bus.h"
+
+typedef struct sensor_bus_s
+{
+    TaskHandle_t task;
+    uint32_t notify_bit;
+    volatile bool pending;
+    volatile uint32_t status;
+
+    sensor_bus_handler_t open;
+    sensor_bus_handler_t close;
+    void *arg;
+    SemaphoreHandle_t mutex;
+    TimerHandle_t idle_timer;
+    bool powered;
+} sensor_bus_t;
+
+static sensor_bus_t sensor_bus[SENSOR_BUS_MAX] = {
+    [SENSOR_BUS_IMU] = {.notify_bit = (1 << 0)},
+    [SENSOR_BUS_MAG] = {.notify_bit = (1 << 1)},
+};
+
+static void sensor_bus_close(sensor_bus_t *bus)
+{
+    if (bus->powered)
+    {
+        bus->close(bus->arg);
+        bus->powered = false;
+    }
+}
+
+static void sensor_bus_idle(TimerHandle_t timer)
+{
+    sensor_bus_t *bus = (sensor_bus_t *)pvTimerGetTimerID(timer);
+
+    // The timer service task must not block.  If the bus is busy the
+    // current owner re-arms the timer on release.
+    if (xSemaphoreTake(bus->mutex, 0) == pdTRUE)
+    {
+        sensor_bus_close(bus);
+        xSemaphoreGive(bus->mutex);
+    }
+}
+
+void sensor_bus_setup(sensor_bus_id_t id,
+                      sensor_bus_handler_t open,
+                      sensor_bus_handler_t close,
+                      void *arg)
+{
+    sensor_bus_t *bus = &sensor_bus[id];
+
+    bus->open = open;
+    bus->close = close;
+    bus->arg = arg;
+    bus->powered = false;
+
+    // A mutex rather than a binary semaphore so that the owner inherits the
+    // priority of the highest priority waiter.  Waiters are queued in
+    // priority order by the kernel.
+    if (bus->mutex == NULL)
+    {
+        bus->mutex = xSemaphoreCreateMutex();
+    }
+
+#if SENSORS_BUS_IDLE_TIMEOUT_MS > 0
+    if (bus->idle_timer == NULL)
+    {
+        bus->idle_timer = xTimerCreate("Sensor Bus Timer",
+                                       pdMS_TO_TICKS(SENSORS_BUS_IDLE_TIMEOUT_MS),
+                                       pdFALSE,
+                                       bus,
+                                       sensor_bus_idle);
+    }
+#endif
+}
+
+bool sensor_bus_acquire(sensor_bus_id_t id)
+{
+    sensor_bus_t *bus = &sensor_bus[id];
+
+    if (xSemaphoreTake(bus->mutex, pdMS_TO_TICKS(SENSORS_BUS_LOCK_TIMEOUT_MS)) != pdTRUE)
+    {
+        return false;
+    }
+
+    if (bus->idle_timer)
+    {
+        xTimerStop(bus->idle_timer, 0);
+    }
+
+    if (!bus->powered)
+    {
+        bus->open(bus->arg);
+        bus->powered = true;
+    }
+
+    return true;
+}
+
+void sensor_bus_release(sensor_bus_id_t id)
+{
+    sensor_bus_t *bus = &sensor_bus[id];
+
+    if (bus->idle_timer)
+    {
+        xTimerReset(bus->idle_timer, 0);
+    }
+    else
+    {
+        sensor_bus_close(bus);
+    }
+
+    xSemaphoreGive(bus->mutex);
+}
+
+void sensor_bus_shutdown(sensor_bus_id_t id)
+{
+    sensor_bus_t *bus = &sensor_bus[id];
+
+    xSemaphoreTake(bus->mutex, portMAX_DELAY);
+    if (bus->idle_timer)
+    {
+        xTimerStop(bus->idle_timer, 0);
+    }
+    sensor_bus_close(bus);
+    xSemaphoreGive(bus->mutex);
+}
+
+void sensor_bus_begin(sensor_bus_id_t id)
+{
+    sensor_bus_t *bus = &sensor_bus[id];
+
+    bus->task = xTaskGetCurrentTaskHandle();
+    bus->status = AM_HAL_STATUS_SUCCESS;
+    bus->pending = true;
+}
+
+void *sensor_bus_context(sensor_bus_id_t id)
+{
+    return &sensor_bus[id];
+}
+
+void sensor_bus_complete(void *context, uint32_t status)
+{
+    sensor_bus_t *bus = (sensor_bus_t *)context;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    bus->status = status;
+    bus->pending = false;
+
+    xTaskNotifyFromISR(bus->task, bus->notify_bit, eSetBits, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+uint32_t sensor_bus_wait(sensor_bus_id_t id)
+{
+    sensor_bus_t *bus = &sensor_bus[id];
+
+    // Each bus owns one notification bit so that a completion on one IOM
+    // is never consumed by a task waiting on the other.  A bit left over
+    // from an earlier transfer is dropped, pending decides when this one
+    // is done.
+    xTaskNotifyWait(0, bus->notify_bit, NULL, 0);
+
+    while (bus->pending)
+    {
+        if (xTaskNotifyWait(0, bus->notify_bit, NULL, pdMS_TO_TICKS(SENSOR_BUS_TIMEOUT_MS)) == pdFALSE)
+        {
+            if (bus->pending)
+            {
+                // The transfer may still be running.  Power cycling the
+                // interface aborts it so that it can neither write into
+                // the buffer nor complete the next transfer.  The caller
+                // holds the bus.
+                bus->close(bus->arg);
+                bus->open(bus->arg);
+                bus->pending = false;
+                return AM_HAL_STATUS_TIMEOUT;
+            }
+        }
+    }
+
+    return bus->status;
+}
@@ -0,0 +1,86 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _SENSOR_BUS_H_
+#define _SENSOR_BUS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum sensor_bus_id_e
+{
+    SENSOR_BUS_IMU,
+    SENSOR_BUS_MAG,
+    SENSOR_BUS_MAX
+} sensor_bus_id_t;
+
+// Completion timeout for a single non-blocking transfer.  The interface is
+// power cycled on a timeout to abort the transfer.
+#define SENSOR_BUS_TIMEOUT_MS (10)
+
+typedef void (*sensor_bus_handler_t)(void *arg);
+
+/*
+ * Bus sessions
+ *
+ * sensor_bus_acquire() locks the bus for the calling task and brings the
+ * interface up through the open handler if it is not already powered.
+ * Tasks contending for a bus are served in priority order and the owner
+ * inherits the priority of the highest waiter.  Acquire fails if the bus
+ * cannot be locked within SENSORS_BUS_LOCK_TIMEOUT_MS.  No interrupts are
+ * masked while a bus is held.
+ *
+ * sensor_bus_release() leaves the interface powered and arms an idle
+ * timer.  The close handler runs only once the bus has been idle for
+ * SENSORS_BUS_IDLE_TIMEOUT_MS.  A timeout of 0 closes the bus on every
+ * release.
+ */
+extern void sensor_bus_setup(sensor_bus_id_t id,
+                             sensor_bus_handler_t open,
+                             sensor_bus_handler_t close,
+                             void *arg);
+extern bool sensor_bus_acquire(sensor_bus_id_t id);
+extern void sensor_bus_release(sensor_bus_id_t id);
+extern void sensor_bus_shutdown(sensor_bus_id_t id);
+
+/*
+ * A transfer is started with sensor_bus_begin(), handed to the driver's
+ * *_async() call with sensor_bus_complete() as the callback and
+ * sensor_bus_context() as the context, and then waited on with
+ * sensor_bus_wait().  The calling task blocks on a task notification so
+ * the CPU is free to run other tasks or sleep while the DMA completes.
+ */
+extern void sensor_bus_begin(sensor_bus_id_t id);
+extern void *sensor_bus_context(sensor_bus_id_t id);
+extern void sensor_bus_complete(void *context, uint32_t status);
+extern uint32_t sensor_bus_wait(sensor_bus_id_t id);
+
+#endif
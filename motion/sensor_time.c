@@ -0,0 +1,162 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <am_mcu_apollo.h>
+
+#include "sensor_time.h"
+
+static uint32_t mcu_time_last;
+static uint64_t mcu_time_ticks;
+
+uint64_t sensor_time_mcu_us(void)
+{
+    uint64_t ticks;
+
+    AM_CRITICAL_BEGIN
+    uint32_t now = am_hal_stimer_counter_get();
+    mcu_time_ticks += (uint32_t)(now - mcu_time_last);
+    mcu_time_last = now;
+    ticks = mcu_time_ticks;
+    AM_CRITICAL_END
+
+    return ticks * 1000000 / SENSOR_TIME_MCU_CLOCK_HZ;
+}
+
+uint32_t sensor_time_ticks_to_us(uint32_t ticks)
+{
+    // 39.0625us = 625 / 16
+    return (uint32_t)(((uint64_t)ticks * 625) / 16);
+}
+
+void sensor_time_start(sensor_time_t *st, uint32_t period_us, uint32_t tolerance)
+{
+    st->period_us = period_us;
+    st->previous_period_us = 0;
+    st->tolerance = (int32_t)tolerance;
+    st->synced = false;
+    st->balance = 0;
+}
+
+void sensor_time_set_period(sensor_time_t *st, uint32_t raw, uint32_t period_us)
+{
+    // Before the first update there is nothing to split.  A second change
+    // before the next update keeps the first boundary; the samples in
+    // between are counted at the latest period.
+    if (st->synced && (st->previous_period_us == 0))
+    {
+        st->previous_period_us = st->period_us;
+        st->switch_raw = raw & SENSOR_TIME_MASK;
+    }
+    st->period_us = period_us;
+}
+
+uint64_t sensor_time_update(sensor_time_t *st, uint32_t raw, uint64_t mcu_us, uint32_t samples, uint32_t *dropped)
+{
+    uint32_t delta = 0;
+
+    raw &= SENSOR_TIME_MASK;
+
+    if (st->synced)
+    {
+        delta = (raw - st->raw) & SENSOR_TIME_MASK;
+    }
+    st->raw = raw;
+    st->ticks += delta;
+
+    int64_t sensor_us = (int64_t)((st->ticks * 625) / 16);
+    int64_t observed = (int64_t)mcu_us - sensor_us;
+
+    *dropped = 0;
+    if (!st->synced)
+    {
+        st->offset_us = observed;
+        st->synced = true;
+    }
+    else
+    {
+        if (observed < st->offset_us)
+        {
+            st->offset_us = observed;
+        }
+        else
+        {
+            st->offset_us += (observed - st->offset_us) >> SENSOR_TIME_OFFSET_SHIFT;
+        }
+
+        // Compare the number of samples that should have been produced
+        // since the last update with the number actually received.  The
+        // tolerance absorbs samples that straddle the read boundaries and
+        // are picked up on the next update instead.
+        if (st->period_us)
+        {
+            uint32_t interval_us = sensor_time_ticks_to_us(delta);
+            uint32_t expected = 0;
+
+            if (st->previous_period_us)
+            {
+                // Samples up to the rate change came at the previous period.
+                uint32_t before = (st->switch_raw - (raw - delta)) & SENSOR_TIME_MASK;
+                if (before <= delta)
+                {
+                    uint32_t before_us = sensor_time_ticks_to_us(before);
+
+                    expected = (before_us + st->previous_period_us / 2) / st->previous_period_us;
+                    interval_us -= before_us;
+                    st->previous_period_us = 0;
+                }
+            }
+            expected += (interval_us + st->period_us / 2) / st->period_us;
+
+            st->balance += (int32_t)expected - (int32_t)samples;
+            if (st->balance > st->tolerance)
+            {
+                *dropped = st->balance - st->tolerance;
+                st->balance = st->tolerance;
+            }
+            else if (st->balance < -st->tolerance)
+            {
+                st->balance = -st->tolerance;
+            }
+        }
+    }
+
+    uint64_t timestamp = (uint64_t)(sensor_us + st->offset_us);
+    if (timestamp <= st->last_us)
+    {
+        timestamp = st->last_us + 1;
+    }
+    st->last_us = timestamp;
+
+    return timestamp;
+}
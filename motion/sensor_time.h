@@ -0,0 +1,91 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _SENSOR_TIME_H_
+#define _SENSOR_TIME_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The BMI270 and BMM350 sensor time counters are both 24 bits wide with
+// 1 LSB = 39.0625us (25.6kHz).  They wrap every 655.36s.
+#define SENSOR_TIME_MASK            (0x00FFFFFF)
+
+// The MCU timebase is the STIMER running from the 32kHz crystal.
+#define SENSOR_TIME_MCU_CLOCK_HZ    (32768)
+
+// Once the offset between a sensor clock and the MCU timebase has been
+// established it is allowed to grow by 1/2^SHIFT of the observed error on
+// each sample.  The offset drops immediately to any smaller observation as
+// the smallest observation carries the least read latency.
+#define SENSOR_TIME_OFFSET_SHIFT    (4)
+
+typedef struct sensor_time_s
+{
+    uint32_t period_us;
+    uint32_t previous_period_us;
+    uint32_t switch_raw;
+    int32_t tolerance;
+    bool synced;
+    uint32_t raw;
+    uint64_t ticks;
+    int64_t offset_us;
+    int32_t balance;
+    uint64_t last_us;
+} sensor_time_t;
+
+/*
+ * sensor_time_start() (re)starts tracking a sensor clock with samples
+ * expected every period_us.  It must be called whenever sampling resumes
+ * after a pause as the sensor counter may have wrapped in the meantime.
+ * tolerance is the number of samples an update may be short by without
+ * being counted as dropped.  It should be 0 for single sample reads and 1
+ * for FIFO reads where a frame may land just after the read.
+ *
+ * sensor_time_update() takes the raw sensor time read together with the
+ * data, the MCU time at which the read completed and the number of
+ * samples the read covers.  It returns the time of the newest sample on
+ * the MCU timebase in microseconds.  The result is monotonic across calls.
+ * The number of samples missed since the previous update is returned in
+ * dropped.
+ *
+ * sensor_time_set_period() changes the sample period without losing sync.
+ * raw is the sensor time at which the new period took effect.  The next
+ * update counts the samples expected before raw at the previous period.
+ */
+extern void sensor_time_start(sensor_time_t *st, uint32_t period_us, uint32_t tolerance);
+extern uint64_t sensor_time_update(sensor_time_t *st, uint32_t raw, uint64_t mcu_us, uint32_t samples, uint32_t *dropped);
+extern void sensor_time_set_period(sensor_time_t *st, uint32_t raw, uint32_t period_us);
+
+extern uint64_t sensor_time_mcu_us(void);
+extern uint32_t sensor_time_ticks_to_us(uint32_t ticks);
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+
+#include <am_mcu_apollo.h>
+
+#include "latency_probe.h"
+
+#define LATENCY_PROBE_CLK        AM_HAL_CTIMER_HFRC_3MHZ
+#define LATENCY_PROBE_TIMER_NUM  3
+#define LATENCY_PROBE_TIMER_SEG  AM_HAL_CTIMER_TIMERA
+#define LATENCY_PROBE_TIMER_INT  AM_HAL_CTIMER_INT_TIMERA3C0
+
+static volatile latency_probe_stats_t latency_probe_stats;
+
+static void latency_probe_handler(void)
+{
+    uint32_t ticks = am_hal_ctimer_read(LATENCY_PROBE_TIMER_NUM, LATENCY_PROBE_TIMER_SEG);
+
+    latency_probe_stats.count++;
+    latency_probe_stats.total += ticks;
+    if (ticks > latency_probe_stats.max)
+    {
+        latency_probe_stats.max = ticks;
+    }
+}
+
+void latency_probe_start(uint32_t period_us)
+{
+    am_hal_ctimer_stop(LATENCY_PROBE_TIMER_NUM, LATENCY_PROBE_TIMER_SEG);
+    am_hal_ctimer_clear(LATENCY_PROBE_TIMER_NUM, LATENCY_PROBE_TIMER_SEG);
+
+    am_hal_ctimer_config_single(
+        LATENCY_PROBE_TIMER_NUM,
+        LATENCY_PROBE_TIMER_SEG,
+        AM_HAL_CTIMER_FN_REPEAT |
+        AM_HAL_CTIMER_INT_ENABLE |
+        LATENCY_PROBE_CLK
+    );
+
+    am_hal_ctimer_period_set(
+        LATENCY_PROBE_TIMER_NUM,
+        LATENCY_PROBE_TIMER_SEG,
+        period_us * LATENCY_PROBE_TICKS_PER_US, 0);
+
+    latency_probe_reset();
+
+    am_hal_ctimer_int_register(LATENCY_PROBE_TIMER_INT, latency_probe_handler);
+    am_hal_ctimer_int_clear(LATENCY_PROBE_TIMER_INT);
+    am_hal_ctimer_int_enable(LATENCY_PROBE_TIMER_INT);
+    NVIC_EnableIRQ(CTIMER_IRQn);
+
+    am_hal_ctimer_start(LATENCY_PROBE_TIMER_NUM, LATENCY_PROBE_TIMER_SEG);
+}
+
+void latency_probe_stop(void)
+{
+    am_hal_ctimer_stop(LATENCY_PROBE_TIMER_NUM, LATENCY_PROBE_TIMER_SEG);
+    am_hal_ctimer_int_disable(LATENCY_PROBE_TIMER_INT);
+    am_hal_ctimer_int_clear(LATENCY_PROBE_TIMER_INT);
+}
+
+void latency_probe_reset(void)
+{
+    AM_CRITICAL_BEGIN
+    latency_probe_stats.count = 0;
+    latency_probe_stats.total = 0;
+    latency_probe_stats.max = 0;
+    AM_CRITICAL_END
+}
+
+void latency_probe_get(latency_probe_stats_t *stats)
+{
+    AM_CRITICAL_BEGIN
+    stats->count = latency_probe_stats.count;
+    stats->total = latency_probe_stats.total;
+    stats->max = latency_probe_stats.max;
+    AM_CRITICAL_END
+}
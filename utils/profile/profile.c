@@ -0,0 +1,96 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include <am_mcu_apollo.h>
+
+#include "profile.h"
+
+static profile_t *profile_probes[PROFILE_MAX_PROBES];
+static uint32_t profile_probes_registered;
+
+void profile_setup(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void profile_register(profile_t *probe)
+{
+    profile_reset(probe);
+
+    for (uint32_t i = 0; i < profile_probes_registered; i++)
+    {
+        if (profile_probes[i] == probe)
+        {
+            return;
+        }
+    }
+
+    if (profile_probes_registered < PROFILE_MAX_PROBES)
+    {
+        profile_probes[profile_probes_registered++] = probe;
+    }
+}
+
+void profile_reset(profile_t *probe)
+{
+    probe->count = 0;
+    probe->total = 0;
+    probe->min = UINT32_MAX;
+    probe->max = 0;
+}
+
+void profile_reset_all(void)
+{
+    for (uint32_t i = 0; i < profile_probes_registered; i++)
+    {
+        profile_reset(profile_probes[i]);
+    }
+}
+
+uint32_t profile_probe_count(void)
+{
+    return profile_probes_registered;
+}
+
+profile_t *profile_probe_get(uint32_t index)
+{
+    if (index < profile_probes_registered)
+    {
+        return profile_probes[index];
+    }
+
+    return NULL;
+}
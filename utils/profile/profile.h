@@ -0,0 +1,88 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <stdint.h>
+
+#include <am_mcu_apollo.h>
+
+// Maximum number of probes that can be registered.
+#ifndef PROFILE_MAX_PROBES
+#define PROFILE_MAX_PROBES (8)
+#endif
+
+/*
+ * Cycle count statistics for a section of code measured with the DWT
+ * cycle counter.  The count includes any time the calling task spends
+ * blocked inside the section, so it is the elapsed time of the section
+ * rather than its CPU cost.
+ */
+typedef struct profile_s
+{
+    const char *name;
+    uint32_t count;
+    uint64_t total;
+    uint32_t min;
+    uint32_t max;
+    uint32_t start;
+} profile_t;
+
+extern void profile_setup(void);
+extern void profile_register(profile_t *probe);
+extern void profile_reset(profile_t *probe);
+extern void profile_reset_all(void);
+extern uint32_t profile_probe_count(void);
+extern profile_t *profile_probe_get(uint32_t index);
+
+static inline void profile_start(profile_t *probe)
+{
+    probe->start = DWT->CYCCNT;
+}
+
+static inline void profile_stop(profile_t *probe)
+{
+    uint32_t cycles = DWT->CYCCNT - probe->start;
+
+    probe->count++;
+    probe->total += cycles;
+    if (cycles < probe->min)
+    {
+        probe->min = cycles;
+    }
+    if (cycles > probe->max)
+    {
+        probe->max = cycles;
+    }
+}
+
+#endif